@@ -0,0 +1,116 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "alloc_utils.h"
+#include "hashtable.h"
+#include "json_utils.h"
+#include "linked_list.h"
+
+#define BENCH_ROUNDS 200
+#define BENCH_NODES  10000
+#define BENCH_KEYS   2000
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned bench_hash(char* key)
+{
+    unsigned hash = 5381;
+    while (*key) hash = hash * 33 + (unsigned char)*key++;
+    return hash;
+}
+
+static void bench_report(const char* name, double seconds, size_t operations, size_t checksum)
+{
+    fprintf(stderr, "  %-26s: %8.1f ns per operation  (checksum %zu)\n", name, seconds * 1e9 / (double)operations, checksum);
+}
+
+// One request's worth of work: a list, a hashtable and a parsed document, all freed at the end
+static size_t bench_request(const t_alloc_utils* allocator, const char* json, size_t json_len, bool free_each)
+{
+    size_t checksum = 0;
+    char key[32];
+
+    t_linked_list* list = linked_list_new_with_allocator(allocator);
+    for (size_t i = 0; i < BENCH_NODES; i++) linked_list_add(list, (void*)(i + 1));
+    checksum += linked_list_count(list);
+
+    t_hashtable* table = hashtable_new_with_allocator(1024, bench_hash, allocator);
+    for (size_t i = 0; i < BENCH_KEYS; i++)
+    {
+        snprintf(key, sizeof(key), "key-%zu", i);
+        hashtable_entry_set(table, key, (void*)(i + 1));
+    }
+    checksum += hashtable_entries_count(table);
+
+    t_json_utils_document_options options = { .allocator = allocator };
+    t_json_utils_document* document = json_utils_document_parse(json, json_len, &options, NULL);
+    checksum += json_utils_value_count(json_utils_document_root(document));
+
+    // With an arena, the reset that follows releases everything at once
+    if (free_each)
+    {
+        linked_list_free(list, NULL);
+        hashtable_free(table, NULL);
+        json_utils_document_free(document);
+    }
+
+    return checksum;
+}
+
+int main(void)
+{
+    t_json_utils_writer* writer = json_utils_writer_new(0);
+    json_utils_writer_begin_array(writer);
+    for (int i = 0; i < 1000; i++)
+    {
+        json_utils_writer_begin_object(writer);
+        json_utils_writer_key(writer, "id");
+        json_utils_writer_int(writer, i);
+        json_utils_writer_key(writer, "name");
+        json_utils_writer_string(writer, "request item");
+        json_utils_writer_end_object(writer);
+    }
+    json_utils_writer_end_array(writer);
+
+    size_t json_len;
+    const char* json = json_utils_writer_data(writer, &json_len);
+    size_t operations = (size_t)BENCH_ROUNDS * (BENCH_NODES + BENCH_KEYS + 1000);
+
+    size_t checksum = 0;
+    double begin = bench_now();
+    for (int r = 0; r < BENCH_ROUNDS; r++) checksum += bench_request(NULL, json, json_len, true);
+    bench_report("default (malloc)", bench_now() - begin, operations, checksum);
+
+    checksum = 0;
+    begin = bench_now();
+    for (int r = 0; r < BENCH_ROUNDS; r++) checksum += bench_request(alloc_utils_pool(), json, json_len, true);
+    bench_report("thread-local pool", bench_now() - begin, operations, checksum);
+
+    t_alloc_utils_arena* arena = alloc_utils_arena_new(0);
+    if (!arena)
+    {
+        fprintf(stderr, "Failed to allocate benchmark arena\n");
+        return 1;
+    }
+
+    checksum = 0;
+    begin = bench_now();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        checksum += bench_request(alloc_utils_arena_allocator(arena), json, json_len, false);
+        alloc_utils_arena_reset(arena);
+    }
+    bench_report("arena, one reset", bench_now() - begin, operations, checksum);
+
+    alloc_utils_arena_free(arena);
+    json_utils_writer_free(writer);
+    return 0;
+}
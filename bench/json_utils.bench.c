@@ -0,0 +1,254 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cpu_utils.h"
+#include "json_utils.h"
+
+#define BENCH_RECORDS 500000
+#define BENCH_CHUNK   (64 * 1024)
+#define BENCH_ROUNDS  5
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool bench_on_value(void* context, const char* text, size_t len)
+{
+    (void)text;
+    *(size_t*)context += len;
+    return true;
+}
+
+/*
+ * Copy of the original json_utils_escape loop (one switch per byte, into a
+ * len * 2 + 1 buffer, so only safe on input without control characters).
+ */
+static size_t legacy_escape(char* escaped, const char* str, size_t len)
+{
+    size_t j = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        switch (str[i])
+        {
+            case '"':  escaped[j++] = '\\'; escaped[j++] = '"'; break;
+            case '\\': escaped[j++] = '\\'; escaped[j++] = '\\'; break;
+            case '\b': escaped[j++] = '\\'; escaped[j++] = 'b'; break;
+            case '\f': escaped[j++] = '\\'; escaped[j++] = 'f'; break;
+            case '\n': escaped[j++] = '\\'; escaped[j++] = 'n'; break;
+            case '\r': escaped[j++] = '\\'; escaped[j++] = 'r'; break;
+            case '\t': escaped[j++] = '\\'; escaped[j++] = 't'; break;
+            default:    escaped[j++] = str[i]; break;
+        }
+    }
+    escaped[j] = '\0';
+    return j;
+}
+
+static void bench_escape(void)
+{
+    static const char* lines[] = {
+        "request 18231 served in 0.482 ms for /api/v2/orders?limit=50&offset=100 by worker-7",
+        "order 4412 filled at 101.25 for account \"acct-412\" via gateway fix-3",
+        "cache miss for key user:session:9f2c41d0 after 3 retries, falling back to primary store",
+    };
+    char output[1024];
+    size_t total = 0;
+    size_t bytes = 0;
+
+    double start = bench_now();
+    for (int i = 0; i < BENCH_RECORDS * 4; i++)
+    {
+        const char* line = lines[i % 3];
+        size_t len = strlen(line);
+        total += legacy_escape(output, line, len);
+        bytes += len;
+    }
+    double legacy = bench_now() - start;
+
+    start = bench_now();
+    for (int i = 0; i < BENCH_RECORDS * 4; i++)
+    {
+        const char* line = lines[i % 3];
+        total += json_utils_escape_into(output, sizeof(output), line, strlen(line));
+    }
+    double current = bench_now() - start;
+
+    fprintf(stderr, "escape legacy    : %8.1f MB/s\n", (double)bytes / legacy / 1e6);
+    fprintf(stderr, "escape_into      : %8.1f MB/s  (%.2fx, %zu bytes out)\n",
+            (double)bytes / current / 1e6, legacy / current, total);
+}
+
+// One response document built with snprintf + json_utils_escape, then with the writer
+static void bench_writer(void)
+{
+    static const char* names[] = { "alice \"al\" smith", "bob", "carol\tjones" };
+    char buffer[512];
+    size_t total = 0;
+
+    double start = bench_now();
+    for (int i = 0; i < BENCH_RECORDS; i++)
+    {
+        char* name = json_utils_escape(names[i % 3]);
+        char* city = json_utils_escape("Zurich");
+        int n = snprintf(buffer, sizeof(buffer),
+                         "{\"id\":%d,\"name\":\"%s\",\"score\":%.17g,\"active\":%s,\"tags\":[\"a\",\"b\"],\"city\":\"%s\"}",
+                         i, name, i * 0.25, i & 1 ? "true" : "false", city);
+        total += (size_t)n;
+        free(name);
+        free(city);
+    }
+    double printf_time = bench_now() - start;
+
+    t_json_utils_writer* writer = json_utils_writer_new(0);
+
+    start = bench_now();
+    for (int i = 0; i < BENCH_RECORDS; i++)
+    {
+        json_utils_writer_reset(writer);
+        json_utils_writer_begin_object(writer);
+        json_utils_writer_key(writer, "id");
+        json_utils_writer_int(writer, i);
+        json_utils_writer_key(writer, "name");
+        json_utils_writer_string(writer, names[i % 3]);
+        json_utils_writer_key(writer, "score");
+        json_utils_writer_double(writer, i * 0.25);
+        json_utils_writer_key(writer, "active");
+        json_utils_writer_bool(writer, i & 1);
+        json_utils_writer_key(writer, "tags");
+        json_utils_writer_begin_array(writer);
+        json_utils_writer_string(writer, "a");
+        json_utils_writer_string(writer, "b");
+        json_utils_writer_end_array(writer);
+        json_utils_writer_key(writer, "city");
+        json_utils_writer_string(writer, "Zurich");
+        json_utils_writer_end_object(writer);
+
+        size_t len = 0;
+        json_utils_writer_data(writer, &len);
+        total += len;
+    }
+    double writer_time = bench_now() - start;
+
+    json_utils_writer_free(writer);
+
+    fprintf(stderr, "snprintf + escape: %8.0f docs/s\n", BENCH_RECORDS / printf_time);
+    fprintf(stderr, "writer           : %8.0f docs/s  (%.2fx, %zu bytes)\n",
+            BENCH_RECORDS / writer_time, printf_time / writer_time, total);
+}
+
+// NDJSON shaped like the output of log_utils
+static char* bench_make_input(size_t* len)
+{
+    size_t capacity = (size_t)BENCH_RECORDS * 256;
+    char* data = malloc(capacity);
+    if (!data) return NULL;
+
+    size_t n = 0;
+    for (int i = 0; i < BENCH_RECORDS; i++)
+    {
+        n += (size_t)snprintf(data + n, capacity - n,
+            "{ \"timestamp\": \"2024-05-01 12:00:%02d\", \"level\": \"INFO\", \"context\": \"order.book\", "
+            "\"content\": \"order %d filled at %d.25 for account \\\"acct-%d\\\" via gateway fix-%d\", "
+            "\"qty\": %d, \"side\": \"buy\", \"ok\": true }\n",
+            i % 60, i, 100 + i % 7, i % 1000, i % 4, i % 100);
+    }
+
+    *len = n;
+    return data;
+}
+
+int main(void)
+{
+    size_t len = 0;
+    char* data = bench_make_input(&len);
+    if (!data)
+    {
+        fprintf(stderr, "Failed to allocate benchmark input\n");
+        return 1;
+    }
+
+    size_t total = 0;
+    t_json_utils_callbacks callbacks = { .on_key = bench_on_value, .on_string = bench_on_value, .on_number = bench_on_value };
+    t_json_utils_parser_options options = { .multiple_values = true };
+    t_json_utils_parser* parser = json_utils_parser_new(&callbacks, &total, &options);
+
+    double best = 0.0;
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        json_utils_parser_reset(parser);
+
+        double start = bench_now();
+        for (size_t offset = 0; offset < len; offset += BENCH_CHUNK)
+        {
+            size_t chunk = len - offset < BENCH_CHUNK ? len - offset : BENCH_CHUNK;
+            json_utils_parser_feed(parser, data + offset, chunk);
+        }
+        e_json_utils_status status = json_utils_parser_finish(parser);
+        double elapsed = bench_now() - start;
+
+        if (status != JSON_UTILS_OK)
+        {
+            fprintf(stderr, "Parse failed: %s\n", json_utils_status_string(status));
+            return 1;
+        }
+        if (round == 0 || elapsed < best) best = elapsed;
+    }
+
+    static const char* levels[] = { "scalar", "sse2", "sse4.2", "avx2", "avx512" };
+    fprintf(stderr, "SAX parser (%s): %8.1f MB/s  (%.1f MB, %zu value bytes)\n",
+            levels[cpu_utils_level()], (double)len / best / 1e6, (double)len / 1e6, total / BENCH_ROUNDS);
+
+    json_utils_parser_free(parser);
+
+    // Same records as one array document: "[rec,rec,...]", the buffer has room for one more byte
+    memmove(data + 1, data, len);
+    data[0] = '[';
+    len++;
+    for (size_t i = 0; i < len - 1; i++)
+    {
+        if (data[i] == '\n') data[i] = ',';
+    }
+    data[len - 1] = ']';
+
+    for (int on_demand = 0; on_demand <= 1; on_demand++)
+    {
+        t_json_utils_document_options document_options = { .on_demand = on_demand };
+        size_t found = 0;
+
+        best = 0.0;
+        for (int round = 0; round < BENCH_ROUNDS; round++)
+        {
+            double start = bench_now();
+            t_json_utils_document* document = json_utils_document_parse(data, len, &document_options, NULL);
+            t_json_utils_value* root = json_utils_document_root(document);
+
+            // Random access to one field of every 100th record
+            found = 0;
+            for (size_t i = 0; i < json_utils_value_count(root); i += 100)
+            {
+                found += json_utils_object_get(json_utils_array_get(root, i), "level") != NULL;
+            }
+            json_utils_document_free(document);
+            double elapsed = bench_now() - start;
+
+            if (round == 0 || elapsed < best) best = elapsed;
+        }
+
+        fprintf(stderr, "DOM %-9s  : %8.1f MB/s  (%zu records read)\n",
+                on_demand ? "on-demand" : "full", (double)len / best / 1e6, found);
+    }
+
+    free(data);
+
+    bench_escape();
+    bench_writer();
+
+    return 0;
+}
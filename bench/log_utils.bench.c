@@ -0,0 +1,141 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "log_utils.h"
+#include "json_utils.h"
+
+#define BENCH_MESSAGES 1000000
+
+/*
+ * Copy of the original log_utils_log hot path (two vsnprintf passes, three
+ * heap allocations, gettimeofday + localtime per message), kept as baseline.
+ */
+static void legacy_timestamp(char* buffer, size_t size)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+
+    struct tm* tm_info = localtime(&tv.tv_sec);
+
+    snprintf(buffer, size, "%04d/%02d/%02d %02d:%02d:%02d:%03ld",
+             tm_info->tm_year + 1900,
+             tm_info->tm_mon + 1,
+             tm_info->tm_mday,
+             tm_info->tm_hour,
+             tm_info->tm_min,
+             tm_info->tm_sec,
+             (long)tv.tv_usec / 1000);
+}
+
+static void legacy_log(const char* context, const char* format, ...)
+{
+    char timestamp[96];
+    legacy_timestamp(timestamp, sizeof(timestamp));
+
+    va_list args;
+    va_start(args, format);
+
+    va_list args_copy;
+    va_copy(args_copy, args);
+    int content_size = vsnprintf(NULL, 0, format, args_copy);
+    va_end(args_copy);
+
+    char* content = malloc(content_size + 1);
+    vsnprintf(content, content_size + 1, format, args);
+    va_end(args);
+
+    char* escaped_context = json_utils_escape(context);
+    char* escaped_content = json_utils_escape(content);
+
+    printf("{ \"timestamp\": \"%s\", \"level\": \"%s\", \"context\": \"%s\", \"content\": \"%s\" }\n",
+           timestamp, "INFO", escaped_context, escaped_content);
+
+    free(content);
+    free(escaped_context);
+    free(escaped_content);
+}
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(void)
+{
+    // Measure formatting cost, not terminal throughput
+    if (!freopen("/dev/null", "w", stdout))
+    {
+        fprintf(stderr, "Failed to redirect stdout\n");
+        return 1;
+    }
+
+    double start = bench_now();
+    for (int i = 0; i < BENCH_MESSAGES; i++)
+    {
+        legacy_log("http.server", "request %d served in %.3f ms for \"%s\"", i, i * 0.001, "/index.html");
+    }
+    double legacy = bench_now() - start;
+
+    start = bench_now();
+    for (int i = 0; i < BENCH_MESSAGES; i++)
+    {
+        log_utils_info("http.server", "request %d served in %.3f ms for \"%s\"", i, i * 0.001, "/index.html");
+    }
+    double current = bench_now() - start;
+
+    // Same information as printf text and as structured fields
+    start = bench_now();
+    for (int i = 0; i < BENCH_MESSAGES; i++)
+    {
+        log_utils_info("http.server", "status=%d bytes=%d user=%d cached=%s", 200, i * 3, i % 1000, i & 1 ? "true" : "false");
+    }
+    double printf_fields = bench_now() - start;
+
+    start = bench_now();
+    for (int i = 0; i < BENCH_MESSAGES; i++)
+    {
+        LOG_UTILS_LOG_FIELDS(LOG_UTILS_LEVEL_INFO, "http.server", NULL,
+                             LOG_UTILS_FIELD_INT("status", 200),
+                             LOG_UTILS_FIELD_INT("bytes", i * 3),
+                             LOG_UTILS_FIELD_INT("user", i % 1000),
+                             LOG_UTILS_FIELD_BOOL("cached", i & 1));
+    }
+    double structured_fields = bench_now() - start;
+
+    // Cost of a call whose level is disabled at runtime
+    log_utils_set_min_level(LOG_UTILS_WARN);
+
+    start = bench_now();
+    for (int i = 0; i < BENCH_MESSAGES * 10; i++)
+    {
+        log_utils_debug("http.server", "request %d served in %.3f ms", i, i * 0.001);
+    }
+    double disabled_call = bench_now() - start;
+
+    start = bench_now();
+    for (int i = 0; i < BENCH_MESSAGES * 10; i++)
+    {
+        LOG_UTILS_LOG_DEBUG("http.server", "request %d served in %.3f ms", i, i * 0.001);
+    }
+    double disabled_macro = bench_now() - start;
+
+    log_utils_set_min_level(LOG_UTILS_DEBUG);
+
+    fprintf(stderr, "legacy log_utils_log : %12.0f msg/s\n", BENCH_MESSAGES / legacy);
+    fprintf(stderr, "log_utils_log        : %12.0f msg/s\n", BENCH_MESSAGES / current);
+    fprintf(stderr, "speedup              : %12.2fx\n", legacy / current);
+    fprintf(stderr, "printf key=value     : %12.0f msg/s\n", BENCH_MESSAGES / printf_fields);
+    fprintf(stderr, "structured fields    : %12.0f msg/s\n", BENCH_MESSAGES / structured_fields);
+    fprintf(stderr, "disabled, function   : %12.2f ns/call\n", disabled_call * 1e9 / (BENCH_MESSAGES * 10));
+    fprintf(stderr, "disabled, macro      : %12.2f ns/call\n", disabled_macro * 1e9 / (BENCH_MESSAGES * 10));
+
+    return 0;
+}
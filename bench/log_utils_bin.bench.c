@@ -0,0 +1,68 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "log_utils.h"
+#include "log_utils_bin.h"
+
+#define BENCH_MESSAGES 2000000
+#define BENCH_TEXT_PATH "/tmp/log_utils_bin_bench.log"
+#define BENCH_BIN_PATH  "/tmp/log_utils_bin_bench.bin"
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static long long bench_file_size(const char* path)
+{
+    struct stat st;
+    return stat(path, &st) == 0 ? (long long)st.st_size : -1;
+}
+
+int main(void)
+{
+    t_log_utils_sink* sink = log_utils_sink_file_new(BENCH_TEXT_PATH, NULL);
+    if (!sink || !log_utils_bin_open(BENCH_BIN_PATH))
+    {
+        fprintf(stderr, "Failed to open benchmark outputs in /tmp\n");
+        return 1;
+    }
+    log_utils_set_sink(sink);
+
+    double start = bench_now();
+    for (int i = 0; i < BENCH_MESSAGES; i++)
+    {
+        log_utils_info("order.book", "order %d filled at %.2f qty %d side %s", i, 101.25 + i % 7, i % 100, "buy");
+    }
+    log_utils_flush();
+    double text = bench_now() - start;
+
+    start = bench_now();
+    for (int i = 0; i < BENCH_MESSAGES; i++)
+    {
+        LOG_UTILS_BIN_INFO("order.book", "order %d filled at %.2f qty %d side %s", i, 101.25 + i % 7, i % 100, "buy");
+    }
+    log_utils_bin_flush();
+    double binary = bench_now() - start;
+
+    log_utils_bin_close();
+    log_utils_set_sink(NULL);
+    log_utils_sink_free(sink);
+
+    long long text_size = bench_file_size(BENCH_TEXT_PATH);
+    long long binary_size = bench_file_size(BENCH_BIN_PATH);
+
+    fprintf(stderr, "JSON text  : %8.1f ns/msg  %6.1f bytes/msg\n", text * 1e9 / BENCH_MESSAGES, (double)text_size / BENCH_MESSAGES);
+    fprintf(stderr, "binary     : %8.1f ns/msg  %6.1f bytes/msg\n", binary * 1e9 / BENCH_MESSAGES, (double)binary_size / BENCH_MESSAGES);
+    fprintf(stderr, "speedup    : %8.2fx      %6.2fx smaller\n", text / binary, (double)text_size / (double)binary_size);
+
+    remove(BENCH_TEXT_PATH);
+    remove(BENCH_BIN_PATH);
+
+    return 0;
+}
@@ -0,0 +1,99 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "log_utils.h"
+#include "log_utils_reader.h"
+#include "log_utils_sink.h"
+
+#define BENCH_RECORDS 1000000
+#define BENCH_ROUNDS  3
+#define BENCH_PATH    "log_utils_reader.bench.log"
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool bench_on_record(void* context, unsigned worker, const t_log_utils_record* record)
+{
+    (void)worker;
+    atomic_fetch_add_explicit((atomic_size_t*)context, record->content_len, memory_order_relaxed);
+    return true;
+}
+
+static double bench_read(const t_log_utils_reader_options* options, t_log_utils_reader_stats* stats)
+{
+    double best = 0.0;
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        atomic_size_t bytes;
+        atomic_init(&bytes, 0);
+
+        double start = bench_now();
+        if (!log_utils_reader_read_file(BENCH_PATH, options, bench_on_record, &bytes, stats)) return -1.0;
+        double elapsed = bench_now() - start;
+
+        if (round == 0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+int main(void)
+{
+    static const char* contexts[] = { "order.book", "gateway", "risk" };
+
+    remove(BENCH_PATH);
+    t_log_utils_sink* sink = log_utils_sink_file_new(BENCH_PATH, NULL);
+    if (!sink)
+    {
+        fprintf(stderr, "Failed to open %s\n", BENCH_PATH);
+        return 1;
+    }
+    log_utils_set_sink(sink);
+    for (int i = 0; i < BENCH_RECORDS; i++)
+    {
+        log_utils_emit(i % 4, contexts[i % 3], "order %d filled at %d.25 for account \"acct-%d\" via gateway fix-%d",
+                       i, 100 + i % 7, i % 1000, i % 4);
+    }
+    log_utils_flush();
+    log_utils_set_sink(NULL);
+    log_utils_sink_free(sink);
+
+    struct stat st;
+    stat(BENCH_PATH, &st);
+    double size = (double)st.st_size / 1e6;
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned max_threads = online > 1 ? (unsigned)online : 1;
+    t_log_utils_reader_stats stats;
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+    {
+        t_log_utils_reader_options options = { .threads = threads };
+        double elapsed = bench_read(&options, &stats);
+        fprintf(stderr, "read, %2u thread(s)      : %8.1f MB/s  (%llu records)\n",
+                threads, size / elapsed, (unsigned long long)stats.records);
+    }
+
+    // Filters rejected on the raw line are never parsed
+    t_log_utils_reader_options options = { .threads = max_threads, .min_level = LOG_UTILS_LEVEL_ERROR };
+    double elapsed = bench_read(&options, &stats);
+    fprintf(stderr, "read, level >= ERROR    : %8.1f MB/s  (%llu records, %llu filtered)\n",
+            size / elapsed, (unsigned long long)stats.records, (unsigned long long)stats.filtered);
+
+    options.context = "risk";
+    elapsed = bench_read(&options, &stats);
+    fprintf(stderr, "read, ERROR and \"risk\"  : %8.1f MB/s  (%llu records, %llu filtered)\n",
+            size / elapsed, (unsigned long long)stats.records, (unsigned long long)stats.filtered);
+
+    remove(BENCH_PATH);
+    return 0;
+}
@@ -0,0 +1,166 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "math_utils.h"
+
+// Each size is processed about the same number of elements in total
+#define BENCH_ELEMENTS ((size_t)1 << 28)
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned s_state = 12345;
+
+static float bench_uniform(void)
+{
+    s_state = s_state * 1103515245u + 12345u;
+    return (float)(s_state >> 8) / (float)(1u << 24);
+}
+
+static void bench_report(const char* name, double seconds, size_t elements, double checksum)
+{
+    fprintf(stderr, "  %-26s: %8.3f ns per element  (checksum %g)\n", name, seconds * 1e9 / (double)elements, checksum);
+}
+
+// The naive loops the array functions replace
+static float bench_naive_sumf(const float* values, size_t count)
+{
+    float sum = 0.0f;
+    for (size_t i = 0; i < count; i++) sum += values[i];
+    return sum;
+}
+
+static size_t bench_naive_argminf(const float* values, size_t count)
+{
+    size_t best = 0;
+    for (size_t i = 1; i < count; i++) best = values[i] < values[best] ? i : best;
+    return best;
+}
+
+static void bench_naive_prefix_sumf(float* out, const float* values, size_t count)
+{
+    float total = 0.0f;
+    for (size_t i = 0; i < count; i++) out[i] = total += values[i];
+}
+
+static void bench_size(size_t count)
+{
+    float* values = malloc(count * sizeof(float));
+    float* out = malloc(count * sizeof(float));
+    int32_t* integers = malloc(count * sizeof(int32_t));
+    int32_t* integers_out = malloc(count * sizeof(int32_t));
+    size_t rounds = BENCH_ELEMENTS / count;
+    size_t elements = rounds * count;
+
+    if (!values || !out || !integers || !integers_out)
+    {
+        fprintf(stderr, "Failed to allocate benchmark input\n");
+        exit(1);
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        values[i] = bench_uniform() * 2.0f - 1.0f;
+        integers[i] = (int32_t)(bench_uniform() * 2000.0f) - 1000;
+    }
+
+    fprintf(stderr, "%zu elements\n", count);
+
+    double checksum = 0.0;
+    double begin = bench_now();
+    for (size_t r = 0; r < rounds; r++) checksum += bench_naive_sumf(values, count);
+    bench_report("naive sumf", bench_now() - begin, elements, checksum);
+
+    checksum = 0.0;
+    begin = bench_now();
+    for (size_t r = 0; r < rounds; r++) checksum += math_utils_array_sumf(values, count);
+    bench_report("array sumf", bench_now() - begin, elements, checksum);
+
+    checksum = 0.0;
+    begin = bench_now();
+    for (size_t r = 0; r < rounds; r++) checksum += (double)math_utils_array_sum(integers, count);
+    bench_report("array sum", bench_now() - begin, elements, checksum);
+
+    checksum = 0.0;
+    begin = bench_now();
+    for (size_t r = 0; r < rounds; r++) checksum += (double)bench_naive_argminf(values, count);
+    bench_report("naive argminf", bench_now() - begin, elements, checksum);
+
+    checksum = 0.0;
+    begin = bench_now();
+    for (size_t r = 0; r < rounds; r++) checksum += (double)math_utils_array_argminf(values, count);
+    bench_report("array argminf", bench_now() - begin, elements, checksum);
+
+    checksum = 0.0;
+    begin = bench_now();
+    for (size_t r = 0; r < rounds; r++) checksum += math_utils_array_maxf(values, count);
+    bench_report("array maxf", bench_now() - begin, elements, checksum);
+
+    checksum = 0.0;
+    begin = bench_now();
+    for (size_t r = 0; r < rounds; r++)
+    {
+        for (size_t i = 0; i < count; i++) out[i] = math_utils_clampf(values[i], -0.5f, 0.5f);
+        checksum += out[r % count];
+    }
+    bench_report("naive clampf", bench_now() - begin, elements, checksum);
+
+    checksum = 0.0;
+    begin = bench_now();
+    for (size_t r = 0; r < rounds; r++)
+    {
+        math_utils_array_clampf(out, values, count, -0.5f, 0.5f);
+        checksum += out[r % count];
+    }
+    bench_report("array clampf", bench_now() - begin, elements, checksum);
+
+    checksum = 0.0;
+    begin = bench_now();
+    for (size_t r = 0; r < rounds; r++)
+    {
+        bench_naive_prefix_sumf(out, values, count);
+        checksum += out[count - 1];
+    }
+    bench_report("naive prefix_sumf", bench_now() - begin, elements, checksum);
+
+    checksum = 0.0;
+    begin = bench_now();
+    for (size_t r = 0; r < rounds; r++)
+    {
+        math_utils_array_prefix_sumf(out, values, count);
+        checksum += out[count - 1];
+    }
+    bench_report("array prefix_sumf", bench_now() - begin, elements, checksum);
+
+    checksum = 0.0;
+    begin = bench_now();
+    for (size_t r = 0; r < rounds; r++)
+    {
+        math_utils_array_prefix_sum(integers_out, integers, count);
+        checksum += integers_out[count - 1];
+    }
+    bench_report("array prefix_sum", bench_now() - begin, elements, checksum);
+
+    free(values);
+    free(out);
+    free(integers);
+    free(integers_out);
+}
+
+int main(void)
+{
+    // In L1, in L2, then from memory, where large arrays are split across threads
+    static const size_t sizes[] = { 4096, 65536, (size_t)1 << 24 };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) bench_size(sizes[i]);
+
+    return 0;
+}
@@ -0,0 +1,192 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "cpu_utils.h"
+#include "math_utils_vec2.h"
+
+#define BENCH_PARTICLES (1 << 20)
+#define BENCH_ROUNDS    20
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Best time of BENCH_ROUNDS runs of statement
+#define BENCH_BEST(best, statement)                        \
+    do                                                      \
+    {                                                       \
+        for (int round = 0; round < BENCH_ROUNDS; round++)  \
+        {                                                   \
+            double begin = bench_now();                     \
+            statement;                                      \
+            double elapsed = bench_now() - begin;           \
+            if (round == 0 || elapsed < (best)) (best) = elapsed; \
+        }                                                   \
+    } while (0)
+
+static void bench_report(const char* name, double baseline, double current)
+{
+    fprintf(stderr, "%-26s: %6.2f ns vs %6.2f ns per vector, array of structs  (%.2fx)\n",
+            name, current * 1e9 / BENCH_PARTICLES, baseline * 1e9 / BENCH_PARTICLES, baseline / current);
+}
+
+// The loop the kernels replace: one call per particle on an array of structs
+static void bench_step_loop(t_math_utils_vec2* positions, const t_math_utils_vec2* velocities, float dt)
+{
+    for (int i = 0; i < BENCH_PARTICLES; i++)
+    {
+        positions[i] = math_utils_vec2_add(positions[i], math_utils_vec2_scale(velocities[i], dt));
+    }
+}
+
+static void bench_normalize_loop(t_math_utils_vec2* out, const t_math_utils_vec2* in)
+{
+    for (int i = 0; i < BENCH_PARTICLES; i++)
+    {
+        float length = sqrtf(in[i].x * in[i].x + in[i].y * in[i].y);
+        out[i] = length > 0.0f ? math_utils_vec2_scale(in[i], 1.0f / length) : math_utils_vec2(0.0f, 0.0f);
+    }
+}
+
+static void bench_clamp_loop(t_math_utils_vec2* out, const t_math_utils_vec2* in, float limit)
+{
+    for (int i = 0; i < BENCH_PARTICLES; i++)
+    {
+        out[i].x = in[i].x < -limit ? -limit : in[i].x > limit ? limit : in[i].x;
+        out[i].y = in[i].y < -limit ? -limit : in[i].y > limit ? limit : in[i].y;
+    }
+}
+
+// Vectors small enough to stay in L1: the kernels below measure computation, not memory
+#define BENCH_GEOMETRY 4096
+#define BENCH_PASSES   256
+#define BENCH_SAMPLES  1000000
+
+static void bench_report_variant(const char* name, double exact, double fast, double error)
+{
+    double calls = (double)BENCH_GEOMETRY * BENCH_PASSES;
+    fprintf(stderr, "%-10s fast vs exact: %6.2f ns vs %6.2f ns  (%.2fx, max error %.2g)\n",
+            name, fast * 1e9 / calls, exact * 1e9 / calls, exact / fast, error);
+}
+
+// Worst error of the fast kernel against double precision, on vectors from 1e-30 to 1e30 long
+static double bench_normalize_error(void)
+{
+    t_math_utils_vec2_buffer* samples = math_utils_vec2_buffer_new(BENCH_SAMPLES);
+    t_math_utils_vec2_buffer* units = math_utils_vec2_buffer_new(BENCH_SAMPLES);
+    unsigned state = 777;
+    double error = 0.0;
+
+    if (samples && units)
+    {
+        for (int i = 0; i < BENCH_SAMPLES; i++)
+        {
+            state = state * 1103515245u + 12345u;
+            double magnitude = pow(10.0, (double)(state >> 8) / (double)(1u << 24) * 60.0 - 30.0);
+            state = state * 1103515245u + 12345u;
+            double direction = (double)(state >> 8) / (double)(1u << 24) * 6.283185307179586;
+            math_utils_vec2_buffer_push(samples, math_utils_vec2((float)(magnitude * cos(direction)),
+                                                                 (float)(magnitude * sin(direction))));
+        }
+
+        math_utils_vec2_buffer_normalize_fast(units, samples);
+        for (int i = 0; i < BENCH_SAMPLES; i++)
+        {
+            double x = samples->x[i], y = samples->y[i];
+            double length = sqrt(x * x + y * y);
+            error = fmax(error, fmax(fabs(units->x[i] - x / length), fabs(units->y[i] - y / length)));
+        }
+    }
+
+    math_utils_vec2_buffer_free(samples);
+    math_utils_vec2_buffer_free(units);
+    return error;
+}
+
+// SIMD rsqrt against SIMD square root and division
+static void bench_geometry(const t_math_utils_vec2* vectors)
+{
+    double exact = 0.0, fast = 0.0;
+    t_math_utils_vec2_buffer* buffer = math_utils_vec2_buffer_new(BENCH_GEOMETRY);
+    t_math_utils_vec2_buffer* units = math_utils_vec2_buffer_new(BENCH_GEOMETRY);
+
+    if (buffer && units)
+    {
+        for (int i = 0; i < BENCH_GEOMETRY; i++) math_utils_vec2_buffer_push(buffer, vectors[i]);
+
+        BENCH_BEST(exact, for (int pass = 0; pass < BENCH_PASSES; pass++)
+                              math_utils_vec2_buffer_normalize(units, buffer));
+        BENCH_BEST(fast, for (int pass = 0; pass < BENCH_PASSES; pass++)
+                             math_utils_vec2_buffer_normalize_fast(units, buffer));
+        bench_report_variant("batch norm", exact, fast, bench_normalize_error());
+        fprintf(stderr, "geometry checksum %g\n", (double)units->x[3]);
+    }
+
+    math_utils_vec2_buffer_free(buffer);
+    math_utils_vec2_buffer_free(units);
+}
+
+int main(void)
+{
+    t_math_utils_vec2* positions = malloc(BENCH_PARTICLES * sizeof(t_math_utils_vec2));
+    t_math_utils_vec2* velocities = malloc(BENCH_PARTICLES * sizeof(t_math_utils_vec2));
+    t_math_utils_vec2* scratch = malloc(BENCH_PARTICLES * sizeof(t_math_utils_vec2));
+    t_math_utils_vec2_buffer* position_buffer = math_utils_vec2_buffer_new(BENCH_PARTICLES);
+    t_math_utils_vec2_buffer* velocity_buffer = math_utils_vec2_buffer_new(BENCH_PARTICLES);
+    t_math_utils_vec2_buffer* scratch_buffer = math_utils_vec2_buffer_new(BENCH_PARTICLES);
+
+    if (!positions || !velocities || !scratch || !position_buffer || !velocity_buffer || !scratch_buffer)
+    {
+        fprintf(stderr, "Failed to allocate benchmark input\n");
+        return 1;
+    }
+
+    unsigned state = 12345;
+    for (int i = 0; i < BENCH_PARTICLES; i++)
+    {
+        state = state * 1103515245u + 12345u;
+        positions[i] = math_utils_vec2((float)(state >> 16 & 0x3ff), (float)(state >> 6 & 0x3ff));
+        velocities[i] = math_utils_vec2((float)(state >> 20 & 0xff) - 128.0f, (float)(state >> 12 & 0xff) - 128.0f);
+        math_utils_vec2_buffer_push(position_buffer, positions[i]);
+        math_utils_vec2_buffer_push(velocity_buffer, velocities[i]);
+    }
+
+    static const char* levels[] = { "scalar", "sse2", "sse4.2", "avx2", "avx512" };
+    fprintf(stderr, "SIMD level: %s, %d vectors\n", levels[cpu_utils_level()], BENCH_PARTICLES);
+
+    double baseline = 0.0, current = 0.0;
+    float dt = 1.0f / 60.0f;
+
+    BENCH_BEST(baseline, bench_step_loop(positions, velocities, dt));
+    BENCH_BEST(current, math_utils_vec2_buffer_fma(position_buffer, velocity_buffer, dt, position_buffer));
+    bench_report("step (fma)", baseline, current);
+
+    BENCH_BEST(baseline, bench_normalize_loop(scratch, velocities));
+    BENCH_BEST(current, math_utils_vec2_buffer_normalize(scratch_buffer, velocity_buffer));
+    bench_report("normalize", baseline, current);
+
+    BENCH_BEST(baseline, bench_clamp_loop(scratch, velocities, 64.0f));
+    BENCH_BEST(current, math_utils_vec2_buffer_clamp(scratch_buffer, velocity_buffer, math_utils_vec2(-64.0f, -64.0f),
+                                                     math_utils_vec2(64.0f, 64.0f)));
+    bench_report("clamp", baseline, current);
+
+    bench_geometry(velocities);
+
+    // Keep the results alive
+    fprintf(stderr, "checksum %g\n", (double)(positions[7].x + scratch[9].y + position_buffer->x[7] + scratch_buffer->y[9]));
+
+    free(positions);
+    free(velocities);
+    free(scratch);
+    math_utils_vec2_buffer_free(position_buffer);
+    math_utils_vec2_buffer_free(velocity_buffer);
+    math_utils_vec2_buffer_free(scratch_buffer);
+    return 0;
+}
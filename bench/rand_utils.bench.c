@@ -0,0 +1,277 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "rand_utils.h"
+
+#define BENCH_DRAWS   20000000
+#define BENCH_THREADS 4
+#define BENCH_FILL    (1 << 20)
+#define BENCH_ROUNDS  50
+#define BENCH_CATEGORIES 10000
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// The former implementation: libc rand() reduced by modulo
+static int bench_legacy_int(int min, int max)
+{
+    return min + rand() % (max - min + 1);
+}
+
+// Monte Carlo estimate of pi, the shape of the workers that used rand()
+static void* bench_legacy_worker(void* arg)
+{
+    long draws = *(const long*)arg;
+    long inside = 0;
+
+    for (long i = 0; i < draws; i++)
+    {
+        float x = (float)rand() / (float)RAND_MAX;
+        float y = (float)rand() / (float)RAND_MAX;
+        inside += x * x + y * y <= 1.0f;
+    }
+
+    return (void*)inside;
+}
+
+// Work of one thread; draws first, as the legacy worker reads it alone
+typedef struct t_bench_job
+{
+    long               draws;
+    t_rand_utils_state state;
+} t_bench_job;
+
+static void* bench_worker(void* arg)
+{
+    t_bench_job* job = arg;
+    long draws = job->draws;
+    long inside = 0;
+    t_rand_utils_state* state = &job->state;
+
+    for (long i = 0; i < draws; i++)
+    {
+        float x = rand_utils_state_float(state, 0.0f, 1.0f);
+        float y = rand_utils_state_float(state, 0.0f, 1.0f);
+        inside += x * x + y * y <= 1.0f;
+    }
+
+    return (void*)inside;
+}
+
+static double bench_threads(void* (*worker)(void*), double* pi)
+{
+    pthread_t threads[BENCH_THREADS];
+    t_bench_job jobs[BENCH_THREADS];
+    t_rand_utils_state master, streams[BENCH_THREADS];
+    long draws = BENCH_DRAWS / BENCH_THREADS;
+    long inside = 0;
+
+    // One stream per thread from a fixed seed: the estimate is the same on every run
+    rand_utils_state_seed(&master, 2024);
+    rand_utils_state_split(&master, streams, BENCH_THREADS);
+
+    double start = bench_now();
+    for (int i = 0; i < BENCH_THREADS; i++)
+    {
+        jobs[i] = (t_bench_job){ draws, streams[i] };
+        pthread_create(&threads[i], NULL, worker, &jobs[i]);
+    }
+    for (int i = 0; i < BENCH_THREADS; i++)
+    {
+        void* result;
+        pthread_join(threads[i], &result);
+        inside += (long)result;
+    }
+    double elapsed = bench_now() - start;
+
+    *pi = 4.0 * (double)inside / (double)(draws * BENCH_THREADS);
+    return elapsed;
+}
+
+// Best time of BENCH_ROUNDS runs of statement
+#define BENCH_BEST(best, statement)                        \
+    do                                                      \
+    {                                                       \
+        for (int round = 0; round < BENCH_ROUNDS; round++)  \
+        {                                                   \
+            double begin = bench_now();                     \
+            statement;                                      \
+            double elapsed = bench_now() - begin;           \
+            if (round == 0 || elapsed < (best)) (best) = elapsed; \
+        }                                                   \
+    } while (0)
+
+static void bench_report_fill(const char* name, double elapsed, size_t bytes, double baseline)
+{
+    fprintf(stderr, "%-30s: %8.1f MB/s  (%.2fx one call per value)\n",
+            name, (double)bytes / elapsed / 1e6, baseline / elapsed);
+}
+
+// Bulk fills against one rand_utils call per value
+static void bench_fill(void)
+{
+    float* floats = malloc(BENCH_FILL * sizeof(float));
+    double* doubles = malloc(BENCH_FILL * sizeof(double));
+    uint32_t* u32 = malloc(BENCH_FILL * sizeof(uint32_t));
+    uint64_t* u64 = malloc(BENCH_FILL * sizeof(uint64_t));
+    t_rand_utils_lanes* lanes = rand_utils_thread_lanes();
+    double loop = 0.0, bulk = 0.0;
+
+    if (floats && doubles && u32 && u64)
+    {
+        BENCH_BEST(loop, for (int i = 0; i < BENCH_FILL; i++) floats[i] = rand_utils_float(0.0f, 1.0f));
+        BENCH_BEST(bulk, rand_utils_fill_float(lanes, floats, BENCH_FILL, 0.0f, 1.0f));
+        bench_report_fill("fill_float", bulk, BENCH_FILL * sizeof(float), loop);
+
+        BENCH_BEST(loop, for (int i = 0; i < BENCH_FILL; i++) doubles[i] = rand_utils_double(0.0, 1.0));
+        BENCH_BEST(bulk, rand_utils_fill_double(lanes, doubles, BENCH_FILL, 0.0, 1.0));
+        bench_report_fill("fill_double", bulk, BENCH_FILL * sizeof(double), loop);
+
+        BENCH_BEST(loop, for (int i = 0; i < BENCH_FILL; i++) u32[i] = (uint32_t)rand_utils_int(0, 999));
+        BENCH_BEST(bulk, rand_utils_fill_u32(lanes, u32, BENCH_FILL, 0, 999));
+        bench_report_fill("fill_u32 [0, 999]", bulk, BENCH_FILL * sizeof(uint32_t), loop);
+
+        // Range 2^31 + 1: nearly half the draws are rejected
+        t_rand_utils_state* state = rand_utils_thread_state();
+        BENCH_BEST(loop, for (int i = 0; i < BENCH_FILL; i++) u32[i] = (uint32_t)rand_utils_state_bounded(state, 0x80000001u));
+        BENCH_BEST(bulk, rand_utils_fill_u32(lanes, u32, BENCH_FILL, 0, 0x80000000u));
+        bench_report_fill("fill_u32 [0, 2^31]", bulk, BENCH_FILL * sizeof(uint32_t), loop);
+
+        BENCH_BEST(loop, for (int i = 0; i < BENCH_FILL; i++) u64[i] = rand_utils_u64());
+        BENCH_BEST(bulk, rand_utils_fill_u64(lanes, u64, BENCH_FILL, 0, UINT64_MAX));
+        bench_report_fill("fill_u64 raw", bulk, BENCH_FILL * sizeof(uint64_t), loop);
+
+        BENCH_BEST(bulk, rand_utils_fill_u64(lanes, u64, BENCH_FILL, 0, 999999));
+        bench_report_fill("fill_u64 [0, 999999]", bulk, BENCH_FILL * sizeof(uint64_t), loop);
+    }
+
+    free(floats);
+    free(doubles);
+    free(u32);
+    free(u64);
+}
+
+// The usual hand-rolled normal: Box-Muller, one log, one sqrt and one cos per value
+static double bench_box_muller(t_rand_utils_state* state)
+{
+    double u = rand_utils_state_double(state, 0.0, 1.0);
+    double v = rand_utils_state_double(state, 0.0, 1.0);
+    return sqrt(-2.0 * log(1.0 - u)) * cos(6.283185307179586 * v);
+}
+
+// The usual hand-rolled weighted choice: a linear scan of the weights
+static size_t bench_linear_choice(t_rand_utils_state* state, const double* weights, size_t count, double total)
+{
+    double target = rand_utils_state_double(state, 0.0, total);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (target < weights[i]) return i;
+        target -= weights[i];
+    }
+    return count - 1;
+}
+
+// Samplers against their naive counterparts
+static void bench_distributions(void)
+{
+    t_rand_utils_state state;
+    double sum = 0.0;
+    rand_utils_state_seed(&state, 3);
+
+    double start = bench_now();
+    for (int i = 0; i < BENCH_DRAWS; i++) sum += bench_box_muller(&state);
+    double naive = bench_now() - start;
+
+    start = bench_now();
+    for (int i = 0; i < BENCH_DRAWS; i++) sum += rand_utils_state_normal(&state, 0.0, 1.0);
+    double current = bench_now() - start;
+
+    fprintf(stderr, "normal, ziggurat vs Box-Muller: %6.2f ns vs %6.2f ns  (%.2fx)\n",
+            current * 1e9 / BENCH_DRAWS, naive * 1e9 / BENCH_DRAWS, naive / current);
+
+    start = bench_now();
+    for (int i = 0; i < BENCH_DRAWS; i++) sum += -log(1.0 - rand_utils_state_double(&state, 0.0, 1.0));
+    naive = bench_now() - start;
+
+    start = bench_now();
+    for (int i = 0; i < BENCH_DRAWS; i++) sum += rand_utils_state_exponential(&state, 1.0);
+    current = bench_now() - start;
+
+    fprintf(stderr, "exponential, ziggurat vs -log : %6.2f ns vs %6.2f ns  (%.2fx)\n",
+            current * 1e9 / BENCH_DRAWS, naive * 1e9 / BENCH_DRAWS, naive / current);
+
+    double* weights = malloc(BENCH_CATEGORIES * sizeof(double));
+    if (!weights) return;
+
+    double total = 0.0;
+    for (int i = 0; i < BENCH_CATEGORIES; i++) total += weights[i] = 1.0 + (double)(i % 97);
+
+    t_rand_utils_alias* alias = rand_utils_alias_new(weights, BENCH_CATEGORIES);
+    if (alias)
+    {
+        size_t picks = 0;
+        int draws = BENCH_DRAWS / 100;
+
+        start = bench_now();
+        for (int i = 0; i < draws; i++) picks += bench_linear_choice(&state, weights, BENCH_CATEGORIES, total);
+        naive = bench_now() - start;
+
+        start = bench_now();
+        for (int i = 0; i < draws; i++) picks += rand_utils_alias_sample(alias, &state);
+        current = bench_now() - start;
+
+        fprintf(stderr, "choice of %d, alias vs scan: %6.2f ns vs %6.0f ns  (%.0fx, sum %zu / %g)\n",
+                BENCH_CATEGORIES, current * 1e9 / draws, naive * 1e9 / draws, naive / current, picks, sum);
+        rand_utils_alias_free(alias);
+    }
+    free(weights);
+}
+
+int main(void)
+{
+    long sum = 0;
+
+    srand(1);
+    double start = bench_now();
+    for (int i = 0; i < BENCH_DRAWS; i++) sum += bench_legacy_int(0, 999);
+    double legacy = bench_now() - start;
+
+    start = bench_now();
+    for (int i = 0; i < BENCH_DRAWS; i++) sum += rand_utils_int(0, 999);
+    double current = bench_now() - start;
+
+    t_rand_utils_state state;
+    rand_utils_state_seed(&state, 1);
+    start = bench_now();
+    for (int i = 0; i < BENCH_DRAWS; i++) sum += rand_utils_state_int(&state, 0, 999);
+    double explicit_state = bench_now() - start;
+
+    fprintf(stderr, "int, thread state vs rand()  : %6.2f ns vs %6.2f ns  (%.2fx)\n",
+            current * 1e9 / BENCH_DRAWS, legacy * 1e9 / BENCH_DRAWS, legacy / current);
+    fprintf(stderr, "int, explicit state vs rand(): %6.2f ns vs %6.2f ns  (%.2fx)\n",
+            explicit_state * 1e9 / BENCH_DRAWS, legacy * 1e9 / BENCH_DRAWS, legacy / explicit_state);
+
+    double legacy_pi, pi;
+    legacy = bench_threads(bench_legacy_worker, &legacy_pi);
+    current = bench_threads(bench_worker, &pi);
+
+    double again;
+    bench_threads(bench_worker, &again);
+    if (again != pi) fprintf(stderr, "split streams are not reproducible\n");
+
+    fprintf(stderr, "pi, %d threads vs rand()      : %6.3f s vs %6.3f s  (%.2fx, pi %.4f / %.4f, sum %ld)\n",
+            BENCH_THREADS, current, legacy, legacy / current, pi, legacy_pi, sum);
+
+    bench_fill();
+    bench_distributions();
+    return 0;
+}
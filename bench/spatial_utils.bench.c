@@ -0,0 +1,188 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "spatial_utils.h"
+
+#define BENCH_QUERIES 10000
+#define BENCH_BRUTE   100
+#define BENCH_K       8
+
+// Points per unit area stay the same at every size, so a radius-1 query finds about ten of them
+#define BENCH_DENSITY 3.0f
+#define BENCH_RADIUS  1.0f
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static unsigned s_state = 12345;
+
+static float bench_uniform(void)
+{
+    s_state = s_state * 1103515245u + 12345u;
+    return (float)(s_state >> 8) / (float)(1u << 24);
+}
+
+// Uniform over the square, or gathered in 64 tight gaussian clusters within it
+static void bench_points(t_math_utils_vec2* points, size_t count, bool clustered)
+{
+    float side = sqrtf((float)count / BENCH_DENSITY);
+    t_math_utils_vec2 centers[64];
+    for (int i = 0; i < 64; i++) centers[i] = math_utils_vec2(bench_uniform() * side, bench_uniform() * side);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!clustered)
+        {
+            points[i] = math_utils_vec2(bench_uniform() * side, bench_uniform() * side);
+            continue;
+        }
+
+        // Box-Muller, spread a tenth of the cluster spacing
+        float radius = sqrtf(-2.0f * logf(bench_uniform() + 1e-7f)) * side / 80.0f;
+        float angle = bench_uniform() * 6.2831853f;
+        t_math_utils_vec2 center = centers[i % 64];
+        points[i] = math_utils_vec2(center.x + radius * cosf(angle), center.y + radius * sinf(angle));
+    }
+}
+
+static size_t bench_brute_radius(const t_math_utils_vec2* points, size_t count, t_math_utils_vec2 center, uint32_t* out, size_t capacity)
+{
+    size_t found = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        float dx = points[i].x - center.x;
+        float dy = points[i].y - center.y;
+        if (dx * dx + dy * dy <= BENCH_RADIUS * BENCH_RADIUS)
+        {
+            if (found < capacity) out[found] = (uint32_t)i;
+            found++;
+        }
+    }
+    return found;
+}
+
+static void bench_report(const char* name, double seconds, size_t operations, size_t checksum)
+{
+    fprintf(stderr, "  %-26s: %10.1f ns per operation  (checksum %zu)\n", name, seconds * 1e9 / (double)operations, checksum);
+}
+
+static void bench_size(size_t count, bool clustered)
+{
+    t_math_utils_vec2* points = malloc(count * sizeof(t_math_utils_vec2));
+    t_math_utils_vec2* queries = malloc(BENCH_QUERIES * sizeof(t_math_utils_vec2));
+    t_spatial_utils_grid* grid = spatial_utils_grid_new(BENCH_RADIUS);
+    t_spatial_utils_quadtree* tree = spatial_utils_quadtree_new();
+    uint32_t ids[4096];
+    float distances[BENCH_K];
+
+    if (!points || !queries || !grid || !tree)
+    {
+        fprintf(stderr, "Failed to allocate benchmark input\n");
+        exit(1);
+    }
+
+    bench_points(points, count, clustered);
+    // Queries where the points are
+    for (size_t i = 0; i < BENCH_QUERIES; i++) queries[i] = points[(size_t)(bench_uniform() * (float)(count - 1))];
+
+    fprintf(stderr, "%zu points, %s\n", count, clustered ? "clustered" : "uniform");
+
+    double begin = bench_now();
+    spatial_utils_grid_build(grid, points, count);
+    bench_report("grid build", bench_now() - begin, count, spatial_utils_grid_count(grid));
+
+    begin = bench_now();
+    spatial_utils_quadtree_build(tree, points, count);
+    bench_report("quadtree build", bench_now() - begin, count, spatial_utils_quadtree_count(tree));
+
+    size_t checksum = 0;
+    begin = bench_now();
+    for (size_t i = 0; i < BENCH_QUERIES; i++) checksum += spatial_utils_grid_query_radius(grid, queries[i], BENCH_RADIUS, ids, 4096);
+    bench_report("grid radius", bench_now() - begin, BENCH_QUERIES, checksum);
+
+    checksum = 0;
+    begin = bench_now();
+    for (size_t i = 0; i < BENCH_QUERIES; i++) checksum += spatial_utils_quadtree_query_radius(tree, queries[i], BENCH_RADIUS, ids, 4096);
+    bench_report("quadtree radius", bench_now() - begin, BENCH_QUERIES, checksum);
+
+    checksum = 0;
+    begin = bench_now();
+    for (size_t i = 0; i < BENCH_BRUTE; i++) checksum += bench_brute_radius(points, count, queries[i], ids, 4096);
+    bench_report("brute force radius", bench_now() - begin, BENCH_BRUTE, checksum);
+
+    checksum = 0;
+    begin = bench_now();
+    for (size_t i = 0; i < BENCH_QUERIES; i++)
+    {
+        spatial_utils_grid_query_nearest(grid, queries[i], BENCH_K, ids, distances);
+        checksum += ids[BENCH_K - 1];
+    }
+    bench_report("grid 8 nearest", bench_now() - begin, BENCH_QUERIES, checksum);
+
+    checksum = 0;
+    begin = bench_now();
+    for (size_t i = 0; i < BENCH_QUERIES; i++)
+    {
+        spatial_utils_quadtree_query_nearest(tree, queries[i], BENCH_K, ids, distances);
+        checksum += ids[BENCH_K - 1];
+    }
+    bench_report("quadtree 8 nearest", bench_now() - begin, BENCH_QUERIES, checksum);
+
+    checksum = 0;
+    begin = bench_now();
+    for (size_t i = 0; i < BENCH_QUERIES; i++)
+    {
+        t_math_utils_vec2 corner = math_utils_vec2(queries[i].x - BENCH_RADIUS, queries[i].y - BENCH_RADIUS);
+        checksum += spatial_utils_grid_query_box(grid, corner, queries[i], ids, 4096);
+    }
+    bench_report("grid box", bench_now() - begin, BENCH_QUERIES, checksum);
+
+    checksum = 0;
+    begin = bench_now();
+    for (size_t i = 0; i < BENCH_QUERIES; i++)
+    {
+        t_math_utils_vec2 corner = math_utils_vec2(queries[i].x - BENCH_RADIUS, queries[i].y - BENCH_RADIUS);
+        checksum += spatial_utils_quadtree_query_box(tree, corner, queries[i], ids, 4096);
+    }
+    bench_report("quadtree box", bench_now() - begin, BENCH_QUERIES, checksum);
+
+    // One simulation step: every point moves a little, most stay in their cell or leaf
+    for (size_t i = 0; i < count; i++)
+    {
+        points[i].x += (bench_uniform() - 0.5f) * 0.2f;
+        points[i].y += (bench_uniform() - 0.5f) * 0.2f;
+    }
+
+    begin = bench_now();
+    for (size_t i = 0; i < count; i++) spatial_utils_grid_update(grid, (uint32_t)i, points[i]);
+    bench_report("grid update", bench_now() - begin, count, spatial_utils_grid_count(grid));
+
+    begin = bench_now();
+    for (size_t i = 0; i < count; i++) spatial_utils_quadtree_update(tree, (uint32_t)i, points[i]);
+    bench_report("quadtree update", bench_now() - begin, count, spatial_utils_quadtree_count(tree));
+
+    spatial_utils_grid_free(grid);
+    spatial_utils_quadtree_free(tree);
+    free(points);
+    free(queries);
+}
+
+int main(void)
+{
+    static const size_t sizes[] = { 10000, 100000, 1000000 };
+
+    for (int clustered = 0; clustered < 2; clustered++)
+    {
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) bench_size(sizes[i], clustered);
+    }
+
+    return 0;
+}
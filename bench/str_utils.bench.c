@@ -0,0 +1,280 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cpu_utils.h"
+#include "str_utils.h"
+
+#define BENCH_SIZE   (16 * 1024 * 1024)
+#define BENCH_ROUNDS 5
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// CSV-like text: words and numbers separated by commas, one record per line
+static char* bench_make_input(size_t len)
+{
+    static const char* words[] = { "order", "filled", "account", "gateway", "price", "quantity", "buy", "sell" };
+    char* data = malloc(len + 1);
+    if (!data) return NULL;
+
+    size_t n = 0;
+    unsigned state = 12345;
+    while (n < len)
+    {
+        state = state * 1103515245u + 12345u;
+        const char* word = words[(state >> 16) % 8];
+        size_t word_len = strlen(word);
+        char separator = (state >> 8) % 8 == 0 ? '\n' : ',';
+
+        for (size_t i = 0; i < word_len && n < len; i++) data[n++] = word[i];
+        if (n < len) data[n++] = separator;
+    }
+    data[len] = '\0';
+
+    return data;
+}
+
+#define BENCH_BEST(best, result, expr)                         \
+    do                                                         \
+    {                                                          \
+        for (int round_ = 0; round_ < BENCH_ROUNDS; round_++)  \
+        {                                                      \
+            double start_ = bench_now();                       \
+            result = (expr);                                   \
+            double elapsed_ = bench_now() - start_;            \
+            if (round_ == 0 || elapsed_ < best) best = elapsed_; \
+        }                                                      \
+    } while (0)
+
+static size_t bench_count_loop(const char* data, size_t len, char c)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < len; i++) count += data[i] == c;
+    return count;
+}
+
+static size_t bench_split_loop(const char* data, size_t len)
+{
+    size_t fields = 0;
+    size_t start = 0;
+    for (size_t i = 0; i <= len; i++)
+    {
+        if (i == len || data[i] == ',' || data[i] == '\n')
+        {
+            fields += i > start;
+            start = i + 1;
+        }
+    }
+    return fields;
+}
+
+static size_t bench_split_tokenizer(const char* data, size_t len)
+{
+    t_str_utils_tokenizer tokenizer;
+    t_str_utils_view token;
+    size_t fields = 0;
+
+    str_utils_tokenizer_init(&tokenizer, str_utils_view_of(data, len), STR_UTILS_VIEW_LITERAL(",\n"), true);
+    while (str_utils_tokenizer_next(&tokenizer, &token)) fields++;
+    return fields;
+}
+
+// Text with one word in four outside ASCII, 2 to 4 bytes per character
+static char* bench_make_utf8_input(size_t len)
+{
+    static const char* words[] = { "order", "caf\xc3\xa9", "gateway", "\xe2\x82\xac", "price",
+                                   "\xe6\x97\xa5\xe6\x9c\xac", "quantity", "\xf0\x9f\x93\x88" };
+    char* data = malloc(len + 1);
+    if (!data) return NULL;
+
+    size_t n = 0;
+    unsigned state = 54321;
+    while (n < len)
+    {
+        state = state * 1103515245u + 12345u;
+        const char* word = words[(state >> 16) % 8];
+        size_t word_len = strlen(word);
+        if (len - n <= word_len) break;
+
+        memcpy(data + n, word, word_len);
+        n += word_len;
+        data[n++] = ' ';
+    }
+    memset(data + n, ' ', len - n);
+    data[len] = '\0';
+
+    return data;
+}
+
+// Bytewise validation, one character at a time
+static size_t bench_utf8_loop(const unsigned char* data, size_t len)
+{
+    size_t i = 0;
+    while (i < len)
+    {
+        unsigned c = data[i];
+        size_t n = c < 0x80 ? 1 : c < 0xc2 ? 0 : c < 0xe0 ? 2 : c < 0xf0 ? 3 : c < 0xf5 ? 4 : 0;
+        if (!n || len - i < n) return i;
+
+        unsigned low = c == 0xe0 ? 0xa0 : c == 0xf0 ? 0x90 : 0x80;
+        unsigned high = c == 0xed ? 0x9f : c == 0xf4 ? 0x8f : 0xbf;
+        for (size_t k = 1; k < n; k++)
+        {
+            if (data[i + k] < low || data[i + k] > high) return i;
+            low = 0x80;
+            high = 0xbf;
+        }
+        i += n;
+    }
+    return STR_UTILS_NPOS;
+}
+
+static void bench_report(const char* name, double baseline, double current, size_t len)
+{
+    fprintf(stderr, "%-28s: %8.1f MB/s vs %8.1f MB/s libc/loop  (%.2fx)\n",
+            name, (double)len / current / 1e6, (double)len / baseline / 1e6, baseline / current);
+}
+
+#define BENCH_NUMBERS 1000000
+
+// Formats and parses doubles and integers with libc, then with str_utils
+static void bench_numbers(void)
+{
+    double* values = malloc(BENCH_NUMBERS * sizeof(double));
+    char* texts = malloc(BENCH_NUMBERS * (size_t)STR_UTILS_DOUBLE_BUFFER_SIZE);
+    if (!values || !texts)
+    {
+        free(values);
+        free(texts);
+        return;
+    }
+
+    unsigned state = 987654321;
+    for (int i = 0; i < BENCH_NUMBERS; i++)
+    {
+        state = state * 1103515245u + 12345u;
+        values[i] = (double)(state >> 8) / 997.0 * (i % 2 ? 1e-3 : 1e6);
+    }
+
+    char buffer[STR_UTILS_DOUBLE_BUFFER_SIZE];
+    size_t total = 0;
+
+    double start = bench_now();
+    for (int i = 0; i < BENCH_NUMBERS; i++) total += (size_t)snprintf(buffer, sizeof(buffer), "%.17g", values[i]);
+    double printf_time = bench_now() - start;
+
+    start = bench_now();
+    for (int i = 0; i < BENCH_NUMBERS; i++)
+    {
+        char* text = texts + (size_t)i * STR_UTILS_DOUBLE_BUFFER_SIZE;
+        size_t len = str_utils_format_double(text, values[i]);
+        text[len] = '\0';
+        total += len;
+    }
+    double format_time = bench_now() - start;
+
+    double sum = 0.0;
+    start = bench_now();
+    for (int i = 0; i < BENCH_NUMBERS; i++) sum += strtod(texts + (size_t)i * STR_UTILS_DOUBLE_BUFFER_SIZE, NULL);
+    double strtod_time = bench_now() - start;
+
+    start = bench_now();
+    for (int i = 0; i < BENCH_NUMBERS; i++)
+    {
+        const char* text = texts + (size_t)i * STR_UTILS_DOUBLE_BUFFER_SIZE;
+        double value = 0.0;
+        str_utils_parse_double(text, strlen(text), &value);
+        sum += value;
+    }
+    double parse_time = bench_now() - start;
+
+    start = bench_now();
+    for (int i = 0; i < BENCH_NUMBERS; i++) total += (size_t)snprintf(buffer, sizeof(buffer), "%d", i * 1999);
+    double int_printf_time = bench_now() - start;
+
+    start = bench_now();
+    for (int i = 0; i < BENCH_NUMBERS; i++) total += str_utils_format_i64(buffer, i * 1999);
+    double int_format_time = bench_now() - start;
+
+    fprintf(stderr, "format_double vs %%.17g     : %8.1f ns vs %8.1f ns  (%.2fx)\n",
+            format_time * 1e9 / BENCH_NUMBERS, printf_time * 1e9 / BENCH_NUMBERS, printf_time / format_time);
+    fprintf(stderr, "parse_double vs strtod     : %8.1f ns vs %8.1f ns  (%.2fx)\n",
+            parse_time * 1e9 / BENCH_NUMBERS, strtod_time * 1e9 / BENCH_NUMBERS, strtod_time / parse_time);
+    fprintf(stderr, "format_i64 vs %%d           : %8.1f ns vs %8.1f ns  (%.2fx, %zu bytes, sum %g)\n",
+            int_format_time * 1e9 / BENCH_NUMBERS, int_printf_time * 1e9 / BENCH_NUMBERS,
+            int_printf_time / int_format_time, total, sum);
+
+    free(values);
+    free(texts);
+}
+
+int main(void)
+{
+    char* data = bench_make_input(BENCH_SIZE);
+    if (!data)
+    {
+        fprintf(stderr, "Failed to allocate benchmark input\n");
+        return 1;
+    }
+
+    static const char* levels[] = { "scalar", "sse2", "sse4.2", "avx2", "avx512" };
+    fprintf(stderr, "SIMD level: %s, %d MiB input\n", levels[cpu_utils_level()], BENCH_SIZE >> 20);
+
+    t_str_utils_view text = str_utils_view_of(data, BENCH_SIZE);
+    double baseline = 0.0, current = 0.0;
+    size_t expected = 0, result = 0;
+
+    // Absent needles scan the whole input
+    const char* needle = "account,gateway,price,sold";
+    const char* found = NULL;
+    BENCH_BEST(baseline, found, strstr(data, needle));
+    expected = found ? (size_t)(found - data) : STR_UTILS_NPOS;
+    BENCH_BEST(current, result, str_utils_view_find(text, str_utils_view(needle)));
+    if (result != expected) fprintf(stderr, "find mismatch\n");
+    bench_report("find vs strstr", baseline, current, BENCH_SIZE);
+
+    BENCH_BEST(baseline, found, strpbrk(data, "|;#@"));
+    expected = found ? (size_t)(found - data) : STR_UTILS_NPOS;
+    BENCH_BEST(current, result, str_utils_view_find_any(text, STR_UTILS_VIEW_LITERAL("|;#@")));
+    if (result != expected) fprintf(stderr, "find_any mismatch\n");
+    bench_report("find_any vs strpbrk", baseline, current, BENCH_SIZE);
+
+    BENCH_BEST(baseline, expected, bench_count_loop(data, BENCH_SIZE, '\n'));
+    BENCH_BEST(current, result, str_utils_view_count(text, STR_UTILS_VIEW_LITERAL("\n")));
+    if (result != expected) fprintf(stderr, "count mismatch\n");
+    bench_report("count vs byte loop", baseline, current, BENCH_SIZE);
+
+    BENCH_BEST(baseline, expected, bench_split_loop(data, BENCH_SIZE));
+    BENCH_BEST(current, result, bench_split_tokenizer(data, BENCH_SIZE));
+    if (result != expected) fprintf(stderr, "tokenizer mismatch\n");
+    bench_report("tokenizer vs byte loop", baseline, current, BENCH_SIZE);
+
+    BENCH_BEST(baseline, expected, bench_utf8_loop((const unsigned char*)data, BENCH_SIZE));
+    BENCH_BEST(current, result, str_utils_utf8_find_invalid(text, NULL));
+    if (result != expected) fprintf(stderr, "utf8 ascii mismatch\n");
+    bench_report("utf8 validate (ascii)", baseline, current, BENCH_SIZE);
+
+    free(data);
+
+    data = bench_make_utf8_input(BENCH_SIZE);
+    if (data)
+    {
+        text = str_utils_view_of(data, BENCH_SIZE);
+        BENCH_BEST(baseline, expected, bench_utf8_loop((const unsigned char*)data, BENCH_SIZE));
+        BENCH_BEST(current, result, str_utils_utf8_find_invalid(text, NULL));
+        if (result != expected) fprintf(stderr, "utf8 mixed mismatch\n");
+        bench_report("utf8 validate (mixed)", baseline, current, BENCH_SIZE);
+        free(data);
+    }
+
+    bench_numbers();
+    return 0;
+}
@@ -0,0 +1,145 @@
+#ifndef ALLOC_UTILS_H
+#define ALLOC_UTILS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @file alloc_utils.h
+ * @brief Pluggable allocators: a vtable, the default malloc one, a bump arena and a thread-local pool.
+ *
+ * Objects created with a `_with_allocator` constructor, or with an
+ * allocator in their options, take all the memory they keep from it. NULL
+ * selects alloc_utils_default(). Memory handed over to the caller, such as
+ * key arrays and duplicated strings, still comes from malloc unless a
+ * function says otherwise, so free() keeps working on it.
+ *
+ * Frees and reallocations pass the size of the block, as given when it was
+ * allocated or last reallocated: pools find the size class from it, and
+ * arenas can give back or grow their last block in place.
+ */
+
+/**
+ * @brief Allocator vtable.
+ *
+ * Blocks are aligned for any type (max_align_t). alloc and realloc return
+ * NULL on failure, leaving the old block intact. realloc with a NULL
+ * pointer allocates; free ignores NULL.
+ */
+typedef struct t_alloc_utils
+{
+    void* (*alloc)(void* context, size_t size);
+    void* (*realloc)(void* context, void* pointer, size_t old_size, size_t new_size);
+    void  (*free)(void* context, void* pointer, size_t size);
+    void* context;
+} t_alloc_utils;
+
+/**
+ * @brief Returns the process-wide default allocator, backed by malloc, realloc and free.
+ */
+const t_alloc_utils* alloc_utils_default(void);
+
+/**
+ * @brief Returns allocator, or the default allocator when it is NULL.
+ */
+static inline const t_alloc_utils* alloc_utils_or_default(const t_alloc_utils* allocator)
+{
+    return allocator ? allocator : alloc_utils_default();
+}
+
+static inline void* alloc_utils_alloc(const t_alloc_utils* allocator, size_t size)
+{
+    return allocator->alloc(allocator->context, size);
+}
+
+static inline void* alloc_utils_realloc(const t_alloc_utils* allocator, void* pointer, size_t old_size, size_t new_size)
+{
+    return allocator->realloc(allocator->context, pointer, old_size, new_size);
+}
+
+static inline void alloc_utils_free(const t_alloc_utils* allocator, void* pointer, size_t size)
+{
+    allocator->free(allocator->context, pointer, size);
+}
+
+/**
+ * @brief Allocates count zeroed elements of size bytes.
+ *
+ * @return The block, of count * size bytes, or NULL on overflow or allocation failure.
+ */
+static inline void* alloc_utils_calloc(const t_alloc_utils* allocator, size_t count, size_t size)
+{
+    if (size && count > SIZE_MAX / size) return NULL;
+
+    void* pointer = alloc_utils_alloc(allocator, count * size);
+    if (pointer) memset(pointer, 0, count * size);
+    return pointer;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Bump arena                                                                 */
+/* -------------------------------------------------------------------------- */
+
+typedef struct t_alloc_utils_arena t_alloc_utils_arena;
+
+/**
+ * @brief Creates an arena that hands out memory by bumping a pointer through malloc'ed chunks.
+ *
+ * Freeing is a no-op except for the last block, which is also the only one
+ * realloc grows in place: everything is released at once by
+ * alloc_utils_arena_reset() or alloc_utils_arena_free(). Blocks larger
+ * than a quarter of a chunk get a chunk of their own. An arena is not
+ * thread-safe.
+ *
+ * @param chunk_size Bytes per chunk. 0 selects 64 KiB.
+ * @return Pointer to the new arena, or NULL on allocation failure.
+ */
+t_alloc_utils_arena* alloc_utils_arena_new(size_t chunk_size);
+
+/**
+ * @brief Frees an arena and every block allocated from it.
+ */
+void alloc_utils_arena_free(t_alloc_utils_arena* arena);
+
+/**
+ * @brief Releases every block at once, keeping the regular chunks for reuse.
+ *
+ * Objects still using the arena must not be touched afterwards, not even
+ * to free them.
+ */
+void alloc_utils_arena_reset(t_alloc_utils_arena* arena);
+
+/**
+ * @brief Returns the allocator interface of an arena, valid as long as the arena.
+ */
+const t_alloc_utils* alloc_utils_arena_allocator(t_alloc_utils_arena* arena);
+
+/**
+ * @brief Returns the number of bytes handed out since the last reset, padding included.
+ */
+size_t alloc_utils_arena_used(const t_alloc_utils_arena* arena);
+
+/* -------------------------------------------------------------------------- */
+/* Thread-local pool                                                          */
+/* -------------------------------------------------------------------------- */
+
+// Blocks up to this size come from the pool; larger ones go to malloc
+#define ALLOC_UTILS_POOL_MAX_SIZE 1024
+
+/**
+ * @brief Returns the thread-local pool allocator.
+ *
+ * Small blocks are rounded up to one of 11 size classes and served from
+ * free lists of the calling thread, without locking; freeing pushes the
+ * block onto the free list of the thread that frees it. Free lists of
+ * exited threads are handed over to the next thread that starts using the
+ * pool. Pool memory is kept for reuse and never returned to the system.
+ *
+ * The pool suits many short-lived small objects, such as list nodes and
+ * hashtable entries: allocation and free are a few instructions.
+ */
+const t_alloc_utils* alloc_utils_pool(void);
+
+#endif /* ALLOC_UTILS_H */
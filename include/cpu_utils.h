@@ -0,0 +1,30 @@
+#ifndef CPU_UTILS_H
+#define CPU_UTILS_H
+
+/**
+ * @file cpu_utils.h
+ * @brief Runtime detection of the SIMD instruction sets used by the library.
+ *
+ * Vectorized routines pick their implementation from cpu_utils_level().
+ * Setting the environment variable VFC_UTILS_SIMD to "scalar", "sse2",
+ * "sse4.2", "avx2" or "avx512" caps the detected level, which is useful to
+ * compare implementations or to test the fallbacks.
+ */
+
+typedef enum e_cpu_utils_level
+{
+    CPU_UTILS_SCALAR = 0,
+    CPU_UTILS_SSE2,
+    CPU_UTILS_SSE42,
+    CPU_UTILS_AVX2,
+    CPU_UTILS_AVX512   /**< AVX-512 F, BW and VL */
+} e_cpu_utils_level;
+
+/**
+ * @brief Returns the highest instruction set level usable on this machine.
+ *
+ * Detection runs once; later calls return the cached result.
+ */
+e_cpu_utils_level cpu_utils_level(void);
+
+#endif /* CPU_UTILS_H */
@@ -5,6 +5,9 @@
 #include <stdbool.h>
 #include <string.h>
 
+#include "alloc_utils.h"
+#include "str_utils.h"
+
 typedef struct t_hashtable t_hashtable;
 typedef struct t_hashtable_entry t_hashtable_entry;
 typedef char   t_hashtable_key;
@@ -28,6 +31,19 @@ typedef unsigned int (*hash_function)(char*);
  */
 t_hashtable* hashtable_new(size_t size, hash_function f);
 
+/**
+ * @brief Creates a new hashtable whose buckets and entries come from allocator.
+ *
+ * Arrays returned by hashtable_keys(), hashtable_values() and the like are
+ * still malloc'ed, for the caller to free().
+ *
+ * @param size Number of buckets in the hashtable.
+ * @param f Pointer to a hash function that maps keys to integer hash values.
+ * @param allocator Allocator of the hashtable and its entries. NULL selects alloc_utils_default().
+ * @return Pointer to the newly created hashtable, or NULL if memory allocation fails.
+ */
+t_hashtable* hashtable_new_with_allocator(size_t size, hash_function f, const t_alloc_utils* allocator);
+
 /**
  * @brief Frees all memory associated with a hashtable.
  *
@@ -48,6 +64,18 @@ void hashtable_free(t_hashtable* hashtable, void (free_value)(void*));
  */
 t_hashtable_value* hashtable_entry_get(t_hashtable* hashtable, char* key);
 
+/**
+ * @brief Retrieves the value of a key given as a view, such as a slice of a larger buffer.
+ *
+ * The hash function still receives a NUL-terminated key: views are copied
+ * to a stack buffer for hashing, or to the heap beyond 255 bytes.
+ *
+ * @param hashtable Pointer to the hashtable.
+ * @param key Key bytes; the null view is rejected.
+ * @return Pointer to the value if found, NULL otherwise.
+ */
+t_hashtable_value* hashtable_entry_get_view(t_hashtable* hashtable, t_str_utils_view key);
+
 /**
  * @brief Inserts a new key-value pair or updates an existing one in the hashtable.
  *
@@ -60,6 +88,13 @@ t_hashtable_value* hashtable_entry_get(t_hashtable* hashtable, char* key);
  */
 bool hashtable_entry_set(t_hashtable* hashtable, char* key, void* value);
 
+/**
+ * @brief Inserts or updates a key given as a view, copied only when a new entry is added.
+ *
+ * @return true if a new entry was added or an existing value updated, false on allocation failure.
+ */
+bool hashtable_entry_set_view(t_hashtable* hashtable, t_str_utils_view key, void* value);
+
 /**
  * @brief Returns the number of buckets in the hashtable.
  *
@@ -78,6 +113,18 @@ size_t hashtable_entries_count(t_hashtable* hashtable);
  */
 t_hashtable_key** hashtable_keys(t_hashtable* hashtable);
 
+/**
+ * @brief Returns views of all keys, without copying them.
+ *
+ * The views point to the keys stored in the hashtable and stay valid until
+ * it is freed; only the array must be freed by the caller.
+ *
+ * @param hashtable Pointer to the hashtable.
+ * @param count Receives the number of keys. Can be NULL.
+ * @return Array of count views, or NULL on failure or if hashtable is NULL.
+ */
+t_str_utils_view* hashtable_key_views(t_hashtable* hashtable, size_t* count);
+
 /**
  * @brief Returns a NULL-terminated array of all values in the hashtable.
  *
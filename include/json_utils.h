@@ -1,6 +1,375 @@
 #ifndef JSON_UTILS_H
 #define JSON_UTILS_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "alloc_utils.h"
+#include "str_utils.h"
+
+/**
+ * @brief Returns a newly allocated JSON-escaped copy of a string, without quotes.
+ *
+ * @param str String to escape. NULL yields "null".
+ * @return The escaped string, to be freed by the caller, or NULL on allocation failure.
+ */
 char* json_utils_escape(const char* str);
 
+/**
+ * @brief Writes the JSON-escaped form of str into a caller buffer, without allocating.
+ *
+ * Writes at most capacity bytes and no NUL terminator. Clean runs are found
+ * 16 or 32 bytes at a time and copied whole.
+ *
+ * @return The full escaped length, which exceeds capacity when the output was truncated.
+ *         At most 6 * len.
+ */
+size_t json_utils_escape_into(char* dst, size_t capacity, const char* str, size_t len);
+
+/**
+ * @brief Same as json_utils_escape_into(), replacing each ill-formed UTF-8 sequence with U+FFFD.
+ *
+ * The output is valid UTF-8, hence valid JSON, whatever the input. Valid
+ * text costs one vectorized validation pass on top of the escaping.
+ *
+ * @return The full escaped length, which exceeds capacity when the output was truncated.
+ *         At most 6 * len.
+ */
+size_t json_utils_escape_utf8_into(char* dst, size_t capacity, const char* str, size_t len);
+
+/* -------------------------------------------------------------------------- */
+/* Writer                                                                     */
+/* -------------------------------------------------------------------------- */
+
+typedef struct t_json_utils_writer t_json_utils_writer;
+
+/**
+ * @brief Creates a JSON writer producing compact output into a growable buffer.
+ *
+ * Commas are inserted automatically; call order is not validated. Strings
+ * are escaped straight into the buffer and numbers are converted without
+ * snprintf, so once the buffer has grown to the document size, writing the
+ * next document after json_utils_writer_reset() does not allocate.
+ *
+ * Calls return false on allocation failure, which is sticky until reset.
+ *
+ * @param capacity Initial buffer capacity in bytes. 0 selects a default.
+ * @return Pointer to the new writer, or NULL on allocation failure.
+ */
+t_json_utils_writer* json_utils_writer_new(size_t capacity);
+
+/**
+ * @brief Creates a JSON writer whose structure and buffer come from allocator.
+ *
+ * @param capacity Initial buffer capacity in bytes. 0 selects a default.
+ * @param allocator Allocator of the writer. NULL selects alloc_utils_default().
+ * @return Pointer to the new writer, or NULL on allocation failure.
+ */
+t_json_utils_writer* json_utils_writer_new_with_allocator(size_t capacity, const t_alloc_utils* allocator);
+
+/**
+ * @brief Frees a writer and its buffer.
+ */
+void json_utils_writer_free(t_json_utils_writer* writer);
+
+/**
+ * @brief Empties the writer for a new document, keeping its buffer.
+ */
+void json_utils_writer_reset(t_json_utils_writer* writer);
+
+/**
+ * @brief Makes the writer replace ill-formed UTF-8 in keys and strings with U+FFFD.
+ *
+ * Off by default: bytes are then copied unchecked, and invalid input yields invalid JSON.
+ * The setting survives json_utils_writer_reset().
+ */
+void json_utils_writer_set_replace_invalid_utf8(t_json_utils_writer* writer, bool enabled);
+
+/**
+ * @brief Returns the NUL-terminated output written so far.
+ *
+ * @param len Receives the output length. Can be NULL.
+ * @return Pointer valid until the next write or reset, or NULL after an allocation failure.
+ */
+const char* json_utils_writer_data(t_json_utils_writer* writer, size_t* len);
+
+bool json_utils_writer_begin_object(t_json_utils_writer* writer);
+bool json_utils_writer_end_object(t_json_utils_writer* writer);
+bool json_utils_writer_begin_array(t_json_utils_writer* writer);
+bool json_utils_writer_end_array(t_json_utils_writer* writer);
+
+/**
+ * @brief Writes an object key; the next call writes its value.
+ */
+bool json_utils_writer_key(t_json_utils_writer* writer, const char* key);
+
+/**
+ * @brief Writes an object key given as a view, which may contain NUL bytes.
+ */
+bool json_utils_writer_key_view(t_json_utils_writer* writer, t_str_utils_view key);
+
+/**
+ * @brief Writes a string value. NULL writes null.
+ */
+bool json_utils_writer_string(t_json_utils_writer* writer, const char* value);
+
+/**
+ * @brief Writes a string value given as a view. The null view writes null.
+ */
+bool json_utils_writer_string_view(t_json_utils_writer* writer, t_str_utils_view value);
+
+bool json_utils_writer_int(t_json_utils_writer* writer, int64_t value);
+
+/**
+ * @brief Writes a number. NaN and infinities, which JSON cannot represent, write null.
+ */
+bool json_utils_writer_double(t_json_utils_writer* writer, double value);
+
+bool json_utils_writer_bool(t_json_utils_writer* writer, bool value);
+bool json_utils_writer_null(t_json_utils_writer* writer);
+
+/**
+ * @brief Result of a parsing call.
+ */
+typedef enum e_json_utils_status
+{
+    JSON_UTILS_OK = 0,
+    JSON_UTILS_ERROR_SYNTAX,           /**< Input is not valid JSON. */
+    JSON_UTILS_ERROR_DEPTH,            /**< Nesting deeper than the configured maximum. */
+    JSON_UTILS_ERROR_TOKEN_TOO_LARGE,  /**< A string or number split across chunks exceeds the token limit. */
+    JSON_UTILS_ERROR_INCOMPLETE,       /**< Input ended inside a value. */
+    JSON_UTILS_ERROR_ABORTED,          /**< A callback returned false. */
+    JSON_UTILS_ERROR_MEMORY            /**< Allocation failure. */
+} e_json_utils_status;
+
+/**
+ * @brief Returns a static, human-readable description of a status.
+ */
+const char* json_utils_status_string(e_json_utils_status status);
+
+/* -------------------------------------------------------------------------- */
+/* Streaming (SAX) parser                                                     */
+/* -------------------------------------------------------------------------- */
+
+typedef struct t_json_utils_parser t_json_utils_parser;
+
+/**
+ * @brief Event callbacks of the streaming parser.
+ *
+ * Any callback can be NULL. Returning false stops parsing with
+ * JSON_UTILS_ERROR_ABORTED. Strings and keys are unescaped UTF-8, not
+ * NUL-terminated, and only valid during the callback. Numbers are passed as
+ * their validated JSON text.
+ */
+typedef struct t_json_utils_callbacks
+{
+    bool (*on_object_begin)(void* context);
+    bool (*on_object_end)(void* context);
+    bool (*on_array_begin)(void* context);
+    bool (*on_array_end)(void* context);
+    bool (*on_key)(void* context, const char* key, size_t len);
+    bool (*on_string)(void* context, const char* value, size_t len);
+    bool (*on_number)(void* context, const char* text, size_t len);
+    bool (*on_bool)(void* context, bool value);
+    bool (*on_null)(void* context);
+    bool (*on_document_end)(void* context);  /**< After each complete top-level value. */
+} t_json_utils_callbacks;
+
+/**
+ * @brief Parser limits and modes. Zero-initialized fields select the defaults.
+ */
+typedef struct t_json_utils_parser_options
+{
+    size_t max_depth;       /**< Maximum nesting of objects and arrays. Default: 1024. */
+    size_t max_token_size;  /**< Maximum size of a string or number split across chunks. Default: 1 MiB. */
+    bool   multiple_values; /**< Accept a stream of whitespace-separated values, such as NDJSON. */
+    const t_alloc_utils* allocator;  /**< Allocator of the parser and its buffers. Default: alloc_utils_default(). */
+} t_json_utils_parser_options;
+
+/**
+ * @brief Creates a streaming parser.
+ *
+ * Memory use is bounded by max_depth bytes of nesting state plus one token
+ * buffer of at most max_token_size bytes, whatever the input size.
+ *
+ * @param callbacks Event callbacks, copied into the parser.
+ * @param context Opaque pointer passed to every callback.
+ * @param options Limits and modes. Can be NULL for defaults.
+ * @return Pointer to the new parser, or NULL on allocation failure.
+ */
+t_json_utils_parser* json_utils_parser_new(const t_json_utils_callbacks* callbacks, void* context,
+                                           const t_json_utils_parser_options* options);
+
+/**
+ * @brief Frees a parser.
+ */
+void json_utils_parser_free(t_json_utils_parser* parser);
+
+/**
+ * @brief Feeds the next chunk of input.
+ *
+ * Chunks can split the input anywhere, including inside tokens. After an
+ * error, every call returns the same error until json_utils_parser_reset().
+ *
+ * @return JSON_UTILS_OK, or the error that stopped parsing.
+ */
+e_json_utils_status json_utils_parser_feed(t_json_utils_parser* parser, const char* data, size_t len);
+
+/**
+ * @brief Signals the end of input.
+ *
+ * @return JSON_UTILS_OK if the input formed complete value(s), an error otherwise.
+ */
+e_json_utils_status json_utils_parser_finish(t_json_utils_parser* parser);
+
+/**
+ * @brief Returns a parser to its initial state, keeping its callbacks and options.
+ */
+void json_utils_parser_reset(t_json_utils_parser* parser);
+
+/**
+ * @brief Returns the number of input bytes consumed, or the offset of the error.
+ */
+size_t json_utils_parser_offset(const t_json_utils_parser* parser);
+
+/* -------------------------------------------------------------------------- */
+/* Document (DOM) parser                                                      */
+/* -------------------------------------------------------------------------- */
+
+typedef struct t_json_utils_document t_json_utils_document;
+typedef struct t_json_utils_value t_json_utils_value;
+
+typedef enum e_json_utils_type
+{
+    JSON_UTILS_TYPE_NULL = 0,
+    JSON_UTILS_TYPE_BOOL,
+    JSON_UTILS_TYPE_NUMBER,
+    JSON_UTILS_TYPE_STRING,
+    JSON_UTILS_TYPE_ARRAY,
+    JSON_UTILS_TYPE_OBJECT
+} e_json_utils_type;
+
+/**
+ * @brief Document parsing modes. Zero-initialized fields select the defaults.
+ */
+typedef struct t_json_utils_document_options
+{
+    size_t max_depth;  /**< Maximum nesting of objects and arrays. Default: 1024. */
+    bool   on_demand;  /**< Materialize objects and arrays only when first accessed. */
+    const t_alloc_utils* allocator;  /**< Allocator of the document and its index. Default: alloc_utils_default(). */
+} t_json_utils_document_options;
+
+/**
+ * @brief Parses a complete JSON document into a tree.
+ *
+ * Every node and decoded string is allocated from an arena owned by the
+ * document, so json_utils_document_free() releases it all at once. Strings
+ * without escapes point straight into data, which must outlive the document.
+ *
+ * In on-demand mode, the input is only indexed and checked for matching
+ * brackets; each object or array is parsed the first time it is accessed, and
+ * subtrees never visited are never built. Errors inside them are then only
+ * found on access: the accessor returns NULL and json_utils_document_status()
+ * reports the error. Accessing an on-demand document mutates it, so it must
+ * not be shared between threads without locking.
+ *
+ * @param data Input text. Does not need to be NUL-terminated.
+ * @param len Input size in bytes, below 4 GiB.
+ * @param options Limits and modes. Can be NULL for defaults.
+ * @param status Receives the parsing result. Can be NULL.
+ * @return Pointer to the new document, or NULL on error.
+ */
+t_json_utils_document* json_utils_document_parse(const char* data, size_t len,
+                                                 const t_json_utils_document_options* options,
+                                                 e_json_utils_status* status);
+
+/**
+ * @brief Frees a document and every value obtained from it.
+ */
+void json_utils_document_free(t_json_utils_document* document);
+
+/**
+ * @brief Returns the root value of a document.
+ */
+t_json_utils_value* json_utils_document_root(t_json_utils_document* document);
+
+/**
+ * @brief Returns JSON_UTILS_OK, or the first error met while materializing on-demand values.
+ */
+e_json_utils_status json_utils_document_status(const t_json_utils_document* document);
+
+/**
+ * @brief Returns the type of a value. A NULL value reads as JSON_UTILS_TYPE_NULL.
+ */
+e_json_utils_type json_utils_value_type(const t_json_utils_value* value);
+
+/**
+ * @brief Returns a boolean value, or false if the value is not a boolean.
+ */
+bool json_utils_value_bool(const t_json_utils_value* value);
+
+/**
+ * @brief Returns a number as a double, or 0.0 if the value is not a number.
+ */
+double json_utils_value_double(const t_json_utils_value* value);
+
+/**
+ * @brief Reads a number as a 64-bit integer.
+ *
+ * @return true if the number is written as an integer that fits in int64_t.
+ */
+bool json_utils_value_int(const t_json_utils_value* value, int64_t* out);
+
+/**
+ * @brief Returns the unescaped UTF-8 bytes of a string, not NUL-terminated.
+ *
+ * @param len Receives the length in bytes. Can be NULL.
+ * @return Pointer valid until the document is freed, or NULL if the value is not a string.
+ */
+const char* json_utils_value_string(const t_json_utils_value* value, size_t* len);
+
+/**
+ * @brief Returns a string value as a view, or the null view if the value is not a string.
+ */
+t_str_utils_view json_utils_value_string_view(const t_json_utils_value* value);
+
+/**
+ * @brief Returns the number of items of an array or members of an object, 0 for other values.
+ */
+size_t json_utils_value_count(t_json_utils_value* value);
+
+/**
+ * @brief Returns an array item, or NULL if out of range or not an array.
+ */
+t_json_utils_value* json_utils_array_get(t_json_utils_value* array, size_t index);
+
+/**
+ * @brief Looks up an object member by key.
+ *
+ * Small objects are searched linearly; larger ones are given a hash index
+ * when they are built. With duplicate keys, the first member wins.
+ *
+ * @return The member value, or NULL if absent or not an object.
+ */
+t_json_utils_value* json_utils_object_get(t_json_utils_value* object, const char* key);
+
+/**
+ * @brief Looks up an object member by a key given as a view, such as a slice of a path.
+ */
+t_json_utils_value* json_utils_object_get_view(t_json_utils_value* object, t_str_utils_view key);
+
+/**
+ * @brief Returns the key of the member at index, in document order.
+ *
+ * @param len Receives the key length in bytes. Can be NULL.
+ * @return The key, not NUL-terminated, or NULL if out of range or not an object.
+ */
+const char* json_utils_object_key_at(t_json_utils_value* object, size_t index, size_t* len);
+
+/**
+ * @brief Returns the value of the member at index, in document order.
+ */
+t_json_utils_value* json_utils_object_value_at(t_json_utils_value* object, size_t index);
+
 #endif /* JSON_UTILS_H */
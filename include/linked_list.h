@@ -4,6 +4,9 @@
 #include <stdlib.h>
 #include <stdbool.h>
 
+#include "alloc_utils.h"
+#include "rand_utils.h"
+
 /**
  * @file linked_list.h
  * @brief Generic doubly linked list implementation in C.
@@ -29,6 +32,16 @@ typedef bool (*linked_list_select_fn) (t_linked_list_node*, void*);
  */
 t_linked_list* linked_list_new();
 
+/**
+ * @brief Creates a new linked list whose structure and nodes come from allocator.
+ *
+ * Lists created from this one, such as by linked_list_select(), use the same allocator.
+ *
+ * @param allocator Allocator of the list and its nodes. NULL selects alloc_utils_default().
+ * @return Pointer to a newly allocated linked list, or NULL on allocation failure.
+ */
+t_linked_list* linked_list_new_with_allocator(const t_alloc_utils* allocator);
+
 /**
  * @brief Creates a new linked list from a NULL-terminated array of values.
  *
@@ -64,6 +77,15 @@ t_linked_list* linked_list_new_from_array(void** array, size_t count);
  */
 void linked_list_free(t_linked_list *list, linked_list_on_free on_free);
 
+/**
+ * @brief Frees a node detached by linked_list_remove() or linked_list_remove_at().
+ *
+ * @param list The list the node was removed from, whose allocator owns it.
+ * @param node Pointer to the node to free.
+ * @param on_free Pointer to a callback function to free the value. Can be NULL.
+ */
+void linked_list_node_free(t_linked_list *list, t_linked_list_node *node, linked_list_on_free on_free);
+
 /**
  * @brief Appends a new node to the end of the list.
  *
@@ -212,6 +234,21 @@ t_linked_list_node* linked_list_at(t_linked_list* list, int index);
  */
 t_linked_list_node* linked_list_random(t_linked_list* list);
 
+/**
+ * @brief Picks k distinct nodes uniformly at random, every subset being equally likely.
+ *
+ * Indices are drawn with Floyd's algorithm in O(k) draws, then the list is
+ * walked once up to the last chosen node, instead of one walk per node as
+ * with repeated linked_list_random() calls.
+ *
+ * @param list Pointer to the linked list.
+ * @param k Number of nodes to pick; the whole list if k >= its count.
+ * @param out Array of at least min(k, count) pointers, filled in list order.
+ * @param state Generator, or NULL for the generator of the calling thread.
+ * @return Number of nodes written to out, or 0 on allocation failure.
+ */
+size_t linked_list_sample(t_linked_list* list, size_t k, t_linked_list_node** out, t_rand_utils_state* state);
+
 /**
  * @brief Iterates through all nodes in the list.
  *
@@ -257,6 +294,14 @@ void* linked_list_find(t_linked_list* list, linked_list_find_fn find_fn, void* c
  */
 t_linked_list* linked_list_select(t_linked_list* list, linked_list_select_fn select_fn, void* context);
 
-void linked_list_concat(t_linked_list* list1, t_linked_list* list2);
+/**
+ * @brief Moves all nodes of list2 to the end of list1, leaving list2 empty.
+ *
+ * When the lists use different allocators, the nodes of list2 are copied
+ * into list1's allocator and the originals freed.
+ *
+ * @return true on success, false if a list is NULL or on allocation failure, leaving both lists unchanged.
+ */
+bool linked_list_concat(t_linked_list* list1, t_linked_list* list2);
 
 #endif /* LINKED_LIST_H */
@@ -1,6 +1,13 @@
 #ifndef LOG_UTILS_H
 #define LOG_UTILS_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "log_utils_sink.h"
+#include "str_utils.h"
+
 typedef int t_log_utils_level;
 
 // Public constants for log levels
@@ -9,10 +16,149 @@ extern const t_log_utils_level LOG_UTILS_INFO;
 extern const t_log_utils_level LOG_UTILS_WARN;
 extern const t_log_utils_level LOG_UTILS_ERROR;
 
+// Same levels as integer constant expressions, for the preprocessor and the macros below
+#define LOG_UTILS_LEVEL_DEBUG 0
+#define LOG_UTILS_LEVEL_INFO  1
+#define LOG_UTILS_LEVEL_WARN  2
+#define LOG_UTILS_LEVEL_ERROR 3
+
+// Calls below this level are compiled out of the LOG_UTILS_LOG_* macros
+#ifndef LOG_UTILS_COMPILE_MIN_LEVEL
+#define LOG_UTILS_COMPILE_MIN_LEVEL LOG_UTILS_LEVEL_DEBUG
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LOG_UTILS_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define LOG_UTILS_UNLIKELY(x) (x)
+#endif
+
+// Runtime minimum level; read it through log_utils_is_enabled()
+extern t_log_utils_level log_utils_runtime_min_level;
+
 void log_utils_set_min_level(t_log_utils_level level);
+
+// Whether a message of this level passes the minimum level (ERROR always does)
+static inline bool log_utils_is_enabled(t_log_utils_level level)
+{
+    return level >= LOG_UTILS_LEVEL_ERROR || level >= log_utils_runtime_min_level;
+}
+
+// Routes log lines to sink (NULL restores stdout). The caller keeps ownership of the sink.
+// Returns once no thread is writing to the previous sink any more, which the caller may
+// then free. Must not be called from a sink callback, which would wait for itself.
+void log_utils_set_sink(t_log_utils_sink* sink);
+// Reports outstanding suppressed counts, then flushes the sink
+void log_utils_flush(void);
+
+// Replaces ill-formed UTF-8 in logged strings with U+FFFD so every line is valid JSON
+// (default: off, bytes are copied unchecked)
+void log_utils_set_replace_invalid_utf8(bool enabled);
+
+// Allocator of the heap buffers of messages too long for the thread-local line buffers
+// (NULL restores alloc_utils_default()). It must be thread-safe, such as alloc_utils_pool(),
+// and stay valid while installed.
+void log_utils_set_allocator(const t_alloc_utils* allocator);
+
+/*
+ * Flood control, applied per (context, level) before a message is formatted.
+ * Dropped messages are counted and reported as a "suppressed N messages"
+ * line of the same context and level, at most once per summary interval.
+ * Counts left when the flood stops are reported by log_utils_flush(), which
+ * also runs at exit once flood control has been enabled.
+ */
+
+// Token bucket: rate messages per second on average, bursts of up to burst. rate <= 0 disables it.
+void log_utils_set_rate_limit(double rate, double burst);
+// Keeps one message in every_n of the level; 0 or 1 keeps them all.
+void log_utils_set_sampling(t_log_utils_level level, unsigned every_n);
+// Minimum delay between two summaries of the same key (default: 10 seconds).
+void log_utils_set_summary_interval(unsigned seconds);
+
 void log_utils_debug(const char* context, const char* format, ...);
 void log_utils_info(const char* context, const char* format, ...);
 void log_utils_warn(const char* context, const char* format, ...);
 void log_utils_error(const char* context, const char* format, ...);
 
+// Logs without checking the minimum level; the macros below call it once the level passed
+void log_utils_emit(t_log_utils_level level, const char* context, const char* format, ...);
+
+/*
+ * Structured events: typed fields are written as JSON members next to
+ * timestamp, level and context, without going through printf. A field
+ * named timestamp, level, context or content is written with the
+ * LOG_UTILS_FIELD_RESERVED_PREFIX ("field.level"), so it never repeats a
+ * member of the line.
+ */
+#define LOG_UTILS_FIELD_RESERVED_PREFIX "field."
+
+typedef enum e_log_utils_field_type
+{
+    LOG_UTILS_FIELD_TYPE_INT,
+    LOG_UTILS_FIELD_TYPE_DOUBLE,
+    LOG_UTILS_FIELD_TYPE_STRING,
+    LOG_UTILS_FIELD_TYPE_BOOL
+} e_log_utils_field_type;
+
+typedef struct t_log_utils_field
+{
+    const char*            key;
+    e_log_utils_field_type type;
+    union
+    {
+        int64_t     i;
+        double      d;
+        const char* s;
+        bool        b;
+    } value;
+} t_log_utils_field;
+
+#define LOG_UTILS_FIELD_INT(key, v)    ((t_log_utils_field){ (key), LOG_UTILS_FIELD_TYPE_INT,    { .i = (v) } })
+#define LOG_UTILS_FIELD_DOUBLE(key, v) ((t_log_utils_field){ (key), LOG_UTILS_FIELD_TYPE_DOUBLE, { .d = (v) } })
+#define LOG_UTILS_FIELD_STRING(key, v) ((t_log_utils_field){ (key), LOG_UTILS_FIELD_TYPE_STRING, { .s = (v) } })
+#define LOG_UTILS_FIELD_BOOL(key, v)   ((t_log_utils_field){ (key), LOG_UTILS_FIELD_TYPE_BOOL,   { .b = (v) } })
+
+// Logs message (as "content", omitted when NULL) followed by the fields; no minimum level check
+void log_utils_fields(t_log_utils_level level, const char* context, const char* message,
+                      const t_log_utils_field* fields, size_t count);
+
+// Logs message verbatim as "content", without printf, from views that need not be NUL-terminated;
+// the null context view is written as a null context. No minimum level check
+void log_utils_write(t_log_utils_level level, t_str_utils_view context, t_str_utils_view message);
+
+/*
+ * Level macros: calls below LOG_UTILS_COMPILE_MIN_LEVEL compile to nothing,
+ * and runtime-disabled levels cost one branch, taken before any argument
+ * is evaluated.
+ */
+#define LOG_UTILS_LOG(level, context, ...)                                              \
+    do {                                                                                \
+        if ((level) >= LOG_UTILS_COMPILE_MIN_LEVEL                                      \
+            && ((level) >= LOG_UTILS_LEVEL_ERROR                                        \
+                || !LOG_UTILS_UNLIKELY((level) < log_utils_runtime_min_level)))         \
+        {                                                                               \
+            log_utils_emit((level), (context), __VA_ARGS__);                            \
+        }                                                                               \
+    } while (0)
+
+// LOG_UTILS_LOG_FIELDS(LOG_UTILS_LEVEL_INFO, "http", "served", LOG_UTILS_FIELD_INT("status", 200), ...)
+// At least one field is required: C11 rejects the empty initializer list. Without fields, use
+// LOG_UTILS_LOG, or log_utils_fields(level, context, message, NULL, 0) after a level check
+#define LOG_UTILS_LOG_FIELDS(level, context, message, ...)                              \
+    do {                                                                                \
+        if ((level) >= LOG_UTILS_COMPILE_MIN_LEVEL                                      \
+            && ((level) >= LOG_UTILS_LEVEL_ERROR                                        \
+                || !LOG_UTILS_UNLIKELY((level) < log_utils_runtime_min_level)))         \
+        {                                                                               \
+            const t_log_utils_field log_utils_fields_[] = { __VA_ARGS__ };              \
+            log_utils_fields((level), (context), (message), log_utils_fields_,          \
+                             sizeof(log_utils_fields_) / sizeof(log_utils_fields_[0])); \
+        }                                                                               \
+    } while (0)
+
+#define LOG_UTILS_LOG_DEBUG(context, ...) LOG_UTILS_LOG(LOG_UTILS_LEVEL_DEBUG, context, __VA_ARGS__)
+#define LOG_UTILS_LOG_INFO(context, ...)  LOG_UTILS_LOG(LOG_UTILS_LEVEL_INFO, context, __VA_ARGS__)
+#define LOG_UTILS_LOG_WARN(context, ...)  LOG_UTILS_LOG(LOG_UTILS_LEVEL_WARN, context, __VA_ARGS__)
+#define LOG_UTILS_LOG_ERROR(context, ...) LOG_UTILS_LOG(LOG_UTILS_LEVEL_ERROR, context, __VA_ARGS__)
+
 #endif /* LOG_UTILS_H */
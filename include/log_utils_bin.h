@@ -0,0 +1,146 @@
+#ifndef LOG_UTILS_BIN_H
+#define LOG_UTILS_BIN_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "log_utils.h"
+
+/**
+ * @file log_utils_bin.h
+ * @brief Binary, deferred-format logging for high-rate call sites.
+ *
+ * Instead of formatting and escaping at runtime, each call records a
+ * format-string id, a tick counter and the raw argument bytes into a
+ * per-thread buffer. Format strings are written once to the stream as
+ * dictionary entries; the `log_utils_decode` tool turns the stream back
+ * into the JSON lines produced by log_utils.
+ *
+ * Per-thread buffers are written to the file when full, when their thread
+ * exits, on log_utils_bin_flush() (calling thread only) and on
+ * log_utils_bin_close(), which must only be called once logging threads
+ * are done.
+ */
+
+// Arguments beyond this count are not recorded
+#define LOG_UTILS_BIN_MAX_ARGS 24
+
+/**
+ * @brief Per call-site registration state.
+ *
+ * Declared static by the LOG_UTILS_BIN_* macros; never touched directly.
+ */
+typedef struct t_log_utils_bin_site
+{
+    _Atomic uint64_t registration;  // (stream generation << 32) | format id
+    bool             parsed;        // kinds below are filled in
+    uint8_t          kind_count;
+    uint8_t          kinds[LOG_UTILS_BIN_MAX_ARGS];
+} t_log_utils_bin_site;
+
+/**
+ * @brief Opens a binary log stream, truncating the file.
+ *
+ * Calibrates the tick counter against the wall clock, which takes about 10 ms.
+ *
+ * @param path Path of the binary log file.
+ * @return true on success, false if a stream is already open or the file cannot be created.
+ */
+bool log_utils_bin_open(const char* path);
+
+/**
+ * @brief Writes the calling thread's buffered records to the stream.
+ */
+void log_utils_bin_flush(void);
+
+/**
+ * @brief Flushes every thread buffer and closes the stream.
+ */
+void log_utils_bin_close(void);
+
+/**
+ * @brief Records one binary log event. Use the LOG_UTILS_BIN_* macros instead.
+ *
+ * The level is not checked here; the macros filter it before the call.
+ *
+ * context and format must outlive the stream (string literals): only their
+ * addresses are kept, their content is written once on registration.
+ */
+void log_utils_bin_log(t_log_utils_bin_site* site, t_log_utils_level level, const char* context, const char* format, ...);
+
+// Level filtering follows LOG_UTILS_LOG: compiled out below LOG_UTILS_COMPILE_MIN_LEVEL
+#define LOG_UTILS_BIN_LOG(level, context, ...)                                          \
+    do {                                                                                \
+        if ((level) >= LOG_UTILS_COMPILE_MIN_LEVEL                                      \
+            && ((level) >= LOG_UTILS_LEVEL_ERROR                                        \
+                || !LOG_UTILS_UNLIKELY((level) < log_utils_runtime_min_level)))         \
+        {                                                                               \
+            static t_log_utils_bin_site log_utils_bin_site_ = { 0 };                    \
+            log_utils_bin_log(&log_utils_bin_site_, (level), (context), __VA_ARGS__);   \
+        }                                                                               \
+    } while (0)
+
+#define LOG_UTILS_BIN_DEBUG(context, ...) LOG_UTILS_BIN_LOG(LOG_UTILS_LEVEL_DEBUG, context, __VA_ARGS__)
+#define LOG_UTILS_BIN_INFO(context, ...)  LOG_UTILS_BIN_LOG(LOG_UTILS_LEVEL_INFO, context, __VA_ARGS__)
+#define LOG_UTILS_BIN_WARN(context, ...)  LOG_UTILS_BIN_LOG(LOG_UTILS_LEVEL_WARN, context, __VA_ARGS__)
+#define LOG_UTILS_BIN_ERROR(context, ...) LOG_UTILS_BIN_LOG(LOG_UTILS_LEVEL_ERROR, context, __VA_ARGS__)
+
+/*
+ * Wire format (native byte order)
+ *
+ * header : magic[8] "VFCLOGB1", u64 ticks_per_second, u64 base_ticks, i64 base_realtime_ns
+ * record : u8 tag, u32 payload size, payload
+ *
+ * DICT payload  : varint id, varint level, varint context size + 1 (0: NULL), context,
+ *                 varint format size, format, varint argument count, u8 kinds[]
+ * BLOCK payload : u64 base ticks, then events until the end of the payload
+ * event         : varint id, varint ticks since previous event (or block base), arguments
+ *
+ * Arguments: zigzag varint (I32, I64), varint (U32, U64, POINTER),
+ * raw 8-byte double (DOUBLE), varint size + bytes (STRING).
+ */
+#define LOG_UTILS_BIN_MAGIC       "VFCLOGB1"
+#define LOG_UTILS_BIN_MAGIC_SIZE  8
+
+#define LOG_UTILS_BIN_TAG_DICT    1
+#define LOG_UTILS_BIN_TAG_BLOCK   2
+
+typedef enum e_log_utils_bin_kind
+{
+    LOG_UTILS_BIN_KIND_I32 = 1,
+    LOG_UTILS_BIN_KIND_I64,
+    LOG_UTILS_BIN_KIND_U32,
+    LOG_UTILS_BIN_KIND_U64,
+    LOG_UTILS_BIN_KIND_DOUBLE,
+    LOG_UTILS_BIN_KIND_LONG_DOUBLE,  // Recorded as a double
+    LOG_UTILS_BIN_KIND_STRING,
+    LOG_UTILS_BIN_KIND_POINTER
+} e_log_utils_bin_kind;
+
+/**
+ * @brief One printf conversion, as classified by log_utils_bin_parse_conversion().
+ *
+ * Shared by the encoder and the decoder so that both agree on which
+ * arguments are recorded. Unsupported conversions (wide characters and
+ * strings, %m, unknown ones) are rendered verbatim by the decoder; the
+ * argument they consume, if any, is still recorded to keep the following
+ * ones in step.
+ */
+typedef struct t_log_utils_bin_conversion
+{
+    const char* length;      // First length modifier; flags, width and precision end here
+    const char* end;         // Past the conversion character
+    char        conversion;  // '\0' at the end of a truncated format
+    uint8_t     star_count;  // '*' widths and precisions, each an I32 argument
+    uint8_t     halves;      // Number of 'h' modifiers
+    uint8_t     kind;        // Kind of the converted argument, 0 if it takes none
+    bool        verbatim;    // Not rendered by the decoder
+} t_log_utils_bin_conversion;
+
+/**
+ * @brief Parses the printf conversion starting after a '%' that does not start "%%".
+ */
+void log_utils_bin_parse_conversion(const char* spec, t_log_utils_bin_conversion* conversion);
+
+#endif /* LOG_UTILS_BIN_H */
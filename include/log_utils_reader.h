@@ -0,0 +1,86 @@
+#ifndef LOG_UTILS_READER_H
+#define LOG_UTILS_READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "log_utils.h"
+
+/**
+ * @file log_utils_reader.h
+ * @brief Parallel reader for the JSON lines written by log_utils.
+ *
+ * The file is memory-mapped and split into newline-aligned chunks, which a
+ * pool of threads parses concurrently. Records of one chunk are delivered in
+ * file order, but chunks are processed in any order and the callback runs on
+ * several threads at once.
+ */
+
+/**
+ * @brief One log line. Strings are unescaped and not NUL-terminated.
+ *
+ * Pointers are only valid during the callback. Lines carrying structured
+ * fields can be parsed further from the raw line. A member repeated at the
+ * top level keeps its first value, the one the raw filters look at.
+ */
+typedef struct t_log_utils_record
+{
+    const char*       timestamp;
+    size_t            timestamp_len;
+    t_log_utils_level level;
+    const char*       context;      /**< NULL for a null context. */
+    size_t            context_len;
+    const char*       content;      /**< NULL when the line has no content member. */
+    size_t            content_len;
+    const char*       line;         /**< Raw JSON line, without its newline. */
+    size_t            line_len;
+} t_log_utils_record;
+
+/**
+ * @brief Receives records. Returning false stops the whole read.
+ *
+ * @param context Opaque pointer given to log_utils_reader_read_file().
+ * @param worker Index of the calling thread, below the thread count, to keep per-thread state.
+ * @param record The record.
+ */
+typedef bool (*log_utils_record_fn)(void* context, unsigned worker, const t_log_utils_record* record);
+
+/**
+ * @brief Reader options. Zero-initialized fields select the defaults.
+ */
+typedef struct t_log_utils_reader_options
+{
+    unsigned          threads;     /**< Worker threads. Default: number of online CPUs. */
+    size_t            chunk_size;  /**< Bytes per work unit, rounded to line ends. Default: 4 MiB. */
+    t_log_utils_level min_level;   /**< Skip records below this level. Default: DEBUG (keep all). */
+    const char*       context;     /**< Only keep records of this context. Default: NULL (keep all). */
+} t_log_utils_reader_options;
+
+/**
+ * @brief Counters of a read, summed over all workers.
+ */
+typedef struct t_log_utils_reader_stats
+{
+    uint64_t records;    /**< Records passed to the callback. */
+    uint64_t filtered;   /**< Lines skipped by the level or context filter. */
+    uint64_t malformed;  /**< Lines that are not log_utils records. */
+} t_log_utils_reader_stats;
+
+/**
+ * @brief Reads a log file and passes every matching record to callback.
+ *
+ * Level and context filters are first applied to the raw line, so most
+ * rejected lines are never parsed.
+ *
+ * @param path Path of the NDJSON log file.
+ * @param options Threads, chunking and filters. Can be NULL for defaults.
+ * @param callback Called for each record, possibly from several threads at once.
+ * @param context Opaque pointer passed to the callback.
+ * @param stats Receives the counters. Can be NULL.
+ * @return true if the whole file was read or the callback stopped it, false on I/O or allocation failure.
+ */
+bool log_utils_reader_read_file(const char* path, const t_log_utils_reader_options* options,
+                                log_utils_record_fn callback, void* context, t_log_utils_reader_stats* stats);
+
+#endif /* LOG_UTILS_READER_H */
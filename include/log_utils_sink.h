@@ -0,0 +1,113 @@
+#ifndef LOG_UTILS_SINK_H
+#define LOG_UTILS_SINK_H
+
+#include <stddef.h>
+
+/**
+ * @file log_utils_sink.h
+ * @brief Output destinations for log_utils lines.
+ *
+ * A sink receives complete, newline-terminated log lines. Sinks are safe to
+ * share between threads; each implementation serializes its own writes.
+ */
+
+typedef struct t_log_utils_sink t_log_utils_sink;
+
+typedef void (*log_utils_sink_write_fn)(void* context, const char* line, size_t len);
+typedef void (*log_utils_sink_flush_fn)(void* context);
+typedef void (*log_utils_sink_free_fn)(void* context);
+
+/**
+ * @brief Options shared by the file and mmap sinks.
+ *
+ * Zero-initialized fields select the defaults.
+ */
+typedef struct t_log_utils_file_sink_options
+{
+    /** Write buffer (file sink) or mapping window (mmap sink, at least two pages) size in bytes.
+     *  Default: 1 MiB / 16 MiB. */
+    size_t   buffer_size;
+    /** Rotate once the file would grow past this many bytes. 0 disables size rotation. */
+    size_t   max_file_size;
+    /** Rotate on every multiple of this many seconds of wall time. 0 disables time rotation. */
+    unsigned rotate_interval;
+    /** Rotated files kept as path.1 .. path.N. 0 truncates the file on rotation. */
+    unsigned max_files;
+    /** File sink: flush buffered lines once they are this old, from a background thread.
+     *  0 only flushes when the buffer is full. */
+    unsigned flush_interval_ms;
+} t_log_utils_file_sink_options;
+
+/**
+ * @brief Creates a sink from user callbacks.
+ *
+ * @param write Called once per log line. Must not be NULL.
+ * @param flush Called by log_utils_sink_flush(). Can be NULL.
+ * @param free_context Called with the context when the sink is freed. Can be NULL.
+ * @param context Opaque pointer passed to the callbacks.
+ * @return Pointer to the new sink, or NULL on allocation failure.
+ */
+t_log_utils_sink* log_utils_sink_new(log_utils_sink_write_fn write, log_utils_sink_flush_fn flush,
+                                     log_utils_sink_free_fn free_context, void* context);
+
+/**
+ * @brief Returns the shared sink writing to stdout.
+ *
+ * This is the default sink. Freeing it is a no-op.
+ */
+t_log_utils_sink* log_utils_sink_stdout(void);
+
+/**
+ * @brief Creates a sink appending to a file through a large write buffer.
+ *
+ * Lines are batched in memory and written with a single write/writev call
+ * when the buffer fills, when the flush interval elapses or on flush. With
+ * a flush interval, a background thread writes lines out on time even when
+ * no further line is logged.
+ *
+ * @param path Path of the log file, created if needed.
+ * @param options Buffering and rotation options. Can be NULL for defaults.
+ * @return Pointer to the new sink, or NULL if the file cannot be opened.
+ */
+t_log_utils_sink* log_utils_sink_file_new(const char* path, const t_log_utils_file_sink_options* options);
+
+/**
+ * @brief Creates a sink appending to a file through a memory mapping.
+ *
+ * The file is grown one mapping window at a time and lines are copied
+ * straight into the page cache; the file is trimmed to its real size on
+ * rotation and when the sink is freed.
+ *
+ * @param path Path of the log file, created if needed.
+ * @param options Window size and rotation options. Can be NULL for defaults.
+ * @return Pointer to the new sink, or NULL if the file cannot be opened or mapped.
+ */
+t_log_utils_sink* log_utils_sink_mmap_new(const char* path, const t_log_utils_file_sink_options* options);
+
+/**
+ * @brief Creates a sink forwarding every line to several sinks.
+ *
+ * The fan-out sink takes ownership of the given sinks and frees them with itself.
+ *
+ * @param sinks Array of sinks.
+ * @param count Number of sinks in the array.
+ * @return Pointer to the new sink, or NULL on allocation failure.
+ */
+t_log_utils_sink* log_utils_sink_fanout_new(t_log_utils_sink** sinks, size_t count);
+
+/**
+ * @brief Writes one log line to a sink.
+ */
+void log_utils_sink_write(t_log_utils_sink* sink, const char* line, size_t len);
+
+/**
+ * @brief Pushes any buffered lines of a sink to its destination.
+ */
+void log_utils_sink_flush(t_log_utils_sink* sink);
+
+/**
+ * @brief Flushes and frees a sink.
+ */
+void log_utils_sink_free(t_log_utils_sink* sink);
+
+#endif /* LOG_UTILS_SINK_H */
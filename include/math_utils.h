@@ -1,7 +1,23 @@
 #ifndef MATH_UTILS_H
 #define MATH_UTILS_H
 
-float math_utils_clampf(float number, float min_value, float max_value)
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file math_utils.h
+ * @brief Scalar helpers, and clamps, reductions and prefix sums over float and int32_t arrays.
+ *
+ * The array functions run SSE2 or AVX2 kernels picked once at runtime from
+ * cpu_utils_level(), and split arrays of several million elements across
+ * one thread per online CPU. Their results do not depend on the instruction
+ * set or on the number of threads.
+ */
+
+/**
+ * @brief Clamps number to [min_value, max_value]. NaN is returned as is.
+ */
+static inline float math_utils_clampf(float number, float min_value, float max_value)
 {
     return number < min_value
         ? min_value
@@ -10,7 +26,10 @@ float math_utils_clampf(float number, float min_value, float max_value)
             : number;
 }
 
-float math_utils_clamp(int number, int min_value, int max_value)
+/**
+ * @brief Clamps number to [min_value, max_value].
+ */
+static inline int math_utils_clamp(int number, int min_value, int max_value)
 {
     return number < min_value
         ? min_value
@@ -19,14 +38,115 @@ float math_utils_clamp(int number, int min_value, int max_value)
             : number;
 }
 
-float math_utils_max(float f1, float f2)
+static inline float math_utils_max(float f1, float f2)
 {
     return f1 > f2 ? f1 : f2;
 }
 
-float math_utils_min(float f1, float f2)
+static inline float math_utils_min(float f1, float f2)
 {
     return f1 < f2 ? f1 : f2;
 }
 
+/* -------------------------------------------------------------------------- */
+/* Arrays                                                                     */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Clamps every element to [min_value, max_value], as math_utils_clampf() does.
+ *
+ * @param out Receives count elements; may be values itself.
+ * @param min_value Lower bound, not above max_value.
+ */
+void math_utils_array_clampf(float* out, const float* values, size_t count, float min_value, float max_value);
+
+/**
+ * @brief Clamps every element to [min_value, max_value].
+ *
+ * @param out Receives count elements; may be values itself.
+ * @param min_value Lower bound, not above max_value.
+ */
+void math_utils_array_clamp(int32_t* out, const int32_t* values, size_t count, int32_t min_value, int32_t max_value);
+
+/**
+ * @brief Returns the smallest element, ignoring NaN.
+ *
+ * @return The minimum, or NaN when count is 0 or every element is NaN.
+ */
+float math_utils_array_minf(const float* values, size_t count);
+
+/**
+ * @brief Returns the largest element, ignoring NaN.
+ *
+ * @return The maximum, or NaN when count is 0 or every element is NaN.
+ */
+float math_utils_array_maxf(const float* values, size_t count);
+
+/**
+ * @brief Returns the smallest element, or INT32_MAX when count is 0.
+ */
+int32_t math_utils_array_min(const int32_t* values, size_t count);
+
+/**
+ * @brief Returns the largest element, or INT32_MIN when count is 0.
+ */
+int32_t math_utils_array_max(const int32_t* values, size_t count);
+
+/**
+ * @brief Returns the index of the first smallest element, ignoring NaN.
+ *
+ * @return The index, or SIZE_MAX when count is 0 or every element is NaN.
+ */
+size_t math_utils_array_argminf(const float* values, size_t count);
+
+/**
+ * @brief Returns the index of the first largest element, ignoring NaN.
+ *
+ * @return The index, or SIZE_MAX when count is 0 or every element is NaN.
+ */
+size_t math_utils_array_argmaxf(const float* values, size_t count);
+
+/**
+ * @brief Returns the index of the first smallest element, or SIZE_MAX when count is 0.
+ */
+size_t math_utils_array_argmin(const int32_t* values, size_t count);
+
+/**
+ * @brief Returns the index of the first largest element, or SIZE_MAX when count is 0.
+ */
+size_t math_utils_array_argmax(const int32_t* values, size_t count);
+
+/**
+ * @brief Returns the sum of the elements, by pairwise summation.
+ *
+ * Blocks of 256 elements are summed in 16 interleaved partial sums, and
+ * the block sums are added pairwise: the rounding error grows with the log
+ * of count rather than with count, at the speed of a plain loop.
+ */
+float math_utils_array_sumf(const float* values, size_t count);
+
+/**
+ * @brief Returns the exact sum of the elements.
+ */
+int64_t math_utils_array_sum(const int32_t* values, size_t count);
+
+/**
+ * @brief Writes the inclusive prefix sums: out[i] = values[0] + ... + values[i].
+ *
+ * Groups of four elements are summed in a tree then added to the running
+ * total, and arrays longer than 65536 elements restart the running total
+ * every 65536 elements before adding it back, so rounding can differ from
+ * a sequential loop in the last bits.
+ *
+ * @param out Receives count elements; may be values itself.
+ */
+void math_utils_array_prefix_sumf(float* out, const float* values, size_t count);
+
+/**
+ * @brief Writes the inclusive prefix sums, wrapping around on overflow like unsigned arithmetic.
+ *
+ * @param out Receives count elements; may be values itself.
+ */
+void math_utils_array_prefix_sum(int32_t* out, const int32_t* values, size_t count);
+
 #endif /* MATH_UTILS_H */
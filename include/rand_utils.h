@@ -4,23 +4,138 @@
 /**
  * @file rand_utils.h
  * @brief Utility functions for generating random numbers in C.
+ *
+ * Numbers come from xoshiro256**, a small, fast generator with a period of
+ * 2^256 - 1 that passes BigCrush. Each generator is an explicit
+ * t_rand_utils_state; the functions without a state use a thread-local one,
+ * seeded on first use, so threads never share or lock anything.
  */
 
+#include <stdint.h>
 #include <stdlib.h>
 
 /**
- * @brief Initializes the random number generator using the current time.
+ * @brief State of a xoshiro256** generator. Not thread-safe: use one per thread.
+ *
+ * Fields are public for stack allocation; treat them as private.
+ */
+typedef struct t_rand_utils_state
+{
+    uint64_t s[4];
+} t_rand_utils_state;
+
+/**
+ * @brief Seeds a generator. The same seed always yields the same sequence.
+ *
+ * The seed is expanded with splitmix64, so close seeds give unrelated sequences.
+ */
+void rand_utils_state_seed(t_rand_utils_state* state, uint64_t seed);
+
+/**
+ * @brief Returns the next 64 random bits. Inline: a few shifts, rotations and a multiply.
+ */
+static inline uint64_t rand_utils_state_next(t_rand_utils_state* state)
+{
+    uint64_t* s = state->s;
+    uint64_t x = s[1] * 5;
+    uint64_t result = ((x << 7) | (x >> 57)) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 45) | (s[3] >> 19);
+
+    return result;
+}
+
+/**
+ * @brief Advances a generator by 2^128 steps.
+ *
+ * The 2^128 values skipped can never be reached by the original sequence
+ * in practice, so each jump starts an independent stream: see
+ * rand_utils_state_split(). Costs about 256 steps.
+ */
+void rand_utils_state_jump(t_rand_utils_state* state);
+
+/**
+ * @brief Advances a generator by 2^192 steps, to split streams into up to 2^64 groups of 2^64 jumps.
+ */
+void rand_utils_state_long_jump(t_rand_utils_state* state);
+
+/**
+ * @brief Derives count non-overlapping streams from master, for parallel workers.
+ *
+ * streams[0] is master itself and streams[k] is master jumped k times, so
+ * worker k gets the same numbers however threads are scheduled. master is
+ * left unchanged.
+ */
+void rand_utils_state_split(const t_rand_utils_state* master, t_rand_utils_state* streams, size_t count);
+
+/**
+ * @brief Seeds state with stream index of seed: the seeded generator jumped index times.
+ *
+ * Lets a worker build its own stream without sharing state, at a cost of
+ * one jump per index.
+ */
+void rand_utils_state_stream(t_rand_utils_state* state, uint64_t seed, uint64_t index);
+
+/**
+ * @brief Returns a uniform integer in [0, range) without modulo bias (Lemire's method).
+ *
+ * Costs one multiply; a division only happens in the rare rejection case.
+ * range 0 yields 0.
+ */
+uint64_t rand_utils_state_bounded(t_rand_utils_state* state, uint64_t range);
+
+/**
+ * @brief Generates a uniform integer between min and max (inclusive) with a given generator.
+ */
+int rand_utils_state_int(t_rand_utils_state* state, int min, int max);
+
+/**
+ * @brief Generates a float in [min, max) from 24 random mantissa bits.
+ */
+float rand_utils_state_float(t_rand_utils_state* state, float min, float max);
+
+/**
+ * @brief Generates a double in [min, max) from 53 random mantissa bits.
+ */
+double rand_utils_state_double(t_rand_utils_state* state, double min, double max);
+
+/**
+ * @brief Returns the generator of the calling thread, seeded on first use.
+ *
+ * Seeds mix the clock, the thread and a process-wide counter, so threads
+ * started together still get distinct sequences.
+ */
+t_rand_utils_state* rand_utils_thread_state(void);
+
+/**
+ * @brief Reseeds the generator of the calling thread from the clock.
  *
- * Must be called once before using any other random functions.
+ * Optional: the generator seeds itself on first use.
  */
 void rand_utils_seed(void);
 
+/**
+ * @brief Reseeds the generator of the calling thread with a fixed seed, for reproducible runs.
+ */
+void rand_utils_seed_value(uint64_t seed);
+
+/**
+ * @brief Returns 64 random bits from the generator of the calling thread.
+ */
+uint64_t rand_utils_u64(void);
+
 /**
  * @brief Generates a random integer between min and max (inclusive).
  *
  * @param min Minimum possible value.
  * @param max Maximum possible value.
- * @return Random integer between min and max.
+ * @return Random integer between min and max, or min if max <= min.
  */
 int rand_utils_int(int min, int max);
 
@@ -29,8 +144,148 @@ int rand_utils_int(int min, int max);
  *
  * @param min Minimum possible value.
  * @param max Maximum possible value.
- * @return Random float in [min, max).
+ * @return Random float in [min, max), or min if max <= min.
  */
 float rand_utils_float(float min, float max);
 
+/**
+ * @brief Generates a random double between min and max.
+ *
+ * @return Random double in [min, max), or min if max <= min.
+ */
+double rand_utils_double(double min, double max);
+
+/* -------------------------------------------------------------------------- */
+/* Bulk generation                                                            */
+/* -------------------------------------------------------------------------- */
+
+// Independent generators advanced together by the bulk functions
+#define RAND_UTILS_LANES 8
+
+/**
+ * @brief Eight xoshiro256** generators stepped in parallel, one per SIMD lane.
+ *
+ * The raw stream interleaves the lanes: value i comes from lane i % 8, so
+ * the output for a seed is the same with AVX-512, AVX2 or scalar code. Each
+ * bulk call starts a new group of eight; values left over from the last
+ * group are dropped. Lanes are 2^128 steps apart (rand_utils_lanes_init()).
+ * Not thread-safe: use one per thread.
+ */
+typedef struct t_rand_utils_lanes
+{
+    _Alignas(64) uint64_t s[4][RAND_UTILS_LANES];  /**< Word w of lane l at s[w][l]. */
+} t_rand_utils_lanes;
+
+/**
+ * @brief Seeds the eight lanes from one seed, as rand_utils_lanes_init() with a seeded generator.
+ */
+void rand_utils_lanes_seed(t_rand_utils_lanes* lanes, uint64_t seed);
+
+/**
+ * @brief Sets lane j to state jumped j times, so lanes never overlap.
+ *
+ * To give each worker its own lanes, long-jump state once per worker:
+ * workers are then 2^192 steps apart and their lanes 2^128.
+ */
+void rand_utils_lanes_init(t_rand_utils_lanes* lanes, const t_rand_utils_state* state);
+
+/**
+ * @brief Returns the lanes of the calling thread, seeded on first use from its generator.
+ */
+t_rand_utils_lanes* rand_utils_thread_lanes(void);
+
+/**
+ * @brief Fills out with count uniform integers in [min, max], without bias.
+ *
+ * The full range [0, UINT64_MAX] copies the raw stream.
+ */
+void rand_utils_fill_u64(t_rand_utils_lanes* lanes, uint64_t* out, size_t count, uint64_t min, uint64_t max);
+
+/**
+ * @brief Fills out with count uniform integers in [min, max], without bias.
+ *
+ * Each raw value gives two 32-bit draws, low half first. Draws rejected by
+ * Lemire's method are skipped, so the stream stays the same on every ISA.
+ */
+void rand_utils_fill_u32(t_rand_utils_lanes* lanes, uint32_t* out, size_t count, uint32_t min, uint32_t max);
+
+/**
+ * @brief Fills out with count floats in [min, max), two per raw value, 24 random bits each.
+ */
+void rand_utils_fill_float(t_rand_utils_lanes* lanes, float* out, size_t count, float min, float max);
+
+/**
+ * @brief Fills out with count doubles in [min, max), 52 random bits each.
+ */
+void rand_utils_fill_double(t_rand_utils_lanes* lanes, double* out, size_t count, double min, double max);
+
+/* -------------------------------------------------------------------------- */
+/* Distributions                                                              */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Draws from the normal distribution, with the 256-layer ziggurat method.
+ *
+ * Nearly all draws cost one random value, a table lookup and a multiply;
+ * exp() or log() only run in about 1% of them.
+ */
+double rand_utils_state_normal(t_rand_utils_state* state, double mean, double stddev);
+
+/**
+ * @brief Draws from the exponential distribution of a rate (mean 1 / rate), with the ziggurat method.
+ */
+double rand_utils_state_exponential(t_rand_utils_state* state, double rate);
+
+/**
+ * @brief Draws from the Poisson distribution of a mean.
+ *
+ * Means below 10 multiply uniforms (about mean + 1 draws); larger ones use
+ * Hormann's transformed rejection (PTRS), which takes about 1.1 pairs of
+ * draws whatever the mean. A mean <= 0 yields 0.
+ */
+uint64_t rand_utils_state_poisson(t_rand_utils_state* state, double mean);
+
+/**
+ * @brief Draws the number of trials up to and including the first success, each succeeding with probability p.
+ *
+ * Inverts the distribution: one draw and two logarithms. p >= 1 yields 1; p <= 0 yields UINT64_MAX.
+ */
+uint64_t rand_utils_state_geometric(t_rand_utils_state* state, double p);
+
+/**
+ * @brief Same distributions, drawn from the generator of the calling thread.
+ */
+double rand_utils_normal(double mean, double stddev);
+double rand_utils_exponential(double rate);
+uint64_t rand_utils_poisson(double mean);
+uint64_t rand_utils_geometric(double p);
+
+/**
+ * @brief Table for O(1) weighted choice among a fixed set of categories (Vose's alias method).
+ */
+typedef struct t_rand_utils_alias t_rand_utils_alias;
+
+/**
+ * @brief Builds the alias table of a set of weights, in O(count).
+ *
+ * @param weights Relative weights, non-negative, not all zero. The array is not kept.
+ * @param count Number of categories.
+ * @return Pointer to the new table, or NULL on invalid weights or allocation failure.
+ */
+t_rand_utils_alias* rand_utils_alias_new(const double* weights, size_t count);
+
+/**
+ * @brief Frees an alias table.
+ */
+void rand_utils_alias_free(t_rand_utils_alias* alias);
+
+/**
+ * @brief Returns a category index, chosen with probability proportional to its weight.
+ *
+ * One random value picks both the column and the coin flip: a multiply and a single memory access.
+ *
+ * @param state Generator, or NULL for the generator of the calling thread.
+ */
+size_t rand_utils_alias_sample(const t_rand_utils_alias* alias, t_rand_utils_state* state);
+
 #endif /* RAND_UTILS_H */
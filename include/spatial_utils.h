@@ -0,0 +1,200 @@
+#ifndef SPATIAL_UTILS_H
+#define SPATIAL_UTILS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "math_utils_vec2.h"
+
+/**
+ * @file spatial_utils.h
+ * @brief Spatial indexes over t_math_utils_vec2 points: a uniform hash grid and a quadtree.
+ *
+ * Both index points by a caller-chosen id, typically the index of the
+ * point in the caller's own array, and answer radius, box and k-nearest
+ * queries. The grid suits dense, evenly spread points and queries of about
+ * one cell; the quadtree adapts to clustered data.
+ *
+ * Ids are small integers: each index keeps a table indexed by id, sized to
+ * the largest id seen. Points that are not finite are never indexed.
+ * Neither index is thread-safe; concurrent queries without updates are fine.
+ */
+
+/* -------------------------------------------------------------------------- */
+/* Uniform hash grid                                                          */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Square cells of a fixed size, hashed to buckets of contiguous points.
+ */
+typedef struct t_spatial_utils_grid t_spatial_utils_grid;
+
+/**
+ * @brief Creates an empty grid.
+ *
+ * @param cell_size Side of the cells, best close to the usual query radius. Must be positive.
+ * @return Pointer to the new grid, or NULL on invalid size or allocation failure.
+ */
+t_spatial_utils_grid* spatial_utils_grid_new(float cell_size);
+
+/**
+ * @brief Frees a grid.
+ */
+void spatial_utils_grid_free(t_spatial_utils_grid* grid);
+
+/**
+ * @brief Replaces the content of the grid with points[0..count), point i getting id i.
+ *
+ * A counting sort lays each bucket out contiguously, in O(count).
+ *
+ * @return true on success, false on allocation failure (the grid is then empty).
+ */
+bool spatial_utils_grid_build(t_spatial_utils_grid* grid, const t_math_utils_vec2* points, size_t count);
+
+/**
+ * @brief Adds a point.
+ *
+ * @return true on success, false if id is already present, the point is not finite or on allocation failure.
+ */
+bool spatial_utils_grid_insert(t_spatial_utils_grid* grid, uint32_t id, t_math_utils_vec2 point);
+
+/**
+ * @brief Moves a point. Moves within a cell only rewrite the position.
+ *
+ * @return true on success, false if id is absent, the point is not finite or on allocation failure.
+ */
+bool spatial_utils_grid_update(t_spatial_utils_grid* grid, uint32_t id, t_math_utils_vec2 point);
+
+/**
+ * @brief Removes a point.
+ *
+ * @return true if id was present.
+ */
+bool spatial_utils_grid_remove(t_spatial_utils_grid* grid, uint32_t id);
+
+/**
+ * @brief Returns the number of points in the grid.
+ */
+size_t spatial_utils_grid_count(const t_spatial_utils_grid* grid);
+
+/**
+ * @brief Finds the points within radius of center (inclusive), in no particular order.
+ *
+ * @param out Receives up to capacity ids.
+ * @return Number of matches, which may exceed capacity: only the first capacity are written.
+ */
+size_t spatial_utils_grid_query_radius(const t_spatial_utils_grid* grid, t_math_utils_vec2 center, float radius,
+                                       uint32_t* out, size_t capacity);
+
+/**
+ * @brief Finds the points inside the box [min, max] (inclusive), in no particular order.
+ *
+ * @return Number of matches, which may exceed capacity: only the first capacity are written.
+ */
+size_t spatial_utils_grid_query_box(const t_spatial_utils_grid* grid, t_math_utils_vec2 min, t_math_utils_vec2 max,
+                                    uint32_t* out, size_t capacity);
+
+/**
+ * @brief Finds the k points nearest to point, nearest first, searching rings of cells outwards.
+ *
+ * @param out Receives up to k ids.
+ * @param distances Receives their distances, or NULL.
+ * @return Number of points found: k, or fewer if the grid holds fewer.
+ *
+ * Squared distances are computed in float: points more than about 1.8e19
+ * away rank as equally far, with an infinite distance, but are still found.
+ */
+size_t spatial_utils_grid_query_nearest(const t_spatial_utils_grid* grid, t_math_utils_vec2 point, size_t k,
+                                        uint32_t* out, float* distances);
+
+/* -------------------------------------------------------------------------- */
+/* Quadtree                                                                   */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Region quadtree with up to 16 points per leaf.
+ *
+ * Nodes live in one array, the four children of a node side by side, and
+ * leaf points in fixed-size blocks of one pool, so traversals stay in a
+ * few cache lines. The root grows to enclose points inserted outside it.
+ */
+typedef struct t_spatial_utils_quadtree t_spatial_utils_quadtree;
+
+/**
+ * @brief Creates an empty quadtree.
+ *
+ * @return Pointer to the new quadtree, or NULL on allocation failure.
+ */
+t_spatial_utils_quadtree* spatial_utils_quadtree_new(void);
+
+/**
+ * @brief Frees a quadtree.
+ */
+void spatial_utils_quadtree_free(t_spatial_utils_quadtree* tree);
+
+/**
+ * @brief Replaces the content of the tree with points[0..count), point i getting id i.
+ *
+ * Builds top-down by partitioning the points into quadrants, in O(count log count),
+ * and compacts the memory left by earlier updates.
+ *
+ * @return true on success, false on allocation failure (the tree is then empty).
+ */
+bool spatial_utils_quadtree_build(t_spatial_utils_quadtree* tree, const t_math_utils_vec2* points, size_t count);
+
+/**
+ * @brief Adds a point, splitting its leaf when full.
+ *
+ * @return true on success, false if id is already present, the point is not finite or on allocation failure.
+ */
+bool spatial_utils_quadtree_insert(t_spatial_utils_quadtree* tree, uint32_t id, t_math_utils_vec2 point);
+
+/**
+ * @brief Moves a point. Moves within a leaf only rewrite the position.
+ *
+ * @return true on success, false if id is absent, the point is not finite or on allocation failure.
+ */
+bool spatial_utils_quadtree_update(t_spatial_utils_quadtree* tree, uint32_t id, t_math_utils_vec2 point);
+
+/**
+ * @brief Removes a point. Emptied leaves are kept until the next build.
+ *
+ * @return true if id was present.
+ */
+bool spatial_utils_quadtree_remove(t_spatial_utils_quadtree* tree, uint32_t id);
+
+/**
+ * @brief Returns the number of points in the tree.
+ */
+size_t spatial_utils_quadtree_count(const t_spatial_utils_quadtree* tree);
+
+/**
+ * @brief Finds the points within radius of center (inclusive), in no particular order.
+ *
+ * @return Number of matches, which may exceed capacity: only the first capacity are written.
+ */
+size_t spatial_utils_quadtree_query_radius(const t_spatial_utils_quadtree* tree, t_math_utils_vec2 center,
+                                           float radius, uint32_t* out, size_t capacity);
+
+/**
+ * @brief Finds the points inside the box [min, max] (inclusive), in no particular order.
+ *
+ * @return Number of matches, which may exceed capacity: only the first capacity are written.
+ */
+size_t spatial_utils_quadtree_query_box(const t_spatial_utils_quadtree* tree, t_math_utils_vec2 min,
+                                        t_math_utils_vec2 max, uint32_t* out, size_t capacity);
+
+/**
+ * @brief Finds the k points nearest to point, nearest first, visiting the nearest nodes first.
+ *
+ * @param distances Receives their distances, or NULL.
+ * @return Number of points found: k, or fewer if the tree holds fewer.
+ *
+ * Squared distances are computed in float: points more than about 1.8e19
+ * away rank as equally far, with an infinite distance, but are still found.
+ */
+size_t spatial_utils_quadtree_query_nearest(const t_spatial_utils_quadtree* tree, t_math_utils_vec2 point, size_t k,
+                                            uint32_t* out, float* distances);
+
+#endif /* SPATIAL_UTILS_H */
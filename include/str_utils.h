@@ -1,6 +1,389 @@
 #ifndef STR_UTILS_H
 #define STR_UTILS_H
 
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "alloc_utils.h"
+
+// Buffer sizes large enough for any output of the number formatters below
+#define STR_UTILS_I64_BUFFER_SIZE    21
+#define STR_UTILS_DOUBLE_BUFFER_SIZE 32
+
 char* str_utils_strdup(const char* s);
 
+/*
+ * Number conversion without printf/strtod: independent of the locale, and
+ * a few table lookups per digit pair.
+ */
+
+// Writes the decimal form of value to buffer (not NUL-terminated), returns its length
+size_t str_utils_format_u64(char* buffer, uint64_t value);
+size_t str_utils_format_i64(char* buffer, int64_t value);
+
+// Same, left-padded with zeros to at least width digits ("%0*llu")
+size_t str_utils_format_u64_padded(char* buffer, uint64_t value, size_t width);
+
+// Writes the shortest decimal form that reads back as value, the closest one to it on ties
+// (Grisu3, with an exact fallback), returns its length.
+// Integers below 2^53 print without a fraction; the layout follows JavaScript: "0.001",
+// "1.5e+300". NaN and infinities print as "nan", "inf" and "-inf"
+size_t str_utils_format_double(char* buffer, double value);
+
+// Parse the longest prefix of data holding an integer: digits, with an optional sign for i64.
+// Return the number of bytes read, or 0 if there are no digits or the value overflows
+size_t str_utils_parse_u64(const char* data, size_t len, uint64_t* out);
+size_t str_utils_parse_i64(const char* data, size_t len, int64_t* out);
+
+// Parses the longest prefix of data holding a decimal number ("-12.5e-3", ".5", "7."), correctly
+// rounded. Returns the number of bytes read, or 0 if there are no digits. Out of range values
+// give 0 or infinity like strtod; hexadecimal, "inf" and "nan" are not accepted
+size_t str_utils_parse_double(const char* data, size_t len, double* out);
+
+/* -------------------------------------------------------------------------- */
+/* String view                                                                */
+/* -------------------------------------------------------------------------- */
+
+// Returned by the find functions when nothing matches
+#define STR_UTILS_NPOS SIZE_MAX
+
+/**
+ * @brief Non-owning (pointer, length) slice of a string, not NUL-terminated.
+ *
+ * Views are passed by value and never own their bytes, which must outlive
+ * them. data is NULL only for the null view, which compares equal to "".
+ */
+typedef struct t_str_utils_view
+{
+    const char* data;
+    size_t      len;
+} t_str_utils_view;
+
+// View of a string literal, without strlen
+#define STR_UTILS_VIEW_LITERAL(literal) ((t_str_utils_view){ (literal), sizeof(literal) - 1 })
+
+/**
+ * @brief Returns a view of a NUL-terminated string. NULL yields the null view.
+ */
+static inline t_str_utils_view str_utils_view(const char* str)
+{
+    return (t_str_utils_view){ str, str ? strlen(str) : 0 };
+}
+
+static inline t_str_utils_view str_utils_view_of(const char* data, size_t len)
+{
+    return (t_str_utils_view){ data, len };
+}
+
+static inline bool str_utils_view_equal(t_str_utils_view a, t_str_utils_view b)
+{
+    return a.len == b.len && (a.len == 0 || memcmp(a.data, b.data, a.len) == 0);
+}
+
+/**
+ * @brief Orders two views bytewise, a shorter prefix first, like strcmp.
+ *
+ * @return A negative value, 0 or a positive value.
+ */
+int str_utils_view_compare(t_str_utils_view a, t_str_utils_view b);
+
+/**
+ * @brief Returns the 64-bit FNV-1a hash of the bytes of a view.
+ */
+uint64_t str_utils_view_hash(t_str_utils_view view);
+
+bool str_utils_view_starts_with(t_str_utils_view view, t_str_utils_view prefix);
+bool str_utils_view_ends_with(t_str_utils_view view, t_str_utils_view suffix);
+
+/**
+ * @brief Returns the offset of the first occurrence of needle, or STR_UTILS_NPOS.
+ *
+ * Candidates are found 16 or 32 bytes at a time by matching the first and
+ * last needle bytes together, then checked with memcmp. An empty needle is
+ * found at offset 0.
+ */
+size_t str_utils_view_find(t_str_utils_view haystack, t_str_utils_view needle);
+
+/**
+ * @brief Returns the number of non-overlapping occurrences of needle, 0 for an empty needle.
+ */
+size_t str_utils_view_count(t_str_utils_view haystack, t_str_utils_view needle);
+
+/**
+ * @brief Returns the offset of the first byte equal to c, or STR_UTILS_NPOS.
+ */
+size_t str_utils_view_find_char(t_str_utils_view haystack, char c);
+
+/**
+ * @brief Set of bytes for the find_any and tokenizer routines, built by str_utils_byte_set_init().
+ *
+ * Membership is kept both as a bitmap and as two 16-entry nibble tables, so
+ * SIMD code tests 16 to 64 bytes against any set with a few shuffles.
+ */
+typedef struct t_str_utils_byte_set
+{
+    uint8_t  low[16];   /**< Bit h of low[l]: byte (h << 4 | l) is in the set. */
+    uint8_t  high[16];  /**< Same for bytes 0x80 and above. */
+    uint64_t bits[4];   /**< Bitmap over the 256 byte values. */
+} t_str_utils_byte_set;
+
+/**
+ * @brief Builds the set of the bytes of a view.
+ */
+void str_utils_byte_set_init(t_str_utils_byte_set* set, t_str_utils_view bytes);
+
+/**
+ * @brief Returns the offset of the first byte of haystack in set, or STR_UTILS_NPOS.
+ */
+size_t str_utils_view_find_set(t_str_utils_view haystack, const t_str_utils_byte_set* set);
+
+/**
+ * @brief Returns the offset of the first byte of haystack found in bytes, like strpbrk, or STR_UTILS_NPOS.
+ */
+size_t str_utils_view_find_any(t_str_utils_view haystack, t_str_utils_view bytes);
+
+/**
+ * @brief Returns the part of view starting at offset, at most len bytes long, clamped to the view.
+ */
+t_str_utils_view str_utils_view_substr(t_str_utils_view view, size_t offset, size_t len);
+
+/**
+ * @brief Returns view without leading and trailing ASCII whitespace.
+ */
+t_str_utils_view str_utils_view_trim(t_str_utils_view view);
+
+/**
+ * @brief Splits off the next field of *rest up to delimiter.
+ *
+ * *rest is advanced past the delimiter. "a,,b" yields "a", "" and "b"; a
+ * trailing delimiter yields a final empty field.
+ *
+ * while (str_utils_view_split(&rest, ',', &field)) { ... }
+ *
+ * @return false once every field has been returned.
+ */
+bool str_utils_view_split(t_str_utils_view* rest, char delimiter, t_str_utils_view* field);
+
+/**
+ * @brief Iterator over the tokens of a text, split at any of a set of delimiter bytes.
+ *
+ * Delimiters are located 64 bytes at a time into a bitmask, so each token
+ * costs a bit scan instead of a byte loop. Tokens are views into the text,
+ * nothing is allocated. Fields are public for stack allocation; treat them
+ * as private.
+ */
+typedef struct t_str_utils_tokenizer
+{
+    t_str_utils_view     text;
+    size_t               position;    // Start of the next token, beyond text.len once done
+    size_t               block;       // Offset of the 64-byte block described by mask
+    uint64_t             mask;        // Delimiters of that block not consumed yet
+    bool                 skip_empty;
+    t_str_utils_byte_set delimiters;
+} t_str_utils_tokenizer;
+
+/**
+ * @brief Starts tokenizing text.
+ *
+ * @param text Text to split, which must outlive the tokenizer. The null view yields no token.
+ * @param delimiters Bytes that separate tokens.
+ * @param skip_empty true to merge runs of delimiters and drop empty tokens, as for
+ *        whitespace; false to keep every field, as for CSV ("a,,b" yields "a", "" and "b").
+ */
+void str_utils_tokenizer_init(t_str_utils_tokenizer* tokenizer, t_str_utils_view text,
+                              t_str_utils_view delimiters, bool skip_empty);
+
+/**
+ * @brief Returns the next token.
+ *
+ * @return false once every token has been returned.
+ */
+bool str_utils_tokenizer_next(t_str_utils_tokenizer* tokenizer, t_str_utils_view* token);
+
+/**
+ * @brief Returns a newly allocated, NUL-terminated copy of a view, or NULL on allocation failure.
+ */
+char* str_utils_view_dup(t_str_utils_view view);
+
+/**
+ * @brief Returns a NUL-terminated copy of a view in view.len + 1 bytes from allocator, or NULL on allocation failure.
+ *
+ * @param allocator Allocator of the copy. NULL selects alloc_utils_default().
+ */
+char* str_utils_view_dup_with_allocator(t_str_utils_view view, const t_alloc_utils* allocator);
+
+/* -------------------------------------------------------------------------- */
+/* UTF-8                                                                      */
+/* -------------------------------------------------------------------------- */
+
+// UTF-8 encoding of U+FFFD, which replaces ill-formed sequences
+#define STR_UTILS_UTF8_REPLACEMENT "\xef\xbf\xbd"
+
+/**
+ * @brief Returns the offset of the first ill-formed UTF-8 sequence of text, or STR_UTILS_NPOS.
+ *
+ * Overlong forms, surrogates, code points above U+10FFFF and truncated
+ * sequences are ill-formed. Text is validated 16 or 32 bytes at a time
+ * with table lookups; only a block holding an error is scanned bytewise.
+ *
+ * @param invalid_len Receives the length of the ill-formed sequence (its maximal
+ *        subpart, 1 to 3 bytes), which one U+FFFD replaces. Can be NULL.
+ */
+size_t str_utils_utf8_find_invalid(t_str_utils_view text, size_t* invalid_len);
+
+static inline bool str_utils_utf8_valid(t_str_utils_view text)
+{
+    return str_utils_utf8_find_invalid(text, NULL) == STR_UTILS_NPOS;
+}
+
+/**
+ * @brief Converts UTF-8 text to UTF-16, in native byte order.
+ *
+ * @param dst Output, room for text.len units (never exceeded).
+ * @return The number of units written, or STR_UTILS_NPOS if text is not valid UTF-8.
+ */
+size_t str_utils_utf8_to_utf16(t_str_utils_view text, uint16_t* dst);
+
+/**
+ * @brief Converts UTF-16 to UTF-8, not NUL-terminated.
+ *
+ * @param dst Output, room for 3 * len bytes (never exceeded).
+ * @return The number of bytes written, or STR_UTILS_NPOS on an unpaired surrogate.
+ */
+size_t str_utils_utf16_to_utf8(const uint16_t* src, size_t len, char* dst);
+
+/* -------------------------------------------------------------------------- */
+/* String builder                                                             */
+/* -------------------------------------------------------------------------- */
+
+// Bytes stored inside the builder itself before it moves to the heap
+#define STR_UTILS_BUILDER_INLINE_SIZE 64
+
+/**
+ * @brief Growable, always NUL-terminated string.
+ *
+ * Short strings live in the inline buffer, or in a caller buffer given to
+ * str_utils_builder_init_buffer(); longer ones move to the heap, growing
+ * geometrically, in blocks from the builder's allocator.
+ * str_utils_builder_reset() keeps the capacity, so a builder reused across
+ * calls stops allocating once it has reached its peak size.
+ *
+ * The builder may point into itself: it must not be copied or moved once
+ * initialized. Fields are public for stack allocation; treat them as read-only.
+ */
+typedef struct t_str_utils_builder
+{
+    char*  data;      /**< Contents, NUL-terminated. */
+    size_t len;       /**< Length, without the NUL. */
+    size_t capacity;  /**< Bytes available at data, including the NUL. */
+    bool   owned;     /**< data is a heap block owned by the builder. */
+    const t_alloc_utils* allocator;  /**< Allocator of heap blocks. */
+    char   inline_buffer[STR_UTILS_BUILDER_INLINE_SIZE];
+} t_str_utils_builder;
+
+/**
+ * @brief Initializes an empty builder over its inline buffer.
+ */
+void str_utils_builder_init(t_str_utils_builder* builder);
+
+/**
+ * @brief Initializes an empty builder over a caller buffer, used until it is full.
+ *
+ * @param buffer Initial storage, which must outlive the builder. NULL selects the inline buffer.
+ * @param size Size of buffer in bytes, including room for the NUL.
+ */
+void str_utils_builder_init_buffer(t_str_utils_builder* builder, char* buffer, size_t size);
+
+/**
+ * @brief Initializes an empty builder over a caller buffer, then heap blocks from allocator.
+ *
+ * @param buffer Initial storage, which must outlive the builder. NULL selects the inline buffer.
+ * @param size Size of buffer in bytes, including room for the NUL.
+ * @param allocator Allocator of heap blocks, kept across str_utils_builder_free(). NULL selects alloc_utils_default().
+ */
+void str_utils_builder_init_with_allocator(t_str_utils_builder* builder, char* buffer, size_t size,
+                                           const t_alloc_utils* allocator);
+
+/**
+ * @brief Releases heap storage and leaves the builder empty over its inline buffer.
+ */
+void str_utils_builder_free(t_str_utils_builder* builder);
+
+/**
+ * @brief Empties the builder, keeping its storage.
+ */
+void str_utils_builder_reset(t_str_utils_builder* builder);
+
+/**
+ * @brief Ensures extra more bytes can be appended without reallocating.
+ *
+ * @return false on allocation failure, leaving the contents unchanged.
+ */
+bool str_utils_builder_reserve(t_str_utils_builder* builder, size_t extra);
+
+/**
+ * @brief Appends len bytes of str. Inline, so short appends cost a compare and a copy.
+ *
+ * @return false on allocation failure, leaving the contents unchanged.
+ */
+static inline bool str_utils_builder_append(t_str_utils_builder* builder, const char* str, size_t len)
+{
+    if (len >= builder->capacity - builder->len && !str_utils_builder_reserve(builder, len)) return false;
+
+    if (len) memcpy(builder->data + builder->len, str, len);
+    builder->len += len;
+    builder->data[builder->len] = '\0';
+    return true;
+}
+
+static inline bool str_utils_builder_append_char(t_str_utils_builder* builder, char c)
+{
+    if (builder->capacity - builder->len < 2 && !str_utils_builder_reserve(builder, 1)) return false;
+
+    builder->data[builder->len++] = c;
+    builder->data[builder->len] = '\0';
+    return true;
+}
+
+/**
+ * @brief Adds len bytes the caller wrote at data + len, after reserving them.
+ *
+ * Lets producers such as escapers write straight into the builder.
+ */
+void str_utils_builder_commit(t_str_utils_builder* builder, size_t len);
+
+/**
+ * @brief Appends printf-style formatted text, formatting in place when it fits.
+ *
+ * @return false on allocation or formatting failure, leaving the contents unchanged.
+ */
+bool str_utils_builder_appendf(t_str_utils_builder* builder, const char* format, ...);
+bool str_utils_builder_vappendf(t_str_utils_builder* builder, const char* format, va_list args);
+
+static inline bool str_utils_builder_append_view(t_str_utils_builder* builder, t_str_utils_view view)
+{
+    return str_utils_builder_append(builder, view.data, view.len);
+}
+
+/**
+ * @brief Returns a view of the current contents, valid until the next change.
+ */
+static inline t_str_utils_view str_utils_builder_view(const t_str_utils_builder* builder)
+{
+    return (t_str_utils_view){ builder->data, builder->len };
+}
+
+/**
+ * @brief Hands the contents over as a heap string and empties the builder.
+ *
+ * With the default allocator the string is malloc'ed. Otherwise it is a
+ * block of len + 1 bytes from the builder's allocator.
+ *
+ * @return The string, to be freed by the caller, or NULL on allocation failure.
+ */
+char* str_utils_builder_detach(t_str_utils_builder* builder);
+
 #endif /* STR_UTILS_H */
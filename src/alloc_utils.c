@@ -0,0 +1,447 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alloc_utils.h"
+
+#define ALLOC_UTILS_ALIGN _Alignof(max_align_t)
+
+#define ALLOC_UTILS_ARENA_CHUNK_SIZE (64 * 1024)
+
+// Size classes: multiples of 16 up to 128 bytes, then 256, 512 and 1024
+#define ALLOC_UTILS_POOL_CLASSES   11
+#define ALLOC_UTILS_POOL_SLAB_SIZE (64 * 1024)
+
+static size_t alloc_utils_align(size_t size)
+{
+    return (size + ALLOC_UTILS_ALIGN - 1) & ~(ALLOC_UTILS_ALIGN - 1);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Default allocator                                                          */
+/* -------------------------------------------------------------------------- */
+
+static void* alloc_utils_default_alloc(void* context, size_t size)
+{
+    (void)context;
+    return malloc(size);
+}
+
+static void* alloc_utils_default_realloc(void* context, void* pointer, size_t old_size, size_t new_size)
+{
+    (void)context;
+    (void)old_size;
+    return realloc(pointer, new_size);
+}
+
+static void alloc_utils_default_free(void* context, void* pointer, size_t size)
+{
+    (void)context;
+    (void)size;
+    free(pointer);
+}
+
+static const t_alloc_utils s_default = {
+    alloc_utils_default_alloc,
+    alloc_utils_default_realloc,
+    alloc_utils_default_free,
+    NULL
+};
+
+const t_alloc_utils* alloc_utils_default(void)
+{
+    return &s_default;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Bump arena                                                                 */
+/* -------------------------------------------------------------------------- */
+
+typedef struct t_alloc_utils_arena_chunk
+{
+    struct t_alloc_utils_arena_chunk* next;
+    size_t                            size;  // Bytes in data
+    max_align_t                       data[];
+} t_alloc_utils_arena_chunk;
+
+typedef struct t_alloc_utils_arena
+{
+    t_alloc_utils              allocator;
+    size_t                     chunk_size;
+    t_alloc_utils_arena_chunk* chunks;   // Regular chunks, in the order they are filled
+    t_alloc_utils_arena_chunk* current;  // Chunk being filled, NULL before the first block
+    size_t                     offset;   // Bytes taken in current
+    char*                      last;     // Last block bumped from current, NULL once freed or moved on
+    t_alloc_utils_arena_chunk* large;    // Blocks with a chunk of their own, most recent first
+    size_t                     used;
+} t_alloc_utils_arena;
+
+// Gives a large block its own chunk, in front of the large list
+static void* alloc_utils_arena_alloc_large(t_alloc_utils_arena* arena, size_t size)
+{
+    if (size > SIZE_MAX - sizeof(t_alloc_utils_arena_chunk)) return NULL;
+
+    t_alloc_utils_arena_chunk* chunk = malloc(sizeof(t_alloc_utils_arena_chunk) + size);
+    if (!chunk) return NULL;
+
+    chunk->next = arena->large;
+    chunk->size = size;
+    arena->large = chunk;
+    arena->used += size;
+    return chunk->data;
+}
+
+static void* alloc_utils_arena_alloc(void* context, size_t size)
+{
+    t_alloc_utils_arena* arena = context;
+
+    if (size > arena->chunk_size / 4) return alloc_utils_arena_alloc_large(arena, size);
+    size = alloc_utils_align(size ? size : 1);
+
+    if (!arena->current || arena->current->size - arena->offset < size)
+    {
+        // Move on to the next chunk, kept by a reset, or a new one
+        t_alloc_utils_arena_chunk* next = arena->current ? arena->current->next : arena->chunks;
+
+        if (!next)
+        {
+            next = malloc(sizeof(t_alloc_utils_arena_chunk) + arena->chunk_size);
+            if (!next) return NULL;
+
+            next->next = NULL;
+            next->size = arena->chunk_size;
+            if (arena->current) arena->current->next = next;
+            else arena->chunks = next;
+        }
+
+        arena->current = next;
+        arena->offset = 0;
+    }
+
+    char* pointer = (char*)arena->current->data + arena->offset;
+    arena->offset += size;
+    arena->used += size;
+    arena->last = pointer;
+    return pointer;
+}
+
+// The size is not needed: the last block ends at the offset
+static void alloc_utils_arena_release(void* context, void* pointer, size_t size)
+{
+    t_alloc_utils_arena* arena = context;
+    (void)size;
+
+    if (!pointer) return;
+
+    if (arena->large && pointer == (void*)arena->large->data)
+    {
+        t_alloc_utils_arena_chunk* chunk = arena->large;
+        arena->large = chunk->next;
+        arena->used -= chunk->size;
+        free(chunk);
+    }
+    else if (pointer == arena->last)
+    {
+        size_t start = (size_t)(arena->last - (char*)arena->current->data);
+        arena->used -= arena->offset - start;
+        arena->offset = start;
+        arena->last = NULL;
+    }
+}
+
+static void* alloc_utils_arena_realloc(void* context, void* pointer, size_t old_size, size_t new_size)
+{
+    t_alloc_utils_arena* arena = context;
+
+    if (!pointer) return alloc_utils_arena_alloc(arena, new_size);
+
+    // The most recent large block resizes its chunk
+    if (arena->large && pointer == (void*)arena->large->data && new_size > arena->chunk_size / 4)
+    {
+        if (new_size > SIZE_MAX - sizeof(t_alloc_utils_arena_chunk)) return NULL;
+
+        t_alloc_utils_arena_chunk* chunk = realloc(arena->large, sizeof(t_alloc_utils_arena_chunk) + new_size);
+        if (!chunk) return NULL;
+
+        arena->used = arena->used - chunk->size + new_size;
+        chunk->size = new_size;
+        arena->large = chunk;
+        return chunk->data;
+    }
+
+    // The last block grows or shrinks in place while it fits in its chunk
+    if (pointer == arena->last && new_size <= arena->chunk_size / 4)
+    {
+        size_t start = (size_t)(arena->last - (char*)arena->current->data);
+        size_t old_aligned = arena->offset - start;
+        size_t new_aligned = alloc_utils_align(new_size ? new_size : 1);
+
+        if (arena->current->size - start >= new_aligned)
+        {
+            arena->offset = start + new_aligned;
+            arena->used = arena->used - old_aligned + new_aligned;
+            return pointer;
+        }
+    }
+
+    void* moved = alloc_utils_arena_alloc(arena, new_size);
+    if (!moved) return NULL;
+
+    memcpy(moved, pointer, old_size < new_size ? old_size : new_size);
+    alloc_utils_arena_release(arena, pointer, old_size);
+    return moved;
+}
+
+t_alloc_utils_arena* alloc_utils_arena_new(size_t chunk_size)
+{
+    t_alloc_utils_arena* arena = calloc(1, sizeof(t_alloc_utils_arena));
+    if (!arena) return NULL;
+
+    arena->allocator = (t_alloc_utils) {
+        alloc_utils_arena_alloc,
+        alloc_utils_arena_realloc,
+        alloc_utils_arena_release,
+        arena
+    };
+    arena->chunk_size = alloc_utils_align(chunk_size ? chunk_size : ALLOC_UTILS_ARENA_CHUNK_SIZE);
+
+    return arena;
+}
+
+static void alloc_utils_arena_free_large(t_alloc_utils_arena* arena)
+{
+    while (arena->large)
+    {
+        t_alloc_utils_arena_chunk* next = arena->large->next;
+        free(arena->large);
+        arena->large = next;
+    }
+}
+
+void alloc_utils_arena_free(t_alloc_utils_arena* arena)
+{
+    if (!arena) return;
+
+    alloc_utils_arena_free_large(arena);
+
+    while (arena->chunks)
+    {
+        t_alloc_utils_arena_chunk* next = arena->chunks->next;
+        free(arena->chunks);
+        arena->chunks = next;
+    }
+
+    free(arena);
+}
+
+void alloc_utils_arena_reset(t_alloc_utils_arena* arena)
+{
+    if (!arena) return;
+
+    alloc_utils_arena_free_large(arena);
+    arena->current = NULL;
+    arena->offset = 0;
+    arena->last = NULL;
+    arena->used = 0;
+}
+
+const t_alloc_utils* alloc_utils_arena_allocator(t_alloc_utils_arena* arena)
+{
+    return arena ? &arena->allocator : NULL;
+}
+
+size_t alloc_utils_arena_used(const t_alloc_utils_arena* arena)
+{
+    return arena ? arena->used : 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Thread-local pool                                                          */
+/* -------------------------------------------------------------------------- */
+
+typedef struct t_alloc_utils_pool_block
+{
+    struct t_alloc_utils_pool_block* next;
+} t_alloc_utils_pool_block;
+
+typedef struct t_alloc_utils_pool_slab
+{
+    struct t_alloc_utils_pool_slab* next;
+    max_align_t                     data[];
+} t_alloc_utils_pool_slab;
+
+// Free lists of one thread, and the rest of its current slab
+typedef struct t_alloc_utils_pool_cache
+{
+    struct t_alloc_utils_pool_cache* next;  // In s_depot once its thread has exited
+    t_alloc_utils_pool_block*        free[ALLOC_UTILS_POOL_CLASSES];
+    char*                            bump;
+    size_t                           bump_left;
+} t_alloc_utils_pool_cache;
+
+static const size_t s_class_sizes[ALLOC_UTILS_POOL_CLASSES] = { 16, 32, 48, 64, 80, 96, 112, 128, 256, 512, 1024 };
+
+static pthread_mutex_t s_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static t_alloc_utils_pool_slab* s_slabs = NULL;         // Every slab, never freed: blocks move between threads
+static t_alloc_utils_pool_cache* s_depot = NULL;        // Caches of exited threads, waiting for a new one
+
+static pthread_once_t s_pool_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t s_pool_key;
+static _Thread_local t_alloc_utils_pool_cache* s_cache = NULL;
+
+static unsigned alloc_utils_pool_class(size_t size)
+{
+    if (size <= 128) return size ? (unsigned)((size - 1) / 16) : 0;
+    if (size <= 256) return 8;
+    return size <= 512 ? 9 : 10;
+}
+
+static void alloc_utils_pool_cache_destroy(void* value)
+{
+    t_alloc_utils_pool_cache* cache = value;
+
+    // Later destructors of this thread that use the pool get a fresh cache,
+    // which pthread hands back here on its next destructor pass
+    s_cache = NULL;
+
+    pthread_mutex_lock(&s_pool_lock);
+    cache->next = s_depot;
+    s_depot = cache;
+    pthread_mutex_unlock(&s_pool_lock);
+}
+
+static void alloc_utils_pool_create_key(void)
+{
+    pthread_key_create(&s_pool_key, alloc_utils_pool_cache_destroy);
+}
+
+// The calling thread's cache: adopted from an exited thread, or new
+static t_alloc_utils_pool_cache* alloc_utils_pool_cache(void)
+{
+    if (s_cache) return s_cache;
+
+    pthread_once(&s_pool_key_once, alloc_utils_pool_create_key);
+
+    pthread_mutex_lock(&s_pool_lock);
+    t_alloc_utils_pool_cache* cache = s_depot;
+    if (cache) s_depot = cache->next;
+    pthread_mutex_unlock(&s_pool_lock);
+
+    if (!cache)
+    {
+        cache = calloc(1, sizeof(t_alloc_utils_pool_cache));
+        if (!cache) return NULL;
+    }
+
+    if (pthread_setspecific(s_pool_key, cache) != 0)
+    {
+        alloc_utils_pool_cache_destroy(cache);
+        return NULL;
+    }
+
+    s_cache = cache;
+    return cache;
+}
+
+static void* alloc_utils_pool_alloc(void* context, size_t size)
+{
+    (void)context;
+
+    if (size > ALLOC_UTILS_POOL_MAX_SIZE) return malloc(size);
+
+    t_alloc_utils_pool_cache* cache = alloc_utils_pool_cache();
+    if (!cache) return NULL;
+
+    unsigned index = alloc_utils_pool_class(size);
+    t_alloc_utils_pool_block* block = cache->free[index];
+    if (block)
+    {
+        cache->free[index] = block->next;
+        return block;
+    }
+
+    size = s_class_sizes[index];
+    if (cache->bump_left < size)
+    {
+        // The rest of the slab is too small for this class: keep it for smaller ones
+        while (cache->bump_left >= s_class_sizes[0])
+        {
+            unsigned rest = alloc_utils_pool_class(cache->bump_left);
+            if (s_class_sizes[rest] > cache->bump_left) rest--;
+
+            block = (t_alloc_utils_pool_block*)cache->bump;
+            block->next = cache->free[rest];
+            cache->free[rest] = block;
+            cache->bump += s_class_sizes[rest];
+            cache->bump_left -= s_class_sizes[rest];
+        }
+
+        t_alloc_utils_pool_slab* slab = malloc(sizeof(t_alloc_utils_pool_slab) + ALLOC_UTILS_POOL_SLAB_SIZE);
+        if (!slab) return NULL;
+
+        pthread_mutex_lock(&s_pool_lock);
+        slab->next = s_slabs;
+        s_slabs = slab;
+        pthread_mutex_unlock(&s_pool_lock);
+
+        cache->bump = (char*)slab->data;
+        cache->bump_left = ALLOC_UTILS_POOL_SLAB_SIZE;
+    }
+
+    void* pointer = cache->bump;
+    cache->bump += size;
+    cache->bump_left -= size;
+    return pointer;
+}
+
+static void alloc_utils_pool_free(void* context, void* pointer, size_t size)
+{
+    (void)context;
+
+    if (!pointer) return;
+    if (size > ALLOC_UTILS_POOL_MAX_SIZE)
+    {
+        free(pointer);
+        return;
+    }
+
+    // Without a cache the block cannot be kept: it stays in its slab, unused
+    t_alloc_utils_pool_cache* cache = alloc_utils_pool_cache();
+    if (!cache) return;
+
+    unsigned index = alloc_utils_pool_class(size);
+    t_alloc_utils_pool_block* block = pointer;
+    block->next = cache->free[index];
+    cache->free[index] = block;
+}
+
+static void* alloc_utils_pool_realloc(void* context, void* pointer, size_t old_size, size_t new_size)
+{
+    if (!pointer) return alloc_utils_pool_alloc(context, new_size);
+
+    bool old_small = old_size <= ALLOC_UTILS_POOL_MAX_SIZE;
+    bool new_small = new_size <= ALLOC_UTILS_POOL_MAX_SIZE;
+
+    if (!old_small && !new_small) return realloc(pointer, new_size);
+    if (old_small && new_small && alloc_utils_pool_class(old_size) == alloc_utils_pool_class(new_size)) return pointer;
+
+    void* moved = alloc_utils_pool_alloc(context, new_size);
+    if (!moved) return NULL;
+
+    memcpy(moved, pointer, old_size < new_size ? old_size : new_size);
+    alloc_utils_pool_free(context, pointer, old_size);
+    return moved;
+}
+
+static const t_alloc_utils s_pool = {
+    alloc_utils_pool_alloc,
+    alloc_utils_pool_realloc,
+    alloc_utils_pool_free,
+    NULL
+};
+
+const t_alloc_utils* alloc_utils_pool(void)
+{
+    return &s_pool;
+}
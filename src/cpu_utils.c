@@ -0,0 +1,57 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu_utils.h"
+
+// Cached level + 1, 0 until detection ran
+static atomic_int s_level = 0;
+
+static e_cpu_utils_level cpu_utils_detect(void)
+{
+    e_cpu_utils_level level = CPU_UTILS_SCALAR;
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("sse2")) level = CPU_UTILS_SSE2;
+    if (level == CPU_UTILS_SSE2 && __builtin_cpu_supports("sse4.2")) level = CPU_UTILS_SSE42;
+    if (level == CPU_UTILS_SSE42 && __builtin_cpu_supports("avx2")) level = CPU_UTILS_AVX2;
+    if (level == CPU_UTILS_AVX2
+        && __builtin_cpu_supports("avx512f")
+        && __builtin_cpu_supports("avx512bw")
+        && __builtin_cpu_supports("avx512vl"))
+    {
+        level = CPU_UTILS_AVX512;
+    }
+#endif
+
+    const char* cap = getenv("VFC_UTILS_SIMD");
+    if (cap)
+    {
+        e_cpu_utils_level limit = level;
+
+        if (strcmp(cap, "scalar") == 0) limit = CPU_UTILS_SCALAR;
+        else if (strcmp(cap, "sse2") == 0) limit = CPU_UTILS_SSE2;
+        else if (strcmp(cap, "sse4.2") == 0) limit = CPU_UTILS_SSE42;
+        else if (strcmp(cap, "avx2") == 0) limit = CPU_UTILS_AVX2;
+        else if (strcmp(cap, "avx512") == 0) limit = CPU_UTILS_AVX512;
+
+        if (limit < level) level = limit;
+    }
+
+    return level;
+}
+
+e_cpu_utils_level cpu_utils_level(void)
+{
+    int level = atomic_load_explicit(&s_level, memory_order_relaxed);
+
+    if (level == 0)
+    {
+        level = (int)cpu_utils_detect() + 1;
+        atomic_store_explicit(&s_level, level, memory_order_relaxed);
+    }
+
+    return (e_cpu_utils_level)(level - 1);
+}
@@ -3,11 +3,16 @@
 #include "hashtable.h"
 #include "str_utils.h"
 
+// Hash functions take NUL-terminated keys; view keys up to this size are terminated on the stack
+#define HASHTABLE_KEY_BUFFER_SIZE 256
+
 typedef struct t_hashtable_entry
 {
     char* key;
+    size_t key_len;
     void* value;
     t_hashtable_entry* next;
+    char key_data[];  // The key is stored with its entry, in a single allocation
 } t_hashtable_entry;
 
 typedef struct t_hashtable
@@ -16,29 +21,43 @@ typedef struct t_hashtable
     t_hashtable_entry** entries;
     size_t size;
     size_t entries_count;
+    const t_alloc_utils* allocator;
 } t_hashtable;
 
 t_hashtable* hashtable_new(size_t size, hash_function f)
 {
-    t_hashtable* hashtable = malloc(sizeof(t_hashtable));
+    return hashtable_new_with_allocator(size, f, NULL);
+}
+
+t_hashtable* hashtable_new_with_allocator(size_t size, hash_function f, const t_alloc_utils* allocator)
+{
+    allocator = alloc_utils_or_default(allocator);
+
+    t_hashtable* hashtable = alloc_utils_alloc(allocator, sizeof(t_hashtable));
 
     if (!hashtable) return NULL;
     
-    hashtable->entries = calloc(size, sizeof(t_hashtable_entry*));
+    hashtable->entries = alloc_utils_calloc(allocator, size, sizeof(t_hashtable_entry*));
 
     if (!hashtable->entries)
     {
-        free(hashtable);
+        alloc_utils_free(allocator, hashtable, sizeof(t_hashtable));
         return NULL;
     }
     
     hashtable->size = size;
     hashtable->entries_count = 0;
     hashtable->hash = f;
+    hashtable->allocator = allocator;
 
     return hashtable;
 }
 
+static size_t hashtable_entry_size(size_t key_len)
+{
+    return sizeof(t_hashtable_entry) + key_len + 1;
+}
+
 void hashtable_free(t_hashtable* hashtable, void (free_value)(void*))
 {
     if (hashtable == NULL) return;
@@ -53,88 +72,113 @@ void hashtable_free(t_hashtable* hashtable, void (free_value)(void*))
                 free_value(entry->value);
             }
             t_hashtable_entry* next = entry->next;
-            free(entry->key);
-            free(entry);
+            alloc_utils_free(hashtable->allocator, entry, hashtable_entry_size(entry->key_len));
 
             entry = next;
         }
     }
     
-    free(hashtable->entries);
-    free(hashtable);
+    alloc_utils_free(hashtable->allocator, hashtable->entries, hashtable->size * sizeof(t_hashtable_entry*));
+    alloc_utils_free(hashtable->allocator, hashtable, sizeof(t_hashtable));
 }
 
-t_hashtable_value* hashtable_entry_get(t_hashtable* hashtable, char* key)
+// terminated_key is key.data when the caller knows it is NUL-terminated, NULL otherwise
+static bool hashtable_bucket(t_hashtable* hashtable, t_str_utils_view key, const char* terminated_key, size_t* index)
 {
-    if (!hashtable || !key) return NULL;
+    if (terminated_key)
+    {
+        *index = hashtable->hash((char*)terminated_key) % hashtable->size;
+        return true;
+    }
 
-    int index = hashtable->hash(key) % hashtable->size;
-    
-    t_hashtable_entry* entry = hashtable->entries[index];
+    char buffer[HASHTABLE_KEY_BUFFER_SIZE];
+    char* terminated = key.len < sizeof(buffer) ? buffer : alloc_utils_alloc(hashtable->allocator, key.len + 1);
+    if (!terminated) return false;
 
-    if (!entry) return NULL;
+    memcpy(terminated, key.data, key.len);
+    terminated[key.len] = '\0';
+    *index = hashtable->hash(terminated) % hashtable->size;
 
-    while (entry != NULL)
+    if (terminated != buffer) alloc_utils_free(hashtable->allocator, terminated, key.len + 1);
+    return true;
+}
+
+static t_hashtable_entry* hashtable_find(t_hashtable_entry* entry, t_str_utils_view key)
+{
+    for (; entry != NULL; entry = entry->next)
     {
-        if (strcmp(entry->key, key) == 0)
-        {
-            return entry->value;
-        }
-        entry = entry->next;
+        if (entry->key_len == key.len && memcmp(entry->key, key.data, key.len) == 0) return entry;
     }
 
     return NULL;
 }
 
-bool hashtable_entry_set(t_hashtable* hashtable, char* key, void* value)
+static t_hashtable_value* hashtable_get(t_hashtable* hashtable, t_str_utils_view key, const char* terminated_key)
 {
-    if (!hashtable || !key || value == NULL) return false;
+    size_t index;
 
-    int index = hashtable->hash(key) % hashtable->size;
+    if (!hashtable || !key.data || !hashtable_bucket(hashtable, key, terminated_key, &index)) return NULL;
 
-    t_hashtable_entry* entry;
+    t_hashtable_entry* entry = hashtable_find(hashtable->entries[index], key);
+    return entry ? entry->value : NULL;
+}
 
-    if (hashtable->entries[index] == NULL)
-    {
-        entry = malloc(sizeof(t_hashtable_entry));
-        
-        if (!entry) return false;
+static bool hashtable_set(t_hashtable* hashtable, t_str_utils_view key, const char* terminated_key, void* value)
+{
+    size_t index;
 
-        entry->key = (char*)str_utils_strdup(key);
-        entry->value = value;
-        entry->next = NULL;
-        hashtable->entries[index] = entry;
+    if (!hashtable || !key.data || value == NULL || !hashtable_bucket(hashtable, key, terminated_key, &index))
+    {
+        return false;
+    }
 
-        hashtable->entries_count++;
-    } else
+    t_hashtable_entry* entry = hashtable_find(hashtable->entries[index], key);
+    if (entry)
     {
-        entry = hashtable->entries[index];
-        t_hashtable_entry* prev = NULL;
+        entry->value = value;
+        return true;
+    }
 
-        while (entry != NULL) {
-            if (strcmp(entry->key, key) == 0) {
-                entry->value = value;
-                return true;
-            }
-            prev = entry;
-            entry = entry->next;
-        }
+    entry = alloc_utils_alloc(hashtable->allocator, hashtable_entry_size(key.len));
+    if (!entry) return false;
 
-        entry = malloc(sizeof(t_hashtable_entry));
-        if (!entry) return false;
+    memcpy(entry->key_data, key.data, key.len);
+    entry->key_data[key.len] = '\0';
+    entry->key = entry->key_data;
+    entry->key_len = key.len;
+    entry->value = value;
 
-        entry->key = str_utils_strdup(key);
-        entry->value = value;
-        entry->next = NULL;
+    entry->next = NULL;
 
-        prev->next = entry;
+    t_hashtable_entry** link = &hashtable->entries[index];
+    while (*link) link = &(*link)->next;
+    *link = entry;
 
-        hashtable->entries_count++;
-    }
+    hashtable->entries_count++;
 
     return true;
 }
 
+t_hashtable_value* hashtable_entry_get(t_hashtable* hashtable, char* key)
+{
+    return key ? hashtable_get(hashtable, str_utils_view(key), key) : NULL;
+}
+
+t_hashtable_value* hashtable_entry_get_view(t_hashtable* hashtable, t_str_utils_view key)
+{
+    return hashtable_get(hashtable, key, NULL);
+}
+
+bool hashtable_entry_set(t_hashtable* hashtable, char* key, void* value)
+{
+    return key ? hashtable_set(hashtable, str_utils_view(key), key, value) : false;
+}
+
+bool hashtable_entry_set_view(t_hashtable* hashtable, t_str_utils_view key, void* value)
+{
+    return hashtable_set(hashtable, key, NULL, value);
+}
+
 size_t hashtable_entries_count(t_hashtable* hashtable)
 {
     return hashtable ? hashtable->entries_count : 0;
@@ -161,6 +205,28 @@ t_hashtable_key** hashtable_keys(t_hashtable* hashtable)
     return keys;
 }
 
+t_str_utils_view* hashtable_key_views(t_hashtable* hashtable, size_t* count)
+{
+    if (count) *count = 0;
+    if (!hashtable) return NULL;
+
+    t_str_utils_view* keys = malloc((hashtable->entries_count + 1) * sizeof(t_str_utils_view));
+    if (!keys) return NULL;
+
+    size_t index = 0;
+
+    for (size_t i = 0; i < hashtable->size; i++)
+    {
+        for (t_hashtable_entry* current = hashtable->entries[i]; current != NULL; current = current->next)
+        {
+            keys[index++] = (t_str_utils_view){ current->key, current->key_len };
+        }
+    }
+
+    if (count) *count = index;
+    return keys;
+}
+
 t_hashtable_value** hashtable_values(t_hashtable *hashtable)
 {
     if (!hashtable) return NULL;
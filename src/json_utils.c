@@ -1,45 +1,2097 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "cpu_utils.h"
+#include "json_utils.h"
 #include "str_utils.h"
 
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define JSON_UTILS_X86 1
+#endif
+
+const char* json_utils_status_string(e_json_utils_status status)
+{
+    switch (status)
+    {
+        case JSON_UTILS_OK:                    return "ok";
+        case JSON_UTILS_ERROR_SYNTAX:          return "syntax error";
+        case JSON_UTILS_ERROR_DEPTH:           return "maximum nesting depth exceeded";
+        case JSON_UTILS_ERROR_TOKEN_TOO_LARGE: return "token too large";
+        case JSON_UTILS_ERROR_INCOMPLETE:      return "unexpected end of input";
+        case JSON_UTILS_ERROR_ABORTED:         return "aborted by callback";
+        case JSON_UTILS_ERROR_MEMORY:          return "out of memory";
+        default:                               return "unknown status";
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* Structural indexing                                                        */
+/* -------------------------------------------------------------------------- */
+
+/*
+ * Input is classified 64 bytes at a time into one bit per byte. Turning the
+ * classes into positions of interest (structural characters outside strings,
+ * string delimiters, scalar starts) is branch-free, so the parser only
+ * visits those positions instead of testing every byte.
+ */
+typedef struct t_json_utils_block
+{
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t control;     // Bytes below 0x20
+    uint64_t structural;  // { } [ ] : ,
+    uint64_t whitespace;
+} t_json_utils_block;
+
+typedef void (*json_utils_classify_fn)(const char* data, t_json_utils_block* block);
+
+// Index of the first byte that must be escaped ('"', '\\', below 0x20), or len
+typedef size_t (*json_utils_find_fn)(const char* data, size_t len);
+
+static json_utils_classify_fn s_classify;
+static json_utils_find_fn s_find_escape;
+static pthread_once_t s_simd_once = PTHREAD_ONCE_INIT;
+
+static void json_utils_classify_scalar(const char* data, t_json_utils_block* block)
+{
+    memset(block, 0, sizeof(*block));
+
+    for (int i = 0; i < 64; i++)
+    {
+        unsigned char c = (unsigned char)data[i];
+        uint64_t bit = 1ull << i;
+
+        if (c == '"') block->quote |= bit;
+        else if (c == '\\') block->backslash |= bit;
+        else if (c == ' ' || c == '\n' || c == '\r' || c == '\t') block->whitespace |= bit;
+        else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',') block->structural |= bit;
+
+        if (c < 0x20) block->control |= bit;
+    }
+}
+
+static size_t json_utils_find_escape_scalar(const char* data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        unsigned char c = (unsigned char)data[i];
+        if (c == '"' || c == '\\' || c < 0x20) return i;
+    }
+    return len;
+}
+
+#ifdef JSON_UTILS_X86
+
+__attribute__((target("sse2")))
+static void json_utils_classify_sse2(const char* data, t_json_utils_block* block)
+{
+    memset(block, 0, sizeof(*block));
+
+    for (int i = 0; i < 64; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+        // '{' '}' '[' ']' only differ from each other in bits 0x20 and 0x02
+        __m128i brace = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i structural = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(brace, _mm_set1_epi8('{')), _mm_cmpeq_epi8(brace, _mm_set1_epi8('}'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+        __m128i whitespace = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))));
+        __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1f)), v);
+
+        block->quote |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))) << i;
+        block->backslash |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))) << i;
+        block->control |= (uint64_t)(uint16_t)_mm_movemask_epi8(control) << i;
+        block->structural |= (uint64_t)(uint16_t)_mm_movemask_epi8(structural) << i;
+        block->whitespace |= (uint64_t)(uint16_t)_mm_movemask_epi8(whitespace) << i;
+    }
+}
+
+__attribute__((target("sse2")))
+static size_t json_utils_find_escape_sse2(const char* data, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+            _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1f)), v));
+        unsigned mask = (unsigned)_mm_movemask_epi8(special);
+
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+    }
+
+    return i + json_utils_find_escape_scalar(data + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static void json_utils_classify_avx2(const char* data, t_json_utils_block* block)
+{
+    memset(block, 0, sizeof(*block));
+
+    for (int i = 0; i < 64; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i brace = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i structural = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(brace, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(brace, _mm256_set1_epi8('}'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))));
+        __m256i whitespace = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))));
+        __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(0x1f)), v);
+
+        block->quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))) << i;
+        block->backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))) << i;
+        block->control |= (uint64_t)(uint32_t)_mm256_movemask_epi8(control) << i;
+        block->structural |= (uint64_t)(uint32_t)_mm256_movemask_epi8(structural) << i;
+        block->whitespace |= (uint64_t)(uint32_t)_mm256_movemask_epi8(whitespace) << i;
+    }
+}
+
+__attribute__((target("avx2")))
+static size_t json_utils_find_escape_avx2(const char* data, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(0x1f)), v));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(special);
+
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+    }
+
+    // Finish here rather than calling the SSE2 version: mixing legacy SSE
+    // code with dirty upper AVX state stalls on every instruction
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+            _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1f)), v));
+        unsigned mask = (unsigned)_mm_movemask_epi8(special);
+
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+    }
+
+    for (; i < len; i++)
+    {
+        unsigned char c = (unsigned char)data[i];
+        if (c == '"' || c == '\\' || c < 0x20) return i;
+    }
+    return len;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void json_utils_classify_avx512(const char* data, t_json_utils_block* block)
+{
+    __m512i v = _mm512_loadu_si512((const void*)data);
+    __m512i brace = _mm512_or_si512(v, _mm512_set1_epi8(0x20));
+
+    block->quote = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('"'));
+    block->backslash = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\\'));
+    block->control = _mm512_cmplt_epu8_mask(v, _mm512_set1_epi8(0x20));
+    block->structural = _mm512_cmpeq_epi8_mask(brace, _mm512_set1_epi8('{'))
+                      | _mm512_cmpeq_epi8_mask(brace, _mm512_set1_epi8('}'))
+                      | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(':'))
+                      | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(','));
+    block->whitespace = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(' '))
+                      | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\n'))
+                      | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\r'))
+                      | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8('\t'));
+}
+
+#endif /* JSON_UTILS_X86 */
+
+static void json_utils_simd_init(void)
+{
+    s_classify = json_utils_classify_scalar;
+    s_find_escape = json_utils_find_escape_scalar;
+
+#ifdef JSON_UTILS_X86
+    switch (cpu_utils_level())
+    {
+        case CPU_UTILS_AVX512:
+            s_classify = json_utils_classify_avx512;
+            s_find_escape = json_utils_find_escape_avx2;
+            break;
+        case CPU_UTILS_AVX2:
+            s_classify = json_utils_classify_avx2;
+            s_find_escape = json_utils_find_escape_avx2;
+            break;
+        case CPU_UTILS_SSE42:
+        case CPU_UTILS_SSE2:
+            s_classify = json_utils_classify_sse2;
+            s_find_escape = json_utils_find_escape_sse2;
+            break;
+        default:
+            break;
+    }
+#endif
+}
+
+// Bit i set when an odd number of bits at or below i are set
+static inline uint64_t json_utils_prefix_xor(uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// Indexing state carried from one block to the next
+typedef struct t_json_utils_indexer
+{
+    uint64_t in_string;  // All ones inside a string
+    bool     escaped;    // Next byte is escaped by a backslash
+    bool     scalar;     // Previous byte belongs to a number or literal
+} t_json_utils_indexer;
+
+/*
+ * Indexes up to 64 bytes and returns the positions of interest: structural
+ * characters outside strings, unescaped quotes, the first byte of every
+ * number or literal, and control characters inside strings (always errors).
+ */
+static uint64_t json_utils_index_block(t_json_utils_indexer* indexer, const char* data, size_t len, uint64_t* backslashes)
+{
+    t_json_utils_block block;
+
+    if (len == 64)
+    {
+        s_classify(data, &block);
+    }
+    else
+    {
+        char padded[64];
+        memset(padded, ' ', sizeof(padded));
+        memcpy(padded, data, len);
+        s_classify(padded, &block);
+    }
+
+    uint64_t valid = len == 64 ? ~0ull : (1ull << len) - 1;
+    uint64_t last = 1ull << (len - 1);
+
+    *backslashes = block.backslash;
+
+    // Backslashes are rare: resolve escape runs one backslash at a time
+    uint64_t backslash = block.backslash;
+    uint64_t escaped = 0;
+
+    if (indexer->escaped)
+    {
+        escaped = 1;
+        backslash &= ~1ull;
+        indexer->escaped = false;
+    }
+    while (backslash)
+    {
+        uint64_t bit = backslash & -backslash;
+        if (bit == last)
+        {
+            indexer->escaped = true;
+            break;
+        }
+        escaped |= bit << 1;
+        backslash &= ~(bit | bit << 1);
+    }
+
+    uint64_t quote = block.quote & ~escaped;
+    uint64_t in_string = json_utils_prefix_xor(quote) ^ indexer->in_string;
+    indexer->in_string = (in_string & last) ? ~0ull : 0;
+
+    uint64_t scalar = ~(block.whitespace | block.structural | in_string | quote) & valid;
+    uint64_t scalar_start = scalar & ~(scalar << 1 | (uint64_t)indexer->scalar);
+    indexer->scalar = (scalar & last) != 0;
+
+    return ((block.structural & ~in_string) | quote | scalar_start | (block.control & in_string)) & valid;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Escaping                                                                   */
+/* -------------------------------------------------------------------------- */
+
+size_t json_utils_escape_into(char* dst, size_t capacity, const char* str, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+    size_t i = 0;
+    size_t j = 0;
+
+    // Keys and short values are checked inline: a dispatched call costs more than the scan
+    if (len < 16)
+    {
+        size_t clean = json_utils_find_escape_scalar(str, len);
+        if (clean == len)
+        {
+            memcpy(dst, str, len <= capacity ? len : capacity);
+            return len;
+        }
+    }
+
+    pthread_once(&s_simd_once, json_utils_simd_init);
+
+    while (i < len)
+    {
+        // Copy the clean run up to the next byte needing an escape
+        size_t run = s_find_escape(str + i, len - i);
+
+        if (j < capacity) memcpy(dst + j, str + i, run < capacity - j ? run : capacity - j);
+        i += run;
+        j += run;
+
+        if (i >= len) break;
+
+        unsigned char c = (unsigned char)str[i++];
+        char escaped[6] = { '\\', 0 };
+        size_t n = 2;
+
+        switch (c)
+        {
+            case '"':  escaped[1] = '"'; break;
+            case '\\': escaped[1] = '\\'; break;
+            case '\b': escaped[1] = 'b'; break;
+            case '\f': escaped[1] = 'f'; break;
+            case '\n': escaped[1] = 'n'; break;
+            case '\r': escaped[1] = 'r'; break;
+            case '\t': escaped[1] = 't'; break;
+            default:
+                // Other control characters: \u00XX
+                escaped[1] = 'u';
+                escaped[2] = '0';
+                escaped[3] = '0';
+                escaped[4] = hex[c >> 4];
+                escaped[5] = hex[c & 0xf];
+                n = 6;
+                break;
+        }
+
+        if (j + n <= capacity) memcpy(dst + j, escaped, n);
+        else if (j < capacity) memcpy(dst + j, escaped, capacity - j);
+        j += n;
+    }
+
+    return j;
+}
+
+size_t json_utils_escape_utf8_into(char* dst, size_t capacity, const char* str, size_t len)
+{
+    size_t i = 0;
+    size_t j = 0;
+
+    // Escape each valid run, then replace the ill-formed sequence that ends it
+    for (;;)
+    {
+        size_t invalid_len;
+        size_t run = str_utils_utf8_find_invalid(str_utils_view_of(str + i, len - i), &invalid_len);
+        if (run == STR_UTILS_NPOS) run = len - i;
+
+        j += json_utils_escape_into(dst + (j < capacity ? j : capacity), j < capacity ? capacity - j : 0, str + i, run);
+        i += run;
+        if (i >= len) return j;
+
+        static const char replacement[] = STR_UTILS_UTF8_REPLACEMENT;
+        if (j + 3 <= capacity) memcpy(dst + j, replacement, 3);
+        else if (j < capacity) memcpy(dst + j, replacement, capacity - j);
+        j += 3;
+        i += invalid_len;
+    }
+}
+
 char* json_utils_escape(const char* str)
 {
     if (!str) return str_utils_strdup("null");
-    
-    // Calculate required size (worst case: every char needs escaping)
+
     size_t len = strlen(str);
-    size_t escaped_size = len * 2 + 1;
-    
-    char* escaped = malloc(escaped_size);
+
+    // Enough for mostly clean text; the worst case (6 bytes per byte) takes a second pass
+    size_t capacity = len + len / 8 + 16;
+    char* escaped = malloc(capacity + 1);
     if (!escaped) return NULL;
-    
-    size_t j = 0;
-    for (size_t i = 0; i < len; i++)
+
+    size_t escaped_len = json_utils_escape_into(escaped, capacity, str, len);
+    if (escaped_len > capacity)
     {
-        switch (str[i])
+        char* larger = realloc(escaped, escaped_len + 1);
+        if (!larger)
         {
-            case '"':  escaped[j++] = '\\'; escaped[j++] = '"'; break;
-            case '\\': escaped[j++] = '\\'; escaped[j++] = '\\'; break;
-            case '\b': escaped[j++] = '\\'; escaped[j++] = 'b'; break;
-            case '\f': escaped[j++] = '\\'; escaped[j++] = 'f'; break;
-            case '\n': escaped[j++] = '\\'; escaped[j++] = 'n'; break;
-            case '\r': escaped[j++] = '\\'; escaped[j++] = 'r'; break;
-            case '\t': escaped[j++] = '\\'; escaped[j++] = 't'; break;
-            default:
-                if ((unsigned char)str[i] < 0x20)
-                {
-                    // Control characters: \uXXXX
-                    j += snprintf(escaped + j, escaped_size - j, "\\u%04x", (unsigned char)str[i]);
-                }
-                else
-                {
-                    escaped[j++] = str[i];
-                }
-                break;
+            free(escaped);
+            return NULL;
         }
+        escaped = larger;
+        json_utils_escape_into(escaped, escaped_len, str, len);
     }
-    escaped[j] = '\0';
-    
+    escaped[escaped_len] = '\0';
+
     return escaped;
 }
+
+/* -------------------------------------------------------------------------- */
+/* Writer                                                                     */
+/* -------------------------------------------------------------------------- */
+
+#define JSON_UTILS_WRITER_DEFAULT_CAPACITY 256
+
+typedef struct t_json_utils_writer
+{
+    char*  data;
+    size_t len;
+    size_t capacity;  // One byte is always kept for the NUL terminator, written on demand
+    bool   comma;     // The next key or value follows a sibling
+    bool   failed;
+    bool   replace_invalid_utf8;
+    const t_alloc_utils* allocator;
+} t_json_utils_writer;
+
+t_json_utils_writer* json_utils_writer_new(size_t capacity)
+{
+    return json_utils_writer_new_with_allocator(capacity, NULL);
+}
+
+t_json_utils_writer* json_utils_writer_new_with_allocator(size_t capacity, const t_alloc_utils* allocator)
+{
+    allocator = alloc_utils_or_default(allocator);
+
+    t_json_utils_writer* writer = alloc_utils_calloc(allocator, 1, sizeof(t_json_utils_writer));
+    if (!writer) return NULL;
+
+    writer->allocator = allocator;
+    writer->capacity = capacity ? capacity : JSON_UTILS_WRITER_DEFAULT_CAPACITY;
+    writer->data = alloc_utils_alloc(allocator, writer->capacity);
+    if (!writer->data)
+    {
+        alloc_utils_free(allocator, writer, sizeof(t_json_utils_writer));
+        return NULL;
+    }
+
+    writer->data[0] = '\0';
+    return writer;
+}
+
+void json_utils_writer_free(t_json_utils_writer* writer)
+{
+    if (!writer) return;
+
+    alloc_utils_free(writer->allocator, writer->data, writer->capacity);
+    alloc_utils_free(writer->allocator, writer, sizeof(t_json_utils_writer));
+}
+
+void json_utils_writer_reset(t_json_utils_writer* writer)
+{
+    if (!writer) return;
+
+    writer->len = 0;
+    writer->comma = false;
+    writer->failed = false;
+    writer->data[0] = '\0';
+}
+
+void json_utils_writer_set_replace_invalid_utf8(t_json_utils_writer* writer, bool enabled)
+{
+    if (writer) writer->replace_invalid_utf8 = enabled;
+}
+
+const char* json_utils_writer_data(t_json_utils_writer* writer, size_t* len)
+{
+    if (!writer || writer->failed) return NULL;
+
+    writer->data[writer->len] = '\0';
+
+    if (len) *len = writer->len;
+    return writer->data;
+}
+
+// Makes room for extra more bytes plus the terminator
+static bool json_utils_writer_reserve(t_json_utils_writer* writer, size_t extra)
+{
+    if (writer->failed) return false;
+    if (writer->capacity - writer->len > extra) return true;
+
+    size_t capacity = writer->capacity;
+    while (capacity - writer->len <= extra) capacity *= 2;
+
+    char* data = alloc_utils_realloc(writer->allocator, writer->data, writer->capacity, capacity);
+    if (!data)
+    {
+        writer->failed = true;
+        return false;
+    }
+
+    writer->data = data;
+    writer->capacity = capacity;
+    return true;
+}
+
+static bool json_utils_writer_raw(t_json_utils_writer* writer, const char* str, size_t len)
+{
+    if (!json_utils_writer_reserve(writer, len)) return false;
+
+    memcpy(writer->data + writer->len, str, len);
+    writer->len += len;
+    return true;
+}
+
+// Writes the comma owed to a previous sibling, then str
+static bool json_utils_writer_token(t_json_utils_writer* writer, const char* str, size_t len, bool comma_after)
+{
+    if (!json_utils_writer_reserve(writer, len + 1)) return false;
+
+    if (writer->comma) writer->data[writer->len++] = ',';
+    memcpy(writer->data + writer->len, str, len);
+    writer->len += len;
+
+    writer->comma = comma_after;
+    return true;
+}
+
+static bool json_utils_writer_quoted(t_json_utils_writer* writer, const char* str, size_t len,
+                                     const char* suffix, size_t suffix_len)
+{
+    if (!json_utils_writer_token(writer, "\"", 1, false)) return false;
+
+    // Escape into the free space; only text with many escapes needs a second pass
+    if (!json_utils_writer_reserve(writer, len + suffix_len)) return false;
+
+    size_t (*escape)(char*, size_t, const char*, size_t) =
+        writer->replace_invalid_utf8 ? json_utils_escape_utf8_into : json_utils_escape_into;
+
+    size_t room = writer->capacity - writer->len - 1;
+    size_t escaped = escape(writer->data + writer->len, room, str, len);
+    if (escaped > room)
+    {
+        if (!json_utils_writer_reserve(writer, escaped + suffix_len)) return false;
+        escape(writer->data + writer->len, escaped, str, len);
+    }
+    writer->len += escaped;
+
+    return json_utils_writer_raw(writer, suffix, suffix_len);
+}
+
+bool json_utils_writer_begin_object(t_json_utils_writer* writer)
+{
+    return writer && json_utils_writer_token(writer, "{", 1, false);
+}
+
+bool json_utils_writer_end_object(t_json_utils_writer* writer)
+{
+    if (!writer) return false;
+
+    writer->comma = false;
+    return json_utils_writer_token(writer, "}", 1, true);
+}
+
+bool json_utils_writer_begin_array(t_json_utils_writer* writer)
+{
+    return writer && json_utils_writer_token(writer, "[", 1, false);
+}
+
+bool json_utils_writer_end_array(t_json_utils_writer* writer)
+{
+    if (!writer) return false;
+
+    writer->comma = false;
+    return json_utils_writer_token(writer, "]", 1, true);
+}
+
+bool json_utils_writer_key(t_json_utils_writer* writer, const char* key)
+{
+    if (!key) return false;
+
+    return json_utils_writer_key_view(writer, str_utils_view(key));
+}
+
+bool json_utils_writer_key_view(t_json_utils_writer* writer, t_str_utils_view key)
+{
+    if (!writer || !key.data) return false;
+
+    if (!json_utils_writer_quoted(writer, key.data, key.len, "\":", 2)) return false;
+    writer->comma = false;
+    return true;
+}
+
+bool json_utils_writer_string(t_json_utils_writer* writer, const char* value)
+{
+    return json_utils_writer_string_view(writer, str_utils_view(value));
+}
+
+bool json_utils_writer_string_view(t_json_utils_writer* writer, t_str_utils_view value)
+{
+    if (!writer) return false;
+    if (!value.data) return json_utils_writer_null(writer);
+
+    if (!json_utils_writer_quoted(writer, value.data, value.len, "\"", 1)) return false;
+    writer->comma = true;
+    return true;
+}
+
+bool json_utils_writer_int(t_json_utils_writer* writer, int64_t value)
+{
+    if (!writer) return false;
+
+    char buffer[STR_UTILS_I64_BUFFER_SIZE];
+    return json_utils_writer_token(writer, buffer, str_utils_format_i64(buffer, value), true);
+}
+
+bool json_utils_writer_double(t_json_utils_writer* writer, double value)
+{
+    if (!writer) return false;
+    if (!isfinite(value)) return json_utils_writer_null(writer);
+
+    char buffer[STR_UTILS_DOUBLE_BUFFER_SIZE];
+    return json_utils_writer_token(writer, buffer, str_utils_format_double(buffer, value), true);
+}
+
+bool json_utils_writer_bool(t_json_utils_writer* writer, bool value)
+{
+    if (!writer) return false;
+
+    return value
+        ? json_utils_writer_token(writer, "true", 4, true)
+        : json_utils_writer_token(writer, "false", 5, true);
+}
+
+bool json_utils_writer_null(t_json_utils_writer* writer)
+{
+    return writer && json_utils_writer_token(writer, "null", 4, true);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Token decoding                                                             */
+/* -------------------------------------------------------------------------- */
+
+static int json_utils_hex4(const char* s)
+{
+    int value = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        char c = s[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= c - '0';
+        else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else return -1;
+    }
+
+    return value;
+}
+
+static size_t json_utils_utf8_encode(char* out, uint32_t cp)
+{
+    if (cp < 0x80)
+    {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800)
+    {
+        out[0] = (char)(0xc0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3f));
+        return 2;
+    }
+    if (cp < 0x10000)
+    {
+        out[0] = (char)(0xe0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3f));
+        out[2] = (char)(0x80 | (cp & 0x3f));
+        return 3;
+    }
+    out[0] = (char)(0xf0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3f));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3f));
+    out[3] = (char)(0x80 | (cp & 0x3f));
+    return 4;
+}
+
+/*
+ * Decodes the escapes of a raw string body (without quotes) into dst, which
+ * may be src itself: the output never outgrows the input.
+ */
+static bool json_utils_unescape(const char* src, size_t len, char* dst, size_t* out_len)
+{
+    size_t i = 0;
+    size_t j = 0;
+
+    while (i < len)
+    {
+        const char* backslash = memchr(src + i, '\\', len - i);
+        size_t run = backslash ? (size_t)(backslash - (src + i)) : len - i;
+
+        memmove(dst + j, src + i, run);
+        i += run;
+        j += run;
+
+        if (i >= len) break;
+        if (i + 1 >= len) return false;
+
+        char escape = src[i + 1];
+        i += 2;
+
+        switch (escape)
+        {
+            case '"':  dst[j++] = '"'; break;
+            case '\\': dst[j++] = '\\'; break;
+            case '/':  dst[j++] = '/'; break;
+            case 'b':  dst[j++] = '\b'; break;
+            case 'f':  dst[j++] = '\f'; break;
+            case 'n':  dst[j++] = '\n'; break;
+            case 'r':  dst[j++] = '\r'; break;
+            case 't':  dst[j++] = '\t'; break;
+            case 'u':
+            {
+                if (len - i < 4) return false;
+                int cp = json_utils_hex4(src + i);
+                if (cp < 0) return false;
+                i += 4;
+
+                if (cp >= 0xd800 && cp <= 0xdbff)
+                {
+                    // High surrogate: must be followed by an escaped low surrogate
+                    if (len - i < 6 || src[i] != '\\' || src[i + 1] != 'u') return false;
+                    int low = json_utils_hex4(src + i + 2);
+                    if (low < 0xdc00 || low > 0xdfff) return false;
+                    i += 6;
+                    cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                }
+                else if (cp >= 0xdc00 && cp <= 0xdfff)
+                {
+                    return false;
+                }
+
+                j += json_utils_utf8_encode(dst + j, (uint32_t)cp);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+
+    *out_len = j;
+    return true;
+}
+
+static bool json_utils_is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static bool json_utils_valid_number(const char* s, size_t n)
+{
+    size_t i = 0;
+
+    if (i < n && s[i] == '-') i++;
+    if (i >= n) return false;
+
+    if (s[i] == '0')
+    {
+        i++;
+    }
+    else if (s[i] >= '1' && s[i] <= '9')
+    {
+        while (i < n && json_utils_is_digit(s[i])) i++;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (i < n && s[i] == '.')
+    {
+        size_t digits = ++i;
+        while (i < n && json_utils_is_digit(s[i])) i++;
+        if (i == digits) return false;
+    }
+
+    if (i < n && (s[i] == 'e' || s[i] == 'E'))
+    {
+        i++;
+        if (i < n && (s[i] == '+' || s[i] == '-')) i++;
+        size_t digits = i;
+        while (i < n && json_utils_is_digit(s[i])) i++;
+        if (i == digits) return false;
+    }
+
+    return i == n;
+}
+
+static bool json_utils_is_whitespace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static bool json_utils_is_number_char(char c)
+{
+    return json_utils_is_digit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+// Numbers and literals end at whitespace or structure: "12x" or "true\"" are errors
+static bool json_utils_is_scalar_end(char c)
+{
+    return json_utils_is_whitespace(c) || c == ',' || c == ']' || c == '}' || c == ':' || c == '[' || c == '{';
+}
+
+/* -------------------------------------------------------------------------- */
+/* Streaming parser                                                           */
+/* -------------------------------------------------------------------------- */
+
+#define JSON_UTILS_DEFAULT_MAX_DEPTH      1024
+#define JSON_UTILS_DEFAULT_MAX_TOKEN_SIZE (1024 * 1024)
+
+typedef enum e_json_utils_parser_state
+{
+    JSON_UTILS_STATE_VALUE,
+    JSON_UTILS_STATE_VALUE_OR_ARRAY_END,
+    JSON_UTILS_STATE_KEY_OR_OBJECT_END,
+    JSON_UTILS_STATE_KEY,
+    JSON_UTILS_STATE_COLON,
+    JSON_UTILS_STATE_COMMA_OR_END,
+    JSON_UTILS_STATE_DONE
+} e_json_utils_parser_state;
+
+// Token left unfinished at the end of the previous chunk
+typedef enum e_json_utils_token
+{
+    JSON_UTILS_TOKEN_NONE,
+    JSON_UTILS_TOKEN_STRING,
+    JSON_UTILS_TOKEN_KEY,
+    JSON_UTILS_TOKEN_NUMBER,
+    JSON_UTILS_TOKEN_LITERAL
+} e_json_utils_token;
+
+// Outcome of a parsing step
+typedef enum e_json_utils_step
+{
+    JSON_UTILS_STEP_DONE,
+    JSON_UTILS_STEP_PENDING,  // Chunk ended inside a token
+    JSON_UTILS_STEP_ERROR
+} e_json_utils_step;
+
+typedef struct t_json_utils_parser
+{
+    t_json_utils_callbacks      callbacks;
+    void*                       context;
+    t_json_utils_parser_options options;
+
+    char*                       stack;          // '{' or '[' per open container
+    size_t                      depth;
+    e_json_utils_parser_state   state;
+
+    e_json_utils_token          token;
+    char*                       buffer;         // Raw, then decoded, token bytes
+    size_t                      buffer_len;
+    size_t                      buffer_capacity;
+
+    t_json_utils_indexer        indexer;
+
+    size_t                      offset;
+    e_json_utils_status         status;
+} t_json_utils_parser;
+
+// Walks the positions of interest of one chunk
+typedef struct t_json_utils_cursor
+{
+    const char* data;
+    size_t      len;
+    size_t      base;         // Offset of the block holding bits
+    size_t      next;         // Offset of the next block to index
+    uint64_t    bits;         // Positions of the current block not visited yet
+    uint64_t    backslashes;  // Backslashes of the current block
+} t_json_utils_cursor;
+
+// The arguments start with the context, so that __VA_ARGS__ is never empty (C11)
+#define JSON_UTILS_CALLBACK(parser, name, ...)                                                     \
+    ((parser)->callbacks.name && !(parser)->callbacks.name(__VA_ARGS__)                            \
+        ? json_utils_parser_fail((parser), JSON_UTILS_ERROR_ABORTED)                               \
+        : JSON_UTILS_STEP_DONE)
+
+static e_json_utils_step json_utils_parser_fail(t_json_utils_parser* parser, e_json_utils_status status)
+{
+    parser->status = status;
+    return JSON_UTILS_STEP_ERROR;
+}
+
+// Returns the next position of interest, or len at the end of the chunk
+static inline size_t json_utils_cursor_next(t_json_utils_parser* parser, t_json_utils_cursor* cursor)
+{
+    while (!cursor->bits)
+    {
+        if (cursor->next >= cursor->len) return cursor->len;
+
+        size_t n = cursor->len - cursor->next < 64 ? cursor->len - cursor->next : 64;
+        cursor->base = cursor->next;
+        cursor->bits = json_utils_index_block(&parser->indexer, cursor->data + cursor->base, n, &cursor->backslashes);
+        cursor->next += n;
+    }
+
+    size_t pos = cursor->base + (size_t)__builtin_ctzll(cursor->bits);
+    cursor->bits &= cursor->bits - 1;
+    return pos;
+}
+
+static bool json_utils_parser_reserve(t_json_utils_parser* parser, size_t size)
+{
+    if (size > parser->options.max_token_size)
+    {
+        json_utils_parser_fail(parser, JSON_UTILS_ERROR_TOKEN_TOO_LARGE);
+        return false;
+    }
+
+    if (size <= parser->buffer_capacity) return true;
+
+    size_t capacity = parser->buffer_capacity ? parser->buffer_capacity : 256;
+    while (capacity < size) capacity *= 2;
+    if (capacity > parser->options.max_token_size) capacity = parser->options.max_token_size;
+
+    char* buffer = alloc_utils_realloc(parser->options.allocator, parser->buffer, parser->buffer_capacity, capacity);
+    if (!buffer)
+    {
+        json_utils_parser_fail(parser, JSON_UTILS_ERROR_MEMORY);
+        return false;
+    }
+
+    parser->buffer = buffer;
+    parser->buffer_capacity = capacity;
+    return true;
+}
+
+static bool json_utils_parser_buffer_append(t_json_utils_parser* parser, const char* data, size_t len)
+{
+    if (!len) return true;
+    if (!json_utils_parser_reserve(parser, parser->buffer_len + len)) return false;
+
+    memcpy(parser->buffer + parser->buffer_len, data, len);
+    parser->buffer_len += len;
+    return true;
+}
+
+static e_json_utils_step json_utils_parser_value_done(t_json_utils_parser* parser)
+{
+    if (parser->depth > 0)
+    {
+        parser->state = JSON_UTILS_STATE_COMMA_OR_END;
+        return JSON_UTILS_STEP_DONE;
+    }
+
+    parser->state = JSON_UTILS_STATE_DONE;
+    return JSON_UTILS_CALLBACK(parser, on_document_end, parser->context);
+}
+
+static e_json_utils_step json_utils_parser_push(t_json_utils_parser* parser, char container)
+{
+    if (parser->depth >= parser->options.max_depth)
+    {
+        return json_utils_parser_fail(parser, JSON_UTILS_ERROR_DEPTH);
+    }
+
+    parser->stack[parser->depth++] = container;
+
+    if (container == '{')
+    {
+        parser->state = JSON_UTILS_STATE_KEY_OR_OBJECT_END;
+        return JSON_UTILS_CALLBACK(parser, on_object_begin, parser->context);
+    }
+
+    parser->state = JSON_UTILS_STATE_VALUE_OR_ARRAY_END;
+    return JSON_UTILS_CALLBACK(parser, on_array_begin, parser->context);
+}
+
+static e_json_utils_step json_utils_parser_pop(t_json_utils_parser* parser)
+{
+    char container = parser->stack[--parser->depth];
+    e_json_utils_step step = container == '{'
+        ? JSON_UTILS_CALLBACK(parser, on_object_end, parser->context)
+        : JSON_UTILS_CALLBACK(parser, on_array_end, parser->context);
+
+    return step == JSON_UTILS_STEP_DONE ? json_utils_parser_value_done(parser) : step;
+}
+
+static e_json_utils_step json_utils_parser_emit_string(t_json_utils_parser* parser, const char* raw, size_t len, bool escaped)
+{
+    const char* text = len ? raw : "";
+    size_t text_len = len;
+    bool is_key = parser->token == JSON_UTILS_TOKEN_KEY;
+
+    parser->token = JSON_UTILS_TOKEN_NONE;
+
+    if (escaped)
+    {
+        // Decode in place when the raw bytes already sit in the token buffer
+        if (raw != parser->buffer && !json_utils_parser_reserve(parser, len)) return JSON_UTILS_STEP_ERROR;
+        if (!json_utils_unescape(raw, len, parser->buffer, &text_len))
+        {
+            return json_utils_parser_fail(parser, JSON_UTILS_ERROR_SYNTAX);
+        }
+        text = parser->buffer;
+    }
+
+    if (is_key)
+    {
+        parser->state = JSON_UTILS_STATE_COLON;
+        return JSON_UTILS_CALLBACK(parser, on_key, parser->context, text, text_len);
+    }
+
+    e_json_utils_step step = JSON_UTILS_CALLBACK(parser, on_string, parser->context, text, text_len);
+    return step == JSON_UTILS_STEP_DONE ? json_utils_parser_value_done(parser) : step;
+}
+
+/*
+ * Reads a string body starting at start; the closing quote is the next
+ * position of interest. Bodies that end in the chunk and contain no escape
+ * are passed to the callback without any copy.
+ */
+static e_json_utils_step json_utils_parser_string(t_json_utils_parser* parser, t_json_utils_cursor* cursor,
+                                                  size_t start, bool resume)
+{
+    const char* data = cursor->data;
+    size_t end = json_utils_cursor_next(parser, cursor);
+
+    if (!resume) parser->buffer_len = 0;
+
+    if (end >= cursor->len)
+    {
+        if (!json_utils_parser_buffer_append(parser, data + start, cursor->len - start)) return JSON_UTILS_STEP_ERROR;
+        return JSON_UTILS_STEP_PENDING;
+    }
+
+    // Anything else than the closing quote is a control character
+    if (data[end] != '"') return json_utils_parser_fail(parser, JSON_UTILS_ERROR_SYNTAX);
+
+    if (resume)
+    {
+        if (!json_utils_parser_buffer_append(parser, data + start, end - start)) return JSON_UTILS_STEP_ERROR;
+        return json_utils_parser_emit_string(parser, parser->buffer, parser->buffer_len,
+                                             parser->buffer_len && memchr(parser->buffer, '\\', parser->buffer_len));
+    }
+
+    // Within one block the backslash bits tell exactly whether the body has escapes
+    bool escaped;
+    if (start >= cursor->base)
+    {
+        uint64_t from = ~0ull << (start - cursor->base);
+        uint64_t to = (1ull << (end - cursor->base)) - 1;
+        escaped = (cursor->backslashes & from & to) != 0;
+    }
+    else
+    {
+        escaped = memchr(data + start, '\\', end - start) != NULL;
+    }
+
+    return json_utils_parser_emit_string(parser, data + start, end - start, escaped);
+}
+
+static e_json_utils_step json_utils_parser_emit_scalar(t_json_utils_parser* parser, const char* text, size_t len)
+{
+    e_json_utils_token token = parser->token;
+    e_json_utils_step step;
+
+    parser->token = JSON_UTILS_TOKEN_NONE;
+
+    if (token == JSON_UTILS_TOKEN_NUMBER)
+    {
+        if (!json_utils_valid_number(text, len)) return json_utils_parser_fail(parser, JSON_UTILS_ERROR_SYNTAX);
+        step = JSON_UTILS_CALLBACK(parser, on_number, parser->context, text, len);
+    }
+    else if (len == 4 && memcmp(text, "true", 4) == 0)
+    {
+        step = JSON_UTILS_CALLBACK(parser, on_bool, parser->context, true);
+    }
+    else if (len == 5 && memcmp(text, "false", 5) == 0)
+    {
+        step = JSON_UTILS_CALLBACK(parser, on_bool, parser->context, false);
+    }
+    else if (len == 4 && memcmp(text, "null", 4) == 0)
+    {
+        step = JSON_UTILS_CALLBACK(parser, on_null, parser->context);
+    }
+    else
+    {
+        return json_utils_parser_fail(parser, JSON_UTILS_ERROR_SYNTAX);
+    }
+
+    return step == JSON_UTILS_STEP_DONE ? json_utils_parser_value_done(parser) : step;
+}
+
+/*
+ * Reads a number or a literal (true, false, null) starting at start. Its
+ * bytes are not positions of interest, so they are scanned directly.
+ */
+static e_json_utils_step json_utils_parser_scalar(t_json_utils_parser* parser, const char* data, size_t len,
+                                                  size_t start, bool resume)
+{
+    size_t i = start;
+
+    if (!resume) parser->buffer_len = 0;
+
+    if (parser->token == JSON_UTILS_TOKEN_NUMBER)
+    {
+        while (i < len && json_utils_is_number_char(data[i])) i++;
+    }
+    else
+    {
+        while (i < len && data[i] >= 'a' && data[i] <= 'z') i++;
+    }
+
+    if (i >= len)
+    {
+        if (!json_utils_parser_buffer_append(parser, data + start, len - start)) return JSON_UTILS_STEP_ERROR;
+        return JSON_UTILS_STEP_PENDING;
+    }
+
+    if (!json_utils_is_scalar_end(data[i])) return json_utils_parser_fail(parser, JSON_UTILS_ERROR_SYNTAX);
+
+    if (resume)
+    {
+        if (!json_utils_parser_buffer_append(parser, data + start, i - start)) return JSON_UTILS_STEP_ERROR;
+        return json_utils_parser_emit_scalar(parser, parser->buffer, parser->buffer_len);
+    }
+
+    return json_utils_parser_emit_scalar(parser, data + start, i - start);
+}
+
+static e_json_utils_step json_utils_parser_begin_value(t_json_utils_parser* parser, t_json_utils_cursor* cursor, size_t pos)
+{
+    char c = cursor->data[pos];
+
+    switch (c)
+    {
+        case '{':
+        case '[':
+            return json_utils_parser_push(parser, c);
+        case '"':
+            parser->token = JSON_UTILS_TOKEN_STRING;
+            return json_utils_parser_string(parser, cursor, pos + 1, false);
+        case 't':
+        case 'f':
+        case 'n':
+            parser->token = JSON_UTILS_TOKEN_LITERAL;
+            return json_utils_parser_scalar(parser, cursor->data, cursor->len, pos, false);
+        default:
+            if (c == '-' || json_utils_is_digit(c))
+            {
+                parser->token = JSON_UTILS_TOKEN_NUMBER;
+                return json_utils_parser_scalar(parser, cursor->data, cursor->len, pos, false);
+            }
+            return json_utils_parser_fail(parser, JSON_UTILS_ERROR_SYNTAX);
+    }
+}
+
+static e_json_utils_step json_utils_parser_step(t_json_utils_parser* parser, t_json_utils_cursor* cursor, size_t pos)
+{
+    char c = cursor->data[pos];
+
+    switch (parser->state)
+    {
+        case JSON_UTILS_STATE_DONE:
+            if (!parser->options.multiple_values) return json_utils_parser_fail(parser, JSON_UTILS_ERROR_SYNTAX);
+            return json_utils_parser_begin_value(parser, cursor, pos);
+
+        case JSON_UTILS_STATE_VALUE_OR_ARRAY_END:
+            if (c == ']') return json_utils_parser_pop(parser);
+            return json_utils_parser_begin_value(parser, cursor, pos);
+
+        case JSON_UTILS_STATE_VALUE:
+            return json_utils_parser_begin_value(parser, cursor, pos);
+
+        case JSON_UTILS_STATE_KEY_OR_OBJECT_END:
+            if (c == '}') return json_utils_parser_pop(parser);
+            /* fall through */
+        case JSON_UTILS_STATE_KEY:
+            if (c != '"') return json_utils_parser_fail(parser, JSON_UTILS_ERROR_SYNTAX);
+            parser->token = JSON_UTILS_TOKEN_KEY;
+            return json_utils_parser_string(parser, cursor, pos + 1, false);
+
+        case JSON_UTILS_STATE_COLON:
+            if (c != ':') return json_utils_parser_fail(parser, JSON_UTILS_ERROR_SYNTAX);
+            parser->state = JSON_UTILS_STATE_VALUE;
+            return JSON_UTILS_STEP_DONE;
+
+        case JSON_UTILS_STATE_COMMA_OR_END:
+        {
+            char container = parser->stack[parser->depth - 1];
+
+            if (c == ',')
+            {
+                parser->state = container == '{' ? JSON_UTILS_STATE_KEY : JSON_UTILS_STATE_VALUE;
+                return JSON_UTILS_STEP_DONE;
+            }
+            if ((c == '}' && container == '{') || (c == ']' && container == '['))
+            {
+                return json_utils_parser_pop(parser);
+            }
+            return json_utils_parser_fail(parser, JSON_UTILS_ERROR_SYNTAX);
+        }
+    }
+
+    return json_utils_parser_fail(parser, JSON_UTILS_ERROR_SYNTAX);
+}
+
+t_json_utils_parser* json_utils_parser_new(const t_json_utils_callbacks* callbacks, void* context,
+                                           const t_json_utils_parser_options* options)
+{
+    pthread_once(&s_simd_once, json_utils_simd_init);
+
+    const t_alloc_utils* allocator = alloc_utils_or_default(options ? options->allocator : NULL);
+
+    t_json_utils_parser* parser = alloc_utils_calloc(allocator, 1, sizeof(t_json_utils_parser));
+    if (!parser) return NULL;
+
+    if (callbacks) parser->callbacks = *callbacks;
+    if (options) parser->options = *options;
+    if (!parser->options.max_depth) parser->options.max_depth = JSON_UTILS_DEFAULT_MAX_DEPTH;
+    if (!parser->options.max_token_size) parser->options.max_token_size = JSON_UTILS_DEFAULT_MAX_TOKEN_SIZE;
+    parser->options.allocator = allocator;
+
+    parser->context = context;
+    parser->stack = alloc_utils_alloc(allocator, parser->options.max_depth);
+    if (!parser->stack)
+    {
+        alloc_utils_free(allocator, parser, sizeof(t_json_utils_parser));
+        return NULL;
+    }
+
+    json_utils_parser_reset(parser);
+    return parser;
+}
+
+void json_utils_parser_free(t_json_utils_parser* parser)
+{
+    if (!parser) return;
+
+    const t_alloc_utils* allocator = parser->options.allocator;
+
+    alloc_utils_free(allocator, parser->stack, parser->options.max_depth);
+    alloc_utils_free(allocator, parser->buffer, parser->buffer_capacity);
+    alloc_utils_free(allocator, parser, sizeof(t_json_utils_parser));
+}
+
+void json_utils_parser_reset(t_json_utils_parser* parser)
+{
+    if (!parser) return;
+
+    parser->depth = 0;
+    parser->state = JSON_UTILS_STATE_VALUE;
+    parser->token = JSON_UTILS_TOKEN_NONE;
+    parser->buffer_len = 0;
+    memset(&parser->indexer, 0, sizeof(parser->indexer));
+    parser->offset = 0;
+    parser->status = JSON_UTILS_OK;
+}
+
+e_json_utils_status json_utils_parser_feed(t_json_utils_parser* parser, const char* data, size_t len)
+{
+    if (!parser) return JSON_UTILS_ERROR_MEMORY;
+    if (parser->status != JSON_UTILS_OK) return parser->status;
+    if (!data || !len) return JSON_UTILS_OK;
+
+    t_json_utils_cursor cursor = { data, len, 0, 0, 0, 0 };
+    e_json_utils_step step = JSON_UTILS_STEP_DONE;
+    size_t pos = 0;
+
+    switch (parser->token)
+    {
+        case JSON_UTILS_TOKEN_STRING:
+        case JSON_UTILS_TOKEN_KEY:
+            step = json_utils_parser_string(parser, &cursor, 0, true);
+            break;
+        case JSON_UTILS_TOKEN_NUMBER:
+        case JSON_UTILS_TOKEN_LITERAL:
+            step = json_utils_parser_scalar(parser, data, len, 0, true);
+            break;
+        default:
+            break;
+    }
+
+    while (step == JSON_UTILS_STEP_DONE)
+    {
+        pos = json_utils_cursor_next(parser, &cursor);
+        if (pos >= len) break;
+        step = json_utils_parser_step(parser, &cursor, pos);
+    }
+
+    if (step == JSON_UTILS_STEP_ERROR)
+    {
+        parser->offset += pos;
+        return parser->status;
+    }
+
+    // A number or literal running to the end leaves blocks to index
+    while (json_utils_cursor_next(parser, &cursor) < len)
+    {
+    }
+
+    parser->offset += len;
+    return parser->status;
+}
+
+e_json_utils_status json_utils_parser_finish(t_json_utils_parser* parser)
+{
+    if (!parser) return JSON_UTILS_ERROR_MEMORY;
+    if (parser->status != JSON_UTILS_OK) return parser->status;
+
+    // A number or literal can only be closed by the end of input
+    if (parser->token == JSON_UTILS_TOKEN_NUMBER || parser->token == JSON_UTILS_TOKEN_LITERAL)
+    {
+        if (json_utils_parser_emit_scalar(parser, parser->buffer, parser->buffer_len) != JSON_UTILS_STEP_DONE)
+        {
+            return parser->status;
+        }
+    }
+
+    bool complete = parser->token == JSON_UTILS_TOKEN_NONE
+        && parser->depth == 0
+        && (parser->state == JSON_UTILS_STATE_DONE
+            || (parser->options.multiple_values && parser->state == JSON_UTILS_STATE_VALUE));
+
+    if (!complete) parser->status = JSON_UTILS_ERROR_INCOMPLETE;
+
+    return parser->status;
+}
+
+size_t json_utils_parser_offset(const t_json_utils_parser* parser)
+{
+    return parser ? parser->offset : 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Document (DOM) parser                                                      */
+/* -------------------------------------------------------------------------- */
+
+// Objects up to this many members are searched linearly
+#define JSON_UTILS_INDEX_THRESHOLD 16
+
+typedef struct t_json_utils_member t_json_utils_member;
+typedef struct t_json_utils_object_index t_json_utils_object_index;
+
+typedef struct t_json_utils_value
+{
+    e_json_utils_type type;
+    bool              pending;  // On-demand container not materialized yet
+    uint32_t          count;
+    union
+    {
+        bool b;
+        struct
+        {
+            const char* ptr;
+            size_t      len;
+        } text;                    // STRING, and NUMBER as written
+        struct
+        {
+            union
+            {
+                t_json_utils_value*  items;
+                t_json_utils_member* members;
+            };
+            t_json_utils_object_index* index;
+        } container;
+        struct
+        {
+            t_json_utils_document* document;
+            size_t                 first;  // Position of the opening bracket
+        } lazy;
+    } as;
+} t_json_utils_value;
+
+typedef struct t_json_utils_member
+{
+    const char*        key;
+    size_t             key_len;
+    t_json_utils_value value;
+} t_json_utils_member;
+
+// Open-addressed table of member indexes + 1, 0 marking free slots
+typedef struct t_json_utils_object_index
+{
+    uint32_t mask;
+    uint32_t slots[];
+} t_json_utils_object_index;
+
+typedef struct t_json_utils_arena_chunk
+{
+    struct t_json_utils_arena_chunk* next;
+    size_t                           size;
+    size_t                           used;
+    max_align_t                      data[];
+} t_json_utils_arena_chunk;
+
+typedef struct t_json_utils_document
+{
+    const char*               data;
+    size_t                    len;
+    uint32_t*                 positions;  // Offsets of the positions of interest
+    size_t                    position_count;
+    size_t                    position_capacity;
+
+    t_json_utils_arena_chunk* arena;
+
+    // Children of the containers being built, moved to the arena once complete
+    t_json_utils_value*       items;
+    size_t                    items_len;
+    size_t                    items_capacity;
+    t_json_utils_member*      members;
+    size_t                    members_len;
+    size_t                    members_capacity;
+
+    // One bit per open container while skipping, set for objects; max_depth bits
+    uint64_t*                 skip_kinds;
+
+    size_t                    max_depth;
+    bool                      on_demand;
+    e_json_utils_status       status;
+    t_json_utils_value        root;
+    const t_alloc_utils*      allocator;
+} t_json_utils_document;
+
+static void* json_utils_arena_alloc(t_json_utils_document* document, size_t size)
+{
+    size = (size + sizeof(max_align_t) - 1) & ~(sizeof(max_align_t) - 1);
+
+    t_json_utils_arena_chunk* chunk = document->arena;
+    if (!chunk || chunk->size - chunk->used < size)
+    {
+        size_t chunk_size = chunk ? chunk->size * 2 : document->len + 4096;
+        if (chunk_size < size) chunk_size = size;
+
+        t_json_utils_arena_chunk* next = alloc_utils_alloc(document->allocator, sizeof(t_json_utils_arena_chunk) + chunk_size);
+        if (!next)
+        {
+            document->status = JSON_UTILS_ERROR_MEMORY;
+            return NULL;
+        }
+
+        next->next = chunk;
+        next->size = chunk_size;
+        next->used = 0;
+        document->arena = next;
+        chunk = next;
+    }
+
+    void* ptr = (char*)chunk->data + chunk->used;
+    chunk->used += size;
+    return ptr;
+}
+
+static bool json_utils_document_fail(t_json_utils_document* document, e_json_utils_status status)
+{
+    if (document->status == JSON_UTILS_OK) document->status = status;
+    return false;
+}
+
+// Character at position i, or 0 past the last position
+static inline char json_utils_document_char(const t_json_utils_document* document, size_t i)
+{
+    return i < document->position_count ? document->data[document->positions[i]] : '\0';
+}
+
+static bool json_utils_document_unexpected(t_json_utils_document* document, char c)
+{
+    return json_utils_document_fail(document, c ? JSON_UTILS_ERROR_SYNTAX : JSON_UTILS_ERROR_INCOMPLETE);
+}
+
+static bool json_utils_document_index(t_json_utils_document* document)
+{
+    t_json_utils_indexer indexer = { 0 };
+    size_t capacity = document->len / 8 + 64;
+
+    document->positions = alloc_utils_alloc(document->allocator, capacity * sizeof(uint32_t));
+    if (!document->positions) return json_utils_document_fail(document, JSON_UTILS_ERROR_MEMORY);
+    document->position_capacity = capacity;
+
+    for (size_t base = 0; base < document->len; base += 64)
+    {
+        size_t n = document->len - base < 64 ? document->len - base : 64;
+        uint64_t backslashes;
+        uint64_t bits = json_utils_index_block(&indexer, document->data + base, n, &backslashes);
+
+        if (capacity - document->position_count < 64)
+        {
+            capacity *= 2;
+            uint32_t* positions = alloc_utils_realloc(document->allocator, document->positions,
+                                                      document->position_capacity * sizeof(uint32_t),
+                                                      capacity * sizeof(uint32_t));
+            if (!positions) return json_utils_document_fail(document, JSON_UTILS_ERROR_MEMORY);
+            document->positions = positions;
+            document->position_capacity = capacity;
+        }
+
+        while (bits)
+        {
+            document->positions[document->position_count++] = (uint32_t)(base + (size_t)__builtin_ctzll(bits));
+            bits &= bits - 1;
+        }
+    }
+
+    if (indexer.in_string) return json_utils_document_fail(document, JSON_UTILS_ERROR_INCOMPLETE);
+    return true;
+}
+
+// Reads the string opened at position *i; its closing quote is the next position
+static bool json_utils_document_string(t_json_utils_document* document, size_t* i, const char** text, size_t* len)
+{
+    if (*i + 1 >= document->position_count) return json_utils_document_fail(document, JSON_UTILS_ERROR_INCOMPLETE);
+
+    size_t open = document->positions[*i];
+    size_t close = document->positions[*i + 1];
+
+    if (document->data[close] != '"') return json_utils_document_fail(document, JSON_UTILS_ERROR_SYNTAX);
+
+    const char* raw = document->data + open + 1;
+    size_t raw_len = close - open - 1;
+
+    if (memchr(raw, '\\', raw_len))
+    {
+        char* decoded = json_utils_arena_alloc(document, raw_len);
+        if (!decoded) return false;
+        if (!json_utils_unescape(raw, raw_len, decoded, &raw_len))
+        {
+            return json_utils_document_fail(document, JSON_UTILS_ERROR_SYNTAX);
+        }
+        raw = decoded;
+    }
+
+    *text = raw;
+    *len = raw_len;
+    *i += 2;
+    return true;
+}
+
+static bool json_utils_document_scalar(t_json_utils_document* document, size_t* i, t_json_utils_value* value)
+{
+    const char* data = document->data;
+    size_t start = document->positions[*i];
+    size_t end = start;
+    bool number = data[start] == '-' || json_utils_is_digit(data[start]);
+
+    if (number)
+    {
+        while (end < document->len && json_utils_is_number_char(data[end])) end++;
+    }
+    else
+    {
+        while (end < document->len && data[end] >= 'a' && data[end] <= 'z') end++;
+    }
+
+    if (end < document->len && !json_utils_is_scalar_end(data[end]))
+    {
+        return json_utils_document_fail(document, JSON_UTILS_ERROR_SYNTAX);
+    }
+
+    const char* text = data + start;
+    size_t len = end - start;
+
+    if (number)
+    {
+        if (!json_utils_valid_number(text, len)) return json_utils_document_fail(document, JSON_UTILS_ERROR_SYNTAX);
+        value->type = JSON_UTILS_TYPE_NUMBER;
+        value->as.text.ptr = text;
+        value->as.text.len = len;
+    }
+    else if (len == 4 && memcmp(text, "true", 4) == 0)
+    {
+        value->type = JSON_UTILS_TYPE_BOOL;
+        value->as.b = true;
+    }
+    else if (len == 5 && memcmp(text, "false", 5) == 0)
+    {
+        value->type = JSON_UTILS_TYPE_BOOL;
+        value->as.b = false;
+    }
+    else if (len == 4 && memcmp(text, "null", 4) == 0)
+    {
+        value->type = JSON_UTILS_TYPE_NULL;
+    }
+    else
+    {
+        return json_utils_document_fail(document, JSON_UTILS_ERROR_SYNTAX);
+    }
+
+    (*i)++;
+    return true;
+}
+
+static size_t json_utils_document_skip_words(const t_json_utils_document* document)
+{
+    return (document->max_depth + 63) / 64;
+}
+
+/*
+ * Moves past the container opened at position *i without building it.
+ * Strings hold no structural positions, so matching brackets is enough:
+ * each closer must match the kind of the innermost open container.
+ */
+static bool json_utils_document_skip(t_json_utils_document* document, size_t* i, size_t depth)
+{
+    if (!document->skip_kinds)
+    {
+        document->skip_kinds = alloc_utils_alloc(document->allocator,
+                                                 json_utils_document_skip_words(document) * sizeof(uint64_t));
+        if (!document->skip_kinds) return json_utils_document_fail(document, JSON_UTILS_ERROR_MEMORY);
+    }
+
+    uint64_t* kinds = document->skip_kinds;
+    size_t level = 0;
+
+    do
+    {
+        char c = json_utils_document_char(document, *i);
+        if (!c) return json_utils_document_fail(document, JSON_UTILS_ERROR_INCOMPLETE);
+        (*i)++;
+
+        if (c == '{' || c == '[')
+        {
+            if (depth + ++level > document->max_depth) return json_utils_document_fail(document, JSON_UTILS_ERROR_DEPTH);
+
+            uint64_t bit = 1ull << ((level - 1) % 64);
+            if (c == '{') kinds[(level - 1) / 64] |= bit;
+            else kinds[(level - 1) / 64] &= ~bit;
+        }
+        else if (c == '}' || c == ']')
+        {
+            bool object = (kinds[(level - 1) / 64] >> ((level - 1) % 64)) & 1;
+            if (object != (c == '}')) return json_utils_document_unexpected(document, c);
+            level--;
+        }
+    } while (level > 0);
+
+    return true;
+}
+
+static bool json_utils_document_value(t_json_utils_document* document, size_t* i, t_json_utils_value* value, size_t depth);
+
+static bool json_utils_document_array(t_json_utils_document* document, size_t* i, t_json_utils_value* value, size_t depth)
+{
+    size_t base = document->items_len;
+
+    (*i)++;
+    if (json_utils_document_char(document, *i) == ']')
+    {
+        (*i)++;
+    }
+    else
+    {
+        for (;;)
+        {
+            t_json_utils_value item;
+            if (!json_utils_document_value(document, i, &item, depth + 1)) return false;
+
+            if (document->items_len == document->items_capacity)
+            {
+                size_t capacity = document->items_capacity ? document->items_capacity * 2 : 64;
+                t_json_utils_value* items = alloc_utils_realloc(document->allocator, document->items,
+                                                                document->items_capacity * sizeof(t_json_utils_value),
+                                                                capacity * sizeof(t_json_utils_value));
+                if (!items) return json_utils_document_fail(document, JSON_UTILS_ERROR_MEMORY);
+                document->items = items;
+                document->items_capacity = capacity;
+            }
+            document->items[document->items_len++] = item;
+
+            char c = json_utils_document_char(document, (*i)++);
+            if (c == ']') break;
+            if (c != ',') return json_utils_document_unexpected(document, c);
+        }
+    }
+
+    size_t count = document->items_len - base;
+    t_json_utils_value* items = NULL;
+
+    if (count)
+    {
+        items = json_utils_arena_alloc(document, count * sizeof(t_json_utils_value));
+        if (!items) return false;
+        memcpy(items, document->items + base, count * sizeof(t_json_utils_value));
+    }
+    document->items_len = base;
+
+    value->type = JSON_UTILS_TYPE_ARRAY;
+    value->pending = false;
+    value->count = (uint32_t)count;
+    value->as.container.items = items;
+    value->as.container.index = NULL;
+    return true;
+}
+
+static uint32_t json_utils_key_hash(const char* key, size_t len)
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= (unsigned char)key[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/*
+ * Builds the member index of a large object in the document arena. Members
+ * are inserted in order, so the first of duplicate keys is found first.
+ */
+static t_json_utils_object_index* json_utils_object_index(t_json_utils_document* document, t_json_utils_value* object)
+{
+    size_t capacity = 1;
+    while (capacity < (size_t)object->count * 2) capacity <<= 1;
+
+    t_json_utils_object_index* index = json_utils_arena_alloc(document, sizeof(t_json_utils_object_index) + capacity * sizeof(uint32_t));
+    if (!index) return NULL;
+
+    index->mask = (uint32_t)(capacity - 1);
+    memset(index->slots, 0, capacity * sizeof(uint32_t));
+
+    for (uint32_t m = 0; m < object->count; m++)
+    {
+        const t_json_utils_member* member = &object->as.container.members[m];
+        uint32_t slot = json_utils_key_hash(member->key, member->key_len) & index->mask;
+
+        while (index->slots[slot]) slot = (slot + 1) & index->mask;
+        index->slots[slot] = m + 1;
+    }
+
+    return index;
+}
+
+static bool json_utils_document_object(t_json_utils_document* document, size_t* i, t_json_utils_value* value, size_t depth)
+{
+    size_t base = document->members_len;
+
+    (*i)++;
+    if (json_utils_document_char(document, *i) == '}')
+    {
+        (*i)++;
+    }
+    else
+    {
+        for (;;)
+        {
+            t_json_utils_member member;
+            char c = json_utils_document_char(document, *i);
+
+            if (c != '"') return json_utils_document_unexpected(document, c);
+            if (!json_utils_document_string(document, i, &member.key, &member.key_len)) return false;
+
+            c = json_utils_document_char(document, (*i)++);
+            if (c != ':') return json_utils_document_unexpected(document, c);
+            if (!json_utils_document_value(document, i, &member.value, depth + 1)) return false;
+
+            if (document->members_len == document->members_capacity)
+            {
+                size_t capacity = document->members_capacity ? document->members_capacity * 2 : 64;
+                t_json_utils_member* members = alloc_utils_realloc(document->allocator, document->members,
+                                                                   document->members_capacity * sizeof(t_json_utils_member),
+                                                                   capacity * sizeof(t_json_utils_member));
+                if (!members) return json_utils_document_fail(document, JSON_UTILS_ERROR_MEMORY);
+                document->members = members;
+                document->members_capacity = capacity;
+            }
+            document->members[document->members_len++] = member;
+
+            c = json_utils_document_char(document, (*i)++);
+            if (c == '}') break;
+            if (c != ',') return json_utils_document_unexpected(document, c);
+        }
+    }
+
+    size_t count = document->members_len - base;
+    t_json_utils_member* members = NULL;
+
+    if (count)
+    {
+        members = json_utils_arena_alloc(document, count * sizeof(t_json_utils_member));
+        if (!members) return false;
+        memcpy(members, document->members + base, count * sizeof(t_json_utils_member));
+    }
+    document->members_len = base;
+
+    value->type = JSON_UTILS_TYPE_OBJECT;
+    value->pending = false;
+    value->count = (uint32_t)count;
+    value->as.container.members = members;
+    value->as.container.index = NULL;
+
+    if (count > JSON_UTILS_INDEX_THRESHOLD)
+    {
+        value->as.container.index = json_utils_object_index(document, value);
+        if (!value->as.container.index) return false;
+    }
+    return true;
+}
+
+static bool json_utils_document_value(t_json_utils_document* document, size_t* i, t_json_utils_value* value, size_t depth)
+{
+    char c = json_utils_document_char(document, *i);
+
+    switch (c)
+    {
+        case '{':
+        case '[':
+            if (document->on_demand)
+            {
+                value->type = c == '{' ? JSON_UTILS_TYPE_OBJECT : JSON_UTILS_TYPE_ARRAY;
+                value->pending = true;
+                value->count = 0;
+                value->as.lazy.document = document;
+                value->as.lazy.first = *i;
+                return json_utils_document_skip(document, i, depth);
+            }
+            if (depth >= document->max_depth) return json_utils_document_fail(document, JSON_UTILS_ERROR_DEPTH);
+            return c == '{'
+                ? json_utils_document_object(document, i, value, depth)
+                : json_utils_document_array(document, i, value, depth);
+        case '"':
+            value->type = JSON_UTILS_TYPE_STRING;
+            return json_utils_document_string(document, i, &value->as.text.ptr, &value->as.text.len);
+        case '\0':
+            return json_utils_document_fail(document, JSON_UTILS_ERROR_INCOMPLETE);
+        default:
+            return json_utils_document_scalar(document, i, value);
+    }
+}
+
+// Builds one level of an on-demand container; nested containers stay pending
+static bool json_utils_document_materialize(t_json_utils_value* value)
+{
+    if (!value->pending) return true;
+
+    t_json_utils_document* document = value->as.lazy.document;
+    if (document->status != JSON_UTILS_OK) return false;
+
+    size_t i = value->as.lazy.first;
+    t_json_utils_value built;
+    bool ok = value->type == JSON_UTILS_TYPE_OBJECT
+        ? json_utils_document_object(document, &i, &built, 0)
+        : json_utils_document_array(document, &i, &built, 0);
+
+    // Leave the scratch stacks empty for the next access after an error
+    document->items_len = 0;
+    document->members_len = 0;
+
+    if (!ok) return false;
+
+    *value = built;
+    return true;
+}
+
+// Frees the index and the child buffers, only needed while containers are being built
+static void json_utils_document_free_scratch(t_json_utils_document* document)
+{
+    alloc_utils_free(document->allocator, document->positions, document->position_capacity * sizeof(uint32_t));
+    alloc_utils_free(document->allocator, document->items, document->items_capacity * sizeof(t_json_utils_value));
+    alloc_utils_free(document->allocator, document->members, document->members_capacity * sizeof(t_json_utils_member));
+    alloc_utils_free(document->allocator, document->skip_kinds,
+                     json_utils_document_skip_words(document) * sizeof(uint64_t));
+
+    document->positions = NULL;
+    document->position_count = 0;
+    document->position_capacity = 0;
+    document->items = NULL;
+    document->items_capacity = 0;
+    document->members = NULL;
+    document->members_capacity = 0;
+    document->skip_kinds = NULL;
+}
+
+t_json_utils_document* json_utils_document_parse(const char* data, size_t len,
+                                                 const t_json_utils_document_options* options,
+                                                 e_json_utils_status* status)
+{
+    pthread_once(&s_simd_once, json_utils_simd_init);
+
+    if (status) *status = JSON_UTILS_ERROR_MEMORY;
+    if (!data && len) return NULL;
+
+    const t_alloc_utils* allocator = alloc_utils_or_default(options ? options->allocator : NULL);
+
+    t_json_utils_document* document = alloc_utils_calloc(allocator, 1, sizeof(t_json_utils_document));
+    if (!document) return NULL;
+
+    document->allocator = allocator;
+    document->data = data;
+    document->len = len;
+    document->max_depth = options && options->max_depth ? options->max_depth : JSON_UTILS_DEFAULT_MAX_DEPTH;
+    document->on_demand = options && options->on_demand;
+
+    size_t i = 0;
+
+    // Positions are stored as 32-bit offsets
+    if (len > UINT32_MAX)
+    {
+        json_utils_document_fail(document, JSON_UTILS_ERROR_TOKEN_TOO_LARGE);
+    }
+    else if (json_utils_document_index(document)
+             && json_utils_document_value(document, &i, &document->root, 0)
+             && i != document->position_count)
+    {
+        json_utils_document_fail(document, JSON_UTILS_ERROR_SYNTAX);
+    }
+
+    if (status) *status = document->status;
+
+    if (document->status != JSON_UTILS_OK)
+    {
+        json_utils_document_free(document);
+        return NULL;
+    }
+
+    // Only on-demand documents index again later
+    if (!document->on_demand)
+    {
+        json_utils_document_free_scratch(document);
+    }
+
+    return document;
+}
+
+void json_utils_document_free(t_json_utils_document* document)
+{
+    if (!document) return;
+
+    t_json_utils_arena_chunk* chunk = document->arena;
+    while (chunk)
+    {
+        t_json_utils_arena_chunk* next = chunk->next;
+        alloc_utils_free(document->allocator, chunk, sizeof(t_json_utils_arena_chunk) + chunk->size);
+        chunk = next;
+    }
+
+    json_utils_document_free_scratch(document);
+    alloc_utils_free(document->allocator, document, sizeof(t_json_utils_document));
+}
+
+t_json_utils_value* json_utils_document_root(t_json_utils_document* document)
+{
+    return document ? &document->root : NULL;
+}
+
+e_json_utils_status json_utils_document_status(const t_json_utils_document* document)
+{
+    return document ? document->status : JSON_UTILS_ERROR_MEMORY;
+}
+
+e_json_utils_type json_utils_value_type(const t_json_utils_value* value)
+{
+    return value ? value->type : JSON_UTILS_TYPE_NULL;
+}
+
+bool json_utils_value_bool(const t_json_utils_value* value)
+{
+    return value && value->type == JSON_UTILS_TYPE_BOOL && value->as.b;
+}
+
+double json_utils_value_double(const t_json_utils_value* value)
+{
+    if (!value || value->type != JSON_UTILS_TYPE_NUMBER) return 0.0;
+
+    // The text is already validated, so it parses whole
+    double result = 0.0;
+    str_utils_parse_double(value->as.text.ptr, value->as.text.len, &result);
+    return result;
+}
+
+bool json_utils_value_int(const t_json_utils_value* value, int64_t* out)
+{
+    if (!value || value->type != JSON_UTILS_TYPE_NUMBER) return false;
+
+    // Fractions, exponents and out of range integers stop short of the whole text
+    int64_t result;
+    if (str_utils_parse_i64(value->as.text.ptr, value->as.text.len, &result) != value->as.text.len) return false;
+
+    if (out) *out = result;
+    return true;
+}
+
+const char* json_utils_value_string(const t_json_utils_value* value, size_t* len)
+{
+    if (!value || value->type != JSON_UTILS_TYPE_STRING) return NULL;
+
+    if (len) *len = value->as.text.len;
+    return value->as.text.ptr;
+}
+
+t_str_utils_view json_utils_value_string_view(const t_json_utils_value* value)
+{
+    size_t len = 0;
+    const char* str = json_utils_value_string(value, &len);
+
+    return str_utils_view_of(str, len);
+}
+
+size_t json_utils_value_count(t_json_utils_value* value)
+{
+    if (!value || (value->type != JSON_UTILS_TYPE_ARRAY && value->type != JSON_UTILS_TYPE_OBJECT)) return 0;
+    if (value->pending && !json_utils_document_materialize(value)) return 0;
+
+    return value->count;
+}
+
+t_json_utils_value* json_utils_array_get(t_json_utils_value* array, size_t index)
+{
+    if (!array || array->type != JSON_UTILS_TYPE_ARRAY) return NULL;
+    if (!json_utils_document_materialize(array)) return NULL;
+
+    return index < array->count ? &array->as.container.items[index] : NULL;
+}
+
+t_json_utils_value* json_utils_object_get(t_json_utils_value* object, const char* key)
+{
+    if (!key) return NULL;
+
+    return json_utils_object_get_view(object, str_utils_view(key));
+}
+
+t_json_utils_value* json_utils_object_get_view(t_json_utils_value* object, t_str_utils_view key_view)
+{
+    if (!object || !key_view.data || object->type != JSON_UTILS_TYPE_OBJECT) return NULL;
+    if (!json_utils_document_materialize(object)) return NULL;
+
+    const char* key = key_view.data;
+    size_t len = key_view.len;
+    t_json_utils_member* members = object->as.container.members;
+
+    if (object->count <= JSON_UTILS_INDEX_THRESHOLD)
+    {
+        for (uint32_t m = 0; m < object->count; m++)
+        {
+            if (members[m].key_len == len && memcmp(members[m].key, key, len) == 0) return &members[m].value;
+        }
+        return NULL;
+    }
+
+    t_json_utils_object_index* index = object->as.container.index;
+    for (uint32_t slot = json_utils_key_hash(key, len) & index->mask; index->slots[slot]; slot = (slot + 1) & index->mask)
+    {
+        t_json_utils_member* member = &members[index->slots[slot] - 1];
+        if (member->key_len == len && memcmp(member->key, key, len) == 0) return &member->value;
+    }
+
+    return NULL;
+}
+
+const char* json_utils_object_key_at(t_json_utils_value* object, size_t index, size_t* len)
+{
+    if (!object || object->type != JSON_UTILS_TYPE_OBJECT) return NULL;
+    if (!json_utils_document_materialize(object) || index >= object->count) return NULL;
+
+    if (len) *len = object->as.container.members[index].key_len;
+    return object->as.container.members[index].key;
+}
+
+t_json_utils_value* json_utils_object_value_at(t_json_utils_value* object, size_t index)
+{
+    if (!object || object->type != JSON_UTILS_TYPE_OBJECT) return NULL;
+    if (!json_utils_document_materialize(object) || index >= object->count) return NULL;
+
+    return &object->as.container.members[index].value;
+}
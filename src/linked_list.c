@@ -22,15 +22,25 @@ typedef struct t_linked_list
     t_linked_list_node* head;
     t_linked_list_node* tail;
     int               count;
+    const t_alloc_utils* allocator;
 } t_linked_list;
 
 t_linked_list* linked_list_new()
 {
-    t_linked_list* list = malloc(sizeof(t_linked_list));
+    return linked_list_new_with_allocator(NULL);
+}
+
+t_linked_list* linked_list_new_with_allocator(const t_alloc_utils* allocator)
+{
+    allocator = alloc_utils_or_default(allocator);
+
+    t_linked_list* list = alloc_utils_alloc(allocator, sizeof(t_linked_list));
+    if (!list) return NULL;
 
     list->head = NULL;
     list->tail = NULL;
     list->count = 0;
+    list->allocator = allocator;
 
     return list;
 }
@@ -65,15 +75,17 @@ t_linked_list* linked_list_new_from_array(void** array, size_t count)
     return linkedlist;
 }
 
-static void linked_list_node_delete(t_linked_list *list, t_linked_list_node *node, linked_list_on_free on_free)
+void linked_list_node_free(t_linked_list *list, t_linked_list_node *node, linked_list_on_free on_free)
 {
+    if (list == NULL || node == NULL) return;
+
     if (on_free != NULL)
     {
         on_free(node);
     }
 
     node->next = node->previous = NULL;
-    free(node);
+    alloc_utils_free(list->allocator, node, sizeof(t_linked_list_node));
 }
 
 void linked_list_free(t_linked_list *list, linked_list_on_free on_free)
@@ -84,18 +96,19 @@ void linked_list_free(t_linked_list *list, linked_list_on_free on_free)
     while (current != NULL)
     {
         t_linked_list_node *next = linked_list_next(current);
-        linked_list_node_delete(list, current, on_free);
+        linked_list_node_free(list, current, on_free);
         current = next;
     }
 
-    free(list);
+    alloc_utils_free(list->allocator, list, sizeof(t_linked_list));
 }
 
 t_linked_list_node* linked_list_add(t_linked_list *list, void *value)
 {
     if (list == NULL) return NULL;
 
-    t_linked_list_node* node = malloc(sizeof(t_linked_list_node));
+    t_linked_list_node* node = alloc_utils_alloc(list->allocator, sizeof(t_linked_list_node));
+    if (node == NULL) return NULL;
 
     *node = linked_list_node_create(value);
 
@@ -120,7 +133,8 @@ t_linked_list_node* linked_list_insert_at(t_linked_list *list, int index, void*
 
     if (index == list->count) return linked_list_add(list, value);
 
-    t_linked_list_node* node = malloc(sizeof(t_linked_list_node));
+    t_linked_list_node* node = alloc_utils_alloc(list->allocator, sizeof(t_linked_list_node));
+    if (node == NULL) return NULL;
 
     *node = linked_list_node_create(value);
 
@@ -205,7 +219,7 @@ void linked_list_remove_after(t_linked_list* list, int index)
     while (node)
     {
         t_linked_list_node* next = node->next;
-        free(node);
+        alloc_utils_free(list->allocator, node, sizeof(t_linked_list_node));
         list->count--;
         node = next;
     }
@@ -216,7 +230,7 @@ void linked_list_free_at(t_linked_list *list, int index, linked_list_on_free on_
     t_linked_list_node *to_remove = linked_list_remove_at(list, index);
     if (to_remove != NULL)
     {
-        linked_list_node_delete(list, to_remove, on_free);
+        linked_list_node_free(list, to_remove, on_free);
     }
 }
 
@@ -238,7 +252,7 @@ void linked_list_free_after(t_linked_list* list, int index, linked_list_on_free
     while (to_free)
     {
         t_linked_list_node* next = to_free->next;
-        linked_list_node_delete(list, to_free, on_free);
+        linked_list_node_free(list, to_free, on_free);
         list->count--;
         to_free = next;
     }
@@ -276,23 +290,93 @@ size_t linked_list_count(t_linked_list* list)
 
 t_linked_list_node* linked_list_at(t_linked_list* list, int index)
 {
-    t_linked_list_node* current = list->head;
-    
-    for (int i = 0; i <= index; i++)
+    if (index < 0 || index >= list->count) return NULL;
+
+    // Walk from the nearest end
+    t_linked_list_node* current;
+    if (index < list->count / 2)
     {
-        if (current == NULL) return NULL;
-        if (i == index) return current;
-        current = current->next;
+        current = list->head;
+        for (int i = 0; i < index; i++) current = current->next;
     }
-    return NULL;
+    else
+    {
+        current = list->tail;
+        for (int i = list->count - 1; i > index; i--) current = current->previous;
+    }
+    return current;
 }
 
 t_linked_list_node* linked_list_random(t_linked_list* list)
 {
+    if (list->count == 0) return NULL;
+
     int rand_index = rand_utils_int(0, list->count-1);
     return linked_list_at(list, rand_index);
 }
 
+static int linked_list_compare_index(const void* a, const void* b)
+{
+    size_t left = *(const size_t*)a;
+    size_t right = *(const size_t*)b;
+    return (left > right) - (left < right);
+}
+
+size_t linked_list_sample(t_linked_list* list, size_t k, t_linked_list_node** out, t_rand_utils_state* state)
+{
+    size_t count = (size_t)list->count;
+    if (k == 0 || count == 0) return 0;
+
+    if (k >= count)
+    {
+        size_t i = 0;
+        for (t_linked_list_node* node = list->head; node; node = node->next) out[i++] = node;
+        return count;
+    }
+    if (!state) state = rand_utils_thread_state();
+
+    // Chosen indices, then an open-addressing set of them (power of two, at most half full)
+    size_t capacity = 16;
+    while (capacity < 2 * k) capacity *= 2;
+    size_t* indices = alloc_utils_alloc(list->allocator, (k + capacity) * sizeof(size_t));
+    if (!indices) return 0;
+
+    size_t* set = indices + k;
+    for (size_t i = 0; i < capacity; i++) set[i] = SIZE_MAX;
+
+    // Floyd: for j in [count - k, count), add a random index in [0, j], or j itself if already taken
+    for (size_t j = count - k, n = 0; j < count; j++, n++)
+    {
+        size_t pick = (size_t)rand_utils_state_bounded(state, (uint64_t)j + 1);
+        size_t slot = (pick * 0x9e3779b97f4a7c15u) & (capacity - 1);
+
+        while (set[slot] != SIZE_MAX && set[slot] != pick) slot = (slot + 1) & (capacity - 1);
+        if (set[slot] == pick)
+        {
+            // j is new: it was not a candidate before this step
+            pick = j;
+            slot = (pick * 0x9e3779b97f4a7c15u) & (capacity - 1);
+            while (set[slot] != SIZE_MAX) slot = (slot + 1) & (capacity - 1);
+        }
+        set[slot] = pick;
+        indices[n] = pick;
+    }
+
+    // One walk, in list order
+    qsort(indices, k, sizeof(size_t), linked_list_compare_index);
+
+    t_linked_list_node* node = list->head;
+    size_t position = 0;
+    for (size_t i = 0; i < k; i++)
+    {
+        for (; position < indices[i]; position++) node = node->next;
+        out[i] = node;
+    }
+
+    alloc_utils_free(list->allocator, indices, (k + capacity) * sizeof(size_t));
+    return k;
+}
+
 void linked_list_sort(t_linked_list *list, linked_list_sort_fn sort_fn) {
     t_linked_list_node *sorted = NULL;
     t_linked_list_node *current = list->head;
@@ -356,7 +440,9 @@ void linked_list_for_each(t_linked_list *list, void (*func)(t_linked_list_node *
 
 t_linked_list* linked_list_select(t_linked_list* list, linked_list_select_fn select_fn, void* context)
 {
-    t_linked_list* selection = linked_list_new(NULL);
+    if (!list) return NULL;
+
+    t_linked_list* selection = linked_list_new_with_allocator(list->allocator);
     
     if (!selection)
     {
@@ -376,12 +462,59 @@ t_linked_list* linked_list_select(t_linked_list* list, linked_list_select_fn sel
     return selection;
 }
 
-void linked_list_concat(t_linked_list* list1, t_linked_list* list2)
+/*
+ * Copies the nodes of list into a chain allocated from allocator, freeing
+ * the originals; list is left untouched on allocation failure.
+ */
+static bool linked_list_rehome(t_linked_list* list, const t_alloc_utils* allocator)
 {
-    if (!list1 || !list2) return;
+    t_linked_list_node* head = NULL;
+    t_linked_list_node* tail = NULL;
+
+    for (t_linked_list_node* node = list->head; node; node = node->next)
+    {
+        t_linked_list_node* copy = alloc_utils_alloc(allocator, sizeof(t_linked_list_node));
+        if (!copy)
+        {
+            while (head)
+            {
+                t_linked_list_node* next = head->next;
+                alloc_utils_free(allocator, head, sizeof(t_linked_list_node));
+                head = next;
+            }
+            return false;
+        }
+
+        *copy = linked_list_node_create(node->value);
+        copy->previous = tail;
+        if (tail) tail->next = copy;
+        else head = copy;
+        tail = copy;
+    }
+
+    for (t_linked_list_node* node = list->head; node; )
+    {
+        t_linked_list_node* next = node->next;
+        alloc_utils_free(list->allocator, node, sizeof(t_linked_list_node));
+        node = next;
+    }
+
+    list->head = head;
+    list->tail = tail;
+    return true;
+}
+
+bool linked_list_concat(t_linked_list* list1, t_linked_list* list2)
+{
+    if (!list1 || !list2) return false;
     
     if (linked_list_count(list2) == 0) {
-        return;
+        return true;
+    }
+
+    // Nodes of list2 must be freed by list1's allocator once moved
+    if (list1->allocator != list2->allocator && !linked_list_rehome(list2, list1->allocator)) {
+        return false;
     }
     
     if (linked_list_count(list1) == 0) {
@@ -399,4 +532,6 @@ void linked_list_concat(t_linked_list* list1, t_linked_list* list2)
     list2->head = NULL;
     list2->tail = NULL;
     list2->count = 0;
+
+    return true;
 }
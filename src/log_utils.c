@@ -1,27 +1,96 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
-#include <sys/time.h>
 
-#include "log_utils.h"
 #include "json_utils.h"
+#include "log_utils.h"
+#include "str_utils.h"
+
+// Per-thread scratch sizes; larger messages fall back to a one-off heap buffer
+#define LOG_UTILS_CONTENT_SIZE   4096
+#define LOG_UTILS_LINE_SIZE      8192
+#define LOG_UTILS_TIMESTAMP_SIZE 32
 
 typedef struct t_log_utils_event
 {
-    char* datetime;
-    char* level;
-    char* context;
-    char* content;
+    const char*              timestamp;
+    size_t                   timestamp_len;
+    t_log_utils_level        level;
+    t_str_utils_view         context;      // Null view: null context
+    const char*              content;      // NULL: no content member
+    size_t                   content_len;
+    const t_log_utils_field* fields;
+    size_t                   field_count;
 } t_log_utils_event;
 
-const t_log_utils_level LOG_UTILS_DEBUG = 0;
-const t_log_utils_level LOG_UTILS_INFO  = 1;
-const t_log_utils_level LOG_UTILS_WARN  = 2;
-const t_log_utils_level LOG_UTILS_ERROR = 3;
+const t_log_utils_level LOG_UTILS_DEBUG = LOG_UTILS_LEVEL_DEBUG;
+const t_log_utils_level LOG_UTILS_INFO  = LOG_UTILS_LEVEL_INFO;
+const t_log_utils_level LOG_UTILS_WARN  = LOG_UTILS_LEVEL_WARN;
+const t_log_utils_level LOG_UTILS_ERROR = LOG_UTILS_LEVEL_ERROR;
+
+
+t_log_utils_level log_utils_runtime_min_level = LOG_UTILS_LEVEL_DEBUG;
+
+// Destination of log lines, NULL meaning the stdout sink
+static _Atomic(t_log_utils_sink*) s_sink = NULL;
+
+// Threads using a sink, counted on the side of the epoch they started in: log_utils_set_sink()
+// waits for the side of the previous epoch while newer writers count on the other one
+static atomic_uint     s_sink_epoch = 0;
+static atomic_size_t   s_sink_users[2];
+static pthread_mutex_t s_sink_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Atomic(const t_alloc_utils*) s_allocator = NULL;
+
+// Replace ill-formed UTF-8 in contexts, messages and fields with U+FFFD
+static atomic_bool s_replace_invalid_utf8 = false;
+
+// Clock used for timestamps, resolved on first use (-1: not resolved yet)
+static atomic_int s_clock_id = -1;
+
+// "YYYY/MM/DD HH:MM:SS:" prefix of the current second, rebuilt once per second
+static _Thread_local time_t s_cached_second = (time_t)-1;
+static _Thread_local size_t s_cached_prefix_len = 0;
+static _Thread_local char   s_cached_prefix[LOG_UTILS_TIMESTAMP_SIZE];
+
+static _Thread_local char s_content[LOG_UTILS_CONTENT_SIZE];
+static _Thread_local char s_line[LOG_UTILS_LINE_SIZE];
+
+// Rate limiting state, per (context, level) key
+#define LOG_UTILS_LIMIT_SLOTS  4096
+#define LOG_UTILS_LIMIT_PROBES 16
+
+typedef struct t_log_utils_limit_slot
+{
+    _Atomic uint64_t key;              // 0: free
+    _Atomic int64_t  arrival_ns;       // Theoretical arrival time of the next message
+    _Atomic uint64_t seen;             // Messages offered, for sampling
+    _Atomic uint64_t suppressed;       // Dropped since the last summary
+    _Atomic int64_t  last_summary_ns;
 
+    // Key of the slot, for summaries written without a message: NULL until published
+    _Atomic(char*)    context;
+    size_t            context_len;
+    bool              context_null;
+    t_log_utils_level level;
+} t_log_utils_limit_slot;
 
-static t_log_utils_level s_min_level = LOG_UTILS_DEBUG;
+static t_log_utils_limit_slot s_limit_slots[LOG_UTILS_LIMIT_SLOTS];
+static atomic_size_t   s_limit_slot_count = 0;
+static pthread_once_t  s_limit_exit_once = PTHREAD_ONCE_INIT;
+static atomic_bool     s_limit_enabled = false;
+static _Atomic int64_t s_limit_interval_ns = 0;
+static _Atomic int64_t s_limit_tolerance_ns = 0;
+static _Atomic int64_t s_limit_summary_ns = 10 * 1000000000ll;
+static atomic_uint     s_limit_sampling[LOG_UTILS_LEVEL_ERROR + 1];
 
 static const char* log_utils_level_string(t_log_utils_level level)
 {
@@ -32,86 +101,560 @@ static const char* log_utils_level_string(t_log_utils_level level)
     return "UNKNOWN";
 }
 
-static void log_utils_timestamp(char* buffer, size_t size)
-{
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    
-    struct tm* tm_info = localtime(&tv.tv_sec);
-    
-    // Format: YYYY/MM/DD HH:MM:SS:MSS
-    snprintf(buffer, size, "%04d/%02d/%02d %02d:%02d:%02d:%03ld",
-             tm_info->tm_year + 1900,
-             tm_info->tm_mon + 1,
-             tm_info->tm_mday,
-             tm_info->tm_hour,
-             tm_info->tm_min,
-             tm_info->tm_sec,
-             tv.tv_usec / 1000);
-}
-
-static void log_utils_log(t_log_utils_level level, const char* context, const char* format, va_list args)
-{
-    char timestamp[32];
-    log_utils_timestamp(timestamp, sizeof(timestamp));
-    
-    // First pass: determine required size
-    va_list args_copy;
-    va_copy(args_copy, args);
-    int content_size = vsnprintf(NULL, 0, format, args_copy);
-    va_end(args_copy);
-    
-    if (content_size < 0)
+static clockid_t log_utils_clock(void)
+{
+    int clock_id = atomic_load_explicit(&s_clock_id, memory_order_relaxed);
+
+    if (clock_id >= 0) return (clockid_t)clock_id;
+
+    clock_id = CLOCK_REALTIME;
+
+#ifdef CLOCK_REALTIME_COARSE
+    // The coarse clock skips the hardware read but ticks at the kernel rate:
+    // only use it when it can still resolve the milliseconds we print.
+    struct timespec resolution;
+    if (clock_getres(CLOCK_REALTIME_COARSE, &resolution) == 0
+        && resolution.tv_sec == 0
+        && resolution.tv_nsec <= 1000000)
     {
-        fprintf(stderr, "Error formatting log message\n");
-        return;
+        clock_id = CLOCK_REALTIME_COARSE;
+    }
+#endif
+
+    atomic_store_explicit(&s_clock_id, clock_id, memory_order_relaxed);
+    return (clockid_t)clock_id;
+}
+
+static size_t log_utils_timestamp(char* buffer)
+{
+    struct timespec now;
+    clock_gettime(log_utils_clock(), &now);
+
+    if (now.tv_sec != s_cached_second)
+    {
+        struct tm tm_info;
+        localtime_r(&now.tv_sec, &tm_info);
+
+        // Format: YYYY/MM/DD HH:MM:SS:MSS
+        char* p = s_cached_prefix;
+        p += str_utils_format_u64_padded(p, (uint64_t)(tm_info.tm_year + 1900) % 10000, 4);
+        *p++ = '/';
+        p += str_utils_format_u64_padded(p, (uint64_t)(tm_info.tm_mon + 1), 2);
+        *p++ = '/';
+        p += str_utils_format_u64_padded(p, (uint64_t)tm_info.tm_mday, 2);
+        *p++ = ' ';
+        p += str_utils_format_u64_padded(p, (uint64_t)tm_info.tm_hour, 2);
+        *p++ = ':';
+        p += str_utils_format_u64_padded(p, (uint64_t)tm_info.tm_min, 2);
+        *p++ = ':';
+        p += str_utils_format_u64_padded(p, (uint64_t)tm_info.tm_sec, 2);
+        *p++ = ':';
+
+        s_cached_prefix_len = (size_t)(p - s_cached_prefix);
+        s_cached_second = now.tv_sec;
+    }
+
+    memcpy(buffer, s_cached_prefix, s_cached_prefix_len);
+    return s_cached_prefix_len + str_utils_format_u64_padded(buffer + s_cached_prefix_len, (uint64_t)(now.tv_nsec / 1000000), 3);
+}
+
+typedef struct t_log_utils_line
+{
+    t_str_utils_builder text;
+    bool                failed;  // An allocation failed, the line is incomplete
+} t_log_utils_line;
+
+static void log_utils_line_append(t_log_utils_line* line, const char* str, size_t len)
+{
+    if (!str_utils_builder_append(&line->text, str, len)) line->failed = true;
+}
+
+static void log_utils_line_append_escaped(t_log_utils_line* line, const char* str, size_t len)
+{
+    t_str_utils_builder* text = &line->text;
+
+    size_t (*escape)(char*, size_t, const char*, size_t) =
+        atomic_load_explicit(&s_replace_invalid_utf8, memory_order_relaxed) ? json_utils_escape_utf8_into
+                                                                            : json_utils_escape_into;
+
+    // Escape in place, growing to the exact size and escaping again only if it did not fit
+    size_t room = text->capacity - text->len - 1;
+    size_t escaped = escape(text->data + text->len, room, str, len);
+    if (escaped > room)
+    {
+        if (!str_utils_builder_reserve(text, escaped))
+        {
+            line->failed = true;
+            return;
+        }
+        escape(text->data + text->len, escaped, str, len);
     }
-    
-    // Allocate buffer for content
-    char* content = malloc(content_size + 1);
-    if (!content)
+
+    str_utils_builder_commit(text, escaped);
+}
+
+#define LOG_UTILS_LINE_APPEND_LITERAL(line, literal) \
+    log_utils_line_append((line), (literal), sizeof(literal) - 1)
+
+static void log_utils_line_append_string(t_log_utils_line* line, const char* str)
+{
+    if (!str)
     {
-        fprintf(stderr, "Failed to allocate memory for log content\n");
+        LOG_UTILS_LINE_APPEND_LITERAL(line, "null");
         return;
     }
-    
-    // Second pass: actually format the content
-    vsnprintf(content, content_size + 1, format, args);
-    
-    // Escape strings for JSON
-    char* escaped_context = json_utils_escape(context);
-    char* escaped_content = json_utils_escape(content);
-    
-    if (!escaped_context || !escaped_content)
-    {
-        fprintf(stderr, "Failed to escape JSON strings\n");
-        free(content);
-        free(escaped_context);
-        free(escaped_content);
+
+    LOG_UTILS_LINE_APPEND_LITERAL(line, "\"");
+    log_utils_line_append_escaped(line, str, strlen(str));
+    LOG_UTILS_LINE_APPEND_LITERAL(line, "\"");
+}
+
+// Members every line starts with: a field of the same name would repeat the key
+static bool log_utils_is_reserved_key(const char* key)
+{
+    return strcmp(key, "timestamp") == 0 || strcmp(key, "level") == 0
+        || strcmp(key, "context") == 0 || strcmp(key, "content") == 0;
+}
+
+static void log_utils_line_append_field(t_log_utils_line* line, const t_log_utils_field* field)
+{
+    char number[STR_UTILS_DOUBLE_BUFFER_SIZE];
+    const char* key = field->key ? field->key : "";
+
+    LOG_UTILS_LINE_APPEND_LITERAL(line, ", \"");
+    if (log_utils_is_reserved_key(key)) LOG_UTILS_LINE_APPEND_LITERAL(line, LOG_UTILS_FIELD_RESERVED_PREFIX);
+    log_utils_line_append_escaped(line, key, strlen(key));
+    LOG_UTILS_LINE_APPEND_LITERAL(line, "\": ");
+
+    switch (field->type)
+    {
+        case LOG_UTILS_FIELD_TYPE_INT:
+            log_utils_line_append(line, number, str_utils_format_i64(number, field->value.i));
+            break;
+        case LOG_UTILS_FIELD_TYPE_DOUBLE:
+            // JSON has no NaN or infinities
+            if (isfinite(field->value.d))
+            {
+                log_utils_line_append(line, number, str_utils_format_double(number, field->value.d));
+            }
+            else
+            {
+                LOG_UTILS_LINE_APPEND_LITERAL(line, "null");
+            }
+            break;
+        case LOG_UTILS_FIELD_TYPE_STRING:
+            log_utils_line_append_string(line, field->value.s);
+            break;
+        case LOG_UTILS_FIELD_TYPE_BOOL:
+            if (field->value.b) LOG_UTILS_LINE_APPEND_LITERAL(line, "true");
+            else LOG_UTILS_LINE_APPEND_LITERAL(line, "false");
+            break;
+        default:
+            LOG_UTILS_LINE_APPEND_LITERAL(line, "null");
+            break;
+    }
+}
+
+/*
+ * Assembles the JSON line into line->text, which moves to the heap only when
+ * the line outgrows its initial buffer.
+ */
+static void log_utils_build_line(t_log_utils_line* line, const t_log_utils_event* event)
+{
+    const char* level_string = log_utils_level_string(event->level);
+
+    LOG_UTILS_LINE_APPEND_LITERAL(line, "{ \"timestamp\": \"");
+    log_utils_line_append(line, event->timestamp, event->timestamp_len);
+    LOG_UTILS_LINE_APPEND_LITERAL(line, "\", \"level\": \"");
+    log_utils_line_append(line, level_string, strlen(level_string));
+    if (event->context.data)
+    {
+        LOG_UTILS_LINE_APPEND_LITERAL(line, "\", \"context\": \"");
+        log_utils_line_append_escaped(line, event->context.data, event->context.len);
+        LOG_UTILS_LINE_APPEND_LITERAL(line, "\"");
+    }
+    else
+    {
+        LOG_UTILS_LINE_APPEND_LITERAL(line, "\", \"context\": null");
+    }
+    if (event->content)
+    {
+        LOG_UTILS_LINE_APPEND_LITERAL(line, ", \"content\": \"");
+        log_utils_line_append_escaped(line, event->content, event->content_len);
+        LOG_UTILS_LINE_APPEND_LITERAL(line, "\"");
+    }
+    for (size_t i = 0; i < event->field_count; i++)
+    {
+        log_utils_line_append_field(line, &event->fields[i]);
+    }
+    LOG_UTILS_LINE_APPEND_LITERAL(line, " }\n");
+}
+
+// Pins the current sink until log_utils_release_sink(side), side being the return value
+static unsigned log_utils_acquire_sink(t_log_utils_sink** sink)
+{
+    for (;;)
+    {
+        unsigned epoch = atomic_load(&s_sink_epoch);
+        atomic_fetch_add(&s_sink_users[epoch & 1], 1);
+
+        // Still the same epoch: the sink loaded now is waited for before it can be replaced
+        if (atomic_load(&s_sink_epoch) == epoch)
+        {
+            t_log_utils_sink* current = atomic_load(&s_sink);
+            *sink = current ? current : log_utils_sink_stdout();
+            return epoch & 1;
+        }
+        atomic_fetch_sub(&s_sink_users[epoch & 1], 1);
+    }
+}
+
+static void log_utils_release_sink(unsigned side)
+{
+    atomic_fetch_sub_explicit(&s_sink_users[side], 1, memory_order_release);
+}
+
+// NULL while none is installed, which the builders read as the default allocator
+static const t_alloc_utils* log_utils_allocator(void)
+{
+    return atomic_load_explicit(&s_allocator, memory_order_acquire);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Rate limiting and sampling                                                 */
+/* -------------------------------------------------------------------------- */
+
+// Copies the key into a claimed slot; the copy lives as long as the slot, so it is never freed
+static void log_utils_limit_publish(t_log_utils_limit_slot* slot, t_log_utils_level level, t_str_utils_view context)
+{
+    char* copy = malloc(context.len + 1);
+    if (!copy) return;
+
+    if (context.len) memcpy(copy, context.data, context.len);
+    copy[context.len] = '\0';
+    slot->context_len = context.len;
+    slot->context_null = context.data == NULL;
+    slot->level = level;
+    atomic_store_explicit(&slot->context, copy, memory_order_release);
+}
+
+/*
+ * Open-addressed table keyed by a hash of (context, level). Slots are claimed
+ * with a CAS on the key and never released; when the probe window is full
+ * the message is let through untracked.
+ */
+static t_log_utils_limit_slot* log_utils_limit_slot(uint64_t key, t_log_utils_level level, t_str_utils_view context,
+                                                    int64_t now)
+{
+    size_t index = (size_t)key & (LOG_UTILS_LIMIT_SLOTS - 1);
+
+    for (size_t probe = 0; probe < LOG_UTILS_LIMIT_PROBES; probe++)
+    {
+        t_log_utils_limit_slot* slot = &s_limit_slots[(index + probe) & (LOG_UTILS_LIMIT_SLOTS - 1)];
+        uint64_t current = atomic_load_explicit(&slot->key, memory_order_acquire);
+
+        if (current == 0)
+        {
+            // Start the summary period at the first message of the key
+            atomic_store_explicit(&slot->last_summary_ns, now, memory_order_relaxed);
+            if (atomic_compare_exchange_strong_explicit(&slot->key, &current, key,
+                                                        memory_order_acq_rel, memory_order_acquire))
+            {
+                log_utils_limit_publish(slot, level, context);
+                atomic_fetch_add_explicit(&s_limit_slot_count, 1, memory_order_release);
+                return slot;
+            }
+        }
+        if (current == key) return slot;
+    }
+
+    return NULL;
+}
+
+static uint64_t log_utils_limit_key(t_log_utils_level level, t_str_utils_view context)
+{
+    // FNV-1a over the context, seeded with the level
+    uint64_t hash = 14695981039346656037ull ^ (uint64_t)(unsigned)level;
+
+    hash *= 1099511628211ull;
+    for (size_t i = 0; i < context.len; i++)
+    {
+        hash ^= (unsigned char)context.data[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash ? hash : 1;
+}
+
+static int64_t log_utils_limit_now(void)
+{
+    struct timespec now;
+#ifdef CLOCK_MONOTONIC_COARSE
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &now);
+#endif
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/*
+ * Decides whether a message may be logged. *summary receives the number of
+ * suppressed messages to report first, at most once per summary interval.
+ */
+static bool log_utils_limit_allow(t_log_utils_level level, t_str_utils_view context, uint64_t* summary)
+{
+    *summary = 0;
+
+    if (!atomic_load_explicit(&s_limit_enabled, memory_order_relaxed)) return true;
+
+    int64_t now = log_utils_limit_now();
+    t_log_utils_limit_slot* slot = log_utils_limit_slot(log_utils_limit_key(level, context), level, context, now);
+    if (!slot) return true;
+
+    bool allowed = true;
+    unsigned every_n = 1;
+
+    if (level >= LOG_UTILS_LEVEL_DEBUG && level <= LOG_UTILS_LEVEL_ERROR)
+    {
+        every_n = atomic_load_explicit(&s_limit_sampling[level], memory_order_relaxed);
+    }
+    if (every_n > 1)
+    {
+        allowed = atomic_fetch_add_explicit(&slot->seen, 1, memory_order_relaxed) % every_n == 0;
+    }
+
+    // Token bucket as a generic cell rate algorithm: one theoretical arrival time per key
+    int64_t interval = atomic_load_explicit(&s_limit_interval_ns, memory_order_relaxed);
+    if (allowed && interval > 0)
+    {
+        int64_t tolerance = atomic_load_explicit(&s_limit_tolerance_ns, memory_order_relaxed);
+        int64_t arrival = atomic_load_explicit(&slot->arrival_ns, memory_order_relaxed);
+
+        for (;;)
+        {
+            int64_t start = arrival > now ? arrival : now;
+
+            if (start - now > tolerance)
+            {
+                allowed = false;
+                break;
+            }
+            if (atomic_compare_exchange_weak_explicit(&slot->arrival_ns, &arrival, start + interval,
+                                                      memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+    }
+
+    if (!allowed)
+    {
+        atomic_fetch_add_explicit(&slot->suppressed, 1, memory_order_relaxed);
+    }
+
+    if (atomic_load_explicit(&slot->suppressed, memory_order_relaxed) > 0)
+    {
+        int64_t last = atomic_load_explicit(&slot->last_summary_ns, memory_order_relaxed);
+        int64_t period = atomic_load_explicit(&s_limit_summary_ns, memory_order_relaxed);
+
+        if (now - last >= period
+            && atomic_compare_exchange_strong_explicit(&slot->last_summary_ns, &last, now,
+                                                       memory_order_relaxed, memory_order_relaxed))
+        {
+            *summary = atomic_exchange_explicit(&slot->suppressed, 0, memory_order_relaxed);
+        }
+    }
+
+    return allowed;
+}
+
+static void log_utils_limit_at_exit(void)
+{
+    atexit(log_utils_flush);
+}
+
+static void log_utils_limit_update_enabled(void)
+{
+    bool enabled = atomic_load_explicit(&s_limit_interval_ns, memory_order_relaxed) > 0;
+
+    for (int level = LOG_UTILS_LEVEL_DEBUG; level <= LOG_UTILS_LEVEL_ERROR; level++)
+    {
+        enabled = enabled || atomic_load_explicit(&s_limit_sampling[level], memory_order_relaxed) > 1;
+    }
+
+    // Counts still outstanding when the process exits are reported by log_utils_flush()
+    if (enabled) pthread_once(&s_limit_exit_once, log_utils_limit_at_exit);
+    atomic_store_explicit(&s_limit_enabled, enabled, memory_order_relaxed);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Output                                                                     */
+/* -------------------------------------------------------------------------- */
+
+static void log_utils_write_event(t_log_utils_event* event)
+{
+    char timestamp[LOG_UTILS_TIMESTAMP_SIZE];
+    event->timestamp = timestamp;
+    event->timestamp_len = log_utils_timestamp(timestamp);
+
+    t_log_utils_line line = { .failed = false };
+    str_utils_builder_init_with_allocator(&line.text, s_line, sizeof(s_line), log_utils_allocator());
+    log_utils_build_line(&line, event);
+
+    if (line.failed)
+    {
+        fprintf(stderr, "Failed to allocate memory for log line\n");
+    }
+    else
+    {
+        t_log_utils_sink* sink;
+        unsigned side = log_utils_acquire_sink(&sink);
+        log_utils_sink_write(sink, line.text.data, line.text.len);
+        log_utils_release_sink(side);
+    }
+
+    str_utils_builder_free(&line.text);
+}
+
+static void log_utils_write_summary(t_log_utils_level level, t_str_utils_view context, uint64_t suppressed)
+{
+    char summary[64];
+    char* p = summary;
+
+    memcpy(p, "suppressed ", 11);
+    p += 11;
+    p += str_utils_format_u64(p, suppressed);
+    memcpy(p, " messages", 9);
+    p += 9;
+
+    t_log_utils_event event = { NULL, 0, level, context, summary, (size_t)(p - summary), NULL, 0 };
+    log_utils_write_event(&event);
+}
+
+/*
+ * Applies flood control, reporting suppressed messages first.
+ * Returns whether the message itself may be logged.
+ */
+static bool log_utils_admit(t_log_utils_level level, t_str_utils_view context)
+{
+    uint64_t suppressed;
+    bool allowed = log_utils_limit_allow(level, context, &suppressed);
+
+    if (suppressed) log_utils_write_summary(level, context, suppressed);
+
+    return allowed;
+}
+
+// Reports every outstanding count, whatever the summary interval, as the flood may be over
+static void log_utils_limit_sweep(void)
+{
+    if (atomic_load_explicit(&s_limit_slot_count, memory_order_acquire) == 0) return;
+
+    int64_t now = log_utils_limit_now();
+
+    for (size_t i = 0; i < LOG_UTILS_LIMIT_SLOTS; i++)
+    {
+        t_log_utils_limit_slot* slot = &s_limit_slots[i];
+        const char* context = atomic_load_explicit(&slot->context, memory_order_acquire);
+
+        if (!context || atomic_load_explicit(&slot->suppressed, memory_order_relaxed) == 0) continue;
+
+        uint64_t suppressed = atomic_exchange_explicit(&slot->suppressed, 0, memory_order_relaxed);
+        if (!suppressed) continue;
+
+        atomic_store_explicit(&slot->last_summary_ns, now, memory_order_relaxed);
+        t_str_utils_view view = slot->context_null ? str_utils_view(NULL)
+                                                   : (t_str_utils_view){ context, slot->context_len };
+        log_utils_write_summary(slot->level, view, suppressed);
+    }
+}
+
+static void log_utils_log(t_log_utils_level level, const char* context_str, const char* format, va_list args)
+{
+    t_str_utils_view context = str_utils_view(context_str);
+
+    if (!log_utils_admit(level, context)) return;
+
+    // Format into the thread-local buffer, only going to the heap for oversized messages
+    t_str_utils_builder content;
+    str_utils_builder_init_with_allocator(&content, s_content, sizeof(s_content), log_utils_allocator());
+
+    if (!str_utils_builder_vappendf(&content, format, args))
+    {
+        fprintf(stderr, "Error formatting log message\n");
+        str_utils_builder_free(&content);
         return;
     }
-    
-    // Build and print JSON
-    printf("{ \"timestamp\": \"%s\", \"level\": \"%s\", \"context\": \"%s\", \"content\": \"%s\" }\n",
-           timestamp,
-           log_utils_level_string(level),
-           escaped_context,
-           escaped_content);
-    
-    // Cleanup
-    free(content);
-    free(escaped_context);
-    free(escaped_content);
+
+    t_log_utils_event event = { NULL, 0, level, context, content.data, content.len, NULL, 0 };
+    log_utils_write_event(&event);
+
+    str_utils_builder_free(&content);
 }
 
 void log_utils_set_min_level(t_log_utils_level level)
 {
-    s_min_level = level;
+    log_utils_runtime_min_level = level;
+}
+
+void log_utils_set_sink(t_log_utils_sink* sink)
+{
+    pthread_mutex_lock(&s_sink_lock);
+
+    atomic_store(&s_sink, sink);
+    unsigned epoch = atomic_fetch_add(&s_sink_epoch, 1);
+    while (atomic_load_explicit(&s_sink_users[epoch & 1], memory_order_acquire) != 0) sched_yield();
+
+    pthread_mutex_unlock(&s_sink_lock);
+}
+
+void log_utils_set_allocator(const t_alloc_utils* allocator)
+{
+    atomic_store_explicit(&s_allocator, allocator, memory_order_release);
+}
+
+void log_utils_set_replace_invalid_utf8(bool enabled)
+{
+    atomic_store_explicit(&s_replace_invalid_utf8, enabled, memory_order_relaxed);
+}
+
+void log_utils_set_rate_limit(double rate, double burst)
+{
+    int64_t interval = rate > 0 ? (int64_t)(1e9 / rate) : 0;
+    if (rate > 0 && interval < 1) interval = 1;
+    if (burst < 1) burst = 1;
+
+    atomic_store_explicit(&s_limit_tolerance_ns, (int64_t)((burst - 1) * (double)interval), memory_order_relaxed);
+    atomic_store_explicit(&s_limit_interval_ns, interval, memory_order_relaxed);
+    log_utils_limit_update_enabled();
+}
+
+void log_utils_set_sampling(t_log_utils_level level, unsigned every_n)
+{
+    if (level < LOG_UTILS_LEVEL_DEBUG || level > LOG_UTILS_LEVEL_ERROR) return;
+
+    atomic_store_explicit(&s_limit_sampling[level], every_n, memory_order_relaxed);
+    log_utils_limit_update_enabled();
+}
+
+void log_utils_set_summary_interval(unsigned seconds)
+{
+    atomic_store_explicit(&s_limit_summary_ns, (int64_t)seconds * 1000000000, memory_order_relaxed);
+}
+
+void log_utils_flush(void)
+{
+    log_utils_limit_sweep();
+
+    t_log_utils_sink* sink;
+    unsigned side = log_utils_acquire_sink(&sink);
+    log_utils_sink_flush(sink);
+    log_utils_release_sink(side);
 }
 
 void log_utils_debug(const char* context, const char* format, ...)
 {
-    if (s_min_level > LOG_UTILS_DEBUG)
+    if (log_utils_runtime_min_level > LOG_UTILS_DEBUG)
     {
         return;
     }
@@ -124,7 +667,7 @@ void log_utils_debug(const char* context, const char* format, ...)
 
 void log_utils_info(const char* context, const char* format, ...)
 {
-    if (s_min_level > LOG_UTILS_INFO)
+    if (log_utils_runtime_min_level > LOG_UTILS_INFO)
     {
         return;
     }
@@ -137,7 +680,7 @@ void log_utils_info(const char* context, const char* format, ...)
 
 void log_utils_warn(const char* context, const char* format, ...)
 {
-    if (s_min_level > LOG_UTILS_WARN)
+    if (log_utils_runtime_min_level > LOG_UTILS_WARN)
     {
         return;
     }
@@ -155,3 +698,34 @@ void log_utils_error(const char* context, const char* format, ...)
     log_utils_log(LOG_UTILS_ERROR, context, format, args);
     va_end(args);
 }
+
+void log_utils_emit(t_log_utils_level level, const char* context, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    log_utils_log(level, context, format, args);
+    va_end(args);
+}
+
+void log_utils_fields(t_log_utils_level level, const char* context_str, const char* message,
+                      const t_log_utils_field* fields, size_t count)
+{
+    t_str_utils_view context = str_utils_view(context_str);
+
+    if (!log_utils_admit(level, context)) return;
+
+    t_log_utils_event event = {
+        NULL, 0, level, context,
+        message, message ? strlen(message) : 0,
+        fields, fields ? count : 0
+    };
+    log_utils_write_event(&event);
+}
+
+void log_utils_write(t_log_utils_level level, t_str_utils_view context, t_str_utils_view message)
+{
+    if (!log_utils_admit(level, context)) return;
+
+    t_log_utils_event event = { NULL, 0, level, context, message.data ? message.data : "", message.len, NULL, 0 };
+    log_utils_write_event(&event);
+}
@@ -0,0 +1,601 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define LOG_UTILS_BIN_HAS_TSC 1
+#endif
+
+#include "log_utils_bin.h"
+
+#define LOG_UTILS_BIN_BLOCK_SIZE         (64 * 1024)
+#define LOG_UTILS_BIN_RECORD_HEADER_SIZE (1 + 4)
+#define LOG_UTILS_BIN_BLOCK_HEADER_SIZE  (LOG_UTILS_BIN_RECORD_HEADER_SIZE + 8)
+#define LOG_UTILS_BIN_VARINT_MAX         10
+
+typedef struct t_log_utils_bin_buffer
+{
+    struct t_log_utils_bin_buffer* next;
+    uint32_t generation;   // Stream the buffered events belong to
+    size_t   used;         // 0 when no block is open
+    uint64_t last_ticks;
+    uint8_t  data[LOG_UTILS_BIN_BLOCK_SIZE];
+} t_log_utils_bin_buffer;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static int s_fd = -1;
+static uint32_t s_next_id = 0;
+static uint32_t s_last_generation = 0;
+static _Atomic uint32_t s_generation = 0;  // 0 while no stream is open
+static t_log_utils_bin_buffer* s_buffers = NULL;
+
+static pthread_once_t s_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t s_buffer_key;
+static _Thread_local t_log_utils_bin_buffer* s_buffer = NULL;
+
+static uint64_t log_utils_bin_ticks(void)
+{
+#ifdef LOG_UTILS_BIN_HAS_TSC
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+static size_t log_utils_bin_put_varint(uint8_t* out, uint64_t value)
+{
+    size_t n = 0;
+
+    while (value >= 0x80)
+    {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+
+    return n;
+}
+
+static uint64_t log_utils_bin_zigzag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static bool log_utils_bin_write_all(const uint8_t* data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t written = write(s_fd, data, len);
+
+        if (written < 0)
+        {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "Failed to write binary log: %s\n", strerror(errno));
+            return false;
+        }
+        data += written;
+        len -= (size_t)written;
+    }
+
+    return true;
+}
+
+static void log_utils_bin_put_record_header(uint8_t* out, uint8_t tag, size_t payload_size)
+{
+    uint32_t size = (uint32_t)payload_size;
+
+    out[0] = tag;
+    memcpy(out + 1, &size, sizeof(size));
+}
+
+/* -------------------------------------------------------------------------- */
+/* Format registration                                                        */
+/* -------------------------------------------------------------------------- */
+
+static uint8_t log_utils_bin_integer_kind(bool is_signed, size_t size)
+{
+    if (size > sizeof(int)) return is_signed ? LOG_UTILS_BIN_KIND_I64 : LOG_UTILS_BIN_KIND_U64;
+    return is_signed ? LOG_UTILS_BIN_KIND_I32 : LOG_UTILS_BIN_KIND_U32;
+}
+
+void log_utils_bin_parse_conversion(const char* spec, t_log_utils_bin_conversion* conversion)
+{
+    const char* p = spec;
+
+    conversion->star_count = 0;
+    conversion->halves = 0;
+    conversion->kind = 0;
+    conversion->verbatim = false;
+
+    while (*p && strchr("-+ #0'", *p)) p++;
+
+    if (*p == '*') { conversion->star_count++; p++; }
+    while (*p >= '0' && *p <= '9') p++;
+
+    if (*p == '.')
+    {
+        p++;
+        if (*p == '*') { conversion->star_count++; p++; }
+        while (*p >= '0' && *p <= '9') p++;
+    }
+
+    conversion->length = p;
+
+    size_t size = sizeof(int);
+    bool long_double = false;
+    bool wide = false;
+    switch (*p)
+    {
+        case 'h': p++; conversion->halves = 1; if (*p == 'h') { p++; conversion->halves = 2; } break;
+        case 'l': p++; size = sizeof(long); wide = true; if (*p == 'l') { p++; size = sizeof(long long); wide = false; } break;
+        case 'j': p++; size = sizeof(intmax_t); break;
+        case 'z': p++; size = sizeof(size_t); break;
+        case 't': p++; size = sizeof(ptrdiff_t); break;
+        case 'L': p++; long_double = true; break;
+        default: break;
+    }
+
+    conversion->conversion = *p;
+    conversion->end = *p ? p + 1 : p;
+
+    switch (*p)
+    {
+        case 'd': case 'i':
+            conversion->kind = log_utils_bin_integer_kind(true, size);
+            break;
+        case 'u': case 'o': case 'x': case 'X':
+            conversion->kind = log_utils_bin_integer_kind(false, size);
+            break;
+        case 'c':
+            // %lc takes a wint_t
+            conversion->kind = LOG_UTILS_BIN_KIND_I32;
+            conversion->verbatim = wide;
+            break;
+        case 'C':
+            conversion->kind = LOG_UTILS_BIN_KIND_I32;
+            conversion->verbatim = true;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            conversion->kind = long_double ? LOG_UTILS_BIN_KIND_LONG_DOUBLE : LOG_UTILS_BIN_KIND_DOUBLE;
+            break;
+        case 's':
+            // %ls takes a wchar_t*: only its address can be recorded
+            conversion->kind = wide ? LOG_UTILS_BIN_KIND_POINTER : LOG_UTILS_BIN_KIND_STRING;
+            conversion->verbatim = wide;
+            break;
+        case 'S':
+            conversion->kind = LOG_UTILS_BIN_KIND_POINTER;
+            conversion->verbatim = true;
+            break;
+        case 'p': case 'n':
+            conversion->kind = LOG_UTILS_BIN_KIND_POINTER;
+            break;
+        default:
+            // %m and unknown conversions take no argument
+            conversion->verbatim = true;
+            break;
+    }
+}
+
+/*
+ * Derives the kind of every variadic argument consumed by a printf format,
+ * including '*' widths and precisions.
+ */
+static uint8_t log_utils_bin_parse_kinds(const char* format, uint8_t* kinds)
+{
+    uint8_t count = 0;
+
+#define LOG_UTILS_BIN_PUSH(kind) do { if (count < LOG_UTILS_BIN_MAX_ARGS) kinds[count++] = (uint8_t)(kind); } while (0)
+
+    for (const char* p = format; *p; )
+    {
+        if (*p++ != '%') continue;
+        if (*p == '%') { p++; continue; }
+
+        t_log_utils_bin_conversion conversion;
+        log_utils_bin_parse_conversion(p, &conversion);
+
+        for (uint8_t i = 0; i < conversion.star_count; i++) LOG_UTILS_BIN_PUSH(LOG_UTILS_BIN_KIND_I32);
+        if (conversion.kind) LOG_UTILS_BIN_PUSH(conversion.kind);
+
+        p = conversion.end;
+    }
+
+#undef LOG_UTILS_BIN_PUSH
+
+    return count;
+}
+
+static uint64_t log_utils_bin_register(t_log_utils_bin_site* site, t_log_utils_level level,
+                                       const char* context, const char* format)
+{
+    pthread_mutex_lock(&s_lock);
+
+    uint32_t generation = atomic_load_explicit(&s_generation, memory_order_relaxed);
+    uint64_t registration = atomic_load_explicit(&site->registration, memory_order_relaxed);
+
+    if (generation == 0 || (registration >> 32) == generation)
+    {
+        pthread_mutex_unlock(&s_lock);
+        return generation ? registration : 0;
+    }
+
+    if (!site->parsed)
+    {
+        site->kind_count = log_utils_bin_parse_kinds(format, site->kinds);
+        site->parsed = true;
+    }
+
+    uint32_t id = ++s_next_id;
+    size_t context_len = context ? strlen(context) : 0;
+    size_t format_len = strlen(format);
+    size_t capacity = LOG_UTILS_BIN_RECORD_HEADER_SIZE + 5 * LOG_UTILS_BIN_VARINT_MAX
+                    + context_len + format_len + site->kind_count;
+    uint8_t* record = malloc(capacity);
+
+    if (!record)
+    {
+        pthread_mutex_unlock(&s_lock);
+        return 0;
+    }
+
+    size_t n = LOG_UTILS_BIN_RECORD_HEADER_SIZE;
+    n += log_utils_bin_put_varint(record + n, id);
+    n += log_utils_bin_put_varint(record + n, log_utils_bin_zigzag(level));
+    n += log_utils_bin_put_varint(record + n, context ? context_len + 1 : 0);
+    memcpy(record + n, context ? context : "", context_len);
+    n += context_len;
+    n += log_utils_bin_put_varint(record + n, format_len);
+    memcpy(record + n, format, format_len);
+    n += format_len;
+    n += log_utils_bin_put_varint(record + n, site->kind_count);
+    memcpy(record + n, site->kinds, site->kind_count);
+    n += site->kind_count;
+
+    log_utils_bin_put_record_header(record, LOG_UTILS_BIN_TAG_DICT, n - LOG_UTILS_BIN_RECORD_HEADER_SIZE);
+    log_utils_bin_write_all(record, n);
+    free(record);
+
+    registration = ((uint64_t)generation << 32) | id;
+    atomic_store_explicit(&site->registration, registration, memory_order_release);
+
+    pthread_mutex_unlock(&s_lock);
+    return registration;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Per-thread buffers                                                         */
+/* -------------------------------------------------------------------------- */
+
+// Caller holds s_lock
+static void log_utils_bin_write_block_locked(t_log_utils_bin_buffer* buffer)
+{
+    if (buffer->used > LOG_UTILS_BIN_BLOCK_HEADER_SIZE
+        && buffer->generation == atomic_load_explicit(&s_generation, memory_order_relaxed))
+    {
+        log_utils_bin_put_record_header(buffer->data, LOG_UTILS_BIN_TAG_BLOCK,
+                                        buffer->used - LOG_UTILS_BIN_RECORD_HEADER_SIZE);
+        log_utils_bin_write_all(buffer->data, buffer->used);
+    }
+    buffer->used = 0;
+}
+
+static void log_utils_bin_write_block(t_log_utils_bin_buffer* buffer)
+{
+    pthread_mutex_lock(&s_lock);
+    log_utils_bin_write_block_locked(buffer);
+    pthread_mutex_unlock(&s_lock);
+}
+
+static void log_utils_bin_buffer_destroy(void* value)
+{
+    t_log_utils_bin_buffer* buffer = value;
+
+    pthread_mutex_lock(&s_lock);
+    log_utils_bin_write_block_locked(buffer);
+
+    t_log_utils_bin_buffer** link = &s_buffers;
+    while (*link && *link != buffer) link = &(*link)->next;
+    if (*link) *link = buffer->next;
+
+    pthread_mutex_unlock(&s_lock);
+    free(buffer);
+}
+
+static void log_utils_bin_create_key(void)
+{
+    pthread_key_create(&s_buffer_key, log_utils_bin_buffer_destroy);
+}
+
+static t_log_utils_bin_buffer* log_utils_bin_thread_buffer(void)
+{
+    if (s_buffer) return s_buffer;
+
+    pthread_once(&s_key_once, log_utils_bin_create_key);
+
+    t_log_utils_bin_buffer* buffer = malloc(sizeof(t_log_utils_bin_buffer));
+    if (!buffer) return NULL;
+
+    buffer->used = 0;
+    buffer->generation = 0;
+    buffer->last_ticks = 0;
+
+    pthread_mutex_lock(&s_lock);
+    buffer->next = s_buffers;
+    s_buffers = buffer;
+    pthread_mutex_unlock(&s_lock);
+
+    pthread_setspecific(s_buffer_key, buffer);
+    s_buffer = buffer;
+
+    return buffer;
+}
+
+/*
+ * Encodes one event at out; returns its size, or 0 if it does not fit in capacity.
+ */
+static size_t log_utils_bin_encode(uint8_t* out, size_t capacity, const t_log_utils_bin_site* site,
+                                   uint32_t id, int64_t delta, va_list args)
+{
+    size_t n = 0;
+
+    if (capacity < 2 * LOG_UTILS_BIN_VARINT_MAX) return 0;
+
+    n += log_utils_bin_put_varint(out + n, id);
+    n += log_utils_bin_put_varint(out + n, log_utils_bin_zigzag(delta));
+
+    for (uint8_t i = 0; i < site->kind_count; i++)
+    {
+        if (capacity - n < LOG_UTILS_BIN_VARINT_MAX) return 0;
+
+        switch (site->kinds[i])
+        {
+            case LOG_UTILS_BIN_KIND_I32:
+                n += log_utils_bin_put_varint(out + n, log_utils_bin_zigzag(va_arg(args, int)));
+                break;
+            case LOG_UTILS_BIN_KIND_I64:
+                n += log_utils_bin_put_varint(out + n, log_utils_bin_zigzag(va_arg(args, long long)));
+                break;
+            case LOG_UTILS_BIN_KIND_U32:
+                n += log_utils_bin_put_varint(out + n, va_arg(args, unsigned int));
+                break;
+            case LOG_UTILS_BIN_KIND_U64:
+                n += log_utils_bin_put_varint(out + n, va_arg(args, unsigned long long));
+                break;
+            case LOG_UTILS_BIN_KIND_DOUBLE:
+            case LOG_UTILS_BIN_KIND_LONG_DOUBLE:
+            {
+                double value = site->kinds[i] == LOG_UTILS_BIN_KIND_DOUBLE
+                    ? va_arg(args, double)
+                    : (double)va_arg(args, long double);
+                memcpy(out + n, &value, sizeof(value));
+                n += sizeof(value);
+                break;
+            }
+            case LOG_UTILS_BIN_KIND_STRING:
+            {
+                const char* value = va_arg(args, const char*);
+                if (!value) value = "(null)";
+
+                size_t len = strlen(value);
+                if (capacity - n < LOG_UTILS_BIN_VARINT_MAX + len) return 0;
+
+                n += log_utils_bin_put_varint(out + n, len);
+                memcpy(out + n, value, len);
+                n += len;
+                break;
+            }
+            case LOG_UTILS_BIN_KIND_POINTER:
+                n += log_utils_bin_put_varint(out + n, (uintptr_t)va_arg(args, void*));
+                break;
+            default:
+                break;
+        }
+    }
+
+    return n;
+}
+
+static void log_utils_bin_open_block(t_log_utils_bin_buffer* buffer, uint64_t ticks)
+{
+    buffer->used = LOG_UTILS_BIN_BLOCK_HEADER_SIZE;
+    buffer->last_ticks = ticks;
+    memcpy(buffer->data + LOG_UTILS_BIN_RECORD_HEADER_SIZE, &ticks, sizeof(ticks));
+}
+
+/*
+ * Events that do not fit in an empty block go out as a block of their own.
+ */
+static void log_utils_bin_log_oversized(const t_log_utils_bin_site* site, uint32_t id, uint64_t ticks, va_list args)
+{
+    size_t capacity = 2 * LOG_UTILS_BIN_BLOCK_SIZE;
+
+    for (;;)
+    {
+        uint8_t* block = malloc(capacity);
+        if (!block) return;
+
+        va_list args_copy;
+        va_copy(args_copy, args);
+        size_t size = log_utils_bin_encode(block + LOG_UTILS_BIN_BLOCK_HEADER_SIZE,
+                                           capacity - LOG_UTILS_BIN_BLOCK_HEADER_SIZE, site, id, 0, args_copy);
+        va_end(args_copy);
+
+        if (size)
+        {
+            size += LOG_UTILS_BIN_BLOCK_HEADER_SIZE;
+            log_utils_bin_put_record_header(block, LOG_UTILS_BIN_TAG_BLOCK, size - LOG_UTILS_BIN_RECORD_HEADER_SIZE);
+            memcpy(block + LOG_UTILS_BIN_RECORD_HEADER_SIZE, &ticks, sizeof(ticks));
+
+            pthread_mutex_lock(&s_lock);
+            log_utils_bin_write_all(block, size);
+            pthread_mutex_unlock(&s_lock);
+
+            free(block);
+            return;
+        }
+
+        free(block);
+        capacity *= 2;
+    }
+}
+
+void log_utils_bin_log(t_log_utils_bin_site* site, t_log_utils_level level, const char* context, const char* format, ...)
+{
+    uint32_t generation = atomic_load_explicit(&s_generation, memory_order_acquire);
+    if (generation == 0) return;
+
+    uint64_t registration = atomic_load_explicit(&site->registration, memory_order_acquire);
+    if ((registration >> 32) != generation)
+    {
+        registration = log_utils_bin_register(site, level, context, format);
+        if (registration == 0) return;
+    }
+
+    t_log_utils_bin_buffer* buffer = s_buffer ? s_buffer : log_utils_bin_thread_buffer();
+    if (!buffer) return;
+
+    if (buffer->generation != generation)
+    {
+        buffer->generation = generation;
+        buffer->used = 0;
+    }
+
+    uint32_t id = (uint32_t)registration;
+    uint64_t ticks = log_utils_bin_ticks();
+
+    va_list args;
+    va_start(args, format);
+
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        if (buffer->used == 0) log_utils_bin_open_block(buffer, ticks);
+
+        va_list args_copy;
+        va_copy(args_copy, args);
+        size_t size = log_utils_bin_encode(buffer->data + buffer->used, LOG_UTILS_BIN_BLOCK_SIZE - buffer->used,
+                                           site, id, (int64_t)(ticks - buffer->last_ticks), args_copy);
+        va_end(args_copy);
+
+        if (size)
+        {
+            buffer->used += size;
+            buffer->last_ticks = ticks;
+            va_end(args);
+            return;
+        }
+
+        // Only an event alone in its block is oversized
+        if (buffer->used == LOG_UTILS_BIN_BLOCK_HEADER_SIZE)
+        {
+            buffer->used = 0;
+            break;
+        }
+        log_utils_bin_write_block(buffer);
+    }
+
+    log_utils_bin_log_oversized(site, id, ticks, args);
+    va_end(args);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Stream                                                                     */
+/* -------------------------------------------------------------------------- */
+
+static int64_t log_utils_bin_timespec_ns(const struct timespec* ts)
+{
+    return (int64_t)ts->tv_sec * 1000000000 + ts->tv_nsec;
+}
+
+bool log_utils_bin_open(const char* path)
+{
+    if (!path) return false;
+
+    pthread_mutex_lock(&s_lock);
+
+    if (s_fd >= 0)
+    {
+        pthread_mutex_unlock(&s_lock);
+        return false;
+    }
+
+    s_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (s_fd < 0)
+    {
+        pthread_mutex_unlock(&s_lock);
+        return false;
+    }
+
+    // Measure the tick rate against the monotonic clock over ~10 ms
+    struct timespec realtime, monotonic_start, monotonic_end;
+    struct timespec pause = { 0, 10 * 1000000 };
+
+    clock_gettime(CLOCK_REALTIME, &realtime);
+    clock_gettime(CLOCK_MONOTONIC, &monotonic_start);
+    uint64_t base_ticks = log_utils_bin_ticks();
+    nanosleep(&pause, NULL);
+    uint64_t end_ticks = log_utils_bin_ticks();
+    clock_gettime(CLOCK_MONOTONIC, &monotonic_end);
+
+    int64_t elapsed_ns = log_utils_bin_timespec_ns(&monotonic_end) - log_utils_bin_timespec_ns(&monotonic_start);
+    uint64_t ticks_per_second = elapsed_ns > 0
+        ? (uint64_t)((long double)(end_ticks - base_ticks) * 1e9L / (long double)elapsed_ns)
+        : 1000000000u;
+    int64_t base_realtime_ns = log_utils_bin_timespec_ns(&realtime);
+
+    uint8_t header[LOG_UTILS_BIN_MAGIC_SIZE + 3 * sizeof(uint64_t)];
+    memcpy(header, LOG_UTILS_BIN_MAGIC, LOG_UTILS_BIN_MAGIC_SIZE);
+    memcpy(header + LOG_UTILS_BIN_MAGIC_SIZE, &ticks_per_second, sizeof(uint64_t));
+    memcpy(header + LOG_UTILS_BIN_MAGIC_SIZE + 8, &base_ticks, sizeof(uint64_t));
+    memcpy(header + LOG_UTILS_BIN_MAGIC_SIZE + 16, &base_realtime_ns, sizeof(int64_t));
+
+    if (!log_utils_bin_write_all(header, sizeof(header)))
+    {
+        close(s_fd);
+        s_fd = -1;
+        pthread_mutex_unlock(&s_lock);
+        return false;
+    }
+
+    s_next_id = 0;
+    atomic_store_explicit(&s_generation, ++s_last_generation, memory_order_release);
+
+    pthread_mutex_unlock(&s_lock);
+    return true;
+}
+
+void log_utils_bin_flush(void)
+{
+    if (s_buffer) log_utils_bin_write_block(s_buffer);
+}
+
+void log_utils_bin_close(void)
+{
+    pthread_mutex_lock(&s_lock);
+
+    if (s_fd >= 0)
+    {
+        for (t_log_utils_bin_buffer* buffer = s_buffers; buffer; buffer = buffer->next)
+        {
+            log_utils_bin_write_block_locked(buffer);
+        }
+
+        atomic_store_explicit(&s_generation, 0, memory_order_release);
+        close(s_fd);
+        s_fd = -1;
+    }
+
+    pthread_mutex_unlock(&s_lock);
+}
@@ -0,0 +1,465 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "json_utils.h"
+#include "log_utils_reader.h"
+
+#define LOG_UTILS_READER_CHUNK_SIZE (4 * 1024 * 1024)
+
+typedef enum e_log_utils_reader_key
+{
+    LOG_UTILS_READER_KEY_OTHER,
+    LOG_UTILS_READER_KEY_TIMESTAMP,
+    LOG_UTILS_READER_KEY_LEVEL,
+    LOG_UTILS_READER_KEY_CONTEXT,
+    LOG_UTILS_READER_KEY_CONTENT
+} e_log_utils_reader_key;
+
+typedef struct t_log_utils_reader t_log_utils_reader;
+
+typedef struct t_log_utils_reader_worker
+{
+    t_log_utils_reader*      reader;
+    unsigned                 index;
+    pthread_t                thread;
+    t_json_utils_parser*     parser;
+
+    // Unescaped strings of the current line; sized so it never moves mid-line
+    char*                    scratch;
+    size_t                   scratch_capacity;
+    size_t                   scratch_len;
+
+    // Current line
+    const char*              line;
+    size_t                   line_len;
+    int                      depth;
+    e_log_utils_reader_key   key;
+    unsigned                 seen;         // Bit per top-level key met so far
+    bool                     has_timestamp;
+    bool                     has_level;
+    bool                     bad_level;
+    t_log_utils_record       record;
+
+    t_log_utils_reader_stats stats;
+    bool                     failed;
+} t_log_utils_reader_worker;
+
+typedef struct t_log_utils_reader
+{
+    const char*         data;
+    size_t*             bounds;        // chunk_count + 1 line-aligned offsets
+    size_t              chunk_count;
+    atomic_size_t       next_chunk;
+    atomic_bool         stop;
+
+    t_log_utils_level   min_level;
+    const char*         context;       // Filter, unescaped
+    char*               raw_context;   // Filter as it appears in a line
+    size_t              raw_context_len;
+
+    log_utils_record_fn callback;
+    void*               callback_context;
+} t_log_utils_reader;
+
+static const char* s_level_names[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+/* -------------------------------------------------------------------------- */
+/* Raw line pre-filter                                                        */
+/* -------------------------------------------------------------------------- */
+
+// Returns the raw string value of "key", or NULL (also for null and non-string values)
+static const char* log_utils_reader_raw_value(const char* line, size_t len, const char* key, size_t key_len)
+{
+    const char* end = line + len;
+    const char* p = line;
+
+    while ((p = memchr(p, '"', (size_t)(end - p))) != NULL)
+    {
+        if ((size_t)(end - p) > key_len + 1 && memcmp(p + 1, key, key_len) == 0 && p[key_len + 1] == '"')
+        {
+            p += key_len + 2;
+            while (p < end && (*p == ' ' || *p == ':')) p++;
+            return p < end && *p == '"' ? p + 1 : NULL;
+        }
+        p++;
+    }
+
+    return NULL;
+}
+
+/*
+ * Rejects lines whose raw level or context cannot match, without parsing.
+ * Lines laid out differently are kept and filtered after parsing.
+ */
+static bool log_utils_reader_prefilter(const t_log_utils_reader* reader, const char* line, size_t len)
+{
+    const char* end = line + len;
+
+    if (reader->min_level > LOG_UTILS_LEVEL_DEBUG)
+    {
+        const char* level = log_utils_reader_raw_value(line, len, "level", 5);
+        if (level)
+        {
+            for (int l = LOG_UTILS_LEVEL_DEBUG; l < reader->min_level; l++)
+            {
+                size_t name_len = strlen(s_level_names[l]);
+                if ((size_t)(end - level) > name_len && memcmp(level, s_level_names[l], name_len) == 0
+                    && level[name_len] == '"')
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    if (reader->raw_context)
+    {
+        const char* context = log_utils_reader_raw_value(line, len, "context", 7);
+        if (context)
+        {
+            size_t n = reader->raw_context_len;
+            if ((size_t)(end - context) <= n || memcmp(context, reader->raw_context, n) != 0 || context[n] != '"')
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Parsing                                                                    */
+/* -------------------------------------------------------------------------- */
+
+static bool log_utils_reader_on_begin(void* context)
+{
+    ((t_log_utils_reader_worker*)context)->depth++;
+    return true;
+}
+
+static bool log_utils_reader_on_end(void* context)
+{
+    ((t_log_utils_reader_worker*)context)->depth--;
+    return true;
+}
+
+static bool log_utils_reader_on_key(void* context, const char* key, size_t len)
+{
+    t_log_utils_reader_worker* worker = context;
+
+    worker->key = LOG_UTILS_READER_KEY_OTHER;
+    if (worker->depth != 1) return true;
+
+    if (len == 9 && memcmp(key, "timestamp", 9) == 0) worker->key = LOG_UTILS_READER_KEY_TIMESTAMP;
+    else if (len == 5 && memcmp(key, "level", 5) == 0) worker->key = LOG_UTILS_READER_KEY_LEVEL;
+    else if (len == 7 && memcmp(key, "context", 7) == 0) worker->key = LOG_UTILS_READER_KEY_CONTEXT;
+    else if (len == 7 && memcmp(key, "content", 7) == 0) worker->key = LOG_UTILS_READER_KEY_CONTENT;
+
+    // The first occurrence wins, as in the raw pre-filter
+    unsigned bit = 1u << worker->key;
+    if (worker->seen & bit) worker->key = LOG_UTILS_READER_KEY_OTHER;
+    worker->seen |= bit;
+
+    return true;
+}
+
+static bool log_utils_reader_on_string(void* context, const char* value, size_t len)
+{
+    t_log_utils_reader_worker* worker = context;
+
+    if (worker->depth != 1 || worker->key == LOG_UTILS_READER_KEY_OTHER) return true;
+
+    // Unescaped values point into the line; decoded ones only live during this call
+    if (value < worker->line || value >= worker->line + worker->line_len)
+    {
+        char* copy = worker->scratch + worker->scratch_len;
+        memcpy(copy, value, len);
+        worker->scratch_len += len;
+        value = copy;
+    }
+
+    switch (worker->key)
+    {
+        case LOG_UTILS_READER_KEY_TIMESTAMP:
+            worker->record.timestamp = value;
+            worker->record.timestamp_len = len;
+            worker->has_timestamp = true;
+            break;
+        case LOG_UTILS_READER_KEY_LEVEL:
+            worker->bad_level = true;
+            for (int l = LOG_UTILS_LEVEL_DEBUG; l <= LOG_UTILS_LEVEL_ERROR; l++)
+            {
+                if (strlen(s_level_names[l]) == len && memcmp(s_level_names[l], value, len) == 0)
+                {
+                    worker->record.level = l;
+                    worker->bad_level = false;
+                }
+            }
+            worker->has_level = true;
+            break;
+        case LOG_UTILS_READER_KEY_CONTEXT:
+            worker->record.context = value;
+            worker->record.context_len = len;
+            break;
+        case LOG_UTILS_READER_KEY_CONTENT:
+            worker->record.content = value;
+            worker->record.content_len = len;
+            break;
+        default:
+            break;
+    }
+
+    return true;
+}
+
+static void log_utils_reader_line(t_log_utils_reader_worker* worker, const char* line, size_t len)
+{
+    t_log_utils_reader* reader = worker->reader;
+
+    if (!log_utils_reader_prefilter(reader, line, len))
+    {
+        worker->stats.filtered++;
+        return;
+    }
+
+    // Decoded strings never exceed the line length
+    if (worker->scratch_capacity < len)
+    {
+        char* scratch = realloc(worker->scratch, len);
+        if (!scratch)
+        {
+            worker->failed = true;
+            atomic_store(&reader->stop, true);
+            return;
+        }
+        worker->scratch = scratch;
+        worker->scratch_capacity = len;
+    }
+
+    worker->scratch_len = 0;
+    worker->line = line;
+    worker->line_len = len;
+    worker->depth = 0;
+    worker->key = LOG_UTILS_READER_KEY_OTHER;
+    worker->seen = 0;
+    worker->has_timestamp = false;
+    worker->has_level = false;
+    worker->bad_level = false;
+    memset(&worker->record, 0, sizeof(worker->record));
+
+    json_utils_parser_reset(worker->parser);
+    if (json_utils_parser_feed(worker->parser, line, len) != JSON_UTILS_OK
+        || json_utils_parser_finish(worker->parser) != JSON_UTILS_OK
+        || !worker->has_timestamp || !worker->has_level || worker->bad_level)
+    {
+        worker->stats.malformed++;
+        return;
+    }
+
+    const t_log_utils_record* record = &worker->record;
+    if (record->level < reader->min_level
+        || (reader->context
+            && (!record->context
+                || record->context_len != strlen(reader->context)
+                || memcmp(record->context, reader->context, record->context_len) != 0)))
+    {
+        worker->stats.filtered++;
+        return;
+    }
+
+    worker->record.line = line;
+    worker->record.line_len = len;
+    worker->stats.records++;
+
+    if (!reader->callback(reader->callback_context, worker->index, &worker->record))
+    {
+        atomic_store(&reader->stop, true);
+    }
+}
+
+static void* log_utils_reader_run(void* arg)
+{
+    t_log_utils_reader_worker* worker = arg;
+    t_log_utils_reader* reader = worker->reader;
+
+    while (!atomic_load_explicit(&reader->stop, memory_order_relaxed))
+    {
+        size_t chunk = atomic_fetch_add(&reader->next_chunk, 1);
+        if (chunk >= reader->chunk_count) break;
+
+        const char* p = reader->data + reader->bounds[chunk];
+        const char* end = reader->data + reader->bounds[chunk + 1];
+
+        while (p < end && !atomic_load_explicit(&reader->stop, memory_order_relaxed))
+        {
+            const char* newline = memchr(p, '\n', (size_t)(end - p));
+            const char* line_end = newline ? newline : end;
+            size_t len = (size_t)(line_end - p);
+
+            if (len && p[len - 1] == '\r') len--;
+            if (len) log_utils_reader_line(worker, p, len);
+
+            p = line_end + 1;
+        }
+    }
+
+    return NULL;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Reader                                                                     */
+/* -------------------------------------------------------------------------- */
+
+// Cuts data into chunks of about chunk_size, each ending after a newline
+static size_t* log_utils_reader_split(const char* data, size_t size, size_t chunk_size, size_t* count)
+{
+    size_t capacity = size / chunk_size + 2;
+    size_t* bounds = malloc(capacity * sizeof(size_t));
+    if (!bounds) return NULL;
+
+    size_t n = 0;
+    bounds[0] = 0;
+
+    while (bounds[n] < size)
+    {
+        size_t bound = bounds[n] + chunk_size;
+
+        if (bound >= size)
+        {
+            bound = size;
+        }
+        else
+        {
+            const char* newline = memchr(data + bound, '\n', size - bound);
+            bound = newline ? (size_t)(newline - data) + 1 : size;
+        }
+
+        bounds[++n] = bound;
+    }
+
+    *count = n;
+    return bounds;
+}
+
+bool log_utils_reader_read_file(const char* path, const t_log_utils_reader_options* options,
+                                log_utils_record_fn callback, void* context, t_log_utils_reader_stats* stats)
+{
+    if (stats) memset(stats, 0, sizeof(*stats));
+    if (!path || !callback) return false;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    size_t size = (size_t)st.st_size;
+    if (size == 0)
+    {
+        close(fd);
+        return true;
+    }
+
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    posix_madvise(map, size, POSIX_MADV_SEQUENTIAL);
+
+    t_log_utils_reader reader = { 0 };
+    reader.data = map;
+    reader.callback = callback;
+    reader.callback_context = context;
+    reader.min_level = options ? options->min_level : LOG_UTILS_LEVEL_DEBUG;
+    reader.context = options ? options->context : NULL;
+    atomic_init(&reader.next_chunk, 0);
+    atomic_init(&reader.stop, false);
+
+    size_t chunk_size = options && options->chunk_size ? options->chunk_size : LOG_UTILS_READER_CHUNK_SIZE;
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned threads = options && options->threads ? options->threads : (online > 0 ? (unsigned)online : 1);
+
+    bool ok = true;
+    t_log_utils_reader_worker* workers = NULL;
+
+    reader.bounds = log_utils_reader_split(reader.data, size, chunk_size, &reader.chunk_count);
+    if (reader.context)
+    {
+        reader.raw_context = json_utils_escape(reader.context);
+        reader.raw_context_len = reader.raw_context ? strlen(reader.raw_context) : 0;
+    }
+    if (threads > reader.chunk_count) threads = (unsigned)reader.chunk_count;
+
+    workers = calloc(threads, sizeof(t_log_utils_reader_worker));
+    if (!reader.bounds || (reader.context && !reader.raw_context) || !workers) ok = false;
+
+    t_json_utils_callbacks callbacks = {
+        .on_object_begin = log_utils_reader_on_begin,
+        .on_object_end = log_utils_reader_on_end,
+        .on_array_begin = log_utils_reader_on_begin,
+        .on_array_end = log_utils_reader_on_end,
+        .on_key = log_utils_reader_on_key,
+        .on_string = log_utils_reader_on_string,
+    };
+
+    for (unsigned i = 0; ok && i < threads; i++)
+    {
+        workers[i].reader = &reader;
+        workers[i].index = i;
+        workers[i].parser = json_utils_parser_new(&callbacks, &workers[i], NULL);
+        if (!workers[i].parser) ok = false;
+    }
+
+    if (ok)
+    {
+        // The calling thread is worker 0; a thread that fails to start leaves its share to the others
+        unsigned started = 1;
+        for (; started < threads; started++)
+        {
+            if (pthread_create(&workers[started].thread, NULL, log_utils_reader_run, &workers[started]) != 0) break;
+        }
+
+        log_utils_reader_run(&workers[0]);
+
+        for (unsigned i = 1; i < started; i++)
+        {
+            pthread_join(workers[i].thread, NULL);
+        }
+
+        for (unsigned i = 0; i < threads; i++)
+        {
+            if (workers[i].failed) ok = false;
+            if (stats)
+            {
+                stats->records += workers[i].stats.records;
+                stats->filtered += workers[i].stats.filtered;
+                stats->malformed += workers[i].stats.malformed;
+            }
+        }
+    }
+
+    for (unsigned i = 0; workers && i < threads; i++)
+    {
+        json_utils_parser_free(workers[i].parser);
+        free(workers[i].scratch);
+    }
+    free(workers);
+    free(reader.raw_context);
+    free(reader.bounds);
+    munmap(map, size);
+
+    return ok;
+}
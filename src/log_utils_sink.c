@@ -0,0 +1,642 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "log_utils_sink.h"
+#include "str_utils.h"
+
+#define LOG_UTILS_SINK_FILE_BUFFER_SIZE  (1024 * 1024)
+#define LOG_UTILS_SINK_MMAP_WINDOW_SIZE  (16 * 1024 * 1024)
+
+#ifdef CLOCK_REALTIME_COARSE
+#define LOG_UTILS_SINK_CLOCK CLOCK_REALTIME_COARSE
+#else
+#define LOG_UTILS_SINK_CLOCK CLOCK_REALTIME
+#endif
+
+typedef struct t_log_utils_sink
+{
+    log_utils_sink_write_fn write;
+    log_utils_sink_flush_fn flush;
+    log_utils_sink_free_fn  free_context;
+    void*                   context;
+} t_log_utils_sink;
+
+/* -------------------------------------------------------------------------- */
+/* Generic sink                                                               */
+/* -------------------------------------------------------------------------- */
+
+t_log_utils_sink* log_utils_sink_new(log_utils_sink_write_fn write, log_utils_sink_flush_fn flush,
+                                     log_utils_sink_free_fn free_context, void* context)
+{
+    if (!write) return NULL;
+
+    t_log_utils_sink* sink = malloc(sizeof(t_log_utils_sink));
+    if (!sink) return NULL;
+
+    sink->write = write;
+    sink->flush = flush;
+    sink->free_context = free_context;
+    sink->context = context;
+
+    return sink;
+}
+
+void log_utils_sink_write(t_log_utils_sink* sink, const char* line, size_t len)
+{
+    if (sink) sink->write(sink->context, line, len);
+}
+
+void log_utils_sink_flush(t_log_utils_sink* sink)
+{
+    if (sink && sink->flush) sink->flush(sink->context);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Stdout sink                                                                */
+/* -------------------------------------------------------------------------- */
+
+static void log_utils_sink_stdout_write(void* context, const char* line, size_t len)
+{
+    (void)context;
+    fwrite(line, 1, len, stdout);
+}
+
+static void log_utils_sink_stdout_flush(void* context)
+{
+    (void)context;
+    fflush(stdout);
+}
+
+static t_log_utils_sink s_stdout_sink = {
+    log_utils_sink_stdout_write,
+    log_utils_sink_stdout_flush,
+    NULL,
+    NULL
+};
+
+t_log_utils_sink* log_utils_sink_stdout(void)
+{
+    return &s_stdout_sink;
+}
+
+void log_utils_sink_free(t_log_utils_sink* sink)
+{
+    if (!sink || sink == &s_stdout_sink) return;
+
+    log_utils_sink_flush(sink);
+    if (sink->free_context) sink->free_context(sink->context);
+    free(sink);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Rotating file target, shared by the file and mmap sinks                    */
+/* -------------------------------------------------------------------------- */
+
+typedef struct t_log_utils_sink_file
+{
+    t_log_utils_file_sink_options options;
+    char*  path;
+    int    fd;
+    size_t size;           // Logical file size, including data not yet written out
+    time_t next_rotation;  // Wall time of the next time-based rotation
+} t_log_utils_sink_file;
+
+static time_t log_utils_sink_file_next_rotation(const t_log_utils_sink_file* file, time_t now)
+{
+    if (file->options.rotate_interval == 0) return 0;
+
+    time_t interval = (time_t)file->options.rotate_interval;
+    return (now / interval + 1) * interval;
+}
+
+static bool log_utils_sink_file_open(t_log_utils_sink_file* file, bool truncate, time_t now)
+{
+    int flags = O_RDWR | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0);
+
+    file->fd = open(file->path, flags, 0644);
+    if (file->fd < 0) return false;
+
+    struct stat st;
+    file->size = fstat(file->fd, &st) == 0 ? (size_t)st.st_size : 0;
+    file->next_rotation = log_utils_sink_file_next_rotation(file, now);
+
+    return true;
+}
+
+static bool log_utils_sink_file_init(t_log_utils_sink_file* file, const char* path,
+                                     const t_log_utils_file_sink_options* options, size_t default_buffer_size)
+{
+    memset(file, 0, sizeof(*file));
+    if (options) file->options = *options;
+    if (file->options.buffer_size == 0) file->options.buffer_size = default_buffer_size;
+
+    file->path = str_utils_strdup(path);
+    if (!file->path) return false;
+
+    struct timespec now;
+    clock_gettime(LOG_UTILS_SINK_CLOCK, &now);
+
+    if (!log_utils_sink_file_open(file, false, now.tv_sec))
+    {
+        free(file->path);
+        return false;
+    }
+
+    return true;
+}
+
+static bool log_utils_sink_file_should_rotate(const t_log_utils_sink_file* file, size_t incoming, time_t now)
+{
+    if (file->options.rotate_interval && now >= file->next_rotation) return true;
+
+    return file->options.max_file_size
+        && file->size > 0
+        && file->size + incoming > file->options.max_file_size;
+}
+
+/*
+ * Closes the current file, shifts path.N-1 -> path.N ... path -> path.1 and
+ * reopens an empty file at path. The caller must have written out its data.
+ */
+static void log_utils_sink_file_rotate(t_log_utils_sink_file* file, time_t now)
+{
+    close(file->fd);
+
+    size_t path_len = strlen(file->path);
+    char* from = malloc(path_len + 16);
+    char* to = malloc(path_len + 16);
+
+    if (from && to && file->options.max_files > 0)
+    {
+        for (unsigned i = file->options.max_files - 1; i >= 1; i--)
+        {
+            snprintf(from, path_len + 16, "%s.%u", file->path, i);
+            snprintf(to, path_len + 16, "%s.%u", file->path, i + 1);
+            rename(from, to);
+        }
+        snprintf(to, path_len + 16, "%s.1", file->path);
+        rename(file->path, to);
+    }
+
+    free(from);
+    free(to);
+
+    if (!log_utils_sink_file_open(file, true, now))
+    {
+        fprintf(stderr, "Failed to reopen log file %s: %s\n", file->path, strerror(errno));
+    }
+}
+
+static void log_utils_sink_file_destroy(t_log_utils_sink_file* file)
+{
+    if (file->fd >= 0) close(file->fd);
+    free(file->path);
+}
+
+static bool log_utils_sink_writev_all(int fd, struct iovec* iov, int iovcnt)
+{
+    while (iovcnt > 0)
+    {
+        ssize_t written = writev(fd, iov, iovcnt);
+
+        if (written < 0)
+        {
+            if (errno == EINTR) continue;
+            return false;
+        }
+
+        while (iovcnt > 0 && (size_t)written >= iov->iov_len)
+        {
+            written -= (ssize_t)iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0)
+        {
+            iov->iov_base = (char*)iov->iov_base + written;
+            iov->iov_len -= (size_t)written;
+        }
+    }
+
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Buffered file sink                                                         */
+/* -------------------------------------------------------------------------- */
+
+typedef struct t_log_utils_file_sink
+{
+    pthread_mutex_t       lock;
+    t_log_utils_sink_file file;
+    char*                 buffer;
+    size_t                used;
+    struct timespec       first_pending;
+    pthread_cond_t        pending;        // Signaled when the buffer stops being empty, and on free
+    pthread_t             flusher;        // Runs only with a flush interval
+    bool                  has_flusher;
+    bool                  stopping;
+} t_log_utils_file_sink;
+
+static void log_utils_file_sink_drain(t_log_utils_file_sink* sink, const char* extra, size_t extra_len)
+{
+    struct iovec iov[2] = {
+        { sink->buffer, sink->used },
+        { (void*)extra, extra_len }
+    };
+    int iovcnt = extra_len ? 2 : 1;
+
+    if ((sink->used || extra_len) && !log_utils_sink_writev_all(sink->file.fd, iov, iovcnt))
+    {
+        fprintf(stderr, "Failed to write log file %s: %s\n", sink->file.path, strerror(errno));
+    }
+    sink->used = 0;
+}
+
+static bool log_utils_file_sink_expired(const t_log_utils_file_sink* sink, const struct timespec* now)
+{
+    if (!sink->file.options.flush_interval_ms || !sink->used) return false;
+
+    long long elapsed_ms = (long long)(now->tv_sec - sink->first_pending.tv_sec) * 1000
+                         + (now->tv_nsec - sink->first_pending.tv_nsec) / 1000000;
+
+    return elapsed_ms >= (long long)sink->file.options.flush_interval_ms;
+}
+
+static void log_utils_file_sink_write(void* context, const char* line, size_t len)
+{
+    t_log_utils_file_sink* sink = context;
+    struct timespec now;
+    clock_gettime(LOG_UTILS_SINK_CLOCK, &now);
+
+    pthread_mutex_lock(&sink->lock);
+
+    if (log_utils_sink_file_should_rotate(&sink->file, len, now.tv_sec))
+    {
+        log_utils_file_sink_drain(sink, NULL, 0);
+        log_utils_sink_file_rotate(&sink->file, now.tv_sec);
+    }
+
+    if (sink->used + len <= sink->file.options.buffer_size)
+    {
+        if (sink->used == 0)
+        {
+            sink->first_pending = now;
+            if (sink->has_flusher) pthread_cond_signal(&sink->pending);
+        }
+        memcpy(sink->buffer + sink->used, line, len);
+        sink->used += len;
+
+        if (sink->used == sink->file.options.buffer_size || log_utils_file_sink_expired(sink, &now))
+        {
+            log_utils_file_sink_drain(sink, NULL, 0);
+        }
+    }
+    else
+    {
+        // Buffer and line go out together in one sequential write
+        log_utils_file_sink_drain(sink, line, len);
+    }
+    sink->file.size += len;
+
+    pthread_mutex_unlock(&sink->lock);
+}
+
+static void log_utils_file_sink_flush(void* context)
+{
+    t_log_utils_file_sink* sink = context;
+
+    pthread_mutex_lock(&sink->lock);
+    log_utils_file_sink_drain(sink, NULL, 0);
+    pthread_mutex_unlock(&sink->lock);
+}
+
+/*
+ * Drains the buffer once its oldest line is flush_interval_ms old, so that
+ * lines do not wait for the next write when logging goes quiet.
+ */
+static void* log_utils_file_sink_flusher(void* context)
+{
+    t_log_utils_file_sink* sink = context;
+    unsigned interval_ms = sink->file.options.flush_interval_ms;
+
+    pthread_mutex_lock(&sink->lock);
+    while (!sink->stopping)
+    {
+        if (!sink->used)
+        {
+            pthread_cond_wait(&sink->pending, &sink->lock);
+            continue;
+        }
+
+        struct timespec deadline = sink->first_pending;
+        deadline.tv_sec += interval_ms / 1000;
+        deadline.tv_nsec += (long)(interval_ms % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+        struct timespec first_pending = sink->first_pending;
+        int status = pthread_cond_timedwait(&sink->pending, &sink->lock, &deadline);
+
+        // The same batch is still buffered: compared with the clock of the timed
+        // wait rather than the coarse one, so a deadline just past cannot spin
+        if (status == ETIMEDOUT && sink->used
+            && sink->first_pending.tv_sec == first_pending.tv_sec
+            && sink->first_pending.tv_nsec == first_pending.tv_nsec)
+        {
+            log_utils_file_sink_drain(sink, NULL, 0);
+        }
+    }
+    pthread_mutex_unlock(&sink->lock);
+
+    return NULL;
+}
+
+static void log_utils_file_sink_free(void* context)
+{
+    t_log_utils_file_sink* sink = context;
+
+    if (sink->has_flusher)
+    {
+        pthread_mutex_lock(&sink->lock);
+        sink->stopping = true;
+        pthread_cond_signal(&sink->pending);
+        pthread_mutex_unlock(&sink->lock);
+        pthread_join(sink->flusher, NULL);
+    }
+
+    log_utils_file_sink_drain(sink, NULL, 0);
+    log_utils_sink_file_destroy(&sink->file);
+    pthread_cond_destroy(&sink->pending);
+    pthread_mutex_destroy(&sink->lock);
+    free(sink->buffer);
+    free(sink);
+}
+
+t_log_utils_sink* log_utils_sink_file_new(const char* path, const t_log_utils_file_sink_options* options)
+{
+    if (!path) return NULL;
+
+    t_log_utils_file_sink* file_sink = calloc(1, sizeof(t_log_utils_file_sink));
+    if (!file_sink) return NULL;
+
+    if (!log_utils_sink_file_init(&file_sink->file, path, options, LOG_UTILS_SINK_FILE_BUFFER_SIZE))
+    {
+        free(file_sink);
+        return NULL;
+    }
+
+    file_sink->buffer = malloc(file_sink->file.options.buffer_size);
+    if (!file_sink->buffer)
+    {
+        log_utils_sink_file_destroy(&file_sink->file);
+        free(file_sink);
+        return NULL;
+    }
+    pthread_mutex_init(&file_sink->lock, NULL);
+    pthread_cond_init(&file_sink->pending, NULL);
+
+    if (file_sink->file.options.flush_interval_ms)
+    {
+        file_sink->has_flusher = pthread_create(&file_sink->flusher, NULL, log_utils_file_sink_flusher, file_sink) == 0;
+        if (!file_sink->has_flusher)
+        {
+            log_utils_file_sink_free(file_sink);
+            return NULL;
+        }
+    }
+
+    t_log_utils_sink* sink = log_utils_sink_new(log_utils_file_sink_write, log_utils_file_sink_flush,
+                                                log_utils_file_sink_free, file_sink);
+    if (!sink) log_utils_file_sink_free(file_sink);
+
+    return sink;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Memory-mapped append sink                                                  */
+/* -------------------------------------------------------------------------- */
+
+typedef struct t_log_utils_mmap_sink
+{
+    pthread_mutex_t       lock;
+    t_log_utils_sink_file file;
+    char*                 map;
+    size_t                map_offset;  // Page-aligned file offset of the mapping
+    size_t                page_size;
+} t_log_utils_mmap_sink;
+
+static void log_utils_mmap_sink_unmap(t_log_utils_mmap_sink* sink)
+{
+    if (sink->map)
+    {
+        munmap(sink->map, sink->file.options.buffer_size);
+        sink->map = NULL;
+    }
+    // Drop the unused tail of the last window
+    if (sink->file.fd >= 0 && ftruncate(sink->file.fd, (off_t)sink->file.size) != 0)
+    {
+        fprintf(stderr, "Failed to trim log file %s: %s\n", sink->file.path, strerror(errno));
+    }
+}
+
+static bool log_utils_mmap_sink_map(t_log_utils_mmap_sink* sink)
+{
+    size_t window = sink->file.options.buffer_size;
+
+    sink->map_offset = sink->file.size / sink->page_size * sink->page_size;
+
+    if (ftruncate(sink->file.fd, (off_t)(sink->map_offset + window)) != 0) return false;
+
+    void* map = mmap(NULL, window, PROT_READ | PROT_WRITE, MAP_SHARED, sink->file.fd, (off_t)sink->map_offset);
+    if (map == MAP_FAILED) return false;
+
+    sink->map = map;
+    return true;
+}
+
+static void log_utils_mmap_sink_write(void* context, const char* line, size_t len)
+{
+    t_log_utils_mmap_sink* sink = context;
+    size_t window = sink->file.options.buffer_size;
+    struct timespec now;
+    clock_gettime(LOG_UTILS_SINK_CLOCK, &now);
+
+    pthread_mutex_lock(&sink->lock);
+
+    if (log_utils_sink_file_should_rotate(&sink->file, len, now.tv_sec))
+    {
+        log_utils_mmap_sink_unmap(sink);
+        log_utils_sink_file_rotate(&sink->file, now.tv_sec);
+    }
+
+    if (sink->map && sink->file.size + len > sink->map_offset + window)
+    {
+        log_utils_mmap_sink_unmap(sink);
+    }
+
+    // Lines larger than half a window bypass the mapping
+    if (len > window / 2)
+    {
+        if (sink->map) log_utils_mmap_sink_unmap(sink);
+
+        struct iovec iov = { (void*)line, len };
+        if (!log_utils_sink_writev_all(sink->file.fd, &iov, 1))
+        {
+            fprintf(stderr, "Failed to write log file %s: %s\n", sink->file.path, strerror(errno));
+        }
+        sink->file.size += len;
+    }
+    else if (sink->map || log_utils_mmap_sink_map(sink))
+    {
+        memcpy(sink->map + (sink->file.size - sink->map_offset), line, len);
+        sink->file.size += len;
+    }
+    else
+    {
+        fprintf(stderr, "Failed to map log file %s: %s\n", sink->file.path, strerror(errno));
+    }
+
+    pthread_mutex_unlock(&sink->lock);
+}
+
+static void log_utils_mmap_sink_flush(void* context)
+{
+    t_log_utils_mmap_sink* sink = context;
+
+    pthread_mutex_lock(&sink->lock);
+    if (sink->map)
+    {
+        msync(sink->map, sink->file.options.buffer_size, MS_ASYNC);
+    }
+    pthread_mutex_unlock(&sink->lock);
+}
+
+static void log_utils_mmap_sink_free(void* context)
+{
+    t_log_utils_mmap_sink* sink = context;
+
+    log_utils_mmap_sink_unmap(sink);
+    log_utils_sink_file_destroy(&sink->file);
+    pthread_mutex_destroy(&sink->lock);
+    free(sink);
+}
+
+t_log_utils_sink* log_utils_sink_mmap_new(const char* path, const t_log_utils_file_sink_options* options)
+{
+    if (!path) return NULL;
+
+    t_log_utils_mmap_sink* mmap_sink = calloc(1, sizeof(t_log_utils_mmap_sink));
+    if (!mmap_sink) return NULL;
+
+    if (!log_utils_sink_file_init(&mmap_sink->file, path, options, LOG_UTILS_SINK_MMAP_WINDOW_SIZE))
+    {
+        free(mmap_sink);
+        return NULL;
+    }
+
+    // The window must be a whole number of pages, and at least two: a new window
+    // starts up to a page before the end of the file and must still fit half a window
+    mmap_sink->page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t window = mmap_sink->file.options.buffer_size;
+    window = (window + mmap_sink->page_size - 1) / mmap_sink->page_size * mmap_sink->page_size;
+    if (window < 2 * mmap_sink->page_size) window = 2 * mmap_sink->page_size;
+    mmap_sink->file.options.buffer_size = window;
+
+    if (!log_utils_mmap_sink_map(mmap_sink))
+    {
+        log_utils_sink_file_destroy(&mmap_sink->file);
+        free(mmap_sink);
+        return NULL;
+    }
+    pthread_mutex_init(&mmap_sink->lock, NULL);
+
+    t_log_utils_sink* sink = log_utils_sink_new(log_utils_mmap_sink_write, log_utils_mmap_sink_flush,
+                                                log_utils_mmap_sink_free, mmap_sink);
+    if (!sink) log_utils_mmap_sink_free(mmap_sink);
+
+    return sink;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Fan-out sink                                                               */
+/* -------------------------------------------------------------------------- */
+
+typedef struct t_log_utils_fanout_sink
+{
+    t_log_utils_sink** sinks;
+    size_t             count;
+} t_log_utils_fanout_sink;
+
+static void log_utils_fanout_sink_write(void* context, const char* line, size_t len)
+{
+    t_log_utils_fanout_sink* fanout = context;
+
+    for (size_t i = 0; i < fanout->count; i++)
+    {
+        log_utils_sink_write(fanout->sinks[i], line, len);
+    }
+}
+
+static void log_utils_fanout_sink_flush(void* context)
+{
+    t_log_utils_fanout_sink* fanout = context;
+
+    for (size_t i = 0; i < fanout->count; i++)
+    {
+        log_utils_sink_flush(fanout->sinks[i]);
+    }
+}
+
+static void log_utils_fanout_sink_free(void* context)
+{
+    t_log_utils_fanout_sink* fanout = context;
+
+    for (size_t i = 0; i < fanout->count; i++)
+    {
+        log_utils_sink_free(fanout->sinks[i]);
+    }
+    free(fanout->sinks);
+    free(fanout);
+}
+
+t_log_utils_sink* log_utils_sink_fanout_new(t_log_utils_sink** sinks, size_t count)
+{
+    if (!sinks && count > 0) return NULL;
+
+    t_log_utils_fanout_sink* fanout = malloc(sizeof(t_log_utils_fanout_sink));
+    if (!fanout) return NULL;
+
+    fanout->sinks = malloc(sizeof(t_log_utils_sink*) * (count ? count : 1));
+    if (!fanout->sinks)
+    {
+        free(fanout);
+        return NULL;
+    }
+    memcpy(fanout->sinks, sinks, sizeof(t_log_utils_sink*) * count);
+    fanout->count = count;
+
+    t_log_utils_sink* sink = log_utils_sink_new(log_utils_fanout_sink_write, log_utils_fanout_sink_flush,
+                                                log_utils_fanout_sink_free, fanout);
+    if (!sink)
+    {
+        free(fanout->sinks);
+        free(fanout);
+    }
+
+    return sink;
+}
@@ -0,0 +1,1174 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "cpu_utils.h"
+#include "math_utils.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define MATH_UTILS_X86 1
+#endif
+
+// Arrays from 4M elements are split across threads, each taking at least 1M
+#define MATH_UTILS_PARALLEL_MIN  ((size_t)1 << 22)
+#define MATH_UTILS_PARALLEL_PART ((size_t)1 << 20)
+#define MATH_UTILS_MAX_THREADS   64
+
+// Thread parts start on a cache line
+#define MATH_UTILS_PART_UNIT 16
+
+// Pairwise summation: leaves of 256 elements summed in 16 interleaved lanes
+#define MATH_UTILS_SUM_BLOCK 256
+#define MATH_UTILS_SUM_LANES 16
+
+// Float prefix sums restart every 64K elements, a piece that stays in L2 between its two passes
+#define MATH_UTILS_PREFIX_CHUNK ((size_t)1 << 16)
+
+/* -------------------------------------------------------------------------- */
+/* Kernels                                                                    */
+/* -------------------------------------------------------------------------- */
+
+/*
+ * Every variant does the same IEEE operations in the same order: sums use
+ * 16 lanes and prefix sums groups of four whatever the register width, so
+ * results do not depend on the instruction set. Min and max kernels return
+ * the identity (+-infinity, INT32_MAX, INT32_MIN) for empty or all-NaN input;
+ * find kernels return count when nothing matches.
+ */
+typedef struct t_math_utils_kernels
+{
+    void    (*clampf)(float* out, const float* values, size_t count, float min, float max);
+    void    (*clamp)(int32_t* out, const int32_t* values, size_t count, int32_t min, int32_t max);
+    float   (*minf)(const float* values, size_t count);
+    float   (*maxf)(const float* values, size_t count);
+    int32_t (*min)(const int32_t* values, size_t count);
+    int32_t (*max)(const int32_t* values, size_t count);
+    size_t  (*findf)(const float* values, size_t count, float value);
+    size_t  (*find)(const int32_t* values, size_t count, int32_t value);
+    float   (*sumf_block)(const float* values, size_t count);
+    int64_t (*sum)(const int32_t* values, size_t count);
+    float   (*prefix_sumf)(float* out, const float* values, size_t count, float total);
+    int32_t (*prefix_sum)(int32_t* out, const int32_t* values, size_t count, int32_t total);
+    void    (*addf)(float* out, size_t count, float value);
+} t_math_utils_kernels;
+
+static t_math_utils_kernels s_kernels;
+static pthread_once_t s_kernels_once = PTHREAD_ONCE_INIT;
+
+static void math_utils_clampf_scalar(float* out, const float* values, size_t count, float min, float max)
+{
+    for (size_t i = 0; i < count; i++) out[i] = math_utils_clampf(values[i], min, max);
+}
+
+static void math_utils_clamp_scalar(int32_t* out, const int32_t* values, size_t count, int32_t min, int32_t max)
+{
+    for (size_t i = 0; i < count; i++) out[i] = values[i] < min ? min : values[i] > max ? max : values[i];
+}
+
+// NaN compares false, so it never replaces the running result
+static float math_utils_minf_scalar(const float* values, size_t count)
+{
+    float result = INFINITY;
+    for (size_t i = 0; i < count; i++) result = values[i] < result ? values[i] : result;
+    return result;
+}
+
+static float math_utils_maxf_scalar(const float* values, size_t count)
+{
+    float result = -INFINITY;
+    for (size_t i = 0; i < count; i++) result = values[i] > result ? values[i] : result;
+    return result;
+}
+
+static int32_t math_utils_min_scalar(const int32_t* values, size_t count)
+{
+    int32_t result = INT32_MAX;
+    for (size_t i = 0; i < count; i++) result = values[i] < result ? values[i] : result;
+    return result;
+}
+
+static int32_t math_utils_max_scalar(const int32_t* values, size_t count)
+{
+    int32_t result = INT32_MIN;
+    for (size_t i = 0; i < count; i++) result = values[i] > result ? values[i] : result;
+    return result;
+}
+
+static size_t math_utils_findf_scalar(const float* values, size_t count, float value)
+{
+    size_t i = 0;
+    while (i < count && values[i] != value) i++;
+    return i;
+}
+
+static size_t math_utils_find_scalar(const int32_t* values, size_t count, int32_t value)
+{
+    size_t i = 0;
+    while (i < count && values[i] != value) i++;
+    return i;
+}
+
+// Folds the lanes in halves: lane j gets lane j + 8, then j + 4, j + 2 and j + 1
+static float math_utils_sum_lanes(float* lanes)
+{
+    for (size_t width = MATH_UTILS_SUM_LANES / 2; width > 0; width /= 2)
+    {
+        for (size_t j = 0; j < width; j++) lanes[j] += lanes[j + width];
+    }
+    return lanes[0];
+}
+
+// Element i goes to lane i % 16, the vector loops included
+static float math_utils_sumf_block_scalar(const float* values, size_t count)
+{
+    float lanes[MATH_UTILS_SUM_LANES] = { 0.0f };
+    for (size_t i = 0; i < count; i++) lanes[i % MATH_UTILS_SUM_LANES] += values[i];
+    return math_utils_sum_lanes(lanes);
+}
+
+static int64_t math_utils_sum_scalar(const int32_t* values, size_t count)
+{
+    int64_t sum = 0;
+    for (size_t i = 0; i < count; i++) sum += values[i];
+    return sum;
+}
+
+/*
+ * Prefix sums by groups of four: x + (x shifted by one), then + (that
+ * shifted by two), then + the running total, the order of the SSE shifts.
+ * Shifted-in lanes are +0, which turns a leading -0 into +0 as the
+ * sequential loop does.
+ */
+static float math_utils_prefix_sumf_scalar(float* out, const float* values, size_t count, float total)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        float x0 = values[i], x1 = values[i + 1], x2 = values[i + 2], x3 = values[i + 3];
+        float s0 = x0 + 0.0f, s1 = x1 + x0, s2 = x2 + x1, s3 = x3 + x2;
+        float t0 = s0 + 0.0f, t1 = s1 + 0.0f, t2 = s2 + s0, t3 = s3 + s1;
+
+        out[i] = t0 + total;
+        out[i + 1] = t1 + total;
+        out[i + 2] = t2 + total;
+        out[i + 3] = total = t3 + total;
+    }
+    for (; i < count; i++) out[i] = total = total + values[i];
+    return total;
+}
+
+// Unsigned arithmetic wraps where signed overflow would be undefined
+static int32_t math_utils_prefix_sum_scalar(int32_t* out, const int32_t* values, size_t count, int32_t total)
+{
+    uint32_t running = (uint32_t)total;
+    for (size_t i = 0; i < count; i++) out[i] = (int32_t)(running += (uint32_t)values[i]);
+    return (int32_t)running;
+}
+
+static void math_utils_addf_scalar(float* out, size_t count, float value)
+{
+    for (size_t i = 0; i < count; i++) out[i] += value;
+}
+
+#ifdef MATH_UTILS_X86
+
+/*
+ * Float min and max take the new vector first: the SSE min and max return
+ * their second operand when either is NaN, so NaN elements leave the
+ * running result alone. clampf is max(min, v) then min(max, v), which lets
+ * NaN through like math_utils_clampf().
+ */
+
+__attribute__((target("sse2")))
+static void math_utils_clampf_sse2(float* out, const float* values, size_t count, float min, float max)
+{
+    __m128 low = _mm_set1_ps(min);
+    __m128 high = _mm_set1_ps(max);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) _mm_storeu_ps(out + i, _mm_min_ps(high, _mm_max_ps(low, _mm_loadu_ps(values + i))));
+    math_utils_clampf_scalar(out + i, values + i, count - i, min, max);
+}
+
+// SSE2 has no 32-bit integer min and max: select with a comparison mask
+__attribute__((target("sse2")))
+static inline __m128i math_utils_select_sse2(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+__attribute__((target("sse2")))
+static void math_utils_clamp_sse2(int32_t* out, const int32_t* values, size_t count, int32_t min, int32_t max)
+{
+    __m128i low = _mm_set1_epi32(min);
+    __m128i high = _mm_set1_epi32(max);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(values + i));
+        v = math_utils_select_sse2(_mm_cmplt_epi32(v, low), low, v);
+        v = math_utils_select_sse2(_mm_cmpgt_epi32(v, high), high, v);
+        _mm_storeu_si128((__m128i*)(out + i), v);
+    }
+    math_utils_clamp_scalar(out + i, values + i, count - i, min, max);
+}
+
+__attribute__((target("sse2")))
+static float math_utils_minf_sse2(const float* values, size_t count)
+{
+    __m128 a = _mm_set1_ps(INFINITY), b = a;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        a = _mm_min_ps(_mm_loadu_ps(values + i), a);
+        b = _mm_min_ps(_mm_loadu_ps(values + i + 4), b);
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_min_ps(a, b));
+    float rest = math_utils_minf_scalar(values + i, count - i);
+    return math_utils_minf_scalar(lanes, 4) < rest ? math_utils_minf_scalar(lanes, 4) : rest;
+}
+
+__attribute__((target("sse2")))
+static float math_utils_maxf_sse2(const float* values, size_t count)
+{
+    __m128 a = _mm_set1_ps(-INFINITY), b = a;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        a = _mm_max_ps(_mm_loadu_ps(values + i), a);
+        b = _mm_max_ps(_mm_loadu_ps(values + i + 4), b);
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_max_ps(a, b));
+    float rest = math_utils_maxf_scalar(values + i, count - i);
+    return math_utils_maxf_scalar(lanes, 4) > rest ? math_utils_maxf_scalar(lanes, 4) : rest;
+}
+
+__attribute__((target("sse2")))
+static int32_t math_utils_min_sse2(const int32_t* values, size_t count)
+{
+    __m128i result = _mm_set1_epi32(INT32_MAX);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(values + i));
+        result = math_utils_select_sse2(_mm_cmplt_epi32(v, result), v, result);
+    }
+
+    int32_t lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, result);
+    int32_t best = math_utils_min_scalar(lanes, 4);
+    int32_t rest = math_utils_min_scalar(values + i, count - i);
+    return rest < best ? rest : best;
+}
+
+__attribute__((target("sse2")))
+static int32_t math_utils_max_sse2(const int32_t* values, size_t count)
+{
+    __m128i result = _mm_set1_epi32(INT32_MIN);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(values + i));
+        result = math_utils_select_sse2(_mm_cmpgt_epi32(v, result), v, result);
+    }
+
+    int32_t lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, result);
+    int32_t best = math_utils_max_scalar(lanes, 4);
+    int32_t rest = math_utils_max_scalar(values + i, count - i);
+    return rest > best ? rest : best;
+}
+
+__attribute__((target("sse2")))
+static size_t math_utils_findf_sse2(const float* values, size_t count, float value)
+{
+    __m128 target = _mm_set1_ps(value);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        int mask = _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(values + i), target));
+        if (mask) return i + (size_t)__builtin_ctz((unsigned)mask);
+    }
+    return i + math_utils_findf_scalar(values + i, count - i, value);
+}
+
+__attribute__((target("sse2")))
+static size_t math_utils_find_sse2(const int32_t* values, size_t count, int32_t value)
+{
+    __m128i target = _mm_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(values + i)), target);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(equal));
+        if (mask) return i + (size_t)__builtin_ctz((unsigned)mask);
+    }
+    return i + math_utils_find_scalar(values + i, count - i, value);
+}
+
+__attribute__((target("sse2")))
+static float math_utils_sumf_block_sse2(const float* values, size_t count)
+{
+    __m128 a = _mm_setzero_ps(), b = a, c = a, d = a;
+    size_t i = 0;
+    for (; i + MATH_UTILS_SUM_LANES <= count; i += MATH_UTILS_SUM_LANES)
+    {
+        a = _mm_add_ps(a, _mm_loadu_ps(values + i));
+        b = _mm_add_ps(b, _mm_loadu_ps(values + i + 4));
+        c = _mm_add_ps(c, _mm_loadu_ps(values + i + 8));
+        d = _mm_add_ps(d, _mm_loadu_ps(values + i + 12));
+    }
+
+    float lanes[MATH_UTILS_SUM_LANES];
+    _mm_storeu_ps(lanes, a);
+    _mm_storeu_ps(lanes + 4, b);
+    _mm_storeu_ps(lanes + 8, c);
+    _mm_storeu_ps(lanes + 12, d);
+    for (size_t j = 0; i + j < count; j++) lanes[j] += values[i + j];
+    return math_utils_sum_lanes(lanes);
+}
+
+// Sign extension by hand: SSE2 has no pmovsxdq
+__attribute__((target("sse2")))
+static int64_t math_utils_sum_sse2(const int32_t* values, size_t count)
+{
+    __m128i sum = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(values + i));
+        __m128i sign = _mm_srai_epi32(v, 31);
+        sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(v, sign));
+        sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(v, sign));
+    }
+
+    int64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, sum);
+    return lanes[0] + lanes[1] + math_utils_sum_scalar(values + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static float math_utils_prefix_sumf_sse2(float* out, const float* values, size_t count, float total)
+{
+    __m128 running = _mm_set1_ps(total);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 v = _mm_loadu_ps(values + i);
+        v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+        v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 8)));
+        v = _mm_add_ps(v, running);
+        _mm_storeu_ps(out + i, v);
+        running = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    return math_utils_prefix_sumf_scalar(out + i, values + i, count - i, _mm_cvtss_f32(running));
+}
+
+__attribute__((target("sse2")))
+static int32_t math_utils_prefix_sum_sse2(int32_t* out, const int32_t* values, size_t count, int32_t total)
+{
+    __m128i running = _mm_set1_epi32(total);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(values + i));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi32(v, running);
+        _mm_storeu_si128((__m128i*)(out + i), v);
+        running = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    return math_utils_prefix_sum_scalar(out + i, values + i, count - i, _mm_cvtsi128_si32(running));
+}
+
+__attribute__((target("sse2")))
+static void math_utils_addf_sse2(float* out, size_t count, float value)
+{
+    __m128 offset = _mm_set1_ps(value);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), offset));
+    math_utils_addf_scalar(out + i, count - i, value);
+}
+
+__attribute__((target("avx2")))
+static void math_utils_clampf_avx2(float* out, const float* values, size_t count, float min, float max)
+{
+    __m256 low = _mm256_set1_ps(min);
+    __m256 high = _mm256_set1_ps(max);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_ps(out + i, _mm256_min_ps(high, _mm256_max_ps(low, _mm256_loadu_ps(values + i))));
+    }
+    math_utils_clampf_scalar(out + i, values + i, count - i, min, max);
+}
+
+__attribute__((target("avx2")))
+static void math_utils_clamp_avx2(int32_t* out, const int32_t* values, size_t count, int32_t min, int32_t max)
+{
+    __m256i low = _mm256_set1_epi32(min);
+    __m256i high = _mm256_set1_epi32(max);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(values + i));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_min_epi32(high, _mm256_max_epi32(low, v)));
+    }
+    math_utils_clamp_scalar(out + i, values + i, count - i, min, max);
+}
+
+// Four accumulators: min and max have a latency of four cycles
+__attribute__((target("avx2")))
+static float math_utils_minf_avx2(const float* values, size_t count)
+{
+    __m256 a = _mm256_set1_ps(INFINITY), b = a, c = a, d = a;
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        a = _mm256_min_ps(_mm256_loadu_ps(values + i), a);
+        b = _mm256_min_ps(_mm256_loadu_ps(values + i + 8), b);
+        c = _mm256_min_ps(_mm256_loadu_ps(values + i + 16), c);
+        d = _mm256_min_ps(_mm256_loadu_ps(values + i + 24), d);
+    }
+
+    float lanes[8];
+    _mm256_storeu_ps(lanes, _mm256_min_ps(_mm256_min_ps(a, b), _mm256_min_ps(c, d)));
+    float best = math_utils_minf_scalar(lanes, 8);
+    float rest = math_utils_minf_sse2(values + i, count - i);
+    return rest < best ? rest : best;
+}
+
+__attribute__((target("avx2")))
+static float math_utils_maxf_avx2(const float* values, size_t count)
+{
+    __m256 a = _mm256_set1_ps(-INFINITY), b = a, c = a, d = a;
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        a = _mm256_max_ps(_mm256_loadu_ps(values + i), a);
+        b = _mm256_max_ps(_mm256_loadu_ps(values + i + 8), b);
+        c = _mm256_max_ps(_mm256_loadu_ps(values + i + 16), c);
+        d = _mm256_max_ps(_mm256_loadu_ps(values + i + 24), d);
+    }
+
+    float lanes[8];
+    _mm256_storeu_ps(lanes, _mm256_max_ps(_mm256_max_ps(a, b), _mm256_max_ps(c, d)));
+    float best = math_utils_maxf_scalar(lanes, 8);
+    float rest = math_utils_maxf_sse2(values + i, count - i);
+    return rest > best ? rest : best;
+}
+
+__attribute__((target("avx2")))
+static int32_t math_utils_min_avx2(const int32_t* values, size_t count)
+{
+    __m256i a = _mm256_set1_epi32(INT32_MAX), b = a;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        a = _mm256_min_epi32(a, _mm256_loadu_si256((const __m256i*)(values + i)));
+        b = _mm256_min_epi32(b, _mm256_loadu_si256((const __m256i*)(values + i + 8)));
+    }
+
+    int32_t lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, _mm256_min_epi32(a, b));
+    int32_t best = math_utils_min_scalar(lanes, 8);
+    int32_t rest = math_utils_min_scalar(values + i, count - i);
+    return rest < best ? rest : best;
+}
+
+__attribute__((target("avx2")))
+static int32_t math_utils_max_avx2(const int32_t* values, size_t count)
+{
+    __m256i a = _mm256_set1_epi32(INT32_MIN), b = a;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        a = _mm256_max_epi32(a, _mm256_loadu_si256((const __m256i*)(values + i)));
+        b = _mm256_max_epi32(b, _mm256_loadu_si256((const __m256i*)(values + i + 8)));
+    }
+
+    int32_t lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, _mm256_max_epi32(a, b));
+    int32_t best = math_utils_max_scalar(lanes, 8);
+    int32_t rest = math_utils_max_scalar(values + i, count - i);
+    return rest > best ? rest : best;
+}
+
+__attribute__((target("avx2")))
+static size_t math_utils_findf_avx2(const float* values, size_t count, float value)
+{
+    __m256 target = _mm256_set1_ps(value);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values + i), target, _CMP_EQ_OQ));
+        if (mask) return i + (size_t)__builtin_ctz((unsigned)mask);
+    }
+    return i + math_utils_findf_scalar(values + i, count - i, value);
+}
+
+__attribute__((target("avx2")))
+static size_t math_utils_find_avx2(const int32_t* values, size_t count, int32_t value)
+{
+    __m256i target = _mm256_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i equal = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(values + i)), target);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+        if (mask) return i + (size_t)__builtin_ctz((unsigned)mask);
+    }
+    return i + math_utils_find_scalar(values + i, count - i, value);
+}
+
+__attribute__((target("avx2")))
+static float math_utils_sumf_block_avx2(const float* values, size_t count)
+{
+    __m256 a = _mm256_setzero_ps(), b = a;
+    size_t i = 0;
+    for (; i + MATH_UTILS_SUM_LANES <= count; i += MATH_UTILS_SUM_LANES)
+    {
+        a = _mm256_add_ps(a, _mm256_loadu_ps(values + i));
+        b = _mm256_add_ps(b, _mm256_loadu_ps(values + i + 8));
+    }
+
+    float lanes[MATH_UTILS_SUM_LANES];
+    _mm256_storeu_ps(lanes, a);
+    _mm256_storeu_ps(lanes + 8, b);
+    for (size_t j = 0; i + j < count; j++) lanes[j] += values[i + j];
+    return math_utils_sum_lanes(lanes);
+}
+
+__attribute__((target("avx2")))
+static int64_t math_utils_sum_avx2(const int32_t* values, size_t count)
+{
+    __m256i a = _mm256_setzero_si256(), b = a;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        a = _mm256_add_epi64(a, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(values + i))));
+        b = _mm256_add_epi64(b, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(values + i + 4))));
+    }
+
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi64(a, b));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + math_utils_sum_scalar(values + i, count - i);
+}
+
+/*
+ * Two groups of four per register: the shifts stay within 128-bit lanes,
+ * then the low group gets the running total and the high group the last
+ * element of the low group, as two SSE iterations would.
+ */
+__attribute__((target("avx2")))
+static float math_utils_prefix_sumf_avx2(float* out, const float* values, size_t count, float total)
+{
+    __m256 running = _mm256_set1_ps(total);
+    __m256i third = _mm256_set1_epi32(3);
+    __m256i seventh = _mm256_set1_epi32(7);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 v = _mm256_loadu_ps(values + i);
+        v = _mm256_add_ps(v, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(v), 4)));
+        v = _mm256_add_ps(v, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(v), 8)));
+
+        __m256 low = _mm256_add_ps(v, running);
+        __m256 high = _mm256_add_ps(v, _mm256_permutevar8x32_ps(low, third));
+        __m256 result = _mm256_blend_ps(low, high, 0xf0);
+
+        _mm256_storeu_ps(out + i, result);
+        running = _mm256_permutevar8x32_ps(result, seventh);
+    }
+    return math_utils_prefix_sumf_sse2(out + i, values + i, count - i, _mm256_cvtss_f32(running));
+}
+
+__attribute__((target("avx2")))
+static int32_t math_utils_prefix_sum_avx2(int32_t* out, const int32_t* values, size_t count, int32_t total)
+{
+    __m256i running = _mm256_set1_epi32(total);
+    __m256i third = _mm256_set1_epi32(3);
+    __m256i seventh = _mm256_set1_epi32(7);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(values + i));
+        v = _mm256_add_epi32(v, _mm256_slli_si256(v, 4));
+        v = _mm256_add_epi32(v, _mm256_slli_si256(v, 8));
+
+        // The low group's total carries into the high group
+        v = _mm256_add_epi32(v, _mm256_blend_epi32(_mm256_setzero_si256(), _mm256_permutevar8x32_epi32(v, third), 0xf0));
+        v = _mm256_add_epi32(v, running);
+
+        _mm256_storeu_si256((__m256i*)(out + i), v);
+        running = _mm256_permutevar8x32_epi32(v, seventh);
+    }
+    return math_utils_prefix_sum_sse2(out + i, values + i, count - i, _mm256_cvtsi256_si32(running));
+}
+
+__attribute__((target("avx2")))
+static void math_utils_addf_avx2(float* out, size_t count, float value)
+{
+    __m256 offset = _mm256_set1_ps(value);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), offset));
+    math_utils_addf_scalar(out + i, count - i, value);
+}
+
+#endif /* MATH_UTILS_X86 */
+
+static void math_utils_kernels_init(void)
+{
+    s_kernels = (t_math_utils_kernels) {
+        math_utils_clampf_scalar,
+        math_utils_clamp_scalar,
+        math_utils_minf_scalar,
+        math_utils_maxf_scalar,
+        math_utils_min_scalar,
+        math_utils_max_scalar,
+        math_utils_findf_scalar,
+        math_utils_find_scalar,
+        math_utils_sumf_block_scalar,
+        math_utils_sum_scalar,
+        math_utils_prefix_sumf_scalar,
+        math_utils_prefix_sum_scalar,
+        math_utils_addf_scalar
+    };
+
+#ifdef MATH_UTILS_X86
+    // Bandwidth-bound kernels: AVX-512 would gain little over AVX2
+    e_cpu_utils_level level = cpu_utils_level();
+
+    if (level >= CPU_UTILS_AVX2)
+    {
+        s_kernels = (t_math_utils_kernels) {
+            math_utils_clampf_avx2,
+            math_utils_clamp_avx2,
+            math_utils_minf_avx2,
+            math_utils_maxf_avx2,
+            math_utils_min_avx2,
+            math_utils_max_avx2,
+            math_utils_findf_avx2,
+            math_utils_find_avx2,
+            math_utils_sumf_block_avx2,
+            math_utils_sum_avx2,
+            math_utils_prefix_sumf_avx2,
+            math_utils_prefix_sum_avx2,
+            math_utils_addf_avx2
+        };
+    }
+    else if (level >= CPU_UTILS_SSE2)
+    {
+        s_kernels = (t_math_utils_kernels) {
+            math_utils_clampf_sse2,
+            math_utils_clamp_sse2,
+            math_utils_minf_sse2,
+            math_utils_maxf_sse2,
+            math_utils_min_sse2,
+            math_utils_max_sse2,
+            math_utils_findf_sse2,
+            math_utils_find_sse2,
+            math_utils_sumf_block_sse2,
+            math_utils_sum_sse2,
+            math_utils_prefix_sumf_sse2,
+            math_utils_prefix_sum_sse2,
+            math_utils_addf_sse2
+        };
+    }
+#endif
+}
+
+static const t_math_utils_kernels* math_utils_kernels(void)
+{
+    pthread_once(&s_kernels_once, math_utils_kernels_init);
+    return &s_kernels;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Threads                                                                    */
+/* -------------------------------------------------------------------------- */
+
+// One part of an array operation: inputs, then what the part yields
+typedef struct t_math_utils_task
+{
+    const t_math_utils_kernels* kernels;
+    const void*                 values;
+    void*                       out;
+    size_t                      begin;
+    size_t                      end;
+    float                       low_f;   // clampf bounds; prefix_sumf: running total at begin
+    float                       high_f;
+    int32_t                     low;     // clamp bounds; prefix_sum: running total at begin
+    int32_t                     high;
+    float                       result_f;
+    int64_t                     result;
+} t_math_utils_task;
+
+// Threads for an array of count elements: 1 below MATH_UTILS_PARALLEL_MIN, then up to one per online CPU
+static unsigned math_utils_threads(size_t count)
+{
+    if (count < MATH_UTILS_PARALLEL_MIN) return 1;
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t threads = online > 1 ? (size_t)online : 1;
+    if (threads > count / MATH_UTILS_PARALLEL_PART) threads = count / MATH_UTILS_PARALLEL_PART;
+    if (threads > MATH_UTILS_MAX_THREADS) threads = MATH_UTILS_MAX_THREADS;
+    return (unsigned)threads;
+}
+
+// Splits [0, count) into at most threads parts, starting on multiples of unit
+static unsigned math_utils_split(t_math_utils_task* tasks, const t_math_utils_task* model, size_t count, unsigned threads,
+                                 size_t unit)
+{
+    size_t part = ((count + threads - 1) / threads + unit - 1) / unit * unit;
+    unsigned parts = 0;
+
+    for (size_t begin = 0; begin < count; begin += part)
+    {
+        tasks[parts] = *model;
+        tasks[parts].begin = begin;
+        tasks[parts].end = count - begin > part ? begin + part : count;
+        parts++;
+    }
+
+    return parts;
+}
+
+// Runs every task, one thread each; the calling thread runs the first, and those whose thread failed to start
+static void math_utils_run(void* (*worker)(void*), t_math_utils_task* tasks, unsigned count)
+{
+    pthread_t threads[MATH_UTILS_MAX_THREADS];
+    bool started[MATH_UTILS_MAX_THREADS] = { false };
+
+    for (unsigned i = 1; i < count; i++) started[i] = pthread_create(&threads[i], NULL, worker, &tasks[i]) == 0;
+
+    worker(&tasks[0]);
+
+    for (unsigned i = 1; i < count; i++)
+    {
+        if (started[i]) pthread_join(threads[i], NULL);
+        else worker(&tasks[i]);
+    }
+}
+
+// Splits a large array across threads and runs worker on the parts; false when the array is too small to split
+static bool math_utils_parallel(void* (*worker)(void*), t_math_utils_task* tasks, unsigned* parts,
+                                const t_math_utils_task* model, size_t count)
+{
+    unsigned threads = math_utils_threads(count);
+    if (threads < 2) return false;
+
+    *parts = math_utils_split(tasks, model, count, threads, MATH_UTILS_PART_UNIT);
+    math_utils_run(worker, tasks, *parts);
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Clamps                                                                     */
+/* -------------------------------------------------------------------------- */
+
+static void* math_utils_clampf_task(void* argument)
+{
+    t_math_utils_task* task = argument;
+    task->kernels->clampf((float*)task->out + task->begin, (const float*)task->values + task->begin,
+                          task->end - task->begin, task->low_f, task->high_f);
+    return NULL;
+}
+
+static void* math_utils_clamp_task(void* argument)
+{
+    t_math_utils_task* task = argument;
+    task->kernels->clamp((int32_t*)task->out + task->begin, (const int32_t*)task->values + task->begin,
+                         task->end - task->begin, task->low, task->high);
+    return NULL;
+}
+
+void math_utils_array_clampf(float* out, const float* values, size_t count, float min_value, float max_value)
+{
+    t_math_utils_task tasks[MATH_UTILS_MAX_THREADS];
+    t_math_utils_task model = { .kernels = math_utils_kernels(), .values = values, .out = out,
+                                .low_f = min_value, .high_f = max_value };
+    unsigned parts;
+
+    if (!math_utils_parallel(math_utils_clampf_task, tasks, &parts, &model, count))
+    {
+        model.kernels->clampf(out, values, count, min_value, max_value);
+    }
+}
+
+void math_utils_array_clamp(int32_t* out, const int32_t* values, size_t count, int32_t min_value, int32_t max_value)
+{
+    t_math_utils_task tasks[MATH_UTILS_MAX_THREADS];
+    t_math_utils_task model = { .kernels = math_utils_kernels(), .values = values, .out = out,
+                                .low = min_value, .high = max_value };
+    unsigned parts;
+
+    if (!math_utils_parallel(math_utils_clamp_task, tasks, &parts, &model, count))
+    {
+        model.kernels->clamp(out, values, count, min_value, max_value);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* Min, max and their indices                                                 */
+/* -------------------------------------------------------------------------- */
+
+static void* math_utils_minf_task(void* argument)
+{
+    t_math_utils_task* task = argument;
+    task->result_f = task->kernels->minf((const float*)task->values + task->begin, task->end - task->begin);
+    return NULL;
+}
+
+static void* math_utils_maxf_task(void* argument)
+{
+    t_math_utils_task* task = argument;
+    task->result_f = task->kernels->maxf((const float*)task->values + task->begin, task->end - task->begin);
+    return NULL;
+}
+
+static void* math_utils_min_task(void* argument)
+{
+    t_math_utils_task* task = argument;
+    task->result = task->kernels->min((const int32_t*)task->values + task->begin, task->end - task->begin);
+    return NULL;
+}
+
+static void* math_utils_max_task(void* argument)
+{
+    t_math_utils_task* task = argument;
+    task->result = task->kernels->max((const int32_t*)task->values + task->begin, task->end - task->begin);
+    return NULL;
+}
+
+// The kernels' identity for "no number at all" is also a number the array may hold: tell them apart
+static float math_utils_extremum_or_nan(const t_math_utils_kernels* kernels, const float* values, size_t count,
+                                        float result, float identity)
+{
+    return result == identity && kernels->findf(values, count, identity) == count ? NAN : result;
+}
+
+float math_utils_array_minf(const float* values, size_t count)
+{
+    t_math_utils_task tasks[MATH_UTILS_MAX_THREADS];
+    t_math_utils_task model = { .kernels = math_utils_kernels(), .values = values };
+    unsigned parts;
+    float result;
+
+    if (math_utils_parallel(math_utils_minf_task, tasks, &parts, &model, count))
+    {
+        result = INFINITY;
+        for (unsigned i = 0; i < parts; i++) result = tasks[i].result_f < result ? tasks[i].result_f : result;
+    }
+    else
+    {
+        result = model.kernels->minf(values, count);
+    }
+
+    return math_utils_extremum_or_nan(model.kernels, values, count, result, INFINITY);
+}
+
+float math_utils_array_maxf(const float* values, size_t count)
+{
+    t_math_utils_task tasks[MATH_UTILS_MAX_THREADS];
+    t_math_utils_task model = { .kernels = math_utils_kernels(), .values = values };
+    unsigned parts;
+    float result;
+
+    if (math_utils_parallel(math_utils_maxf_task, tasks, &parts, &model, count))
+    {
+        result = -INFINITY;
+        for (unsigned i = 0; i < parts; i++) result = tasks[i].result_f > result ? tasks[i].result_f : result;
+    }
+    else
+    {
+        result = model.kernels->maxf(values, count);
+    }
+
+    return math_utils_extremum_or_nan(model.kernels, values, count, result, -INFINITY);
+}
+
+int32_t math_utils_array_min(const int32_t* values, size_t count)
+{
+    t_math_utils_task tasks[MATH_UTILS_MAX_THREADS];
+    t_math_utils_task model = { .kernels = math_utils_kernels(), .values = values };
+    unsigned parts;
+
+    if (!math_utils_parallel(math_utils_min_task, tasks, &parts, &model, count)) return model.kernels->min(values, count);
+
+    int64_t result = INT32_MAX;
+    for (unsigned i = 0; i < parts; i++) result = tasks[i].result < result ? tasks[i].result : result;
+    return (int32_t)result;
+}
+
+int32_t math_utils_array_max(const int32_t* values, size_t count)
+{
+    t_math_utils_task tasks[MATH_UTILS_MAX_THREADS];
+    t_math_utils_task model = { .kernels = math_utils_kernels(), .values = values };
+    unsigned parts;
+
+    if (!math_utils_parallel(math_utils_max_task, tasks, &parts, &model, count)) return model.kernels->max(values, count);
+
+    int64_t result = INT32_MIN;
+    for (unsigned i = 0; i < parts; i++) result = tasks[i].result > result ? tasks[i].result : result;
+    return (int32_t)result;
+}
+
+// The index is found by a second pass, which stops at the first match
+size_t math_utils_array_argminf(const float* values, size_t count)
+{
+    float result = math_utils_array_minf(values, count);
+    return isnan(result) ? SIZE_MAX : math_utils_kernels()->findf(values, count, result);
+}
+
+size_t math_utils_array_argmaxf(const float* values, size_t count)
+{
+    float result = math_utils_array_maxf(values, count);
+    return isnan(result) ? SIZE_MAX : math_utils_kernels()->findf(values, count, result);
+}
+
+size_t math_utils_array_argmin(const int32_t* values, size_t count)
+{
+    return count == 0 ? SIZE_MAX : math_utils_kernels()->find(values, count, math_utils_array_min(values, count));
+}
+
+size_t math_utils_array_argmax(const int32_t* values, size_t count)
+{
+    return count == 0 ? SIZE_MAX : math_utils_kernels()->find(values, count, math_utils_array_max(values, count));
+}
+
+/* -------------------------------------------------------------------------- */
+/* Sums                                                                       */
+/* -------------------------------------------------------------------------- */
+
+/*
+ * Pairwise summation over blocks, as a binary counter: a sum of 2^level
+ * blocks is pushed, and merged with the sum on top while that covers as
+ * many blocks. The merge tree only depends on the number of blocks, so a
+ * thread that sums an aligned run of 2^level blocks yields exactly the
+ * value the serial loop reaches for that run.
+ */
+typedef struct t_math_utils_pairwise
+{
+    float    sums[64];
+    unsigned levels[64];
+    unsigned depth;
+} t_math_utils_pairwise;
+
+static void math_utils_pairwise_push(t_math_utils_pairwise* pairwise, float sum, unsigned level)
+{
+    while (pairwise->depth > 0 && pairwise->levels[pairwise->depth - 1] == level)
+    {
+        sum = pairwise->sums[--pairwise->depth] + sum;
+        level++;
+    }
+
+    pairwise->sums[pairwise->depth] = sum;
+    pairwise->levels[pairwise->depth] = level;
+    pairwise->depth++;
+}
+
+// Adds up what is left, the most recent first
+static float math_utils_pairwise_total(const t_math_utils_pairwise* pairwise)
+{
+    if (pairwise->depth == 0) return 0.0f;
+
+    float total = pairwise->sums[pairwise->depth - 1];
+    for (unsigned i = pairwise->depth - 1; i-- > 0;) total = pairwise->sums[i] + total;
+    return total;
+}
+
+static void math_utils_pairwise_blocks(t_math_utils_pairwise* pairwise, const t_math_utils_kernels* kernels,
+                                       const float* values, size_t count)
+{
+    for (size_t i = 0; i < count; i += MATH_UTILS_SUM_BLOCK)
+    {
+        size_t block = count - i < MATH_UTILS_SUM_BLOCK ? count - i : MATH_UTILS_SUM_BLOCK;
+        math_utils_pairwise_push(pairwise, kernels->sumf_block(values + i, block), 0);
+    }
+}
+
+static void* math_utils_sumf_task(void* argument)
+{
+    t_math_utils_task* task = argument;
+    t_math_utils_pairwise pairwise = { .depth = 0 };
+
+    math_utils_pairwise_blocks(&pairwise, task->kernels, (const float*)task->values + task->begin, task->end - task->begin);
+    task->result_f = math_utils_pairwise_total(&pairwise);
+    return NULL;
+}
+
+static void* math_utils_sum_task(void* argument)
+{
+    t_math_utils_task* task = argument;
+    task->result = task->kernels->sum((const int32_t*)task->values + task->begin, task->end - task->begin);
+    return NULL;
+}
+
+float math_utils_array_sumf(const float* values, size_t count)
+{
+    const t_math_utils_kernels* kernels = math_utils_kernels();
+    t_math_utils_pairwise pairwise = { .depth = 0 };
+    size_t done = 0;
+    unsigned threads = math_utils_threads(count);
+
+    if (threads > 1)
+    {
+        // Runs of 2^level blocks, the smallest that needs no more runs than threads
+        size_t blocks = count / MATH_UTILS_SUM_BLOCK;
+        unsigned level = 0;
+        while (((size_t)threads << level) < blocks) level++;
+
+        size_t run = (size_t)MATH_UTILS_SUM_BLOCK << level;
+        unsigned parts = (unsigned)(count / run);
+        t_math_utils_task tasks[MATH_UTILS_MAX_THREADS];
+
+        for (unsigned i = 0; i < parts; i++)
+        {
+            tasks[i] = (t_math_utils_task) { .kernels = kernels, .values = values, .begin = i * run, .end = (i + 1) * run };
+        }
+        math_utils_run(math_utils_sumf_task, tasks, parts);
+
+        for (unsigned i = 0; i < parts; i++) math_utils_pairwise_push(&pairwise, tasks[i].result_f, level);
+        done = parts * run;
+    }
+
+    math_utils_pairwise_blocks(&pairwise, kernels, values + done, count - done);
+    return math_utils_pairwise_total(&pairwise);
+}
+
+int64_t math_utils_array_sum(const int32_t* values, size_t count)
+{
+    t_math_utils_task tasks[MATH_UTILS_MAX_THREADS];
+    t_math_utils_task model = { .kernels = math_utils_kernels(), .values = values };
+    unsigned parts;
+
+    if (!math_utils_parallel(math_utils_sum_task, tasks, &parts, &model, count)) return model.kernels->sum(values, count);
+
+    int64_t sum = 0;
+    for (unsigned i = 0; i < parts; i++) sum += tasks[i].result;
+    return sum;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Prefix sums                                                                */
+/* -------------------------------------------------------------------------- */
+
+/*
+ * Float prefix sums go chunk by chunk: each chunk is scanned from zero, then
+ * gets the total of the chunks before it added. Serially both steps run on
+ * one chunk while it is in cache; threads scan their chunks in a first pass
+ * and add the totals in a second. The additions are the same either way.
+ */
+static void* math_utils_prefix_sumf_scan_task(void* argument)
+{
+    t_math_utils_task* task = argument;
+
+    for (size_t begin = task->begin; begin < task->end; begin += MATH_UTILS_PREFIX_CHUNK)
+    {
+        size_t chunk = task->end - begin < MATH_UTILS_PREFIX_CHUNK ? task->end - begin : MATH_UTILS_PREFIX_CHUNK;
+        task->kernels->prefix_sumf((float*)task->out + begin, (const float*)task->values + begin, chunk, 0.0f);
+    }
+    return NULL;
+}
+
+static void* math_utils_prefix_sumf_offset_task(void* argument)
+{
+    t_math_utils_task* task = argument;
+    float* out = task->out;
+    float total = task->low_f;
+
+    for (size_t begin = task->begin; begin < task->end; begin += MATH_UTILS_PREFIX_CHUNK)
+    {
+        size_t chunk = task->end - begin < MATH_UTILS_PREFIX_CHUNK ? task->end - begin : MATH_UTILS_PREFIX_CHUNK;
+        float last = out[begin + chunk - 1];
+
+        if (begin > 0) task->kernels->addf(out + begin, chunk, total);
+        total = total + last;
+    }
+    return NULL;
+}
+
+static void* math_utils_prefix_sum_task(void* argument)
+{
+    t_math_utils_task* task = argument;
+    task->kernels->prefix_sum((int32_t*)task->out + task->begin, (const int32_t*)task->values + task->begin,
+                              task->end - task->begin, task->low);
+    return NULL;
+}
+
+void math_utils_array_prefix_sumf(float* out, const float* values, size_t count)
+{
+    const t_math_utils_kernels* kernels = math_utils_kernels();
+    unsigned threads = math_utils_threads(count);
+
+    if (count <= MATH_UTILS_PREFIX_CHUNK)
+    {
+        kernels->prefix_sumf(out, values, count, 0.0f);
+    }
+    else if (threads < 2)
+    {
+        float total = 0.0f;
+        for (size_t begin = 0; begin < count; begin += MATH_UTILS_PREFIX_CHUNK)
+        {
+            size_t chunk = count - begin < MATH_UTILS_PREFIX_CHUNK ? count - begin : MATH_UTILS_PREFIX_CHUNK;
+            float last = kernels->prefix_sumf(out + begin, values + begin, chunk, 0.0f);
+
+            if (begin > 0) kernels->addf(out + begin, chunk, total);
+            total = total + last;
+        }
+    }
+    else
+    {
+        t_math_utils_task tasks[MATH_UTILS_MAX_THREADS];
+        t_math_utils_task model = { .kernels = kernels, .values = values, .out = out };
+        unsigned parts = math_utils_split(tasks, &model, count, threads, MATH_UTILS_PREFIX_CHUNK);
+
+        math_utils_run(math_utils_prefix_sumf_scan_task, tasks, parts);
+
+        // Running total at the start of each part, chunk by chunk as the serial loop does
+        float total = 0.0f;
+        for (unsigned i = 0; i < parts; i++)
+        {
+            tasks[i].low_f = total;
+            for (size_t begin = tasks[i].begin; begin < tasks[i].end; begin += MATH_UTILS_PREFIX_CHUNK)
+            {
+                size_t chunk = tasks[i].end - begin < MATH_UTILS_PREFIX_CHUNK ? tasks[i].end - begin : MATH_UTILS_PREFIX_CHUNK;
+                total = total + out[begin + chunk - 1];
+            }
+        }
+
+        math_utils_run(math_utils_prefix_sumf_offset_task, tasks, parts);
+    }
+}
+
+// Integer sums are exact: threads add up their parts, then scan them from the total before
+void math_utils_array_prefix_sum(int32_t* out, const int32_t* values, size_t count)
+{
+    t_math_utils_task tasks[MATH_UTILS_MAX_THREADS];
+    t_math_utils_task model = { .kernels = math_utils_kernels(), .values = values, .out = out };
+    unsigned parts;
+
+    if (!math_utils_parallel(math_utils_sum_task, tasks, &parts, &model, count))
+    {
+        model.kernels->prefix_sum(out, values, count, 0);
+        return;
+    }
+
+    uint32_t total = 0;
+    for (unsigned i = 0; i < parts; i++)
+    {
+        tasks[i].low = (int32_t)total;
+        total += (uint32_t)tasks[i].result;
+    }
+
+    math_utils_run(math_utils_prefix_sum_task, tasks, parts);
+}
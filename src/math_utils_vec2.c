@@ -0,0 +1,699 @@
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include "cpu_utils.h"
+#include "math_utils_vec2.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define MATH_UTILS_VEC2_X86 1
+#endif
+
+// Alignment of the component arrays, and the unit their capacity is rounded to
+#define MATH_UTILS_VEC2_ALIGNMENT 64
+#define MATH_UTILS_VEC2_BLOCK     (MATH_UTILS_VEC2_ALIGNMENT / sizeof(float))
+
+/* -------------------------------------------------------------------------- */
+/* Buffers                                                                    */
+/* -------------------------------------------------------------------------- */
+
+t_math_utils_vec2_buffer* math_utils_vec2_buffer_new(size_t capacity)
+{
+    t_math_utils_vec2_buffer* buffer = malloc(sizeof(t_math_utils_vec2_buffer));
+    if (!buffer) return NULL;
+
+    *buffer = (t_math_utils_vec2_buffer) { NULL, NULL, 0, 0 };
+    if (!math_utils_vec2_buffer_reserve(buffer, capacity))
+    {
+        free(buffer);
+        return NULL;
+    }
+
+    return buffer;
+}
+
+void math_utils_vec2_buffer_free(t_math_utils_vec2_buffer* buffer)
+{
+    if (!buffer) return;
+
+    // y lives in the same block as x
+    free(buffer->x);
+    free(buffer);
+}
+
+bool math_utils_vec2_buffer_reserve(t_math_utils_vec2_buffer* buffer, size_t capacity)
+{
+    if (capacity <= buffer->capacity && buffer->x) return true;
+
+    // x then y in one block; a capacity in whole blocks keeps y aligned and the size a multiple of the alignment
+    size_t rounded = (capacity + MATH_UTILS_VEC2_BLOCK - 1) / MATH_UTILS_VEC2_BLOCK * MATH_UTILS_VEC2_BLOCK;
+    if (rounded == 0) rounded = MATH_UTILS_VEC2_BLOCK;
+    if (rounded < capacity || rounded > SIZE_MAX / 2 / sizeof(float)) return false;
+
+    float* block = aligned_alloc(MATH_UTILS_VEC2_ALIGNMENT, 2 * rounded * sizeof(float));
+    if (!block) return false;
+
+    if (buffer->x)
+    {
+        memcpy(block, buffer->x, buffer->count * sizeof(float));
+        memcpy(block + rounded, buffer->y, buffer->count * sizeof(float));
+        free(buffer->x);
+    }
+
+    buffer->x = block;
+    buffer->y = block + rounded;
+    buffer->capacity = rounded;
+    return true;
+}
+
+bool math_utils_vec2_buffer_resize(t_math_utils_vec2_buffer* buffer, size_t count)
+{
+    if (count > buffer->capacity && !math_utils_vec2_buffer_reserve(buffer, count)) return false;
+
+    if (count > buffer->count)
+    {
+        memset(buffer->x + buffer->count, 0, (count - buffer->count) * sizeof(float));
+        memset(buffer->y + buffer->count, 0, (count - buffer->count) * sizeof(float));
+    }
+
+    buffer->count = count;
+    return true;
+}
+
+bool math_utils_vec2_buffer_push(t_math_utils_vec2_buffer* buffer, t_math_utils_vec2 v)
+{
+    if (buffer->count == buffer->capacity && !math_utils_vec2_buffer_reserve(buffer, buffer->capacity * 2))
+    {
+        return false;
+    }
+
+    buffer->x[buffer->count] = v.x;
+    buffer->y[buffer->count] = v.y;
+    buffer->count++;
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Batch kernels                                                              */
+/* -------------------------------------------------------------------------- */
+
+/*
+ * Component-wise kernels run once on x and once on y. Every variant does
+ * the same IEEE operations in the same order, so results do not depend on
+ * the instruction set; the one exception is fma, fused only where the CPU
+ * has FMA instructions, since emulating it with fmaf() costs ten times more.
+ */
+typedef struct t_math_utils_vec2_kernels
+{
+    void (*add)(float* out, const float* a, const float* b, size_t count);
+    void (*sub)(float* out, const float* a, const float* b, size_t count);
+    void (*scale)(float* out, const float* a, float scale, size_t count);
+    void (*fma)(float* out, const float* a, float scale, const float* b, size_t count);
+    void (*clamp)(float* out, const float* a, float min, float max, size_t count);
+    void (*dot)(float* out, const float* ax, const float* ay, const float* bx, const float* by, size_t count);
+    void (*length)(float* out, const float* x, const float* y, size_t count);
+    void (*normalize)(float* out_x, float* out_y, const float* x, const float* y, size_t count);
+    void (*normalize_fast)(float* out_x, float* out_y, const float* x, const float* y, size_t count);
+} t_math_utils_vec2_kernels;
+
+static t_math_utils_vec2_kernels s_kernels;
+static pthread_once_t s_kernels_once = PTHREAD_ONCE_INIT;
+
+static void math_utils_vec2_add_scalar(float* out, const float* a, const float* b, size_t count)
+{
+    for (size_t i = 0; i < count; i++) out[i] = a[i] + b[i];
+}
+
+static void math_utils_vec2_sub_scalar(float* out, const float* a, const float* b, size_t count)
+{
+    for (size_t i = 0; i < count; i++) out[i] = a[i] - b[i];
+}
+
+static void math_utils_vec2_scale_scalar(float* out, const float* a, float scale, size_t count)
+{
+    for (size_t i = 0; i < count; i++) out[i] = a[i] * scale;
+}
+
+static void math_utils_vec2_fma_scalar(float* out, const float* a, float scale, const float* b, size_t count)
+{
+    for (size_t i = 0; i < count; i++) out[i] = a[i] * scale + b[i];
+}
+
+static void math_utils_vec2_clamp_scalar(float* out, const float* a, float min, float max, size_t count)
+{
+    // NaN passes through, as in math_utils_clampf()
+    for (size_t i = 0; i < count; i++) out[i] = a[i] < min ? min : a[i] > max ? max : a[i];
+}
+
+static void math_utils_vec2_dot_scalar(float* out, const float* ax, const float* ay, const float* bx, const float* by,
+                                       size_t count)
+{
+    for (size_t i = 0; i < count; i++) out[i] = ax[i] * bx[i] + ay[i] * by[i];
+}
+
+static void math_utils_vec2_length_scalar(float* out, const float* x, const float* y, size_t count)
+{
+    for (size_t i = 0; i < count; i++) out[i] = math_utils_vec2_length(math_utils_vec2(x[i], y[i]));
+}
+
+static void math_utils_vec2_normalize_scalar(float* out_x, float* out_y, const float* x, const float* y, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        t_math_utils_vec2 unit = math_utils_vec2_normalize(math_utils_vec2(x[i], y[i]));
+        out_x[i] = unit.x;
+        out_y[i] = unit.y;
+    }
+}
+
+/*
+ * 1 / sqrt(x) for x in [FLT_MIN, FLT_MAX], with a relative error below 4e-7:
+ * the hardware estimate of the vector kernels (rsqrtss, 12 bits) refined by
+ * the same Newton step; elsewhere, the bit-level initial guess (5 bits)
+ * needs three steps.
+ */
+static float math_utils_vec2_rsqrt_fast(float x)
+{
+    float estimate;
+#ifdef MATH_UTILS_VEC2_X86
+    estimate = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+#else
+    union { float f; unsigned int u; } bits = { x };
+    bits.u = 0x5f375a86u - (bits.u >> 1);
+    estimate = bits.f;
+    estimate = estimate * (1.5f - 0.5f * x * estimate * estimate);
+    estimate = estimate * (1.5f - 0.5f * x * estimate * estimate);
+#endif
+    return estimate * (1.5f - 0.5f * x * estimate * estimate);
+}
+
+static void math_utils_vec2_normalize_fast_scalar(float* out_x, float* out_y, const float* x, const float* y,
+                                                  size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        t_math_utils_vec2 v = math_utils_vec2(x[i], y[i]);
+        float squared = math_utils_vec2_length_squared(v);
+        t_math_utils_vec2 unit = squared >= FLT_MIN && squared <= FLT_MAX
+            ? math_utils_vec2_scale(v, math_utils_vec2_rsqrt_fast(squared))
+            : math_utils_vec2_normalize_scaled(v);
+
+        out_x[i] = unit.x;
+        out_y[i] = unit.y;
+    }
+}
+
+#ifdef MATH_UTILS_VEC2_X86
+
+/*
+ * Vector lanes whose squared length is outside [FLT_MIN, FLT_MAX] (bit
+ * clear in usable) are redone on the scalar slow path, from copies of the
+ * inputs since out may be the input buffer.
+ */
+static void math_utils_vec2_length_fixup(float* out, const float* x, const float* y, unsigned usable, size_t lanes)
+{
+    for (size_t j = 0; j < lanes; j++)
+    {
+        if (!(usable >> j & 1)) out[j] = math_utils_vec2_length_scaled(math_utils_vec2(x[j], y[j]));
+    }
+}
+
+static void math_utils_vec2_normalize_fixup(float* out_x, float* out_y, const float* x, const float* y,
+                                            unsigned usable, size_t lanes)
+{
+    for (size_t j = 0; j < lanes; j++)
+    {
+        if (usable >> j & 1) continue;
+
+        t_math_utils_vec2 unit = math_utils_vec2_normalize_scaled(math_utils_vec2(x[j], y[j]));
+        out_x[j] = unit.x;
+        out_y[j] = unit.y;
+    }
+}
+
+static void math_utils_vec2_add_sse2(float* out, const float* a, const float* b, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    math_utils_vec2_add_scalar(out + i, a + i, b + i, count - i);
+}
+
+static void math_utils_vec2_sub_sse2(float* out, const float* a, const float* b, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) _mm_storeu_ps(out + i, _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    math_utils_vec2_sub_scalar(out + i, a + i, b + i, count - i);
+}
+
+static void math_utils_vec2_scale_sse2(float* out, const float* a, float scale, size_t count)
+{
+    __m128 factor = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(a + i), factor));
+    math_utils_vec2_scale_scalar(out + i, a + i, scale, count - i);
+}
+
+static void math_utils_vec2_fma_sse2(float* out, const float* a, float scale, const float* b, size_t count)
+{
+    __m128 factor = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + i), factor), _mm_loadu_ps(b + i)));
+    }
+    math_utils_vec2_fma_scalar(out + i, a + i, scale, b + i, count - i);
+}
+
+/*
+ * clamp as max(min, v) then min(max, v): the SSE min and max return their
+ * second operand when either is NaN, which lets NaN through like the scalar
+ * comparisons do.
+ */
+
+static void math_utils_vec2_clamp_sse2(float* out, const float* a, float min, float max, size_t count)
+{
+    __m128 low = _mm_set1_ps(min);
+    __m128 high = _mm_set1_ps(max);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) _mm_storeu_ps(out + i, _mm_min_ps(high, _mm_max_ps(low, _mm_loadu_ps(a + i))));
+    math_utils_vec2_clamp_scalar(out + i, a + i, min, max, count - i);
+}
+
+static void math_utils_vec2_dot_sse2(float* out, const float* ax, const float* ay, const float* bx, const float* by,
+                                     size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 xx = _mm_mul_ps(_mm_loadu_ps(ax + i), _mm_loadu_ps(bx + i));
+        __m128 yy = _mm_mul_ps(_mm_loadu_ps(ay + i), _mm_loadu_ps(by + i));
+        _mm_storeu_ps(out + i, _mm_add_ps(xx, yy));
+    }
+    math_utils_vec2_dot_scalar(out + i, ax + i, ay + i, bx + i, by + i, count - i);
+}
+
+static void math_utils_vec2_length_sse2(float* out, const float* x, const float* y, size_t count)
+{
+    __m128 smallest = _mm_set1_ps(FLT_MIN);
+    __m128 largest = _mm_set1_ps(FLT_MAX);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 squared = _mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy));
+        unsigned usable = (unsigned)_mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(squared, smallest),
+                                                               _mm_cmple_ps(squared, largest)));
+
+        _mm_storeu_ps(out + i, _mm_sqrt_ps(squared));
+        if (usable != 0xf)
+        {
+            float lane_x[4], lane_y[4];
+            _mm_storeu_ps(lane_x, vx);
+            _mm_storeu_ps(lane_y, vy);
+            math_utils_vec2_length_fixup(out + i, lane_x, lane_y, usable, 4);
+        }
+    }
+    math_utils_vec2_length_scalar(out + i, x + i, y + i, count - i);
+}
+
+static void math_utils_vec2_normalize_sse2(float* out_x, float* out_y, const float* x, const float* y, size_t count)
+{
+    __m128 smallest = _mm_set1_ps(FLT_MIN);
+    __m128 largest = _mm_set1_ps(FLT_MAX);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 squared = _mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy));
+        unsigned usable = (unsigned)_mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(squared, smallest),
+                                                               _mm_cmple_ps(squared, largest)));
+        __m128 length = _mm_sqrt_ps(squared);
+
+        _mm_storeu_ps(out_x + i, _mm_div_ps(vx, length));
+        _mm_storeu_ps(out_y + i, _mm_div_ps(vy, length));
+        if (usable != 0xf)
+        {
+            float lane_x[4], lane_y[4];
+            _mm_storeu_ps(lane_x, vx);
+            _mm_storeu_ps(lane_y, vy);
+            math_utils_vec2_normalize_fixup(out_x + i, out_y + i, lane_x, lane_y, usable, 4);
+        }
+    }
+    math_utils_vec2_normalize_scalar(out_x + i, out_y + i, x + i, y + i, count - i);
+}
+
+/*
+ * Fast kernels: rsqrtps estimate, then one Newton step r (1.5 - 0.5 s r^2),
+ * the same arithmetic as math_utils_vec2_rsqrt_fast().
+ */
+
+static void math_utils_vec2_normalize_fast_sse2(float* out_x, float* out_y, const float* x, const float* y,
+                                                size_t count)
+{
+    __m128 smallest = _mm_set1_ps(FLT_MIN);
+    __m128 largest = _mm_set1_ps(FLT_MAX);
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 three_halves = _mm_set1_ps(1.5f);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 squared = _mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy));
+        unsigned usable = (unsigned)_mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(squared, smallest),
+                                                               _mm_cmple_ps(squared, largest)));
+        __m128 r = _mm_rsqrt_ps(squared);
+        r = _mm_mul_ps(r, _mm_sub_ps(three_halves, _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(half, squared), r), r)));
+
+        _mm_storeu_ps(out_x + i, _mm_mul_ps(vx, r));
+        _mm_storeu_ps(out_y + i, _mm_mul_ps(vy, r));
+        if (usable != 0xf)
+        {
+            float lane_x[4], lane_y[4];
+            _mm_storeu_ps(lane_x, vx);
+            _mm_storeu_ps(lane_y, vy);
+            math_utils_vec2_normalize_fixup(out_x + i, out_y + i, lane_x, lane_y, usable, 4);
+        }
+    }
+    math_utils_vec2_normalize_fast_scalar(out_x + i, out_y + i, x + i, y + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void math_utils_vec2_add_avx2(float* out, const float* a, const float* b, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    math_utils_vec2_add_scalar(out + i, a + i, b + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void math_utils_vec2_sub_avx2(float* out, const float* a, const float* b, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_ps(out + i, _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    math_utils_vec2_sub_scalar(out + i, a + i, b + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void math_utils_vec2_scale_avx2(float* out, const float* a, float scale, size_t count)
+{
+    __m256 factor = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), factor));
+    math_utils_vec2_scale_scalar(out + i, a + i, scale, count - i);
+}
+
+// Only selected when the CPU also has FMA
+__attribute__((target("avx2,fma")))
+static void math_utils_vec2_fma_avx2(float* out, const float* a, float scale, const float* b, size_t count)
+{
+    __m256 factor = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_ps(out + i, _mm256_fmadd_ps(_mm256_loadu_ps(a + i), factor, _mm256_loadu_ps(b + i)));
+    }
+    for (; i < count; i++) out[i] = fmaf(a[i], scale, b[i]);
+}
+
+__attribute__((target("avx2")))
+static void math_utils_vec2_clamp_avx2(float* out, const float* a, float min, float max, size_t count)
+{
+    __m256 low = _mm256_set1_ps(min);
+    __m256 high = _mm256_set1_ps(max);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm256_storeu_ps(out + i, _mm256_min_ps(high, _mm256_max_ps(low, _mm256_loadu_ps(a + i))));
+    }
+    math_utils_vec2_clamp_scalar(out + i, a + i, min, max, count - i);
+}
+
+__attribute__((target("avx2")))
+static void math_utils_vec2_dot_avx2(float* out, const float* ax, const float* ay, const float* bx, const float* by,
+                                     size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 xx = _mm256_mul_ps(_mm256_loadu_ps(ax + i), _mm256_loadu_ps(bx + i));
+        __m256 yy = _mm256_mul_ps(_mm256_loadu_ps(ay + i), _mm256_loadu_ps(by + i));
+        _mm256_storeu_ps(out + i, _mm256_add_ps(xx, yy));
+    }
+    math_utils_vec2_dot_scalar(out + i, ax + i, ay + i, bx + i, by + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void math_utils_vec2_length_avx2(float* out, const float* x, const float* y, size_t count)
+{
+    __m256 smallest = _mm256_set1_ps(FLT_MIN);
+    __m256 largest = _mm256_set1_ps(FLT_MAX);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(x + i);
+        __m256 vy = _mm256_loadu_ps(y + i);
+        __m256 squared = _mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy));
+        unsigned usable = (unsigned)_mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(squared, smallest, _CMP_GE_OQ),
+                                                                     _mm256_cmp_ps(squared, largest, _CMP_LE_OQ)));
+
+        _mm256_storeu_ps(out + i, _mm256_sqrt_ps(squared));
+        if (usable != 0xff)
+        {
+            float lane_x[8], lane_y[8];
+            _mm256_storeu_ps(lane_x, vx);
+            _mm256_storeu_ps(lane_y, vy);
+            math_utils_vec2_length_fixup(out + i, lane_x, lane_y, usable, 8);
+        }
+    }
+    math_utils_vec2_length_scalar(out + i, x + i, y + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void math_utils_vec2_normalize_avx2(float* out_x, float* out_y, const float* x, const float* y, size_t count)
+{
+    __m256 smallest = _mm256_set1_ps(FLT_MIN);
+    __m256 largest = _mm256_set1_ps(FLT_MAX);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(x + i);
+        __m256 vy = _mm256_loadu_ps(y + i);
+        __m256 squared = _mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy));
+        unsigned usable = (unsigned)_mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(squared, smallest, _CMP_GE_OQ),
+                                                                     _mm256_cmp_ps(squared, largest, _CMP_LE_OQ)));
+        __m256 length = _mm256_sqrt_ps(squared);
+
+        _mm256_storeu_ps(out_x + i, _mm256_div_ps(vx, length));
+        _mm256_storeu_ps(out_y + i, _mm256_div_ps(vy, length));
+        if (usable != 0xff)
+        {
+            float lane_x[8], lane_y[8];
+            _mm256_storeu_ps(lane_x, vx);
+            _mm256_storeu_ps(lane_y, vy);
+            math_utils_vec2_normalize_fixup(out_x + i, out_y + i, lane_x, lane_y, usable, 8);
+        }
+    }
+    math_utils_vec2_normalize_scalar(out_x + i, out_y + i, x + i, y + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void math_utils_vec2_normalize_fast_avx2(float* out_x, float* out_y, const float* x, const float* y,
+                                                size_t count)
+{
+    __m256 smallest = _mm256_set1_ps(FLT_MIN);
+    __m256 largest = _mm256_set1_ps(FLT_MAX);
+    __m256 half = _mm256_set1_ps(0.5f);
+    __m256 three_halves = _mm256_set1_ps(1.5f);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(x + i);
+        __m256 vy = _mm256_loadu_ps(y + i);
+        __m256 squared = _mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy));
+        unsigned usable = (unsigned)_mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(squared, smallest, _CMP_GE_OQ),
+                                                                     _mm256_cmp_ps(squared, largest, _CMP_LE_OQ)));
+        __m256 r = _mm256_rsqrt_ps(squared);
+        r = _mm256_mul_ps(r, _mm256_sub_ps(three_halves,
+                                           _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(half, squared), r), r)));
+
+        _mm256_storeu_ps(out_x + i, _mm256_mul_ps(vx, r));
+        _mm256_storeu_ps(out_y + i, _mm256_mul_ps(vy, r));
+        if (usable != 0xff)
+        {
+            float lane_x[8], lane_y[8];
+            _mm256_storeu_ps(lane_x, vx);
+            _mm256_storeu_ps(lane_y, vy);
+            math_utils_vec2_normalize_fixup(out_x + i, out_y + i, lane_x, lane_y, usable, 8);
+        }
+    }
+    math_utils_vec2_normalize_fast_scalar(out_x + i, out_y + i, x + i, y + i, count - i);
+}
+
+#endif /* MATH_UTILS_VEC2_X86 */
+
+static void math_utils_vec2_kernels_init(void)
+{
+    s_kernels = (t_math_utils_vec2_kernels) {
+        math_utils_vec2_add_scalar,
+        math_utils_vec2_sub_scalar,
+        math_utils_vec2_scale_scalar,
+        math_utils_vec2_fma_scalar,
+        math_utils_vec2_clamp_scalar,
+        math_utils_vec2_dot_scalar,
+        math_utils_vec2_length_scalar,
+        math_utils_vec2_normalize_scalar,
+        math_utils_vec2_normalize_fast_scalar
+    };
+
+#ifdef MATH_UTILS_VEC2_X86
+    // Bandwidth-bound kernels: AVX-512 would gain little over AVX2
+    e_cpu_utils_level level = cpu_utils_level();
+
+    if (level >= CPU_UTILS_AVX2)
+    {
+        s_kernels = (t_math_utils_vec2_kernels) {
+            math_utils_vec2_add_avx2,
+            math_utils_vec2_sub_avx2,
+            math_utils_vec2_scale_avx2,
+            math_utils_vec2_fma_sse2,
+            math_utils_vec2_clamp_avx2,
+            math_utils_vec2_dot_avx2,
+            math_utils_vec2_length_avx2,
+            math_utils_vec2_normalize_avx2,
+            math_utils_vec2_normalize_fast_avx2
+        };
+        if (__builtin_cpu_supports("fma")) s_kernels.fma = math_utils_vec2_fma_avx2;
+    }
+    else if (level >= CPU_UTILS_SSE2)
+    {
+        s_kernels = (t_math_utils_vec2_kernels) {
+            math_utils_vec2_add_sse2,
+            math_utils_vec2_sub_sse2,
+            math_utils_vec2_scale_sse2,
+            math_utils_vec2_fma_sse2,
+            math_utils_vec2_clamp_sse2,
+            math_utils_vec2_dot_sse2,
+            math_utils_vec2_length_sse2,
+            math_utils_vec2_normalize_sse2,
+            math_utils_vec2_normalize_fast_sse2
+        };
+    }
+#endif
+}
+
+static const t_math_utils_vec2_kernels* math_utils_vec2_kernels(void)
+{
+    pthread_once(&s_kernels_once, math_utils_vec2_kernels_init);
+    return &s_kernels;
+}
+
+bool math_utils_vec2_buffer_add(t_math_utils_vec2_buffer* out, const t_math_utils_vec2_buffer* a,
+                                const t_math_utils_vec2_buffer* b)
+{
+    size_t count = a->count;
+    if (b->count != count || !math_utils_vec2_buffer_resize(out, count)) return false;
+
+    const t_math_utils_vec2_kernels* kernels = math_utils_vec2_kernels();
+    kernels->add(out->x, a->x, b->x, count);
+    kernels->add(out->y, a->y, b->y, count);
+    return true;
+}
+
+bool math_utils_vec2_buffer_sub(t_math_utils_vec2_buffer* out, const t_math_utils_vec2_buffer* a,
+                                const t_math_utils_vec2_buffer* b)
+{
+    size_t count = a->count;
+    if (b->count != count || !math_utils_vec2_buffer_resize(out, count)) return false;
+
+    const t_math_utils_vec2_kernels* kernels = math_utils_vec2_kernels();
+    kernels->sub(out->x, a->x, b->x, count);
+    kernels->sub(out->y, a->y, b->y, count);
+    return true;
+}
+
+bool math_utils_vec2_buffer_scale(t_math_utils_vec2_buffer* out, const t_math_utils_vec2_buffer* a, float scale)
+{
+    size_t count = a->count;
+    if (!math_utils_vec2_buffer_resize(out, count)) return false;
+
+    const t_math_utils_vec2_kernels* kernels = math_utils_vec2_kernels();
+    kernels->scale(out->x, a->x, scale, count);
+    kernels->scale(out->y, a->y, scale, count);
+    return true;
+}
+
+bool math_utils_vec2_buffer_fma(t_math_utils_vec2_buffer* out, const t_math_utils_vec2_buffer* a, float scale,
+                                const t_math_utils_vec2_buffer* b)
+{
+    size_t count = a->count;
+    if (b->count != count || !math_utils_vec2_buffer_resize(out, count)) return false;
+
+    const t_math_utils_vec2_kernels* kernels = math_utils_vec2_kernels();
+    kernels->fma(out->x, a->x, scale, b->x, count);
+    kernels->fma(out->y, a->y, scale, b->y, count);
+    return true;
+}
+
+bool math_utils_vec2_buffer_clamp(t_math_utils_vec2_buffer* out, const t_math_utils_vec2_buffer* a,
+                                  t_math_utils_vec2 min, t_math_utils_vec2 max)
+{
+    size_t count = a->count;
+    if (!math_utils_vec2_buffer_resize(out, count)) return false;
+
+    const t_math_utils_vec2_kernels* kernels = math_utils_vec2_kernels();
+    kernels->clamp(out->x, a->x, min.x, max.x, count);
+    kernels->clamp(out->y, a->y, min.y, max.y, count);
+    return true;
+}
+
+bool math_utils_vec2_buffer_normalize(t_math_utils_vec2_buffer* out, const t_math_utils_vec2_buffer* a)
+{
+    size_t count = a->count;
+    if (!math_utils_vec2_buffer_resize(out, count)) return false;
+
+#ifdef MATH_UTILS_VEC2_FAST_MATH
+    math_utils_vec2_kernels()->normalize_fast(out->x, out->y, a->x, a->y, count);
+#else
+    math_utils_vec2_kernels()->normalize(out->x, out->y, a->x, a->y, count);
+#endif
+    return true;
+}
+
+bool math_utils_vec2_buffer_dot(float* out, const t_math_utils_vec2_buffer* a, const t_math_utils_vec2_buffer* b)
+{
+    if (b->count != a->count) return false;
+
+    math_utils_vec2_kernels()->dot(out, a->x, a->y, b->x, b->y, a->count);
+    return true;
+}
+
+void math_utils_vec2_buffer_length(float* out, const t_math_utils_vec2_buffer* a)
+{
+    math_utils_vec2_kernels()->length(out, a->x, a->y, a->count);
+}
+
+bool math_utils_vec2_buffer_normalize_fast(t_math_utils_vec2_buffer* out, const t_math_utils_vec2_buffer* a)
+{
+    size_t count = a->count;
+    if (!math_utils_vec2_buffer_resize(out, count)) return false;
+
+    math_utils_vec2_kernels()->normalize_fast(out->x, out->y, a->x, a->y, count);
+    return true;
+}
@@ -1,30 +1,1101 @@
 #include <rand_utils.h>
-#include <time.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "cpu_utils.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define RAND_UTILS_X86 1
+#endif
+
+// Bulk conversions must round the same at every SIMD level: never fuse a * b + c,
+// which GNU C modes and clang allow by default
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// Thread-local default generator
+static _Thread_local t_rand_utils_state s_thread_state;
+static _Thread_local bool s_thread_seeded = false;
+
+static _Thread_local t_rand_utils_lanes s_thread_lanes;
+static _Thread_local bool s_thread_lanes_seeded = false;
+
+// Distinguishes seeds taken in the same clock tick
+static atomic_uint_fast64_t s_seed_counter = 0;
+
+static uint64_t rand_utils_splitmix64(uint64_t* x)
+{
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// High and low halves of a * b
+static uint64_t rand_utils_multiply_128(uint64_t a, uint64_t b, uint64_t* low)
+{
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 product = (unsigned __int128)a * b;
+    *low = (uint64_t)product;
+    return (uint64_t)(product >> 64);
+#else
+    const uint64_t m32 = 0xffffffffull;
+    uint64_t ah = a >> 32, al = a & m32, bh = b >> 32, bl = b & m32;
+    uint64_t ll = al * bl, hl = ah * bl, lh = al * bh;
+    uint64_t middle = (ll >> 32) + (hl & m32) + (lh & m32);
+    *low = (middle << 32) | (ll & m32);
+    return ah * bh + (hl >> 32) + (lh >> 32) + (middle >> 32);
+#endif
+}
+
+void rand_utils_state_seed(t_rand_utils_state* state, uint64_t seed)
+{
+    // splitmix64 never yields four zero words, the one state xoshiro cannot leave
+    for (int i = 0; i < 4; i++) state->s[i] = rand_utils_splitmix64(&seed);
+}
+
+// Jump polynomials: XOR of the states reached after each set bit equals the state 2^128 / 2^192 steps ahead
+static const uint64_t s_jump[4] =
+{
+    0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull, 0xa9582618e03fc9aaull, 0x39abdc4529b1661cull
+};
+
+static const uint64_t s_long_jump[4] =
+{
+    0x76e15d3efefdcbbfull, 0xc5004e441c522fb3ull, 0x77710069854ee241ull, 0x39109bb02acbe635ull
+};
 
-static bool has_been_seed = false;
+static void rand_utils_state_apply(t_rand_utils_state* state, const uint64_t polynomial[4])
+{
+    uint64_t s[4] = { 0, 0, 0, 0 };
+
+    for (int i = 0; i < 4; i++)
+    {
+        for (int b = 0; b < 64; b++)
+        {
+            if (polynomial[i] & (1ull << b))
+            {
+                for (int w = 0; w < 4; w++) s[w] ^= state->s[w];
+            }
+            rand_utils_state_next(state);
+        }
+    }
+
+    for (int w = 0; w < 4; w++) state->s[w] = s[w];
+}
+
+void rand_utils_state_jump(t_rand_utils_state* state)
+{
+    rand_utils_state_apply(state, s_jump);
+}
+
+void rand_utils_state_long_jump(t_rand_utils_state* state)
+{
+    rand_utils_state_apply(state, s_long_jump);
+}
+
+void rand_utils_state_split(const t_rand_utils_state* master, t_rand_utils_state* streams, size_t count)
+{
+    t_rand_utils_state state = *master;
+
+    for (size_t k = 0; k < count; k++)
+    {
+        streams[k] = state;
+        rand_utils_state_jump(&state);
+    }
+}
+
+void rand_utils_state_stream(t_rand_utils_state* state, uint64_t seed, uint64_t index)
+{
+    rand_utils_state_seed(state, seed);
+    for (uint64_t k = 0; k < index; k++) rand_utils_state_jump(state);
+}
+
+uint64_t rand_utils_state_bounded(t_rand_utils_state* state, uint64_t range)
+{
+    uint64_t low;
+    uint64_t high = rand_utils_multiply_128(rand_utils_state_next(state), range, &low);
+
+    // The high half is uniform once the low halves below 2^64 mod range are rejected
+    if (low < range)
+    {
+        uint64_t threshold = (0 - range) % range;
+        while (low < threshold) high = rand_utils_multiply_128(rand_utils_state_next(state), range, &low);
+    }
+
+    return high;
+}
+
+int rand_utils_state_int(t_rand_utils_state* state, int min, int max)
+{
+    if (max <= min) return min;
+
+    uint64_t range = (uint64_t)((int64_t)max - min) + 1;
+    return (int)((int64_t)min + (int64_t)rand_utils_state_bounded(state, range));
+}
+
+float rand_utils_state_float(t_rand_utils_state* state, float min, float max)
+{
+    if (max <= min) return min;
+
+    float unit = (float)(rand_utils_state_next(state) >> 40) * 0x1.0p-24f;
+    float value = min + unit * (max - min);
+
+    // Rounding can reach max when the range is wide
+    return value < max ? value : min;
+}
+
+double rand_utils_state_double(t_rand_utils_state* state, double min, double max)
+{
+    if (max <= min) return min;
+
+    double unit = (double)(rand_utils_state_next(state) >> 11) * 0x1.0p-53;
+    double value = min + unit * (max - min);
+
+    return value < max ? value : min;
+}
+
+static uint64_t rand_utils_clock_seed(void)
+{
+    struct timespec ts = { 0 };
+    timespec_get(&ts, TIME_UTC);
+
+    uint64_t seed = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    seed ^= (uint64_t)(uintptr_t)&s_thread_state;
+    seed += atomic_fetch_add_explicit(&s_seed_counter, 1, memory_order_relaxed) * 0x9e3779b97f4a7c15ull;
+    return seed;
+}
+
+t_rand_utils_state* rand_utils_thread_state(void)
+{
+    if (!s_thread_seeded) rand_utils_seed();
+    return &s_thread_state;
+}
 
 void rand_utils_seed(void)
 {
-    has_been_seed = true;
-    srand((unsigned int)time(NULL));
+    rand_utils_seed_value(rand_utils_clock_seed());
 }
 
-void ensure_seed(void)
+void rand_utils_seed_value(uint64_t seed)
 {
-    if (!has_been_seed) rand_utils_seed();
+    rand_utils_state_seed(&s_thread_state, seed);
+    s_thread_seeded = true;
+}
+
+uint64_t rand_utils_u64(void)
+{
+    return rand_utils_state_next(rand_utils_thread_state());
 }
 
 int rand_utils_int(int min, int max)
 {
-    ensure_seed();
-    if (max <= min) return min;
-    return min + rand() % (max - min + 1);
+    return rand_utils_state_int(rand_utils_thread_state(), min, max);
 }
 
 float rand_utils_float(float min, float max)
 {
-    ensure_seed();
-    if (max <= min) return min;
-    return min + ((float)rand() / (float)RAND_MAX) * (max - min);
+    return rand_utils_state_float(rand_utils_thread_state(), min, max);
+}
+
+double rand_utils_double(double min, double max)
+{
+    return rand_utils_state_double(rand_utils_thread_state(), min, max);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Bulk generation                                                            */
+/* -------------------------------------------------------------------------- */
+
+// Writes blocks groups of eight raw values, lane j of group b at out[8 * b + j]
+typedef void (*rand_utils_generate_fn)(t_rand_utils_lanes* lanes, uint64_t* out, size_t blocks);
+
+/*
+ * Conversions of raw values, from draw first on. 32-bit draws are the low
+ * then high halves of each raw value. Vector code uses the same operations
+ * in the same order as the scalar code (no FMA), so results are identical.
+ */
+typedef void (*rand_utils_to_float_fn)(const uint64_t* raw, size_t count, float* out, float min, float max);
+typedef void (*rand_utils_to_double_fn)(const uint64_t* raw, size_t count, double* out, double min, double max);
+
+// Maps draws with Lemire's method; returns true if any draw must be rejected (its output is then garbage)
+typedef bool (*rand_utils_to_u32_fn)(const uint64_t* raw, size_t first, size_t count, uint32_t* out,
+                                     uint32_t min, uint32_t range, uint32_t threshold);
+
+// Maps draws and keeps the accepted ones, in draw order; returns the number written
+typedef size_t (*rand_utils_compact_u32_fn)(const uint64_t* raw, size_t first, size_t count, uint32_t* out,
+                                            uint32_t min, uint32_t range, uint32_t threshold);
+
+static rand_utils_generate_fn s_generate;
+static rand_utils_to_float_fn s_to_float;
+static rand_utils_to_double_fn s_to_double;
+static rand_utils_to_u32_fn s_to_u32;
+static rand_utils_compact_u32_fn s_compact_u32;
+static pthread_once_t s_simd_once = PTHREAD_ONCE_INIT;
+
+// Raw values produced per refill of the conversion buffers
+#define RAND_UTILS_CHUNK 256
+
+static void rand_utils_generate_scalar(t_rand_utils_lanes* lanes, uint64_t* out, size_t blocks)
+{
+    for (int lane = 0; lane < RAND_UTILS_LANES; lane++)
+    {
+        t_rand_utils_state state = { { lanes->s[0][lane], lanes->s[1][lane], lanes->s[2][lane], lanes->s[3][lane] } };
+
+        for (size_t b = 0; b < blocks; b++) out[b * RAND_UTILS_LANES + lane] = rand_utils_state_next(&state);
+
+        for (int w = 0; w < 4; w++) lanes->s[w][lane] = state.s[w];
+    }
+}
+
+static uint32_t rand_utils_draw(const uint64_t* raw, size_t k)
+{
+    return (uint32_t)(raw[k / 2] >> (k % 2 * 32));
+}
+
+static void rand_utils_to_float_scalar(const uint64_t* raw, size_t count, float* out, float min, float max)
+{
+    float span = max - min;
+
+    for (size_t k = 0; k < count; k++)
+    {
+        float value = min + (float)(int32_t)(rand_utils_draw(raw, k) >> 8) * 0x1.0p-24f * span;
+        out[k] = value < max ? value : min;
+    }
+}
+
+static void rand_utils_to_double_scalar(const uint64_t* raw, size_t count, double* out, double min, double max)
+{
+    double span = max - min;
+
+    // 52 random bits as the mantissa of a double in [1, 2)
+    for (size_t k = 0; k < count; k++)
+    {
+        uint64_t bits = raw[k] >> 12 | 0x3ff0000000000000ull;
+        double unit;
+        memcpy(&unit, &bits, sizeof(unit));
+
+        double value = min + (unit - 1.0) * span;
+        out[k] = value < max ? value : min;
+    }
+}
+
+static bool rand_utils_to_u32_scalar(const uint64_t* raw, size_t first, size_t count, uint32_t* out,
+                                     uint32_t min, uint32_t range, uint32_t threshold)
+{
+    bool rejected = false;
+
+    for (size_t k = 0; k < count; k++)
+    {
+        uint64_t product = (uint64_t)rand_utils_draw(raw, first + k) * range;
+        out[k] = min + (uint32_t)(product >> 32);
+        rejected |= (uint32_t)product < threshold;
+    }
+
+    return rejected;
+}
+
+// Maps draws and keeps the accepted ones, in draw order; returns the number written
+static size_t rand_utils_compact_u32_scalar(const uint64_t* raw, size_t first, size_t count, uint32_t* out,
+                                            uint32_t min, uint32_t range, uint32_t threshold)
+{
+    size_t written = 0;
+
+    for (size_t k = 0; k < count; k++)
+    {
+        uint64_t product = (uint64_t)rand_utils_draw(raw, first + k) * range;
+        out[written] = min + (uint32_t)(product >> 32);
+        written += (uint32_t)product >= threshold;
+    }
+
+    return written;
+}
+
+#ifdef RAND_UTILS_X86
+
+#define RAND_UTILS_ROTL_256(x, k) _mm256_or_si256(_mm256_slli_epi64((x), (k)), _mm256_srli_epi64((x), 64 - (k)))
+
+// One xoshiro256** step of four lanes
+#define RAND_UTILS_STEP_256(s0, s1, s2, s3, result)                                 \
+    do                                                                              \
+    {                                                                               \
+        __m256i x5 = _mm256_add_epi64((s1), _mm256_slli_epi64((s1), 2));            \
+        __m256i r7 = RAND_UTILS_ROTL_256(x5, 7);                                    \
+        (result) = _mm256_add_epi64(r7, _mm256_slli_epi64(r7, 3));                  \
+        __m256i t = _mm256_slli_epi64((s1), 17);                                    \
+        (s2) = _mm256_xor_si256((s2), (s0));                                        \
+        (s3) = _mm256_xor_si256((s3), (s1));                                        \
+        (s1) = _mm256_xor_si256((s1), (s2));                                        \
+        (s0) = _mm256_xor_si256((s0), (s3));                                        \
+        (s2) = _mm256_xor_si256((s2), t);                                           \
+        (s3) = RAND_UTILS_ROTL_256((s3), 45);                                       \
+    } while (0)
+
+__attribute__((target("avx2")))
+static void rand_utils_generate_avx2(t_rand_utils_lanes* lanes, uint64_t* out, size_t blocks)
+{
+    // Lanes 0-3 in a*, 4-7 in b*
+    __m256i a0 = _mm256_load_si256((const __m256i*)&lanes->s[0][0]);
+    __m256i a1 = _mm256_load_si256((const __m256i*)&lanes->s[1][0]);
+    __m256i a2 = _mm256_load_si256((const __m256i*)&lanes->s[2][0]);
+    __m256i a3 = _mm256_load_si256((const __m256i*)&lanes->s[3][0]);
+    __m256i b0 = _mm256_load_si256((const __m256i*)&lanes->s[0][4]);
+    __m256i b1 = _mm256_load_si256((const __m256i*)&lanes->s[1][4]);
+    __m256i b2 = _mm256_load_si256((const __m256i*)&lanes->s[2][4]);
+    __m256i b3 = _mm256_load_si256((const __m256i*)&lanes->s[3][4]);
+
+    for (size_t b = 0; b < blocks; b++)
+    {
+        __m256i low, high;
+        RAND_UTILS_STEP_256(a0, a1, a2, a3, low);
+        RAND_UTILS_STEP_256(b0, b1, b2, b3, high);
+        _mm256_storeu_si256((__m256i*)(out + b * RAND_UTILS_LANES), low);
+        _mm256_storeu_si256((__m256i*)(out + b * RAND_UTILS_LANES + 4), high);
+    }
+
+    _mm256_store_si256((__m256i*)&lanes->s[0][0], a0);
+    _mm256_store_si256((__m256i*)&lanes->s[1][0], a1);
+    _mm256_store_si256((__m256i*)&lanes->s[2][0], a2);
+    _mm256_store_si256((__m256i*)&lanes->s[3][0], a3);
+    _mm256_store_si256((__m256i*)&lanes->s[0][4], b0);
+    _mm256_store_si256((__m256i*)&lanes->s[1][4], b1);
+    _mm256_store_si256((__m256i*)&lanes->s[2][4], b2);
+    _mm256_store_si256((__m256i*)&lanes->s[3][4], b3);
+}
+
+__attribute__((target("avx512f")))
+static void rand_utils_generate_avx512(t_rand_utils_lanes* lanes, uint64_t* out, size_t blocks)
+{
+    __m512i s0 = _mm512_load_si512(lanes->s[0]);
+    __m512i s1 = _mm512_load_si512(lanes->s[1]);
+    __m512i s2 = _mm512_load_si512(lanes->s[2]);
+    __m512i s3 = _mm512_load_si512(lanes->s[3]);
+
+    for (size_t b = 0; b < blocks; b++)
+    {
+        __m512i x5 = _mm512_add_epi64(s1, _mm512_slli_epi64(s1, 2));
+        __m512i r7 = _mm512_rol_epi64(x5, 7);
+        _mm512_storeu_si512(out + b * RAND_UTILS_LANES, _mm512_add_epi64(r7, _mm512_slli_epi64(r7, 3)));
+
+        __m512i t = _mm512_slli_epi64(s1, 17);
+        s2 = _mm512_xor_si512(s2, s0);
+        s3 = _mm512_xor_si512(s3, s1);
+        s1 = _mm512_xor_si512(s1, s2);
+        s0 = _mm512_xor_si512(s0, s3);
+        s2 = _mm512_xor_si512(s2, t);
+        s3 = _mm512_rol_epi64(s3, 45);
+    }
+
+    _mm512_store_si512(lanes->s[0], s0);
+    _mm512_store_si512(lanes->s[1], s1);
+    _mm512_store_si512(lanes->s[2], s2);
+    _mm512_store_si512(lanes->s[3], s3);
+}
+
+// Raw values hold their draws in memory order on x86, so vectors load them directly
+__attribute__((target("avx2")))
+static void rand_utils_to_float_avx2(const uint64_t* raw, size_t count, float* out, float min, float max)
+{
+    const __m256 vmin = _mm256_set1_ps(min);
+    const __m256 vmax = _mm256_set1_ps(max);
+    const __m256 span = _mm256_set1_ps(max - min);
+    const __m256 scale = _mm256_set1_ps(0x1.0p-24f);
+    size_t k = 0;
+
+    for (; k + 8 <= count; k += 8)
+    {
+        __m256i draws = _mm256_loadu_si256((const __m256i*)(raw + k / 2));
+        __m256 unit = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(draws, 8)), scale);
+        __m256 value = _mm256_add_ps(vmin, _mm256_mul_ps(unit, span));
+        _mm256_storeu_ps(out + k, _mm256_blendv_ps(vmin, value, _mm256_cmp_ps(value, vmax, _CMP_LT_OQ)));
+    }
+
+    rand_utils_to_float_scalar(raw + k / 2, count - k, out + k, min, max);
+}
+
+__attribute__((target("avx2")))
+static void rand_utils_to_double_avx2(const uint64_t* raw, size_t count, double* out, double min, double max)
+{
+    const __m256d vmin = _mm256_set1_pd(min);
+    const __m256d vmax = _mm256_set1_pd(max);
+    const __m256d span = _mm256_set1_pd(max - min);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256i exponent = _mm256_set1_epi64x(0x3ff0000000000000ll);
+    size_t k = 0;
+
+    for (; k + 4 <= count; k += 4)
+    {
+        __m256i bits = _mm256_or_si256(_mm256_srli_epi64(_mm256_loadu_si256((const __m256i*)(raw + k)), 12), exponent);
+        __m256d unit = _mm256_sub_pd(_mm256_castsi256_pd(bits), one);
+        __m256d value = _mm256_add_pd(vmin, _mm256_mul_pd(unit, span));
+        _mm256_storeu_pd(out + k, _mm256_blendv_pd(vmin, value, _mm256_cmp_pd(value, vmax, _CMP_LT_OQ)));
+    }
+
+    rand_utils_to_double_scalar(raw + k, count - k, out + k, min, max);
+}
+
+__attribute__((target("avx2")))
+static bool rand_utils_to_u32_avx2(const uint64_t* raw, size_t first, size_t count, uint32_t* out,
+                                   uint32_t min, uint32_t range, uint32_t threshold)
+{
+    const __m256i vrange = _mm256_set1_epi64x(range);
+    const __m256i vmin = _mm256_set1_epi32((int)min);
+    const __m256i sign = _mm256_set1_epi32((int)0x80000000u);
+    const __m256i vthreshold = _mm256_xor_si256(_mm256_set1_epi32((int)threshold), sign);
+    const __m256i odd = _mm256_set1_epi64x((long long)0xffffffff00000000ull);
+    const uint32_t* draws = (const uint32_t*)raw + first;
+    __m256i rejected = _mm256_setzero_si256();
+    size_t k = 0;
+
+    for (; k + 8 <= count; k += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(draws + k));
+
+        // 64-bit products of the even and odd draws; high halves are the results, low ones the rejection test
+        __m256i even = _mm256_mul_epu32(v, vrange);
+        __m256i odd_products = _mm256_mul_epu32(_mm256_srli_epi64(v, 32), vrange);
+        __m256i high = _mm256_or_si256(_mm256_srli_epi64(even, 32), _mm256_and_si256(odd_products, odd));
+        __m256i low = _mm256_or_si256(_mm256_and_si256(even, _mm256_set1_epi64x(0xffffffff)),
+                                      _mm256_slli_epi64(odd_products, 32));
+
+        _mm256_storeu_si256((__m256i*)(out + k), _mm256_add_epi32(vmin, high));
+        rejected = _mm256_or_si256(rejected, _mm256_cmpgt_epi32(vthreshold, _mm256_xor_si256(low, sign)));
+    }
+
+    return !_mm256_testz_si256(rejected, rejected)
+           | rand_utils_to_u32_scalar(raw, first + k, count - k, out + k, min, range, threshold);
+}
+
+__attribute__((target("avx512f")))
+static void rand_utils_to_float_avx512(const uint64_t* raw, size_t count, float* out, float min, float max)
+{
+    const __m512 vmin = _mm512_set1_ps(min);
+    const __m512 vmax = _mm512_set1_ps(max);
+    const __m512 span = _mm512_set1_ps(max - min);
+    const __m512 scale = _mm512_set1_ps(0x1.0p-24f);
+    size_t k = 0;
+
+    for (; k + 16 <= count; k += 16)
+    {
+        __m512i draws = _mm512_loadu_si512(raw + k / 2);
+        __m512 unit = _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(draws, 8)), scale);
+        __m512 value = _mm512_add_ps(vmin, _mm512_mul_ps(unit, span));
+        _mm512_storeu_ps(out + k, _mm512_mask_blend_ps(_mm512_cmp_ps_mask(value, vmax, _CMP_LT_OQ), vmin, value));
+    }
+
+    rand_utils_to_float_scalar(raw + k / 2, count - k, out + k, min, max);
+}
+
+__attribute__((target("avx512f")))
+static void rand_utils_to_double_avx512(const uint64_t* raw, size_t count, double* out, double min, double max)
+{
+    const __m512d vmin = _mm512_set1_pd(min);
+    const __m512d vmax = _mm512_set1_pd(max);
+    const __m512d span = _mm512_set1_pd(max - min);
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512i exponent = _mm512_set1_epi64(0x3ff0000000000000ll);
+    size_t k = 0;
+
+    for (; k + 8 <= count; k += 8)
+    {
+        __m512i bits = _mm512_or_si512(_mm512_srli_epi64(_mm512_loadu_si512(raw + k), 12), exponent);
+        __m512d unit = _mm512_sub_pd(_mm512_castsi512_pd(bits), one);
+        __m512d value = _mm512_add_pd(vmin, _mm512_mul_pd(unit, span));
+        _mm512_storeu_pd(out + k, _mm512_mask_blend_pd(_mm512_cmp_pd_mask(value, vmax, _CMP_LT_OQ), vmin, value));
+    }
+
+    rand_utils_to_double_scalar(raw + k, count - k, out + k, min, max);
+}
+
+// Draws first, first + 1, ... of a 512-bit load are its 32-bit lanes in order: compressing keeps draw order
+__attribute__((target("avx512f")))
+static size_t rand_utils_compact_u32_avx512(const uint64_t* raw, size_t first, size_t count, uint32_t* out,
+                                            uint32_t min, uint32_t range, uint32_t threshold)
+{
+    const __m512i vrange = _mm512_set1_epi64(range);
+    const __m512i vmin = _mm512_set1_epi32((int)min);
+    const __m512i vthreshold = _mm512_set1_epi32((int)threshold);
+    const __mmask16 odd = 0xaaaa;
+    size_t written = 0;
+    size_t k = 0;
+
+    // Vector code needs an even first draw; the scalar code takes the odd one
+    if (first % 2 && count > 0)
+    {
+        written = rand_utils_compact_u32_scalar(raw, first, 1, out, min, range, threshold);
+        k = 1;
+    }
+
+    for (; k + 16 <= count; k += 16)
+    {
+        __m512i v = _mm512_loadu_si512(raw + (first + k) / 2);
+        __m512i even = _mm512_mul_epu32(v, vrange);
+        __m512i odd_products = _mm512_mul_epu32(_mm512_srli_epi64(v, 32), vrange);
+        __m512i high = _mm512_mask_blend_epi32(odd, _mm512_srli_epi64(even, 32), odd_products);
+        __m512i low = _mm512_mask_blend_epi32(odd, even, _mm512_slli_epi64(odd_products, 32));
+
+        // Full store: written <= k, so the 16 lanes stay within out[0, count)
+        __mmask16 accepted = _mm512_cmp_epu32_mask(low, vthreshold, _MM_CMPINT_NLT);
+        _mm512_storeu_si512(out + written, _mm512_maskz_compress_epi32(accepted, _mm512_add_epi32(vmin, high)));
+        written += (size_t)__builtin_popcount(accepted);
+    }
+
+    return written + rand_utils_compact_u32_scalar(raw, first + k, count - k, out + written, min, range, threshold);
+}
+
+#endif /* RAND_UTILS_X86 */
+
+static void rand_utils_simd_init(void)
+{
+    s_generate = rand_utils_generate_scalar;
+    s_to_float = rand_utils_to_float_scalar;
+    s_to_double = rand_utils_to_double_scalar;
+    s_to_u32 = rand_utils_to_u32_scalar;
+    s_compact_u32 = rand_utils_compact_u32_scalar;
+
+#ifdef RAND_UTILS_X86
+    switch (cpu_utils_level())
+    {
+        case CPU_UTILS_AVX512:
+            s_generate = rand_utils_generate_avx512;
+            s_to_float = rand_utils_to_float_avx512;
+            s_to_double = rand_utils_to_double_avx512;
+            s_to_u32 = rand_utils_to_u32_avx2;
+            s_compact_u32 = rand_utils_compact_u32_avx512;
+            break;
+        case CPU_UTILS_AVX2:
+            s_generate = rand_utils_generate_avx2;
+            s_to_float = rand_utils_to_float_avx2;
+            s_to_double = rand_utils_to_double_avx2;
+            s_to_u32 = rand_utils_to_u32_avx2;
+            break;
+        default:
+            break;
+    }
+#endif
+}
+
+// Generates at least count raw values, at most RAND_UTILS_CHUNK; returns how many
+static size_t rand_utils_refill(t_rand_utils_lanes* lanes, uint64_t* buffer, size_t count)
+{
+    size_t blocks = (count + RAND_UTILS_LANES - 1) / RAND_UTILS_LANES;
+    if (blocks > RAND_UTILS_CHUNK / RAND_UTILS_LANES) blocks = RAND_UTILS_CHUNK / RAND_UTILS_LANES;
+
+    s_generate(lanes, buffer, blocks);
+    return blocks * RAND_UTILS_LANES;
+}
+
+void rand_utils_lanes_seed(t_rand_utils_lanes* lanes, uint64_t seed)
+{
+    t_rand_utils_state state;
+    rand_utils_state_seed(&state, seed);
+    rand_utils_lanes_init(lanes, &state);
+}
+
+void rand_utils_lanes_init(t_rand_utils_lanes* lanes, const t_rand_utils_state* state)
+{
+    t_rand_utils_state lane_state = *state;
+
+    for (int lane = 0; lane < RAND_UTILS_LANES; lane++)
+    {
+        for (int w = 0; w < 4; w++) lanes->s[w][lane] = lane_state.s[w];
+        rand_utils_state_jump(&lane_state);
+    }
+}
+
+t_rand_utils_lanes* rand_utils_thread_lanes(void)
+{
+    if (!s_thread_lanes_seeded)
+    {
+        // Lanes 2^192 steps away from the thread generator
+        t_rand_utils_state state = *rand_utils_thread_state();
+        rand_utils_state_long_jump(&state);
+        rand_utils_lanes_init(&s_thread_lanes, &state);
+        s_thread_lanes_seeded = true;
+    }
+    return &s_thread_lanes;
+}
+
+void rand_utils_fill_u64(t_rand_utils_lanes* lanes, uint64_t* out, size_t count, uint64_t min, uint64_t max)
+{
+    _Alignas(64) uint64_t buffer[RAND_UTILS_CHUNK];
+
+    if (max < min)
+    {
+        for (size_t i = 0; i < count; i++) out[i] = min;
+        return;
+    }
+
+    pthread_once(&s_simd_once, rand_utils_simd_init);
+
+    uint64_t range = max - min + 1;
+    if (range == 0)
+    {
+        // Full range: whole groups straight into out, the tail through the buffer
+        size_t whole = count / RAND_UTILS_LANES;
+        s_generate(lanes, out, whole);
+
+        size_t done = whole * RAND_UTILS_LANES;
+        if (done < count)
+        {
+            rand_utils_refill(lanes, buffer, count - done);
+            memcpy(out + done, buffer, (count - done) * sizeof(uint64_t));
+        }
+        return;
+    }
+
+    uint64_t threshold = (0 - range) % range;
+    size_t available = 0;
+    size_t position = 0;
+
+    for (size_t i = 0; i < count;)
+    {
+        if (position == available)
+        {
+            available = rand_utils_refill(lanes, buffer, count - i);
+            position = 0;
+        }
+
+        uint64_t low;
+        uint64_t high = rand_utils_multiply_128(buffer[position++], range, &low);
+        if (low >= threshold) out[i++] = min + high;
+    }
+}
+
+void rand_utils_fill_u32(t_rand_utils_lanes* lanes, uint32_t* out, size_t count, uint32_t min, uint32_t max)
+{
+    _Alignas(64) uint64_t buffer[RAND_UTILS_CHUNK];
+
+    if (max < min)
+    {
+        for (size_t i = 0; i < count; i++) out[i] = min;
+        return;
+    }
+
+    pthread_once(&s_simd_once, rand_utils_simd_init);
+
+    uint64_t range = (uint64_t)max - min + 1;
+    if (range > UINT32_MAX)
+    {
+        for (size_t i = 0; i < count;)
+        {
+            size_t raw = rand_utils_refill(lanes, buffer, (count - i + 1) / 2);
+            size_t take = count - i < 2 * raw ? count - i : 2 * raw;
+
+            for (size_t k = 0; k < take; k++) out[i + k] = rand_utils_draw(buffer, k);
+            i += take;
+        }
+        return;
+    }
+
+    uint32_t threshold = (uint32_t)((0x100000000ull - range) % range);
+    // Rejection rate of 1/256 or more: most runs of 2 * RAND_UTILS_CHUNK draws would be mapped twice
+    bool frequent = threshold >= (1u << 24);
+    size_t available = 0;
+    size_t position = 0;
+
+    for (size_t i = 0; i < count;)
+    {
+        if (position == available)
+        {
+            available = 2 * rand_utils_refill(lanes, buffer, (count - i + 1) / 2);
+            position = 0;
+        }
+
+        // Map the whole run; one rejected draw sends it through a single compacting pass
+        size_t take = count - i < available - position ? count - i : available - position;
+        if (!frequent && !s_to_u32(buffer, position, take, out + i, min, (uint32_t)range, threshold))
+        {
+            i += take;
+        }
+        else
+        {
+            i += s_compact_u32(buffer, position, take, out + i, min, (uint32_t)range, threshold);
+        }
+        position += take;
+    }
+}
+
+void rand_utils_fill_float(t_rand_utils_lanes* lanes, float* out, size_t count, float min, float max)
+{
+    _Alignas(64) uint64_t buffer[RAND_UTILS_CHUNK];
+
+    if (max <= min)
+    {
+        for (size_t i = 0; i < count; i++) out[i] = min;
+        return;
+    }
+
+    pthread_once(&s_simd_once, rand_utils_simd_init);
+
+    for (size_t i = 0; i < count;)
+    {
+        size_t raw = rand_utils_refill(lanes, buffer, (count - i + 1) / 2);
+        size_t take = count - i < 2 * raw ? count - i : 2 * raw;
+
+        s_to_float(buffer, take, out + i, min, max);
+        i += take;
+    }
+}
+
+void rand_utils_fill_double(t_rand_utils_lanes* lanes, double* out, size_t count, double min, double max)
+{
+    _Alignas(64) uint64_t buffer[RAND_UTILS_CHUNK];
+
+    if (max <= min)
+    {
+        for (size_t i = 0; i < count; i++) out[i] = min;
+        return;
+    }
+
+    pthread_once(&s_simd_once, rand_utils_simd_init);
+
+    for (size_t i = 0; i < count;)
+    {
+        size_t raw = rand_utils_refill(lanes, buffer, count - i);
+        size_t take = count - i < raw ? count - i : raw;
+
+        s_to_double(buffer, take, out + i, min, max);
+        i += take;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* Distributions                                                              */
+/* -------------------------------------------------------------------------- */
+
+/*
+ * Ziggurat tables (Marsaglia and Tsang), 256 layers of equal area under the
+ * density. Layer i is accepted at once when the magnitude bits fall below
+ * k[i]; w[i] scales them to x, and f[i] is the density at the layer edge.
+ * Layer 0 is the base strip, which also covers the tail beyond R.
+ */
+#define RAND_UTILS_ZIGGURAT_LAYERS 256
+
+#define RAND_UTILS_NORMAL_R      3.6541528853610088
+#define RAND_UTILS_NORMAL_AREA   4.928673233974655e-3
+#define RAND_UTILS_EXPONENTIAL_R 7.697117470131050
+#define RAND_UTILS_EXPONENTIAL_AREA 3.949659822581572e-3
+
+typedef struct t_rand_utils_ziggurat
+{
+    uint64_t k[RAND_UTILS_ZIGGURAT_LAYERS];
+    double   w[RAND_UTILS_ZIGGURAT_LAYERS];
+    double   f[RAND_UTILS_ZIGGURAT_LAYERS];
+} t_rand_utils_ziggurat;
+
+static t_rand_utils_ziggurat s_normal;
+static t_rand_utils_ziggurat s_exponential;
+static pthread_once_t s_ziggurat_once = PTHREAD_ONCE_INIT;
+
+// Builds the layers of a decreasing density from the right edge r and the layer area, for magnitudes below scale
+static void rand_utils_ziggurat_build(t_rand_utils_ziggurat* table, double r, double area, double scale,
+                                      double (*density)(double), double (*inverse)(double))
+{
+    const int n = RAND_UTILS_ZIGGURAT_LAYERS;
+    double x = r;
+    double previous = r;
+    double base = area / density(r);  // Width of the base strip, tail included
+
+    table->k[0] = (uint64_t)(r / base * scale);
+    table->k[1] = 0;
+    table->w[0] = base / scale;
+    table->w[n - 1] = r / scale;
+    table->f[0] = 1.0;
+    table->f[n - 1] = density(r);
+
+    for (int i = n - 2; i >= 1; i--)
+    {
+        x = inverse(area / x + density(x));
+        table->k[i + 1] = (uint64_t)(x / previous * scale);
+        previous = x;
+        table->f[i] = density(x);
+        table->w[i] = x / scale;
+    }
+}
+
+static double rand_utils_normal_density(double x)
+{
+    return exp(-0.5 * x * x);
+}
+
+static double rand_utils_normal_inverse(double y)
+{
+    return sqrt(-2.0 * log(y));
+}
+
+static double rand_utils_exponential_density(double x)
+{
+    return exp(-x);
+}
+
+static double rand_utils_exponential_inverse(double y)
+{
+    return -log(y);
+}
+
+static void rand_utils_ziggurat_init(void)
+{
+    rand_utils_ziggurat_build(&s_normal, RAND_UTILS_NORMAL_R, RAND_UTILS_NORMAL_AREA, 0x1.0p53,
+                              rand_utils_normal_density, rand_utils_normal_inverse);
+    rand_utils_ziggurat_build(&s_exponential, RAND_UTILS_EXPONENTIAL_R, RAND_UTILS_EXPONENTIAL_AREA, 0x1.0p56,
+                              rand_utils_exponential_density, rand_utils_exponential_inverse);
+}
+
+// Uniform in (0, 1], safe for log()
+static double rand_utils_open_unit(t_rand_utils_state* state)
+{
+    return (double)((rand_utils_state_next(state) >> 11) + 1) * 0x1.0p-53;
+}
+
+static double rand_utils_unit(t_rand_utils_state* state)
+{
+    return (double)(rand_utils_state_next(state) >> 11) * 0x1.0p-53;
+}
+
+double rand_utils_state_normal(t_rand_utils_state* state, double mean, double stddev)
+{
+    pthread_once(&s_ziggurat_once, rand_utils_ziggurat_init);
+
+    for (;;)
+    {
+        // Bits 0-7: layer, bit 8: sign, bits 11-63: magnitude
+        uint64_t bits = rand_utils_state_next(state);
+        size_t layer = bits & 0xff;
+        double sign = bits & 0x100 ? -stddev : stddev;
+        uint64_t magnitude = bits >> 11;
+        double x = (double)(int64_t)magnitude * s_normal.w[layer];
+
+        if (magnitude < s_normal.k[layer]) return mean + sign * x;
+
+        if (layer == 0)
+        {
+            // Tail beyond R (Marsaglia's method)
+            double tail, y;
+            do
+            {
+                tail = -log(rand_utils_open_unit(state)) / RAND_UTILS_NORMAL_R;
+                y = -log(rand_utils_open_unit(state));
+            } while (y + y < tail * tail);
+
+            return mean + sign * (RAND_UTILS_NORMAL_R + tail);
+        }
+
+        // Wedge between the layer rectangle and the curve
+        double f = s_normal.f[layer];
+        if (f + rand_utils_unit(state) * (s_normal.f[layer - 1] - f) < exp(-0.5 * x * x)) return mean + sign * x;
+    }
+}
+
+static double rand_utils_standard_exponential(t_rand_utils_state* state)
+{
+    pthread_once(&s_ziggurat_once, rand_utils_ziggurat_init);
+
+    for (;;)
+    {
+        // Bits 0-7: layer, bits 8-63: magnitude
+        uint64_t bits = rand_utils_state_next(state);
+        size_t layer = bits & 0xff;
+        uint64_t magnitude = bits >> 8;
+        double x = (double)(int64_t)magnitude * s_exponential.w[layer];
+
+        if (magnitude < s_exponential.k[layer]) return x;
+
+        // The tail is the distribution itself, shifted by R
+        if (layer == 0) return RAND_UTILS_EXPONENTIAL_R - log(rand_utils_open_unit(state));
+
+        double f = s_exponential.f[layer];
+        if (f + rand_utils_unit(state) * (s_exponential.f[layer - 1] - f) < exp(-x)) return x;
+    }
+}
+
+double rand_utils_state_exponential(t_rand_utils_state* state, double rate)
+{
+    return rand_utils_standard_exponential(state) / rate;
+}
+
+uint64_t rand_utils_state_poisson(t_rand_utils_state* state, double mean)
+{
+    if (!(mean > 0.0)) return 0;
+
+    if (mean < 10.0)
+    {
+        // Count uniforms until their product drops below e^-mean
+        double limit = exp(-mean);
+        double product = rand_utils_open_unit(state);
+        uint64_t k = 0;
+
+        while (product > limit)
+        {
+            product *= rand_utils_open_unit(state);
+            k++;
+        }
+        return k;
+    }
+
+    // PTRS: transformed rejection with squeeze (Hormann, 1993)
+    double root = sqrt(mean);
+    double log_mean = log(mean);
+    double b = 0.931 + 2.53 * root;
+    double a = -0.059 + 0.02483 * b;
+    double inverse_alpha = 1.1239 + 1.1328 / (b - 3.4);
+    double squeeze = 0.9277 - 3.6224 / (b - 2.0);
+
+    for (;;)
+    {
+        double u = rand_utils_unit(state) - 0.5;
+        double v = rand_utils_unit(state);
+        double us = 0.5 - fabs(u);
+        double k = floor((2.0 * a / us + b) * u + mean + 0.43);
+
+        if (us >= 0.07 && v <= squeeze) return (uint64_t)k;
+        if (k < 0.0 || (us < 0.013 && v > us)) continue;
+
+        if (log(v) + log(inverse_alpha) - log(a / (us * us) + b) <= -mean + k * log_mean - lgamma(k + 1.0))
+        {
+            return (uint64_t)k;
+        }
+    }
+}
+
+uint64_t rand_utils_state_geometric(t_rand_utils_state* state, double p)
+{
+    if (p >= 1.0) return 1;
+    if (!(p > 0.0)) return UINT64_MAX;
+
+    double trials = ceil(log(rand_utils_open_unit(state)) / log1p(-p));
+    if (trials < 1.0) return 1;
+    return trials < 0x1.0p64 ? (uint64_t)trials : UINT64_MAX;
+}
+
+double rand_utils_normal(double mean, double stddev)
+{
+    return rand_utils_state_normal(rand_utils_thread_state(), mean, stddev);
+}
+
+double rand_utils_exponential(double rate)
+{
+    return rand_utils_state_exponential(rand_utils_thread_state(), rate);
+}
+
+uint64_t rand_utils_poisson(double mean)
+{
+    return rand_utils_state_poisson(rand_utils_thread_state(), mean);
+}
+
+uint64_t rand_utils_geometric(double p)
+{
+    return rand_utils_state_geometric(rand_utils_thread_state(), p);
+}
+
+/*
+ * Alias table: column i keeps category i with probability threshold / 2^64
+ * and yields alias otherwise. Both fields share one 16-byte entry, so a
+ * sample touches a single cache line.
+ */
+typedef struct t_rand_utils_alias_entry
+{
+    uint64_t threshold;
+    size_t   alias;
+} t_rand_utils_alias_entry;
+
+typedef struct t_rand_utils_alias
+{
+    size_t                   count;
+    t_rand_utils_alias_entry entries[];
+} t_rand_utils_alias;
+
+t_rand_utils_alias* rand_utils_alias_new(const double* weights, size_t count)
+{
+    if (!weights || count == 0 || count > SIZE_MAX / 2 / sizeof(t_rand_utils_alias_entry)) return NULL;
+
+    double total = 0.0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!(weights[i] >= 0.0) || isinf(weights[i])) return NULL;
+        total += weights[i];
+    }
+    if (!(total > 0.0) || isinf(total)) return NULL;
+
+    t_rand_utils_alias* alias = malloc(sizeof(t_rand_utils_alias) + count * sizeof(t_rand_utils_alias_entry));
+    double* scaled = malloc(count * sizeof(double));
+    size_t* work = malloc(count * sizeof(size_t));
+    if (!alias || !scaled || !work)
+    {
+        free(alias);
+        free(scaled);
+        free(work);
+        return NULL;
+    }
+
+    // Vose: scaled weights average 1; small ones (< 1) are topped up by large ones.
+    // work holds the small indices from the front and the large ones from the back
+    size_t small = 0;
+    size_t large = count;
+    for (size_t i = 0; i < count; i++)
+    {
+        scaled[i] = weights[i] * (double)count / total;
+        if (scaled[i] < 1.0) work[small++] = i;
+        else work[--large] = i;
+    }
+
+    alias->count = count;
+    while (small > 0 && large < count)
+    {
+        size_t less = work[--small];
+        size_t more = work[large];
+
+        // Rounding can leave a topped-up column slightly below zero
+        alias->entries[less].threshold = scaled[less] > 0.0 ? (uint64_t)(scaled[less] * 0x1.0p64) : 0;
+        alias->entries[less].alias = more;
+
+        scaled[more] -= 1.0 - scaled[less];
+        if (scaled[more] < 1.0)
+        {
+            large++;
+            work[small++] = more;
+        }
+    }
+
+    // Leftovers are 1 up to rounding: always keep them
+    while (large < count)
+    {
+        size_t i = work[large++];
+        alias->entries[i].threshold = UINT64_MAX;
+        alias->entries[i].alias = i;
+    }
+    while (small > 0)
+    {
+        size_t i = work[--small];
+        alias->entries[i].threshold = UINT64_MAX;
+        alias->entries[i].alias = i;
+    }
+
+    free(scaled);
+    free(work);
+    return alias;
+}
+
+void rand_utils_alias_free(t_rand_utils_alias* alias)
+{
+    free(alias);
+}
+
+size_t rand_utils_alias_sample(const t_rand_utils_alias* alias, t_rand_utils_state* state)
+{
+    if (!state) state = rand_utils_thread_state();
+
+    // The high half of bits * count picks the column, the low half is a uniform fraction for the coin
+    uint64_t low;
+    uint64_t column = rand_utils_multiply_128(rand_utils_state_next(state), alias->count, &low);
+    const t_rand_utils_alias_entry* entry = &alias->entries[column];
+
+    return low < entry->threshold ? (size_t)column : entry->alias;
 }
@@ -0,0 +1,1398 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spatial_utils.h"
+
+// Marks absent ids, leaves (no children) and leaves without points (no slab)
+#define SPATIAL_UTILS_NONE UINT32_MAX
+
+// k-nearest queries keep up to this many candidates on the stack before allocating
+#define SPATIAL_UTILS_LOCAL_CANDIDATES 64
+
+// Cell coordinates are clamped to +-2^30, so ring and range arithmetic cannot overflow
+#define SPATIAL_UTILS_GRID_CELL_LIMIT 1073741824.0f
+
+// The bucket table has at least 2^6 buckets, and is grown past two points per bucket
+#define SPATIAL_UTILS_GRID_MIN_BITS 6
+#define SPATIAL_UTILS_GRID_LOAD     2
+
+// Room given to a bucket the first time it outgrows its run of entries
+#define SPATIAL_UTILS_GRID_MIN_BUCKET 4
+
+// Queries over at most this many cells skip buckets already seen instead of checking the cell of each point
+#define SPATIAL_UTILS_GRID_SMALL_QUERY 64
+
+// Points per leaf, levels a leaf may be split below the root, and levels the root may grow to
+#define SPATIAL_UTILS_QUADTREE_LEAF   16
+#define SPATIAL_UTILS_QUADTREE_DEPTH  20
+#define SPATIAL_UTILS_QUADTREE_HEIGHT 256
+
+// Each internal node popped pushes four children: three more entries per level
+#define SPATIAL_UTILS_QUADTREE_STACK (3 * SPATIAL_UTILS_QUADTREE_HEIGHT + 4)
+
+/* -------------------------------------------------------------------------- */
+/* Shared                                                                     */
+/* -------------------------------------------------------------------------- */
+
+typedef struct t_spatial_utils_entry
+{
+    float    x;
+    float    y;
+    uint32_t id;
+} t_spatial_utils_entry;
+
+// Where an id lives: grid bucket or quadtree leaf, and slot within it
+typedef struct t_spatial_utils_location
+{
+    uint32_t container;
+    uint32_t slot;
+} t_spatial_utils_location;
+
+// What radius and box queries accept: points inside the box and, for radius queries, inside the circle
+typedef struct t_spatial_utils_filter
+{
+    float min_x;
+    float min_y;
+    float max_x;
+    float max_y;
+    float center_x;
+    float center_y;
+    float radius_squared;
+    bool  circle;
+} t_spatial_utils_filter;
+
+// Candidate of a k-nearest query, by squared distance
+typedef struct t_spatial_utils_candidate
+{
+    float    distance;
+    uint32_t id;
+} t_spatial_utils_candidate;
+
+// Max-heap of the best candidates so far: the worst of them is on top
+typedef struct t_spatial_utils_heap
+{
+    t_spatial_utils_candidate* items;
+    size_t                     count;
+    size_t                     capacity;
+} t_spatial_utils_heap;
+
+static inline bool spatial_utils_point_valid(t_math_utils_vec2 point)
+{
+    return isfinite(point.x) && isfinite(point.y);
+}
+
+static bool spatial_utils_locations_reserve(t_spatial_utils_location** locations, size_t* capacity, size_t count)
+{
+    if (count <= *capacity) return true;
+
+    size_t grown = *capacity < 64 ? 64 : *capacity * 2;
+    if (grown < count) grown = count;
+    if (grown > SIZE_MAX / sizeof(t_spatial_utils_location)) return false;
+
+    t_spatial_utils_location* resized = realloc(*locations, grown * sizeof(t_spatial_utils_location));
+    if (!resized) return false;
+
+    for (size_t i = *capacity; i < grown; i++) resized[i].container = SPATIAL_UTILS_NONE;
+    *locations = resized;
+    *capacity = grown;
+    return true;
+}
+
+static inline bool spatial_utils_location_present(const t_spatial_utils_location* locations, size_t capacity, uint32_t id)
+{
+    return id < capacity && locations[id].container != SPATIAL_UTILS_NONE;
+}
+
+static bool spatial_utils_filter_radius(t_spatial_utils_filter* filter, t_math_utils_vec2 center, float radius)
+{
+    if (!spatial_utils_point_valid(center) || !(radius >= 0.0f)) return false;
+
+    *filter = (t_spatial_utils_filter) { center.x - radius, center.y - radius, center.x + radius, center.y + radius,
+                                         center.x, center.y, radius * radius, true };
+    return true;
+}
+
+static bool spatial_utils_filter_box(t_spatial_utils_filter* filter, t_math_utils_vec2 min, t_math_utils_vec2 max)
+{
+    // Also false for NaN bounds
+    if (!(min.x <= max.x) || !(min.y <= max.y)) return false;
+
+    *filter = (t_spatial_utils_filter) { min.x, min.y, max.x, max.y, 0.0f, 0.0f, 0.0f, false };
+    return true;
+}
+
+static inline bool spatial_utils_filter_accepts(const t_spatial_utils_filter* filter, float x, float y)
+{
+    if (x < filter->min_x || x > filter->max_x || y < filter->min_y || y > filter->max_y) return false;
+    if (!filter->circle) return true;
+
+    float dx = x - filter->center_x;
+    float dy = y - filter->center_y;
+    return dx * dx + dy * dy <= filter->radius_squared;
+}
+
+// Squared distance from (x, y) to the box, 0 inside it
+static inline float spatial_utils_box_distance(float min_x, float min_y, float max_x, float max_y, float x, float y)
+{
+    float dx = x < min_x ? min_x - x : x > max_x ? x - max_x : 0.0f;
+    float dy = y < min_y ? min_y - y : y > max_y ? y - max_y : 0.0f;
+    return dx * dx + dy * dy;
+}
+
+static inline void spatial_utils_emit(uint32_t* out, size_t capacity, size_t* found, uint32_t id)
+{
+    if (*found < capacity) out[*found] = id;
+    (*found)++;
+}
+
+static bool spatial_utils_heap_init(t_spatial_utils_heap* heap, t_spatial_utils_candidate* local, size_t capacity)
+{
+    heap->count = 0;
+    heap->capacity = capacity;
+    heap->items = capacity <= SPATIAL_UTILS_LOCAL_CANDIDATES ? local : malloc(capacity * sizeof(t_spatial_utils_candidate));
+    return heap->items != NULL;
+}
+
+static void spatial_utils_heap_release(t_spatial_utils_heap* heap, t_spatial_utils_candidate* local)
+{
+    if (heap->items != local) free(heap->items);
+}
+
+static void spatial_utils_heap_sift_down(t_spatial_utils_candidate* items, size_t count, size_t index)
+{
+    t_spatial_utils_candidate item = items[index];
+
+    for (;;)
+    {
+        size_t child = 2 * index + 1;
+        if (child >= count) break;
+        if (child + 1 < count && items[child + 1].distance > items[child].distance) child++;
+        if (items[child].distance <= item.distance) break;
+
+        items[index] = items[child];
+        index = child;
+    }
+
+    items[index] = item;
+}
+
+// Squared distance a candidate must beat to be kept
+static inline float spatial_utils_heap_worst(const t_spatial_utils_heap* heap)
+{
+    return heap->count < heap->capacity ? INFINITY : heap->items[0].distance;
+}
+
+// Whether spatial_utils_heap_offer() would keep a candidate; an infinite distance fills a heap that is not full
+static inline bool spatial_utils_heap_accepts(const t_spatial_utils_heap* heap, float distance)
+{
+    return heap->count < heap->capacity || distance < heap->items[0].distance;
+}
+
+static inline void spatial_utils_heap_offer(t_spatial_utils_heap* heap, float distance, uint32_t id)
+{
+    if (heap->count < heap->capacity)
+    {
+        size_t index = heap->count++;
+        while (index > 0)
+        {
+            size_t parent = (index - 1) / 2;
+            if (heap->items[parent].distance >= distance) break;
+
+            heap->items[index] = heap->items[parent];
+            index = parent;
+        }
+        heap->items[index] = (t_spatial_utils_candidate) { distance, id };
+    }
+    else if (distance < heap->items[0].distance)
+    {
+        heap->items[0] = (t_spatial_utils_candidate) { distance, id };
+        spatial_utils_heap_sift_down(heap->items, heap->count, 0);
+    }
+}
+
+// Sorts the candidates nearest first, in place, and writes them out
+static size_t spatial_utils_heap_finish(t_spatial_utils_heap* heap, uint32_t* out, float* distances)
+{
+    for (size_t end = heap->count; end > 1; end--)
+    {
+        t_spatial_utils_candidate worst = heap->items[0];
+        heap->items[0] = heap->items[end - 1];
+        heap->items[end - 1] = worst;
+        spatial_utils_heap_sift_down(heap->items, end - 1, 0);
+    }
+
+    for (size_t i = 0; i < heap->count; i++)
+    {
+        out[i] = heap->items[i].id;
+        if (distances) distances[i] = sqrtf(heap->items[i].distance);
+    }
+
+    return heap->count;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Uniform hash grid                                                          */
+/* -------------------------------------------------------------------------- */
+
+/*
+ * Cells hash into a power-of-two table of buckets. The points of a bucket
+ * are one contiguous run of entries, so a query scans a few short arrays.
+ * A bucket that outgrows its run moves to the end of the entries with
+ * twice the room; once most entries are gaps left behind by such moves,
+ * everything is laid out again with a counting sort. Points of different
+ * cells may share a bucket: queries test every point they scan.
+ */
+typedef struct t_spatial_utils_bucket
+{
+    uint32_t start;
+    uint32_t count;
+    uint32_t capacity;
+} t_spatial_utils_bucket;
+
+typedef struct t_spatial_utils_grid
+{
+    float                     cell_size;
+    float                     inverse_cell_size;
+    t_spatial_utils_bucket*   buckets;
+    unsigned                  bucket_bits;
+    t_spatial_utils_entry*    entries;
+    size_t                    entries_used;
+    size_t                    entries_capacity;
+    t_spatial_utils_location* locations;
+    size_t                    locations_capacity;
+    size_t                    count;
+
+    // Cells that may hold points: exact after a layout, only widened by inserts and moves
+    int32_t min_cell_x;
+    int32_t min_cell_y;
+    int32_t max_cell_x;
+    int32_t max_cell_y;
+} t_spatial_utils_grid;
+
+static inline int32_t spatial_utils_grid_cell(const t_spatial_utils_grid* grid, float value)
+{
+    float scaled = value * grid->inverse_cell_size;
+    if (scaled < -SPATIAL_UTILS_GRID_CELL_LIMIT) scaled = -SPATIAL_UTILS_GRID_CELL_LIMIT;
+    if (scaled > SPATIAL_UTILS_GRID_CELL_LIMIT) scaled = SPATIAL_UTILS_GRID_CELL_LIMIT;
+
+    // Floor without a libm call
+    int32_t cell = (int32_t)scaled;
+    return cell - ((float)cell > scaled);
+}
+
+// Fibonacci hashing: the top bits of the product depend on every bit of both coordinates
+static inline size_t spatial_utils_grid_hash(int32_t cell_x, int32_t cell_y, unsigned bits)
+{
+    uint64_t key = (uint64_t)(uint32_t)cell_x << 32 | (uint32_t)cell_y;
+    return (size_t)((key * 0x9e3779b97f4a7c15ull) >> (64 - bits));
+}
+
+static inline size_t spatial_utils_grid_bucket(const t_spatial_utils_grid* grid, float x, float y)
+{
+    return spatial_utils_grid_hash(spatial_utils_grid_cell(grid, x), spatial_utils_grid_cell(grid, y), grid->bucket_bits);
+}
+
+static void spatial_utils_grid_widen(t_spatial_utils_grid* grid, float x, float y)
+{
+    int32_t cell_x = spatial_utils_grid_cell(grid, x);
+    int32_t cell_y = spatial_utils_grid_cell(grid, y);
+
+    if (cell_x < grid->min_cell_x) grid->min_cell_x = cell_x;
+    if (cell_x > grid->max_cell_x) grid->max_cell_x = cell_x;
+    if (cell_y < grid->min_cell_y) grid->min_cell_y = cell_y;
+    if (cell_y > grid->max_cell_y) grid->max_cell_y = cell_y;
+}
+
+// Smallest table with at least one bucket per point
+static unsigned spatial_utils_grid_bits(size_t count)
+{
+    unsigned bits = SPATIAL_UTILS_GRID_MIN_BITS;
+    while (bits < 32 && ((size_t)1 << bits) < count) bits++;
+    return bits;
+}
+
+// Replaces the layout with source[0..count) in a table of 2^bits buckets; the grid is unchanged on failure
+static bool spatial_utils_grid_layout(t_spatial_utils_grid* grid, const t_spatial_utils_entry* source, size_t count,
+                                      unsigned bits)
+{
+    size_t bucket_count = (size_t)1 << bits;
+    size_t capacity = count + count / 4 + 64;
+    if (capacity > UINT32_MAX) return false;
+
+    t_spatial_utils_bucket* buckets = calloc(bucket_count, sizeof(t_spatial_utils_bucket));
+    t_spatial_utils_entry* entries = malloc(capacity * sizeof(t_spatial_utils_entry));
+    if (!buckets || !entries)
+    {
+        free(buckets);
+        free(entries);
+        return false;
+    }
+
+    // Counting sort: sizes, then starts, then placement
+    for (size_t i = 0; i < count; i++)
+    {
+        buckets[spatial_utils_grid_hash(spatial_utils_grid_cell(grid, source[i].x),
+                                        spatial_utils_grid_cell(grid, source[i].y), bits)].count++;
+    }
+
+    uint32_t start = 0;
+    for (size_t b = 0; b < bucket_count; b++)
+    {
+        buckets[b].start = start;
+        buckets[b].capacity = buckets[b].count;
+        start += buckets[b].count;
+        buckets[b].count = 0;
+    }
+
+    grid->min_cell_x = grid->min_cell_y = INT32_MAX;
+    grid->max_cell_x = grid->max_cell_y = INT32_MIN;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        t_spatial_utils_bucket* bucket = &buckets[spatial_utils_grid_hash(spatial_utils_grid_cell(grid, source[i].x),
+                                                                          spatial_utils_grid_cell(grid, source[i].y), bits)];
+        uint32_t slot = bucket->count++;
+
+        entries[bucket->start + slot] = source[i];
+        grid->locations[source[i].id] = (t_spatial_utils_location) { (uint32_t)(bucket - buckets), slot };
+        spatial_utils_grid_widen(grid, source[i].x, source[i].y);
+    }
+
+    free(grid->buckets);
+    free(grid->entries);
+    grid->buckets = buckets;
+    grid->bucket_bits = bits;
+    grid->entries = entries;
+    grid->entries_used = count;
+    grid->entries_capacity = capacity;
+    grid->count = count;
+    return true;
+}
+
+// Lays the current points out again, compacting the entries, in a table of 2^bits buckets
+static bool spatial_utils_grid_rehash(t_spatial_utils_grid* grid, unsigned bits)
+{
+    t_spatial_utils_entry* live = malloc((grid->count ? grid->count : 1) * sizeof(t_spatial_utils_entry));
+    if (!live) return false;
+
+    size_t count = 0;
+    for (size_t b = 0; grid->buckets && b < ((size_t)1 << grid->bucket_bits); b++)
+    {
+        const t_spatial_utils_bucket* bucket = &grid->buckets[b];
+        memcpy(live + count, grid->entries + bucket->start, bucket->count * sizeof(t_spatial_utils_entry));
+        count += bucket->count;
+    }
+
+    bool laid_out = spatial_utils_grid_layout(grid, live, count, bits);
+    free(live);
+    return laid_out;
+}
+
+// Makes room for one more point in a bucket, moving it to the end of the entries when full
+static bool spatial_utils_grid_make_room(t_spatial_utils_grid* grid, size_t index)
+{
+    if (grid->buckets[index].count < grid->buckets[index].capacity) return true;
+
+    // Mostly gaps: compact first, which may leave the bucket full still
+    if (grid->entries_used > 2 * grid->count + 1024)
+    {
+        if (!spatial_utils_grid_rehash(grid, grid->bucket_bits)) return false;
+        if (grid->buckets[index].count < grid->buckets[index].capacity) return true;
+    }
+
+    t_spatial_utils_bucket* bucket = &grid->buckets[index];
+    size_t capacity = bucket->capacity < SPATIAL_UTILS_GRID_MIN_BUCKET ? SPATIAL_UTILS_GRID_MIN_BUCKET
+                                                                        : 2 * (size_t)bucket->capacity;
+    size_t used = grid->entries_used + capacity;
+    if (used > UINT32_MAX) return false;
+
+    if (used > grid->entries_capacity)
+    {
+        size_t grown = 2 * grid->entries_capacity;
+        if (grown < used) grown = used;
+        if (grown > UINT32_MAX) grown = UINT32_MAX;
+
+        t_spatial_utils_entry* entries = realloc(grid->entries, grown * sizeof(t_spatial_utils_entry));
+        if (!entries) return false;
+
+        grid->entries = entries;
+        grid->entries_capacity = grown;
+    }
+
+    // Slots are relative to the start, so locations stay valid
+    memcpy(grid->entries + grid->entries_used, grid->entries + bucket->start, bucket->count * sizeof(t_spatial_utils_entry));
+    bucket->start = (uint32_t)grid->entries_used;
+    bucket->capacity = (uint32_t)capacity;
+    grid->entries_used = used;
+    return true;
+}
+
+// Adds a point to a bucket with room
+static void spatial_utils_grid_place(t_spatial_utils_grid* grid, size_t index, uint32_t id, t_math_utils_vec2 point)
+{
+    t_spatial_utils_bucket* bucket = &grid->buckets[index];
+    uint32_t slot = bucket->count++;
+
+    grid->entries[bucket->start + slot] = (t_spatial_utils_entry) { point.x, point.y, id };
+    grid->locations[id] = (t_spatial_utils_location) { (uint32_t)index, slot };
+    grid->count++;
+    spatial_utils_grid_widen(grid, point.x, point.y);
+}
+
+// Takes a present point out of its bucket, filling its slot with the bucket's last point
+static void spatial_utils_grid_detach(t_spatial_utils_grid* grid, uint32_t id)
+{
+    t_spatial_utils_location location = grid->locations[id];
+    t_spatial_utils_bucket* bucket = &grid->buckets[location.container];
+    uint32_t last = --bucket->count;
+
+    if (location.slot != last)
+    {
+        t_spatial_utils_entry moved = grid->entries[bucket->start + last];
+        grid->entries[bucket->start + location.slot] = moved;
+        grid->locations[moved.id].slot = location.slot;
+    }
+
+    grid->locations[id].container = SPATIAL_UTILS_NONE;
+    grid->count--;
+}
+
+t_spatial_utils_grid* spatial_utils_grid_new(float cell_size)
+{
+    if (!(cell_size > 0.0f) || !isfinite(1.0f / cell_size) || isinf(cell_size)) return NULL;
+
+    t_spatial_utils_grid* grid = calloc(1, sizeof(t_spatial_utils_grid));
+    if (!grid) return NULL;
+
+    grid->cell_size = cell_size;
+    grid->inverse_cell_size = 1.0f / cell_size;
+    if (!spatial_utils_grid_layout(grid, NULL, 0, SPATIAL_UTILS_GRID_MIN_BITS))
+    {
+        free(grid);
+        return NULL;
+    }
+
+    return grid;
+}
+
+void spatial_utils_grid_free(t_spatial_utils_grid* grid)
+{
+    if (!grid) return;
+
+    free(grid->buckets);
+    free(grid->entries);
+    free(grid->locations);
+    free(grid);
+}
+
+bool spatial_utils_grid_build(t_spatial_utils_grid* grid, const t_math_utils_vec2* points, size_t count)
+{
+    for (size_t i = 0; i < grid->locations_capacity; i++) grid->locations[i].container = SPATIAL_UTILS_NONE;
+
+    t_spatial_utils_entry* source = NULL;
+    size_t valid = 0;
+    bool built = count <= UINT32_MAX
+              && spatial_utils_locations_reserve(&grid->locations, &grid->locations_capacity, count)
+              && (source = malloc((count ? count : 1) * sizeof(t_spatial_utils_entry))) != NULL;
+
+    if (built)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (spatial_utils_point_valid(points[i])) source[valid++] = (t_spatial_utils_entry) { points[i].x, points[i].y, (uint32_t)i };
+        }
+        built = spatial_utils_grid_layout(grid, source, valid, spatial_utils_grid_bits(valid));
+    }
+    free(source);
+
+    // Failed: leave the grid empty, with a table to insert into if one can be had
+    if (!built && !spatial_utils_grid_layout(grid, NULL, 0, SPATIAL_UTILS_GRID_MIN_BITS))
+    {
+        for (size_t b = 0; b < ((size_t)1 << grid->bucket_bits); b++) grid->buckets[b].count = 0;
+        grid->count = 0;
+    }
+
+    return built;
+}
+
+bool spatial_utils_grid_insert(t_spatial_utils_grid* grid, uint32_t id, t_math_utils_vec2 point)
+{
+    if (!spatial_utils_point_valid(point) || id == SPATIAL_UTILS_NONE) return false;
+    if (spatial_utils_location_present(grid->locations, grid->locations_capacity, id)) return false;
+    if (!spatial_utils_locations_reserve(&grid->locations, &grid->locations_capacity, (size_t)id + 1)) return false;
+
+    if (grid->count >= (size_t)SPATIAL_UTILS_GRID_LOAD << grid->bucket_bits && grid->bucket_bits < 32
+        && !spatial_utils_grid_rehash(grid, spatial_utils_grid_bits(grid->count + 1)))
+    {
+        return false;
+    }
+
+    size_t index = spatial_utils_grid_bucket(grid, point.x, point.y);
+    if (!spatial_utils_grid_make_room(grid, index)) return false;
+
+    spatial_utils_grid_place(grid, index, id, point);
+    return true;
+}
+
+bool spatial_utils_grid_update(t_spatial_utils_grid* grid, uint32_t id, t_math_utils_vec2 point)
+{
+    if (!spatial_utils_point_valid(point)) return false;
+    if (!spatial_utils_location_present(grid->locations, grid->locations_capacity, id)) return false;
+
+    t_spatial_utils_location location = grid->locations[id];
+    size_t index = spatial_utils_grid_bucket(grid, point.x, point.y);
+
+    if (index == location.container)
+    {
+        t_spatial_utils_entry* entry = &grid->entries[grid->buckets[index].start + location.slot];
+        entry->x = point.x;
+        entry->y = point.y;
+        spatial_utils_grid_widen(grid, point.x, point.y);
+        return true;
+    }
+
+    // Room first, so a failure leaves the point where it was
+    if (!spatial_utils_grid_make_room(grid, index)) return false;
+
+    spatial_utils_grid_detach(grid, id);
+    spatial_utils_grid_place(grid, index, id, point);
+    return true;
+}
+
+bool spatial_utils_grid_remove(t_spatial_utils_grid* grid, uint32_t id)
+{
+    if (!spatial_utils_location_present(grid->locations, grid->locations_capacity, id)) return false;
+
+    spatial_utils_grid_detach(grid, id);
+    return true;
+}
+
+size_t spatial_utils_grid_count(const t_spatial_utils_grid* grid)
+{
+    return grid->count;
+}
+
+static size_t spatial_utils_grid_scan(const t_spatial_utils_grid* grid, size_t index, const t_spatial_utils_filter* filter,
+                                      uint32_t* out, size_t capacity, size_t found)
+{
+    const t_spatial_utils_bucket* bucket = &grid->buckets[index];
+    const t_spatial_utils_entry* entries = grid->entries + bucket->start;
+
+    for (uint32_t i = 0; i < bucket->count; i++)
+    {
+        if (spatial_utils_filter_accepts(filter, entries[i].x, entries[i].y)) spatial_utils_emit(out, capacity, &found, entries[i].id);
+    }
+
+    return found;
+}
+
+/*
+ * A bucket holding several cells of the range must be scanned once only.
+ * Small ranges remember the buckets they scanned; larger ones keep only
+ * the points of the cell being visited; ranges with more cells than there
+ * are buckets scan every bucket once. A point the filter accepts always
+ * lies in a cell of the range, so none of them are missed.
+ */
+static size_t spatial_utils_grid_collect(const t_spatial_utils_grid* grid, const t_spatial_utils_filter* filter,
+                                         uint32_t* out, size_t capacity)
+{
+    if (grid->count == 0) return 0;
+
+    int64_t min_x = spatial_utils_grid_cell(grid, filter->min_x);
+    int64_t min_y = spatial_utils_grid_cell(grid, filter->min_y);
+    int64_t max_x = spatial_utils_grid_cell(grid, filter->max_x);
+    int64_t max_y = spatial_utils_grid_cell(grid, filter->max_y);
+    if (min_x < grid->min_cell_x) min_x = grid->min_cell_x;
+    if (min_y < grid->min_cell_y) min_y = grid->min_cell_y;
+    if (max_x > grid->max_cell_x) max_x = grid->max_cell_x;
+    if (max_y > grid->max_cell_y) max_y = grid->max_cell_y;
+    if (min_x > max_x || min_y > max_y) return 0;
+
+    size_t bucket_count = (size_t)1 << grid->bucket_bits;
+    uint64_t cells = (uint64_t)(max_x - min_x + 1) * (uint64_t)(max_y - min_y + 1);
+    size_t found = 0;
+
+    if (cells >= bucket_count)
+    {
+        for (size_t b = 0; b < bucket_count; b++) found = spatial_utils_grid_scan(grid, b, filter, out, capacity, found);
+    }
+    else if (cells <= SPATIAL_UTILS_GRID_SMALL_QUERY)
+    {
+        size_t seen[SPATIAL_UTILS_GRID_SMALL_QUERY];
+        size_t seen_count = 0;
+
+        for (int64_t y = min_y; y <= max_y; y++)
+        {
+            for (int64_t x = min_x; x <= max_x; x++)
+            {
+                size_t index = spatial_utils_grid_hash((int32_t)x, (int32_t)y, grid->bucket_bits);
+                size_t i = 0;
+                while (i < seen_count && seen[i] != index) i++;
+                if (i < seen_count) continue;
+
+                seen[seen_count++] = index;
+                found = spatial_utils_grid_scan(grid, index, filter, out, capacity, found);
+            }
+        }
+    }
+    else
+    {
+        for (int64_t y = min_y; y <= max_y; y++)
+        {
+            for (int64_t x = min_x; x <= max_x; x++)
+            {
+                const t_spatial_utils_bucket* bucket = &grid->buckets[spatial_utils_grid_hash((int32_t)x, (int32_t)y, grid->bucket_bits)];
+                const t_spatial_utils_entry* entries = grid->entries + bucket->start;
+
+                for (uint32_t i = 0; i < bucket->count; i++)
+                {
+                    if (spatial_utils_filter_accepts(filter, entries[i].x, entries[i].y)
+                        && spatial_utils_grid_cell(grid, entries[i].x) == x && spatial_utils_grid_cell(grid, entries[i].y) == y)
+                    {
+                        spatial_utils_emit(out, capacity, &found, entries[i].id);
+                    }
+                }
+            }
+        }
+    }
+
+    return found;
+}
+
+size_t spatial_utils_grid_query_radius(const t_spatial_utils_grid* grid, t_math_utils_vec2 center, float radius,
+                                       uint32_t* out, size_t capacity)
+{
+    t_spatial_utils_filter filter;
+    if (!spatial_utils_filter_radius(&filter, center, radius)) return 0;
+
+    return spatial_utils_grid_collect(grid, &filter, out, capacity);
+}
+
+size_t spatial_utils_grid_query_box(const t_spatial_utils_grid* grid, t_math_utils_vec2 min, t_math_utils_vec2 max,
+                                    uint32_t* out, size_t capacity)
+{
+    t_spatial_utils_filter filter;
+    if (!spatial_utils_filter_box(&filter, min, max)) return 0;
+
+    return spatial_utils_grid_collect(grid, &filter, out, capacity);
+}
+
+// Offers the points of one cell; points of other cells sharing the bucket are offered with their own cell
+static void spatial_utils_grid_offer_cell(const t_spatial_utils_grid* grid, t_spatial_utils_heap* heap,
+                                          int64_t cell_x, int64_t cell_y, t_math_utils_vec2 point)
+{
+    const t_spatial_utils_bucket* bucket = &grid->buckets[spatial_utils_grid_hash((int32_t)cell_x, (int32_t)cell_y, grid->bucket_bits)];
+    const t_spatial_utils_entry* entries = grid->entries + bucket->start;
+
+    for (uint32_t i = 0; i < bucket->count; i++)
+    {
+        float dx = entries[i].x - point.x;
+        float dy = entries[i].y - point.y;
+        float distance = dx * dx + dy * dy;
+
+        if (spatial_utils_heap_accepts(heap, distance)
+            && spatial_utils_grid_cell(grid, entries[i].x) == cell_x && spatial_utils_grid_cell(grid, entries[i].y) == cell_y)
+        {
+            spatial_utils_heap_offer(heap, distance, entries[i].id);
+        }
+    }
+}
+
+/*
+ * Visits square rings of cells around the cell of the point, clipped to
+ * the occupied cells. After ring r every point left is at least r cells
+ * away, so the search stops once the k-th best is within that distance or
+ * the rings cover every occupied cell. Sparse grids, where rings would
+ * visit more cells than there are buckets, fall back to one full scan.
+ */
+size_t spatial_utils_grid_query_nearest(const t_spatial_utils_grid* grid, t_math_utils_vec2 point, size_t k,
+                                        uint32_t* out, float* distances)
+{
+    if (k == 0 || grid->count == 0 || !spatial_utils_point_valid(point)) return 0;
+
+    t_spatial_utils_candidate local[SPATIAL_UTILS_LOCAL_CANDIDATES];
+    t_spatial_utils_heap heap;
+    if (!spatial_utils_heap_init(&heap, local, k < grid->count ? k : grid->count)) return 0;
+
+    int64_t center_x = spatial_utils_grid_cell(grid, point.x);
+    int64_t center_y = spatial_utils_grid_cell(grid, point.y);
+    int64_t min_x = grid->min_cell_x, min_y = grid->min_cell_y;
+    int64_t max_x = grid->max_cell_x, max_y = grid->max_cell_y;
+
+    // Rings nearer than the occupied cells are empty
+    int64_t gap_x = center_x < min_x ? min_x - center_x : center_x > max_x ? center_x - max_x : 0;
+    int64_t gap_y = center_y < min_y ? min_y - center_y : center_y > max_y ? center_y - max_y : 0;
+    int64_t ring = gap_x > gap_y ? gap_x : gap_y;
+
+    size_t bucket_count = (size_t)1 << grid->bucket_bits;
+    uint64_t visited = 0;
+
+    for (;; ring++)
+    {
+        int64_t from_x = center_x - ring < min_x ? min_x : center_x - ring;
+        int64_t to_x = center_x + ring > max_x ? max_x : center_x + ring;
+        int64_t from_y = center_y - ring + 1 < min_y ? min_y : center_y - ring + 1;
+        int64_t to_y = center_y + ring - 1 > max_y ? max_y : center_y + ring - 1;
+
+        // Bottom and top rows, then the left and right columns between them
+        for (int row = 0; row < (ring > 0 ? 2 : 1); row++)
+        {
+            int64_t y = row == 0 ? center_y - ring : center_y + ring;
+            if (y < min_y || y > max_y) continue;
+
+            for (int64_t x = from_x; x <= to_x; x++) spatial_utils_grid_offer_cell(grid, &heap, x, y, point);
+            visited += (uint64_t)(to_x - from_x + 1);
+        }
+        for (int column = 0; ring > 0 && column < 2; column++)
+        {
+            int64_t x = column == 0 ? center_x - ring : center_x + ring;
+            if (x < min_x || x > max_x || from_y > to_y) continue;
+
+            for (int64_t y = from_y; y <= to_y; y++) spatial_utils_grid_offer_cell(grid, &heap, x, y, point);
+            visited += (uint64_t)(to_y - from_y + 1);
+        }
+
+        if (center_x - ring <= min_x && center_x + ring >= max_x && center_y - ring <= min_y && center_y + ring >= max_y) break;
+
+        float reach = (float)ring * grid->cell_size;
+        if (spatial_utils_heap_worst(&heap) <= reach * reach) break;
+
+        if (visited > bucket_count)
+        {
+            heap.count = 0;
+            for (size_t b = 0; b < bucket_count; b++)
+            {
+                const t_spatial_utils_bucket* bucket = &grid->buckets[b];
+                for (uint32_t i = 0; i < bucket->count; i++)
+                {
+                    const t_spatial_utils_entry* entry = &grid->entries[bucket->start + i];
+                    float dx = entry->x - point.x;
+                    float dy = entry->y - point.y;
+                    spatial_utils_heap_offer(&heap, dx * dx + dy * dy, entry->id);
+                }
+            }
+            break;
+        }
+    }
+
+    size_t found = spatial_utils_heap_finish(&heap, out, distances);
+    spatial_utils_heap_release(&heap, local);
+    return found;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Quadtree                                                                   */
+/* -------------------------------------------------------------------------- */
+
+/*
+ * Nodes are half-open boxes [min, max). The children of a node are four
+ * consecutive nodes, quadrant bit 0 set on the right and bit 1 at the top,
+ * and share their inner bounds exactly: a point goes right when x is at
+ * least the lower x of child 1 and up when y is at least the lower y of
+ * child 2. Leaves keep their points in chains of slabs; chains longer than
+ * one slab only form at the depth limit, under many equal points.
+ */
+typedef struct t_spatial_utils_node
+{
+    float    min_x;
+    float    min_y;
+    float    max_x;
+    float    max_y;
+    uint32_t child;
+    uint32_t count;
+    uint32_t slab;
+} t_spatial_utils_node;
+
+typedef struct t_spatial_utils_slab
+{
+    t_spatial_utils_entry entries[SPATIAL_UTILS_QUADTREE_LEAF];
+    uint32_t              next;
+} t_spatial_utils_slab;
+
+typedef struct t_spatial_utils_quadtree
+{
+    t_spatial_utils_node*     nodes;  // nodes[0] is the root, when there is one
+    size_t                    node_count;
+    size_t                    node_capacity;
+    t_spatial_utils_slab*     slabs;
+    size_t                    slab_count;
+    size_t                    slab_capacity;
+    uint32_t                  free_slab;
+    t_spatial_utils_location* locations;
+    size_t                    locations_capacity;
+    size_t                    count;
+    unsigned                  height;  // Deepest level, which bounds the traversal stacks
+} t_spatial_utils_quadtree;
+
+// Room for nodes and slabs more, so that the operation that follows cannot fail
+static bool spatial_utils_quadtree_reserve(t_spatial_utils_quadtree* tree, size_t nodes, size_t slabs)
+{
+    if (tree->node_count + nodes > tree->node_capacity)
+    {
+        size_t grown = tree->node_capacity < 64 ? 64 : tree->node_capacity * 2;
+        if (grown < tree->node_count + nodes) grown = tree->node_count + nodes;
+        if (grown > UINT32_MAX) return false;
+
+        t_spatial_utils_node* resized = realloc(tree->nodes, grown * sizeof(t_spatial_utils_node));
+        if (!resized) return false;
+
+        tree->nodes = resized;
+        tree->node_capacity = grown;
+    }
+
+    if (tree->slab_count + slabs > tree->slab_capacity)
+    {
+        size_t grown = tree->slab_capacity < 16 ? 16 : tree->slab_capacity * 2;
+        if (grown < tree->slab_count + slabs) grown = tree->slab_count + slabs;
+        if (grown > UINT32_MAX) return false;
+
+        t_spatial_utils_slab* resized = realloc(tree->slabs, grown * sizeof(t_spatial_utils_slab));
+        if (!resized) return false;
+
+        tree->slabs = resized;
+        tree->slab_capacity = grown;
+    }
+
+    return true;
+}
+
+static uint32_t spatial_utils_quadtree_slab_new(t_spatial_utils_quadtree* tree)
+{
+    uint32_t index = tree->free_slab;
+
+    if (index != SPATIAL_UTILS_NONE) tree->free_slab = tree->slabs[index].next;
+    else index = (uint32_t)tree->slab_count++;
+
+    tree->slabs[index].next = SPATIAL_UTILS_NONE;
+    return index;
+}
+
+static void spatial_utils_quadtree_slab_release(t_spatial_utils_quadtree* tree, uint32_t index)
+{
+    tree->slabs[index].next = tree->free_slab;
+    tree->free_slab = index;
+}
+
+// Slab holding slot of a leaf
+static uint32_t spatial_utils_quadtree_slab_of(const t_spatial_utils_quadtree* tree, uint32_t node, uint32_t slot)
+{
+    uint32_t slab = tree->nodes[node].slab;
+    for (uint32_t hop = slot / SPATIAL_UTILS_QUADTREE_LEAF; hop > 0; hop--) slab = tree->slabs[slab].next;
+    return slab;
+}
+
+static t_spatial_utils_entry* spatial_utils_quadtree_entry(t_spatial_utils_quadtree* tree, uint32_t node, uint32_t slot)
+{
+    return &tree->slabs[spatial_utils_quadtree_slab_of(tree, node, slot)].entries[slot % SPATIAL_UTILS_QUADTREE_LEAF];
+}
+
+// Appends to a leaf; a slab must be reserved when the leaf's last slab is full
+static void spatial_utils_quadtree_append(t_spatial_utils_quadtree* tree, uint32_t node, t_spatial_utils_entry entry)
+{
+    uint32_t slot = tree->nodes[node].count;
+
+    if (slot % SPATIAL_UTILS_QUADTREE_LEAF == 0)
+    {
+        uint32_t slab = spatial_utils_quadtree_slab_new(tree);
+        if (slot == 0) tree->nodes[node].slab = slab;
+        else tree->slabs[spatial_utils_quadtree_slab_of(tree, node, slot - 1)].next = slab;
+    }
+
+    *spatial_utils_quadtree_entry(tree, node, slot) = entry;
+    tree->nodes[node].count++;
+    tree->locations[entry.id] = (t_spatial_utils_location) { node, slot };
+}
+
+// Gives a leaf four empty children split at (mid_x, mid_y); four nodes must be reserved
+static uint32_t spatial_utils_quadtree_children(t_spatial_utils_quadtree* tree, uint32_t node, float mid_x, float mid_y)
+{
+    const t_spatial_utils_node parent = tree->nodes[node];
+    uint32_t first = (uint32_t)tree->node_count;
+
+    for (uint32_t quadrant = 0; quadrant < 4; quadrant++)
+    {
+        tree->nodes[first + quadrant] = (t_spatial_utils_node) {
+            quadrant & 1 ? mid_x : parent.min_x,
+            quadrant & 2 ? mid_y : parent.min_y,
+            quadrant & 1 ? parent.max_x : mid_x,
+            quadrant & 2 ? parent.max_y : mid_y,
+            SPATIAL_UTILS_NONE, 0, SPATIAL_UTILS_NONE
+        };
+    }
+
+    tree->node_count += 4;
+    tree->nodes[node].child = first;
+    return first;
+}
+
+static uint32_t spatial_utils_quadtree_subdivide(t_spatial_utils_quadtree* tree, uint32_t node)
+{
+    // Halves first: the sum of the bounds could overflow
+    const t_spatial_utils_node* parent = &tree->nodes[node];
+    return spatial_utils_quadtree_children(tree, node, parent->min_x * 0.5f + parent->max_x * 0.5f,
+                                           parent->min_y * 0.5f + parent->max_y * 0.5f);
+}
+
+static inline uint32_t spatial_utils_quadtree_quadrant(const t_spatial_utils_quadtree* tree, uint32_t first, float x, float y)
+{
+    return (uint32_t)(x >= tree->nodes[first + 1].min_x) | (uint32_t)(y >= tree->nodes[first + 2].min_y) << 1;
+}
+
+// Moves the points of a full leaf into four new children; four nodes and four slabs must be reserved
+static void spatial_utils_quadtree_split(t_spatial_utils_quadtree* tree, uint32_t node)
+{
+    uint32_t slab = tree->nodes[node].slab;
+    uint32_t count = tree->nodes[node].count;
+    uint32_t first = spatial_utils_quadtree_subdivide(tree, node);
+
+    tree->nodes[node].count = 0;
+    tree->nodes[node].slab = SPATIAL_UTILS_NONE;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        t_spatial_utils_entry entry = tree->slabs[slab].entries[i];
+        spatial_utils_quadtree_append(tree, first + spatial_utils_quadtree_quadrant(tree, first, entry.x, entry.y), entry);
+    }
+
+    spatial_utils_quadtree_slab_release(tree, slab);
+}
+
+// Doubles the root towards (x, y); the old root becomes the opposite quadrant of the new one
+static bool spatial_utils_quadtree_grow(t_spatial_utils_quadtree* tree, float x, float y)
+{
+    if (tree->height >= SPATIAL_UTILS_QUADTREE_HEIGHT || !spatial_utils_quadtree_reserve(tree, 4, 0)) return false;
+
+    const t_spatial_utils_node old = tree->nodes[0];
+    bool left = x < old.min_x;
+    bool down = y < old.min_y;
+    float width = old.max_x - old.min_x;
+    float height = old.max_y - old.min_y;
+
+    tree->nodes[0] = (t_spatial_utils_node) {
+        left ? old.min_x - width : old.min_x,
+        down ? old.min_y - height : old.min_y,
+        left ? old.max_x : old.max_x + width,
+        down ? old.max_y : old.max_y + height,
+        SPATIAL_UTILS_NONE, 0, SPATIAL_UTILS_NONE
+    };
+
+    uint32_t first = spatial_utils_quadtree_children(tree, 0, left ? old.min_x : old.max_x, down ? old.min_y : old.max_y);
+    uint32_t moved = first + ((uint32_t)left | (uint32_t)down << 1);
+    tree->nodes[moved] = old;
+
+    if (old.child == SPATIAL_UTILS_NONE)
+    {
+        for (uint32_t slot = 0; slot < old.count; slot++)
+        {
+            tree->locations[spatial_utils_quadtree_entry(tree, moved, slot)->id].container = moved;
+        }
+    }
+
+    tree->height++;
+    return true;
+}
+
+static inline bool spatial_utils_quadtree_contains(const t_spatial_utils_node* node, float x, float y)
+{
+    return x >= node->min_x && x < node->max_x && y >= node->min_y && y < node->max_y;
+}
+
+// Adds a valid entry whose id has a location, growing the root and splitting leaves on the way down
+static bool spatial_utils_quadtree_place(t_spatial_utils_quadtree* tree, t_spatial_utils_entry entry)
+{
+    if (tree->node_count == 0)
+    {
+        if (!spatial_utils_quadtree_reserve(tree, 1, 0)) return false;
+
+        // Wide enough that the point stays inside at any magnitude
+        float half = fmaxf(1.0f, fmaxf(fabsf(entry.x), fabsf(entry.y)) * 0x1p-10f);
+        tree->nodes[0] = (t_spatial_utils_node) { entry.x - half, entry.y - half, entry.x + half, entry.y + half,
+                                                  SPATIAL_UTILS_NONE, 0, SPATIAL_UTILS_NONE };
+        tree->node_count = 1;
+        tree->height = 0;
+    }
+
+    while (!spatial_utils_quadtree_contains(&tree->nodes[0], entry.x, entry.y))
+    {
+        if (!spatial_utils_quadtree_grow(tree, entry.x, entry.y)) return false;
+    }
+
+    uint32_t node = 0;
+    unsigned depth = 0;
+
+    for (;;)
+    {
+        const t_spatial_utils_node* current = &tree->nodes[node];
+
+        if (current->child != SPATIAL_UTILS_NONE)
+        {
+            node = current->child + spatial_utils_quadtree_quadrant(tree, current->child, entry.x, entry.y);
+            depth++;
+            continue;
+        }
+
+        if (current->count < SPATIAL_UTILS_QUADTREE_LEAF || depth >= SPATIAL_UTILS_QUADTREE_DEPTH)
+        {
+            if (current->count % SPATIAL_UTILS_QUADTREE_LEAF == 0 && !spatial_utils_quadtree_reserve(tree, 0, 1)) return false;
+
+            spatial_utils_quadtree_append(tree, node, entry);
+            tree->count++;
+            return true;
+        }
+
+        if (!spatial_utils_quadtree_reserve(tree, 4, 4)) return false;
+
+        spatial_utils_quadtree_split(tree, node);
+        if (depth + 1 > tree->height) tree->height = depth + 1;
+    }
+}
+
+// Takes a present point out of its leaf, filling its slot with the leaf's last point
+static void spatial_utils_quadtree_detach(t_spatial_utils_quadtree* tree, uint32_t id)
+{
+    t_spatial_utils_location location = tree->locations[id];
+    t_spatial_utils_node* leaf = &tree->nodes[location.container];
+    uint32_t last = --leaf->count;
+
+    if (location.slot != last)
+    {
+        t_spatial_utils_entry moved = *spatial_utils_quadtree_entry(tree, location.container, last);
+        *spatial_utils_quadtree_entry(tree, location.container, location.slot) = moved;
+        tree->locations[moved.id].slot = location.slot;
+    }
+
+    // The last slab emptied: release it
+    if (last % SPATIAL_UTILS_QUADTREE_LEAF == 0)
+    {
+        if (last == 0)
+        {
+            spatial_utils_quadtree_slab_release(tree, leaf->slab);
+            leaf->slab = SPATIAL_UTILS_NONE;
+        }
+        else
+        {
+            uint32_t previous = spatial_utils_quadtree_slab_of(tree, location.container, last - 1);
+            spatial_utils_quadtree_slab_release(tree, tree->slabs[previous].next);
+            tree->slabs[previous].next = SPATIAL_UTILS_NONE;
+        }
+    }
+
+    tree->locations[id].container = SPATIAL_UTILS_NONE;
+    tree->count--;
+}
+
+static void spatial_utils_quadtree_clear(t_spatial_utils_quadtree* tree)
+{
+    tree->node_count = 0;
+    tree->slab_count = 0;
+    tree->free_slab = SPATIAL_UTILS_NONE;
+    tree->count = 0;
+    tree->height = 0;
+    for (size_t i = 0; i < tree->locations_capacity; i++) tree->locations[i].container = SPATIAL_UTILS_NONE;
+}
+
+// Moves the entries below split, on x or on y, to the front; returns how many there are
+static size_t spatial_utils_quadtree_partition(t_spatial_utils_entry* entries, size_t count, bool on_y, float split)
+{
+    size_t below = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if ((on_y ? entries[i].y : entries[i].x) < split)
+        {
+            t_spatial_utils_entry swapped = entries[below];
+            entries[below++] = entries[i];
+            entries[i] = swapped;
+        }
+    }
+
+    return below;
+}
+
+// Stores entries[0..count) under a leaf, subdividing it while it holds more than a slab
+static bool spatial_utils_quadtree_build_node(t_spatial_utils_quadtree* tree, uint32_t node, t_spatial_utils_entry* entries,
+                                              size_t count, unsigned depth)
+{
+    if (depth > tree->height) tree->height = depth;
+
+    if (count <= SPATIAL_UTILS_QUADTREE_LEAF || depth >= SPATIAL_UTILS_QUADTREE_DEPTH)
+    {
+        if (!spatial_utils_quadtree_reserve(tree, 0, (count + SPATIAL_UTILS_QUADTREE_LEAF - 1) / SPATIAL_UTILS_QUADTREE_LEAF))
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < count; i++) spatial_utils_quadtree_append(tree, node, entries[i]);
+        tree->count += count;
+        return true;
+    }
+
+    if (!spatial_utils_quadtree_reserve(tree, 4, 0)) return false;
+
+    // Bottom half then top half, each left then right: the order of the quadrants
+    uint32_t first = spatial_utils_quadtree_subdivide(tree, node);
+    float mid_x = tree->nodes[first + 1].min_x;
+    float mid_y = tree->nodes[first + 2].min_y;
+
+    size_t bottom = spatial_utils_quadtree_partition(entries, count, true, mid_y);
+    size_t bounds[5];
+    bounds[0] = 0;
+    bounds[1] = spatial_utils_quadtree_partition(entries, bottom, false, mid_x);
+    bounds[2] = bottom;
+    bounds[3] = bottom + spatial_utils_quadtree_partition(entries + bottom, count - bottom, false, mid_x);
+    bounds[4] = count;
+
+    for (uint32_t quadrant = 0; quadrant < 4; quadrant++)
+    {
+        if (!spatial_utils_quadtree_build_node(tree, first + quadrant, entries + bounds[quadrant],
+                                               bounds[quadrant + 1] - bounds[quadrant], depth + 1))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+t_spatial_utils_quadtree* spatial_utils_quadtree_new(void)
+{
+    t_spatial_utils_quadtree* tree = calloc(1, sizeof(t_spatial_utils_quadtree));
+    if (!tree) return NULL;
+
+    tree->free_slab = SPATIAL_UTILS_NONE;
+    return tree;
+}
+
+void spatial_utils_quadtree_free(t_spatial_utils_quadtree* tree)
+{
+    if (!tree) return;
+
+    free(tree->nodes);
+    free(tree->slabs);
+    free(tree->locations);
+    free(tree);
+}
+
+bool spatial_utils_quadtree_build(t_spatial_utils_quadtree* tree, const t_math_utils_vec2* points, size_t count)
+{
+    spatial_utils_quadtree_clear(tree);
+    if (count > UINT32_MAX || !spatial_utils_locations_reserve(&tree->locations, &tree->locations_capacity, count)) return false;
+
+    t_spatial_utils_entry* entries = malloc((count ? count : 1) * sizeof(t_spatial_utils_entry));
+    if (!entries) return false;
+
+    size_t valid = 0;
+    float min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!spatial_utils_point_valid(points[i])) continue;
+
+        entries[valid++] = (t_spatial_utils_entry) { points[i].x, points[i].y, (uint32_t)i };
+        min_x = fminf(min_x, points[i].x);
+        min_y = fminf(min_y, points[i].y);
+        max_x = fmaxf(max_x, points[i].x);
+        max_y = fmaxf(max_y, points[i].y);
+    }
+
+    bool built = true;
+    if (valid > 0)
+    {
+        // A square root, a little wider than the points so the largest stay inside the half-open bounds
+        float magnitude = fmaxf(fmaxf(fabsf(min_x), fabsf(max_x)), fmaxf(fabsf(min_y), fabsf(max_y)));
+        float width = fmaxf(max_x - min_x, max_y - min_y);
+        width = width + width * 0x1p-10f + magnitude * 0x1p-20f + 0x1p-100f;
+
+        built = spatial_utils_quadtree_reserve(tree, 1, 0);
+        if (built)
+        {
+            tree->nodes[0] = (t_spatial_utils_node) { min_x, min_y, min_x + width, min_y + width,
+                                                      SPATIAL_UTILS_NONE, 0, SPATIAL_UTILS_NONE };
+            tree->node_count = 1;
+            built = spatial_utils_quadtree_build_node(tree, 0, entries, valid, 0);
+        }
+    }
+
+    free(entries);
+    if (!built) spatial_utils_quadtree_clear(tree);
+    return built;
+}
+
+bool spatial_utils_quadtree_insert(t_spatial_utils_quadtree* tree, uint32_t id, t_math_utils_vec2 point)
+{
+    if (!spatial_utils_point_valid(point) || id == SPATIAL_UTILS_NONE) return false;
+    if (spatial_utils_location_present(tree->locations, tree->locations_capacity, id)) return false;
+    if (!spatial_utils_locations_reserve(&tree->locations, &tree->locations_capacity, (size_t)id + 1)) return false;
+
+    return spatial_utils_quadtree_place(tree, (t_spatial_utils_entry) { point.x, point.y, id });
+}
+
+bool spatial_utils_quadtree_update(t_spatial_utils_quadtree* tree, uint32_t id, t_math_utils_vec2 point)
+{
+    if (!spatial_utils_point_valid(point)) return false;
+    if (!spatial_utils_location_present(tree->locations, tree->locations_capacity, id)) return false;
+
+    t_spatial_utils_location location = tree->locations[id];
+    t_spatial_utils_entry* entry = spatial_utils_quadtree_entry(tree, location.container, location.slot);
+
+    if (spatial_utils_quadtree_contains(&tree->nodes[location.container], point.x, point.y))
+    {
+        entry->x = point.x;
+        entry->y = point.y;
+        return true;
+    }
+
+    // Put the point back where it was if the new place cannot be had: its leaf has room now
+    t_spatial_utils_entry previous = *entry;
+    spatial_utils_quadtree_detach(tree, id);
+    if (spatial_utils_quadtree_place(tree, (t_spatial_utils_entry) { point.x, point.y, id })) return true;
+
+    spatial_utils_quadtree_place(tree, previous);
+    return false;
+}
+
+bool spatial_utils_quadtree_remove(t_spatial_utils_quadtree* tree, uint32_t id)
+{
+    if (!spatial_utils_location_present(tree->locations, tree->locations_capacity, id)) return false;
+
+    spatial_utils_quadtree_detach(tree, id);
+    return true;
+}
+
+size_t spatial_utils_quadtree_count(const t_spatial_utils_quadtree* tree)
+{
+    return tree->count;
+}
+
+static size_t spatial_utils_quadtree_collect(const t_spatial_utils_quadtree* tree, const t_spatial_utils_filter* filter,
+                                             uint32_t* out, size_t capacity)
+{
+    if (tree->count == 0) return 0;
+
+    uint32_t stack[SPATIAL_UTILS_QUADTREE_STACK];
+    size_t top = 0;
+    size_t found = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+        const t_spatial_utils_node* node = &tree->nodes[stack[--top]];
+
+        if (node->min_x > filter->max_x || node->max_x < filter->min_x || node->min_y > filter->max_y || node->max_y < filter->min_y)
+        {
+            continue;
+        }
+        if (filter->circle
+            && spatial_utils_box_distance(node->min_x, node->min_y, node->max_x, node->max_y, filter->center_x, filter->center_y)
+               > filter->radius_squared)
+        {
+            continue;
+        }
+
+        if (node->child != SPATIAL_UTILS_NONE)
+        {
+            for (uint32_t quadrant = 0; quadrant < 4; quadrant++) stack[top++] = node->child + quadrant;
+            continue;
+        }
+
+        uint32_t remaining = node->count;
+        for (uint32_t slab = node->slab; remaining > 0; slab = tree->slabs[slab].next)
+        {
+            const t_spatial_utils_entry* entries = tree->slabs[slab].entries;
+            uint32_t count = remaining < SPATIAL_UTILS_QUADTREE_LEAF ? remaining : SPATIAL_UTILS_QUADTREE_LEAF;
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (spatial_utils_filter_accepts(filter, entries[i].x, entries[i].y)) spatial_utils_emit(out, capacity, &found, entries[i].id);
+            }
+            remaining -= count;
+        }
+    }
+
+    return found;
+}
+
+size_t spatial_utils_quadtree_query_radius(const t_spatial_utils_quadtree* tree, t_math_utils_vec2 center,
+                                           float radius, uint32_t* out, size_t capacity)
+{
+    t_spatial_utils_filter filter;
+    if (!spatial_utils_filter_radius(&filter, center, radius)) return 0;
+
+    return spatial_utils_quadtree_collect(tree, &filter, out, capacity);
+}
+
+size_t spatial_utils_quadtree_query_box(const t_spatial_utils_quadtree* tree, t_math_utils_vec2 min,
+                                        t_math_utils_vec2 max, uint32_t* out, size_t capacity)
+{
+    t_spatial_utils_filter filter;
+    if (!spatial_utils_filter_box(&filter, min, max)) return 0;
+
+    return spatial_utils_quadtree_collect(tree, &filter, out, capacity);
+}
+
+/*
+ * Depth first, nearest child first: children are pushed farthest first,
+ * each with its squared distance, and skipped when popped if the k-th
+ * best found since is nearer.
+ */
+size_t spatial_utils_quadtree_query_nearest(const t_spatial_utils_quadtree* tree, t_math_utils_vec2 point, size_t k,
+                                            uint32_t* out, float* distances)
+{
+    if (k == 0 || tree->count == 0 || !spatial_utils_point_valid(point)) return 0;
+
+    t_spatial_utils_candidate local[SPATIAL_UTILS_LOCAL_CANDIDATES];
+    t_spatial_utils_heap heap;
+    if (!spatial_utils_heap_init(&heap, local, k < tree->count ? k : tree->count)) return 0;
+
+    t_spatial_utils_candidate stack[SPATIAL_UTILS_QUADTREE_STACK];
+    size_t top = 0;
+    stack[top++] = (t_spatial_utils_candidate) { 0.0f, 0 };
+
+    while (top > 0)
+    {
+        t_spatial_utils_candidate visit = stack[--top];
+        if (visit.distance > spatial_utils_heap_worst(&heap)) continue;
+
+        const t_spatial_utils_node* node = &tree->nodes[visit.id];
+
+        if (node->child != SPATIAL_UTILS_NONE)
+        {
+            t_spatial_utils_candidate children[4];
+            for (uint32_t quadrant = 0; quadrant < 4; quadrant++)
+            {
+                const t_spatial_utils_node* child = &tree->nodes[node->child + quadrant];
+                float distance = spatial_utils_box_distance(child->min_x, child->min_y, child->max_x, child->max_y, point.x, point.y);
+
+                // Insertion sort, farthest first
+                uint32_t i = quadrant;
+                while (i > 0 && children[i - 1].distance < distance)
+                {
+                    children[i] = children[i - 1];
+                    i--;
+                }
+                children[i] = (t_spatial_utils_candidate) { distance, node->child + quadrant };
+            }
+
+            for (int i = 0; i < 4; i++) stack[top++] = children[i];
+            continue;
+        }
+
+        uint32_t remaining = node->count;
+        for (uint32_t slab = node->slab; remaining > 0; slab = tree->slabs[slab].next)
+        {
+            const t_spatial_utils_entry* entries = tree->slabs[slab].entries;
+            uint32_t count = remaining < SPATIAL_UTILS_QUADTREE_LEAF ? remaining : SPATIAL_UTILS_QUADTREE_LEAF;
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                float dx = entries[i].x - point.x;
+                float dy = entries[i].y - point.y;
+                spatial_utils_heap_offer(&heap, dx * dx + dy * dy, entries[i].id);
+            }
+            remaining -= count;
+        }
+    }
+
+    size_t found = spatial_utils_heap_finish(&heap, out, distances);
+    spatial_utils_heap_release(&heap, local);
+    return found;
+}
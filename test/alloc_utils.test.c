@@ -0,0 +1,273 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alloc_utils.h"
+#include "json_utils.h"
+#include "log_utils.h"
+#include "log_utils_sink.h"
+#include "str_utils.h"
+#include "tracking_alloc.h"
+
+/*
+ * The arena and the pool, then every module taking an allocator run on a
+ * tracking allocator: each free and realloc must pass the size the block
+ * was allocated with, and nothing may be left once the objects are freed.
+ */
+
+static bool is_aligned(const void* pointer)
+{
+    return (uintptr_t)pointer % alignof(max_align_t) == 0;
+}
+
+static void fill(void* block, size_t size, unsigned char byte)
+{
+    memset(block, byte, size);
+}
+
+static bool is_filled(const void* block, size_t size, unsigned char byte)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        if (((const unsigned char*)block)[i] != byte) return false;
+    }
+    return true;
+}
+
+static void test_default(void)
+{
+    const t_alloc_utils* allocator = alloc_utils_default();
+    assert(alloc_utils_or_default(NULL) == allocator && alloc_utils_or_default(alloc_utils_pool()) == alloc_utils_pool());
+
+    char* block = alloc_utils_alloc(allocator, 100);
+    assert(block != NULL && is_aligned(block));
+    fill(block, 100, 7);
+    block = alloc_utils_realloc(allocator, block, 100, 10000);
+    assert(block != NULL && is_filled(block, 100, 7));
+    alloc_utils_free(allocator, block, 10000);
+    alloc_utils_free(allocator, NULL, 0);
+
+    int* zeros = alloc_utils_calloc(allocator, 1000, sizeof(int));
+    assert(zeros != NULL && is_filled(zeros, 1000 * sizeof(int), 0));
+    alloc_utils_free(allocator, zeros, 1000 * sizeof(int));
+    assert(alloc_utils_calloc(allocator, SIZE_MAX / 2, 4) == NULL);
+}
+
+static void test_arena(void)
+{
+    t_alloc_utils_arena* arena = alloc_utils_arena_new(4096);
+    const t_alloc_utils* allocator = alloc_utils_arena_allocator(arena);
+    assert(arena != NULL && allocator != NULL && alloc_utils_arena_used(arena) == 0);
+
+    // Blocks are aligned and padded; used counts the padding
+    char* a = alloc_utils_alloc(allocator, 1);
+    char* b = alloc_utils_alloc(allocator, 17);
+    assert(is_aligned(a) && is_aligned(b) && b > a);
+    size_t used = alloc_utils_arena_used(arena);
+    assert(used >= 18 && used % alignof(max_align_t) == 0);
+
+    // Only the last block is given back, or grown in place
+    alloc_utils_free(allocator, a, 1);
+    assert(alloc_utils_arena_used(arena) == used);
+    fill(b, 17, 3);
+    char* grown = alloc_utils_realloc(allocator, b, 17, 900);
+    assert(grown == b && is_filled(grown, 17, 3) && alloc_utils_arena_used(arena) > used);
+    alloc_utils_free(allocator, grown, 900);
+    assert(alloc_utils_arena_used(arena) < used);
+
+    // A block that no longer fits its chunk moves, keeping its contents
+    char* moved = alloc_utils_alloc(allocator, 1000);
+    fill(moved, 1000, 9);
+    for (int i = 0; i < 3; i++) assert(alloc_utils_alloc(allocator, 1000) != NULL);
+    char* last = alloc_utils_alloc(allocator, 600);
+    fill(last, 600, 5);
+    char* copy = alloc_utils_realloc(allocator, moved, 1000, 1024);
+    assert(copy != moved && is_filled(copy, 1000, 9));
+
+    // Blocks above a quarter of a chunk get their own, resized by realloc
+    char* large = alloc_utils_alloc(allocator, 5000);
+    assert(large != NULL && is_aligned(large));
+    fill(large, 5000, 1);
+    large = alloc_utils_realloc(allocator, large, 5000, 50000);
+    assert(large != NULL && is_filled(large, 5000, 1));
+    used = alloc_utils_arena_used(arena);
+    alloc_utils_free(allocator, large, 50000);
+    assert(alloc_utils_arena_used(arena) == used - 50000);
+
+    // Reset keeps the chunks: the first block comes back at the same address
+    alloc_utils_arena_reset(arena);
+    assert(alloc_utils_arena_used(arena) == 0);
+    assert(alloc_utils_alloc(allocator, 1) == a);
+    alloc_utils_arena_free(arena);
+
+    // Chunk size 0 selects the default
+    arena = alloc_utils_arena_new(0);
+    for (int i = 0; i < 10000; i++) assert(alloc_utils_alloc(alloc_utils_arena_allocator(arena), (size_t)i % 300) != NULL);
+    alloc_utils_arena_free(arena);
+    alloc_utils_arena_free(NULL);
+}
+
+// Every size class and above, through reallocations that keep the contents
+static void* exercise_pool(void* argument)
+{
+    enum { BLOCKS = 2000 };
+    const t_alloc_utils* pool = alloc_utils_pool();
+    unsigned char* blocks[BLOCKS];
+    size_t sizes[BLOCKS];
+    uint32_t seed = (uint32_t)(uintptr_t)argument;
+
+    for (size_t i = 0; i < BLOCKS; i++)
+    {
+        sizes[i] = (seed = seed * 1103515245u + 12345u) >> 8 & 2047;
+        blocks[i] = alloc_utils_alloc(pool, sizes[i]);
+        assert(blocks[i] != NULL && is_aligned(blocks[i]));
+        fill(blocks[i], sizes[i], (unsigned char)i);
+    }
+    for (size_t i = 0; i < BLOCKS; i++)
+    {
+        size_t size = (seed = seed * 1103515245u + 12345u) >> 8 & 2047;
+        blocks[i] = alloc_utils_realloc(pool, blocks[i], sizes[i], size);
+        assert(blocks[i] != NULL && is_filled(blocks[i], sizes[i] < size ? sizes[i] : size, (unsigned char)i));
+        sizes[i] = size;
+        fill(blocks[i], size, (unsigned char)~i);
+    }
+    for (size_t i = 0; i < BLOCKS; i++)
+    {
+        assert(is_filled(blocks[i], sizes[i], (unsigned char)~i));
+        alloc_utils_free(pool, blocks[i], sizes[i]);
+    }
+    return NULL;
+}
+
+static void test_pool(void)
+{
+    const t_alloc_utils* pool = alloc_utils_pool();
+    assert(pool == alloc_utils_pool());
+
+    // A freed block is reused for the same size class
+    void* block = alloc_utils_alloc(pool, 40);
+    alloc_utils_free(pool, block, 40);
+    assert(alloc_utils_alloc(pool, 33) == block);
+    alloc_utils_free(pool, block, 33);
+
+    block = alloc_utils_alloc(pool, ALLOC_UTILS_POOL_MAX_SIZE + 1);
+    assert(block != NULL);
+    alloc_utils_free(pool, block, ALLOC_UTILS_POOL_MAX_SIZE + 1);
+
+    exercise_pool((void*)1);
+
+    // Threads, then threads picking up the free lists of exited ones
+    pthread_t threads[4];
+    for (uintptr_t round = 0; round < 2; round++)
+    {
+        for (uintptr_t i = 0; i < 4; i++) assert(pthread_create(&threads[i], NULL, exercise_pool, (void*)(i + 2 + round * 4)) == 0);
+        for (size_t i = 0; i < 4; i++) pthread_join(threads[i], NULL);
+    }
+}
+
+static bool count_string(void* context, const char* value, size_t len)
+{
+    (void)value;
+    *(size_t*)context += len;
+    return true;
+}
+
+static void discard_line(void* context, const char* line, size_t len)
+{
+    (void)line;
+    *(size_t*)context += len;
+}
+
+static void test_consumers(const t_alloc_utils* allocator, t_tracker* tracker)
+{
+    // Builder: detached strings are blocks of len + 1 bytes from its allocator
+    t_str_utils_builder builder;
+    str_utils_builder_init_with_allocator(&builder, NULL, 0, allocator);
+    for (int i = 0; i < 500; i++) assert(str_utils_builder_appendf(&builder, "%d,", i));
+    char* text = str_utils_builder_detach(&builder);
+    assert(text != NULL && strncmp(text, "0,1,2,", 6) == 0);
+    alloc_utils_free(allocator, text, strlen(text) + 1);
+    for (int i = 0; i < 200; i++) assert(str_utils_builder_append(&builder, "abcdefgh", 8));
+    str_utils_builder_free(&builder);
+    assert(builder.allocator == allocator);
+
+    char* copy = str_utils_view_dup_with_allocator(STR_UTILS_VIEW_LITERAL("view"), allocator);
+    assert(copy != NULL && strcmp(copy, "view") == 0);
+    alloc_utils_free(allocator, copy, 5);
+
+    // Writer, then a streaming parser and documents over its output
+    t_json_utils_writer* writer = json_utils_writer_new_with_allocator(8, allocator);
+    assert(json_utils_writer_begin_array(writer));
+    for (int i = 0; i < 3000; i++) assert(json_utils_writer_string(writer, "some string value") && json_utils_writer_int(writer, i));
+    assert(json_utils_writer_end_array(writer));
+    size_t len;
+    const char* data = json_utils_writer_data(writer, &len);
+    char* json = malloc(len);
+    assert(data != NULL && json != NULL);
+    memcpy(json, data, len);
+    json_utils_writer_free(writer);
+
+    size_t strings = 0;
+    t_json_utils_callbacks callbacks = { .on_string = count_string };
+    t_json_utils_parser_options parser_options = { .allocator = allocator };
+    t_json_utils_parser* parser = json_utils_parser_new(&callbacks, &strings, &parser_options);
+    for (size_t i = 0; i < len; i += 7) assert(json_utils_parser_feed(parser, json + i, len - i < 7 ? len - i : 7) == JSON_UTILS_OK);
+    assert(json_utils_parser_finish(parser) == JSON_UTILS_OK && strings == 3000 * 17);
+    json_utils_parser_free(parser);
+
+    for (int on_demand = 0; on_demand < 2; on_demand++)
+    {
+        t_json_utils_document_options document_options = { .on_demand = on_demand, .allocator = allocator };
+        e_json_utils_status status;
+        t_json_utils_document* document = json_utils_document_parse(json, len, &document_options, &status);
+        assert(document != NULL && status == JSON_UTILS_OK);
+        assert(json_utils_value_count(json_utils_document_root(document)) == 6000);
+        json_utils_document_free(document);
+        assert(json_utils_document_parse("[1,2,{\"a\":", 10, &document_options, &status) == NULL);
+    }
+    free(json);
+
+    // Log lines too long for the thread-local buffers
+    size_t logged = 0;
+    t_log_utils_sink* sink = log_utils_sink_new(discard_line, NULL, NULL, &logged);
+    char message[20000];
+    memset(message, 'z', sizeof(message) - 1);
+    message[sizeof(message) - 1] = '\0';
+    size_t allocations = tracker ? tracker->allocations : 0;
+
+    log_utils_set_sink(sink);
+    log_utils_set_allocator(allocator);
+    log_utils_info("alloc", "%s", message);
+    log_utils_set_allocator(NULL);
+    log_utils_set_sink(NULL);
+    log_utils_sink_free(sink);
+    assert(logged > sizeof(message));
+    if (tracker) assert(tracker->allocations > allocations);
+}
+
+int main(void)
+{
+    test_default();
+    test_arena();
+    test_pool();
+
+    t_tracker tracker;
+    tracker_init(&tracker);
+    test_consumers(&tracker.allocator, &tracker);
+    assert(tracker.allocations > 0 && tracker.live == 0);
+
+    test_consumers(alloc_utils_default(), NULL);
+    test_consumers(alloc_utils_pool(), NULL);
+
+    t_alloc_utils_arena* arena = alloc_utils_arena_new(0);
+    test_consumers(alloc_utils_arena_allocator(arena), NULL);
+    assert(alloc_utils_arena_used(arena) > 0);
+    alloc_utils_arena_free(arena);
+
+    printf("All tests passed!\n");
+    return 0;
+}
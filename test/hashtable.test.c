@@ -2,7 +2,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
-#include "../hashtable.h"
+#include "hashtable.h"
+#include "tracking_alloc.h"
 
 // Dummy free function just for testing
 void dummy_free(void* value) {
@@ -11,13 +12,42 @@ void dummy_free(void* value) {
 
 unsigned int simple_hash(char* key) {
     char* str = (char*)key;
-    int hash = 0;
+    unsigned int hash = 0;
     while (*str) {
         hash = hash * 31 + *str++;
     }
     return hash;
 }
 
+// Fills a table past several resizes, with keys of every length, then checks it
+static void check_allocator(const t_alloc_utils* allocator) {
+    t_hashtable* ht = hashtable_new_with_allocator(3, simple_hash, allocator);
+    assert(ht != NULL);
+
+    char key[600];
+    for (size_t i = 0; i < 2000; i++) {
+        int n = snprintf(key, sizeof(key), "key%zu", i);
+        if (i % 100 == 0) {
+            memset(key + n, 'x', 400);
+            key[n + 400] = '\0';
+        }
+        assert(hashtable_entry_set(ht, key, (void*)(i + 1)) == true);
+    }
+    assert(hashtable_entries_count(ht) == 2000);
+    assert(hashtable_entry_set(ht, "key7", (void*)7) == true);
+    assert(hashtable_entries_count(ht) == 2000);
+    assert((size_t)hashtable_entry_get(ht, "key7") == 7);
+    assert((size_t)hashtable_entry_get_view(ht, STR_UTILS_VIEW_LITERAL("key1999")) == 2000);
+    assert(hashtable_entry_get(ht, "key2000") == NULL);
+
+    // Copies handed to the caller still come from malloc
+    char** keys = hashtable_keys(ht);
+    for (size_t i = 0; keys[i] != NULL; i++) free(keys[i]);
+    free(keys);
+
+    hashtable_free(ht, NULL);
+}
+
 int main(void) {
     t_hashtable* ht = hashtable_new(10, simple_hash);
     assert(ht != NULL);
@@ -46,6 +76,7 @@ int main(void) {
     int* val1_new = malloc(sizeof(int));
     *val1_new = 123;
     assert(hashtable_entry_set(ht, key1, val1_new) == true);
+    free(val1);
     int* get_val1_new = (int*)hashtable_entry_get(ht, key1);
     assert(get_val1_new != NULL && *get_val1_new == 123);
 
@@ -80,6 +111,73 @@ int main(void) {
     free(keys[0]);
     free(keys[1]);
     free(keys);
+    free(values);
+    free(entries);
+
+    // View keys: slices of a larger buffer, not NUL-terminated
+    t_hashtable* views = hashtable_new(4, simple_hash);
+    assert(views != NULL);
+
+    const char* line = "alpha,beta,gamma";
+    int values_by_key[3] = { 1, 2, 3 };
+    assert(hashtable_entry_set_view(views, str_utils_view_of(line, 5), &values_by_key[0]) == true);
+    assert(hashtable_entry_set_view(views, str_utils_view_of(line + 6, 4), &values_by_key[1]) == true);
+    assert(hashtable_entry_set(views, "gamma", &values_by_key[2]) == true);
+    assert(hashtable_entries_count(views) == 3);
+
+    // Views and C strings find the same entries
+    assert(hashtable_entry_get(views, "alpha") == &values_by_key[0]);
+    assert(hashtable_entry_get_view(views, str_utils_view_of(line + 6, 4)) == &values_by_key[1]);
+    assert(hashtable_entry_get_view(views, str_utils_view_of(line + 11, 5)) == &values_by_key[2]);
+    assert(hashtable_entry_get_view(views, str_utils_view_of(line, 4)) == NULL);
+    assert(hashtable_entry_get_view(views, str_utils_view_of(line, 6)) == NULL);
+
+    // Updating through a view keeps a single entry
+    assert(hashtable_entry_set_view(views, STR_UTILS_VIEW_LITERAL("beta"), &values_by_key[0]) == true);
+    assert(hashtable_entries_count(views) == 3);
+    assert(hashtable_entry_get(views, "beta") == &values_by_key[0]);
+
+    // The null view is rejected; the empty key is a key like any other
+    assert(hashtable_entry_get_view(views, str_utils_view(NULL)) == NULL);
+    assert(hashtable_entry_set_view(views, str_utils_view(NULL), &values_by_key[0]) == false);
+    assert(hashtable_entry_set_view(views, str_utils_view_of(line, 0), &values_by_key[2]) == true);
+    assert(hashtable_entry_get(views, "") == &values_by_key[2]);
+
+    // Keys longer than the stack buffer used for hashing
+    char long_key[600];
+    memset(long_key, 'k', sizeof(long_key));
+    assert(hashtable_entry_set_view(views, str_utils_view_of(long_key, sizeof(long_key)), &values_by_key[1]) == true);
+    assert(hashtable_entry_get_view(views, str_utils_view_of(long_key, sizeof(long_key))) == &values_by_key[1]);
+    assert(hashtable_entry_get_view(views, str_utils_view_of(long_key, sizeof(long_key) - 1)) == NULL);
+
+    // Key views point into the table, in the same order as hashtable_keys()
+    size_t view_count = 0;
+    t_str_utils_view* key_views = hashtable_key_views(views, &view_count);
+    char** view_keys = hashtable_keys(views);
+    assert(key_views != NULL && view_count == 5);
+    for (size_t i = 0; i < view_count; i++) {
+        assert(str_utils_view_equal(key_views[i], str_utils_view(view_keys[i])));
+        assert(hashtable_entry_get_view(views, key_views[i]) != NULL);
+        free(view_keys[i]);
+    }
+    assert(view_keys[view_count] == NULL);
+    free(view_keys);
+    free(key_views);
+
+    hashtable_free(views, NULL);
+
+    // Buckets and entries come from the allocator, freed with their sizes
+    t_tracker tracker;
+    tracker_init(&tracker);
+    check_allocator(&tracker.allocator);
+    assert(tracker.allocations > 0 && tracker.live == 0);
+    check_allocator(NULL);
+    check_allocator(alloc_utils_pool());
+
+    t_alloc_utils_arena* arena = alloc_utils_arena_new(0);
+    check_allocator(alloc_utils_arena_allocator(arena));
+    assert(alloc_utils_arena_used(arena) > 0);
+    alloc_utils_arena_free(arena);
 
     printf("All tests passed!\n");
     return 0;
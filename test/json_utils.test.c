@@ -0,0 +1,947 @@
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "json_utils.h"
+#include "tracking_alloc.h"
+
+// Parser events and DOM walks are both flattened to the same text, such as {K<a>N<1>[S<x>TFZ]}
+typedef struct t_events
+{
+    char   text[1 << 18];
+    size_t len;
+    size_t documents;
+    size_t abort_after;  // Callbacks fail from this event on, 0 never
+    size_t count;
+} t_events;
+
+static void events_put(t_events* events, const char* data, size_t len)
+{
+    assert(events->len + len <= sizeof(events->text));
+    memcpy(events->text + events->len, data, len);
+    events->len += len;
+}
+
+static void events_put_tagged(t_events* events, const char* tag, const char* data, size_t len)
+{
+    events_put(events, tag, 2);
+    events_put(events, data, len);
+    events_put(events, ">", 1);
+}
+
+// Numbers are compared as the double they read as, so "1e2" and 100 match
+static void events_put_number(t_events* events, double value)
+{
+    char text[32];
+    int len = snprintf(text, sizeof(text), "%.17g", value);
+    events_put_tagged(events, "N<", text, (size_t)len);
+}
+
+static bool events_next(t_events* events)
+{
+    return !events->abort_after || ++events->count < events->abort_after;
+}
+
+static bool on_object_begin(void* context) { events_put(context, "{", 1); return events_next(context); }
+static bool on_object_end(void* context)   { events_put(context, "}", 1); return events_next(context); }
+static bool on_array_begin(void* context)  { events_put(context, "[", 1); return events_next(context); }
+static bool on_array_end(void* context)    { events_put(context, "]", 1); return events_next(context); }
+static bool on_null(void* context)         { events_put(context, "Z", 1); return events_next(context); }
+
+static bool on_key(void* context, const char* key, size_t len)
+{
+    events_put_tagged(context, "K<", key, len);
+    return events_next(context);
+}
+
+static bool on_string(void* context, const char* value, size_t len)
+{
+    events_put_tagged(context, "S<", value, len);
+    return events_next(context);
+}
+
+static bool on_number(void* context, const char* text, size_t len)
+{
+    char copy[64];
+    assert(len < sizeof(copy));
+    memcpy(copy, text, len);
+    copy[len] = '\0';
+    events_put_number(context, strtod(copy, NULL));
+    return events_next(context);
+}
+
+static bool on_bool(void* context, bool value)
+{
+    events_put(context, value ? "T" : "F", 1);
+    return events_next(context);
+}
+
+static bool on_document_end(void* context)
+{
+    ((t_events*)context)->documents++;
+    return true;
+}
+
+static const t_json_utils_callbacks s_callbacks =
+{
+    on_object_begin, on_object_end, on_array_begin, on_array_end,
+    on_key, on_string, on_number, on_bool, on_null, on_document_end
+};
+
+// Parses data fed in chunks of chunk bytes (0 for one piece) and returns the final status
+static e_json_utils_status sax_parse(const char* data, size_t len, size_t chunk,
+                                     const t_json_utils_parser_options* options, t_events* events)
+{
+    events->len = 0;
+    events->documents = 0;
+    events->count = 0;
+
+    t_json_utils_parser* parser = json_utils_parser_new(&s_callbacks, events, options);
+    assert(parser != NULL);
+
+    e_json_utils_status status = JSON_UTILS_OK;
+    for (size_t offset = 0; offset < len && status == JSON_UTILS_OK; offset += chunk ? chunk : len)
+    {
+        size_t n = chunk && len - offset > chunk ? chunk : len - offset;
+        status = json_utils_parser_feed(parser, data + offset, n);
+    }
+    if (status == JSON_UTILS_OK) status = json_utils_parser_finish(parser);
+
+    json_utils_parser_free(parser);
+    return status;
+}
+
+static void dom_walk(t_json_utils_value* value, t_events* events)
+{
+    size_t len;
+    const char* text;
+
+    switch (json_utils_value_type(value))
+    {
+        case JSON_UTILS_TYPE_NULL:
+            events_put(events, "Z", 1);
+            break;
+        case JSON_UTILS_TYPE_BOOL:
+            events_put(events, json_utils_value_bool(value) ? "T" : "F", 1);
+            break;
+        case JSON_UTILS_TYPE_NUMBER:
+            events_put_number(events, json_utils_value_double(value));
+            break;
+        case JSON_UTILS_TYPE_STRING:
+            text = json_utils_value_string(value, &len);
+            events_put_tagged(events, "S<", text, len);
+            break;
+        case JSON_UTILS_TYPE_ARRAY:
+            events_put(events, "[", 1);
+            for (size_t i = 0; i < json_utils_value_count(value); i++)
+            {
+                dom_walk(json_utils_array_get(value, i), events);
+            }
+            events_put(events, "]", 1);
+            break;
+        case JSON_UTILS_TYPE_OBJECT:
+            events_put(events, "{", 1);
+            for (size_t i = 0; i < json_utils_value_count(value); i++)
+            {
+                text = json_utils_object_key_at(value, i, &len);
+                events_put_tagged(events, "K<", text, len);
+                dom_walk(json_utils_object_value_at(value, i), events);
+            }
+            events_put(events, "}", 1);
+            break;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* Random documents                                                           */
+/* -------------------------------------------------------------------------- */
+
+typedef struct t_generator
+{
+    char     text[1 << 18];
+    size_t   len;
+    uint64_t seed;
+} t_generator;
+
+static unsigned generator_next(t_generator* g, unsigned range)
+{
+    g->seed = g->seed * 6364136223846793005ull + 1442695040888963407ull;
+    return (unsigned)(g->seed >> 33) % range;
+}
+
+static void generator_put(t_generator* g, const char* text)
+{
+    size_t len = strlen(text);
+    assert(g->len + len < sizeof(g->text));
+    memcpy(g->text + g->len, text, len);
+    g->len += len;
+}
+
+static void generator_space(t_generator* g)
+{
+    for (unsigned n = generator_next(g, 4); n; n--) generator_put(g, generator_next(g, 2) ? " " : "\n\t");
+}
+
+// Strings mix escapes, multi-byte UTF-8 and structural characters, sometimes longer than a SIMD block
+static void generator_string(t_generator* g)
+{
+    static const char* const pieces[] =
+    {
+        "\\\\", "\\\"", "\\n", "\\t", "\\/", "\\u00e9", "\\ud83d\\ude00", "\xc3\xa9", "{", "}", "[", "]", ":", ",", " "
+    };
+
+    generator_put(g, "\"");
+    unsigned len = generator_next(g, generator_next(g, 4) ? 12 : 150);
+    for (unsigned i = 0; i < len; i++)
+    {
+        if (generator_next(g, 4) == 0) generator_put(g, pieces[generator_next(g, 15)]);
+        else
+        {
+            char c[2] = { (char)('a' + generator_next(g, 26)), '\0' };
+            generator_put(g, c);
+        }
+    }
+    generator_put(g, "\"");
+}
+
+static void generator_value(t_generator* g, unsigned depth)
+{
+    static const char* const numbers[] = { "0", "-12", "3.25", "1e3", "-0.5E-2", "123456789012", "2.5e+300" };
+    static const char* const literals[] = { "true", "false", "null" };
+
+    generator_space(g);
+    switch (generator_next(g, depth > 5 ? 3 : 5))
+    {
+        case 0:
+            generator_string(g);
+            break;
+        case 1:
+            generator_put(g, numbers[generator_next(g, 7)]);
+            break;
+        case 2:
+            generator_put(g, literals[generator_next(g, 3)]);
+            break;
+        case 3:
+        {
+            generator_put(g, "[");
+            unsigned count = generator_next(g, 5);
+            for (unsigned i = 0; i < count; i++)
+            {
+                if (i) generator_put(g, ",");
+                generator_value(g, depth + 1);
+            }
+            generator_put(g, "]");
+            break;
+        }
+        default:
+        {
+            generator_put(g, "{");
+            unsigned count = generator_next(g, depth == 0 && generator_next(g, 2) ? 40 : 5);
+            for (unsigned i = 0; i < count; i++)
+            {
+                if (i) generator_put(g, ",");
+                generator_space(g);
+                generator_string(g);
+                generator_space(g);
+                generator_put(g, ":");
+                generator_value(g, depth + 1);
+            }
+            generator_put(g, "}");
+            break;
+        }
+    }
+    generator_space(g);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Escaping                                                                   */
+/* -------------------------------------------------------------------------- */
+
+// One byte at a time, writing everything; returns the escaped length
+static size_t escape_reference(char* dst, const char* str, size_t len)
+{
+    size_t j = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        unsigned char c = (unsigned char)str[i];
+        const char* short_form = c == '"' ? "\\\"" : c == '\\' ? "\\\\" : c == '\b' ? "\\b" : c == '\f' ? "\\f"
+                               : c == '\n' ? "\\n" : c == '\r' ? "\\r" : c == '\t' ? "\\t" : NULL;
+        if (short_form)
+        {
+            memcpy(dst + j, short_form, 2);
+            j += 2;
+        }
+        else if (c < 0x20)
+        {
+            j += (size_t)sprintf(dst + j, "\\u%04x", c);
+        }
+        else
+        {
+            dst[j++] = (char)c;
+        }
+    }
+    return j;
+}
+
+// Escapes the valid runs with the reference and replaces every ill-formed sequence
+static size_t escape_utf8_reference(char* dst, const char* str, size_t len)
+{
+    size_t i = 0, j = 0;
+    for (;;)
+    {
+        size_t invalid_len;
+        size_t run = str_utils_utf8_find_invalid(str_utils_view_of(str + i, len - i), &invalid_len);
+        if (run == STR_UTILS_NPOS) run = len - i;
+        j += escape_reference(dst + j, str + i, run);
+        i += run;
+        if (i >= len) return j;
+
+        memcpy(dst + j, STR_UTILS_UTF8_REPLACEMENT, 3);
+        j += 3;
+        i += invalid_len;
+    }
+}
+
+// escape_into at every capacity up to the full length: the prefix is written, nothing beyond it
+static void check_escape(const char* str, size_t len, bool utf8)
+{
+    static char expected[6 * 4096], out[6 * 4096 + 16];
+    size_t expected_len = utf8 ? escape_utf8_reference(expected, str, len) : escape_reference(expected, str, len);
+    assert(expected_len <= 6 * len);
+
+    // Every capacity near both ends, a sample of the others
+    size_t step = expected_len > 256 ? expected_len / 32 : 1;
+    for (size_t capacity = 0; capacity <= expected_len + 1; capacity++)
+    {
+        if (capacity > 8 && capacity + 8 < expected_len && capacity % step) continue;
+
+        memset(out, '#', capacity + 16);
+        size_t written = utf8 ? json_utils_escape_utf8_into(out, capacity, str, len)
+                              : json_utils_escape_into(out, capacity, str, len);
+        size_t kept = capacity < expected_len ? capacity : expected_len;
+        assert(written == expected_len);
+        assert(memcmp(out, expected, kept) == 0);
+        for (size_t i = capacity; i < capacity + 16; i++) assert(out[i] == '#');
+    }
+}
+
+static void test_escape_worst_case(void)
+{
+    static char str[4096];
+
+    // Every control character without a short form takes 6 bytes, also through the allocating version
+    for (size_t len = 0; len < sizeof(str); len = len * 2 + 1)
+    {
+        for (size_t i = 0; i < len; i++) str[i] = (char)(i % 2 ? 0x01 : 0x1f);
+        str[len] = '\0';
+        check_escape(str, len, false);
+        check_escape(str, len, true);
+
+        char* escaped = json_utils_escape(str);
+        assert(escaped != NULL && strlen(escaped) == 6 * len);
+        for (size_t i = 0; i < len; i++) assert(memcmp(escaped + 6 * i, i % 2 ? "\\u0001" : "\\u001f", 6) == 0);
+        free(escaped);
+    }
+
+    char* escaped = json_utils_escape(NULL);
+    assert(strcmp(escaped, "null") == 0);
+    free(escaped);
+}
+
+// One byte to escape at every offset of clean runs around the 16- and 32-byte blocks, at every alignment
+static void test_escape_offsets(void)
+{
+    static const char specials[] = { '"', '\\', '\n', '\t', '\b', '\f', '\r', 0x01, 0x1f, 0x7f };
+    char buffer[32 + 80];
+
+    for (size_t len = 1; len <= 80; len++)
+    {
+        for (size_t at = 0; at < len; at++)
+        {
+            char* str = buffer + (len + at) % 32;
+            for (size_t i = 0; i < len; i++) str[i] = (char)('a' + i % 26);
+            str[at] = specials[(len + at) % sizeof(specials)];
+            check_escape(str, len, false);
+
+            // A second one further on, and UTF-8 around them
+            if (at + 1 < len) str[len - 1] = '"';
+            if (at > 1)
+            {
+                str[at - 2] = '\xc3';
+                str[at - 1] = '\xa9';
+            }
+            check_escape(str, len, false);
+            check_escape(str, len, true);
+        }
+    }
+}
+
+static void test_escape_random(void)
+{
+    static const char* const pieces[] =
+    {
+        "\"", "\\", "\n", "\x01", "\x1f", "\x7f", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xff", "\xc3",
+        "\xed\xa0\x80", "\xe2\x82", " "
+    };
+    static t_generator g;
+
+    g.seed = 7;
+    for (int i = 0; i < 3000; i++)
+    {
+        g.len = 0;
+        unsigned len = generator_next(&g, generator_next(&g, 4) ? 40 : 400);
+        unsigned rate = 1 + generator_next(&g, 16);
+        for (unsigned j = 0; j < len; j++)
+        {
+            if (generator_next(&g, rate) == 0) generator_put(&g, pieces[generator_next(&g, 14)]);
+            else
+            {
+                char c[2] = { (char)('a' + generator_next(&g, 26)), '\0' };
+                generator_put(&g, c);
+            }
+        }
+
+        check_escape(g.text, g.len, false);
+        check_escape(g.text, g.len, true);
+    }
+
+    // Ill-formed sequences become one U+FFFD per maximal subpart
+    char out[64];
+    size_t n = json_utils_escape_utf8_into(out, sizeof(out), "a\xff\"\xe2\x82", 5);
+    assert(n == 9 && memcmp(out, "a\xef\xbf\xbd\\\"\xef\xbf\xbd", n) == 0);
+    n = json_utils_escape_utf8_into(out, sizeof(out), "\xc0\x80\xc3\xa9", 4);
+    assert(n == 8 && memcmp(out, "\xef\xbf\xbd\xef\xbf\xbd\xc3\xa9", n) == 0);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Writer                                                                     */
+/* -------------------------------------------------------------------------- */
+
+static void expect_output(t_json_utils_writer* writer, const char* expected)
+{
+    size_t len;
+    const char* data = json_utils_writer_data(writer, &len);
+    assert(data != NULL && len == strlen(expected) && strcmp(data, expected) == 0);
+}
+
+// Commas go between siblings only, whatever closed the previous one
+static void test_writer_nesting(void)
+{
+    t_json_utils_writer* writer = json_utils_writer_new(0);
+    assert(writer != NULL);
+    expect_output(writer, "");
+
+    assert(json_utils_writer_begin_object(writer));
+    assert(json_utils_writer_key(writer, "a"));
+    assert(json_utils_writer_begin_array(writer));
+    assert(json_utils_writer_int(writer, 1));
+    assert(json_utils_writer_begin_object(writer));
+    assert(json_utils_writer_key(writer, "b"));
+    assert(json_utils_writer_begin_array(writer));
+    assert(json_utils_writer_end_array(writer));
+    assert(json_utils_writer_key(writer, "c"));
+    assert(json_utils_writer_begin_object(writer));
+    assert(json_utils_writer_end_object(writer));
+    assert(json_utils_writer_end_object(writer));
+    assert(json_utils_writer_begin_array(writer));
+    assert(json_utils_writer_bool(writer, true));
+    assert(json_utils_writer_null(writer));
+    assert(json_utils_writer_string(writer, NULL));
+    assert(json_utils_writer_end_array(writer));
+    assert(json_utils_writer_bool(writer, false));
+    assert(json_utils_writer_end_array(writer));
+    assert(json_utils_writer_key(writer, "d"));
+    assert(json_utils_writer_string(writer, "x"));
+    assert(json_utils_writer_key_view(writer, STR_UTILS_VIEW_LITERAL("e")));
+    assert(json_utils_writer_int(writer, INT64_MIN));
+    assert(json_utils_writer_key(writer, "f"));
+    assert(json_utils_writer_int(writer, INT64_MAX));
+    assert(json_utils_writer_end_object(writer));
+    expect_output(writer, "{\"a\":[1,{\"b\":[],\"c\":{}},[true,null,null],false],\"d\":\"x\","
+                          "\"e\":-9223372036854775808,\"f\":9223372036854775807}");
+
+    // Top-level arrays of containers, and an empty object
+    json_utils_writer_reset(writer);
+    assert(json_utils_writer_begin_array(writer));
+    for (int i = 0; i < 3; i++)
+    {
+        assert(json_utils_writer_begin_object(writer));
+        if (i != 1)
+        {
+            assert(json_utils_writer_key(writer, "i"));
+            assert(json_utils_writer_int(writer, i));
+        }
+        assert(json_utils_writer_end_object(writer));
+    }
+    assert(json_utils_writer_begin_array(writer));
+    assert(json_utils_writer_begin_array(writer));
+    assert(json_utils_writer_end_array(writer));
+    assert(json_utils_writer_end_array(writer));
+    assert(json_utils_writer_end_array(writer));
+    expect_output(writer, "[{\"i\":0},{},{\"i\":2},[[]]]");
+
+    json_utils_writer_free(writer);
+}
+
+// A missing writer or key is refused without output; an allocation failure sticks until reset
+static void test_writer_errors(void)
+{
+    t_tracker tracker;
+    tracker_init(&tracker);
+    t_json_utils_writer* writer = json_utils_writer_new_with_allocator(16, &tracker.allocator);
+    assert(writer != NULL);
+
+    assert(json_utils_writer_begin_object(writer));
+    assert(!json_utils_writer_key(writer, NULL));
+    assert(!json_utils_writer_key_view(writer, (t_str_utils_view){ NULL, 0 }));
+    assert(json_utils_writer_key(writer, "k"));
+    assert(json_utils_writer_int(writer, 1));
+    assert(json_utils_writer_end_object(writer));
+    expect_output(writer, "{\"k\":1}");
+
+    assert(!json_utils_writer_begin_object(NULL) && !json_utils_writer_end_object(NULL));
+    assert(!json_utils_writer_begin_array(NULL) && !json_utils_writer_end_array(NULL));
+    assert(!json_utils_writer_key(NULL, "k") && !json_utils_writer_string(NULL, "v"));
+    assert(!json_utils_writer_int(NULL, 1) && !json_utils_writer_double(NULL, 1.0));
+    assert(!json_utils_writer_bool(NULL, true) && !json_utils_writer_null(NULL));
+    assert(json_utils_writer_data(NULL, NULL) == NULL);
+
+    // Growing past 16 bytes fails, and so does everything after, even what would fit
+    json_utils_writer_reset(writer);
+    tracker.limit = tracker.allocations;
+    assert(json_utils_writer_begin_array(writer));
+    assert(!json_utils_writer_string(writer, "longer than sixteen bytes"));
+    assert(!json_utils_writer_int(writer, 1));
+    assert(!json_utils_writer_end_array(writer));
+    assert(json_utils_writer_data(writer, NULL) == NULL);
+
+    json_utils_writer_reset(writer);
+    assert(json_utils_writer_begin_array(writer));
+    assert(json_utils_writer_int(writer, 2));
+    assert(json_utils_writer_end_array(writer));
+    expect_output(writer, "[2]");
+
+    tracker.limit = SIZE_MAX;
+    assert(json_utils_writer_string(writer, "longer than sixteen bytes"));
+    expect_output(writer, "[2],\"longer than sixteen bytes\"");
+
+    json_utils_writer_free(writer);
+    assert(tracker.live == 0);
+
+    tracker.limit = tracker.allocations + 1;
+    assert(json_utils_writer_new_with_allocator(0, &tracker.allocator) == NULL);
+    assert(tracker.live == 0);
+}
+
+// Keys and strings are escaped like json_utils_escape_into, also when the escaped text outgrows the buffer
+static void test_writer_escaping(void)
+{
+    static const char* const pieces[] =
+    {
+        "\"", "\\", "\n", "\x01", "\x1f", "\x7f", "\xc3\xa9", "\xff", "\xe2\x82", "a"
+    };
+    static t_generator g;
+    static char expected[6 * 1024 + 16];
+
+    g.seed = 11;
+    for (int i = 0; i < 500; i++)
+    {
+        g.len = 0;
+        unsigned len = generator_next(&g, i % 2 ? 20 : 600);
+        for (unsigned j = 0; j < len; j++) generator_put(&g, pieces[generator_next(&g, 10)]);
+
+        bool utf8 = i % 3 == 0;
+        t_json_utils_writer* writer = json_utils_writer_new(1 + (size_t)i % 32);
+        json_utils_writer_set_replace_invalid_utf8(writer, utf8);
+        assert(json_utils_writer_begin_object(writer));
+        assert(json_utils_writer_key_view(writer, str_utils_view_of(g.text, g.len)));
+        assert(json_utils_writer_string_view(writer, str_utils_view_of(g.text, g.len)));
+        assert(json_utils_writer_end_object(writer));
+
+        size_t n = 0;
+        expected[n++] = '{';
+        for (int part = 0; part < 2; part++)
+        {
+            expected[n++] = '"';
+            n += utf8 ? escape_utf8_reference(expected + n, g.text, g.len)
+                      : escape_reference(expected + n, g.text, g.len);
+            expected[n++] = '"';
+            expected[n++] = part ? '}' : ':';
+        }
+        expected[n] = '\0';
+
+        size_t out_len;
+        const char* out = json_utils_writer_data(writer, &out_len);
+        assert(out_len == n && memcmp(out, expected, n) == 0);
+        json_utils_writer_free(writer);
+    }
+
+    // NUL bytes of views are escaped too
+    t_json_utils_writer* writer = json_utils_writer_new(0);
+    assert(json_utils_writer_string_view(writer, str_utils_view_of("a\0b", 3)));
+    expect_output(writer, "\"a\\u0000b\"");
+    json_utils_writer_free(writer);
+}
+
+// Every finite double reads back bit for bit, through strtod and the parser; others become null
+static void test_writer_doubles(void)
+{
+    static const double specials[] =
+    {
+        0.0, -0.0, 0.1, 1.0 / 3, -1.5, 123.0, 1e21, 1e-7, 5e-324, DBL_MIN, DBL_MAX, -DBL_MAX
+    };
+    static t_generator g;
+    t_json_utils_writer* writer = json_utils_writer_new(0);
+
+    g.seed = 13;
+    for (int i = 0; i < 20000; i++)
+    {
+        double value;
+        if (i < (int)(sizeof(specials) / sizeof(specials[0]))) value = specials[i];
+        else
+        {
+            // Random bit patterns cover every exponent; integers and short decimals are common in practice
+            generator_next(&g, 1);
+            uint64_t bits = g.seed;
+            memcpy(&value, &bits, sizeof(value));
+            if (i % 3 == 1) value = (double)(int64_t)(bits >> (bits % 64));
+            if (i % 3 == 2) value = (double)(bits % 100000) / 1000;
+            if (!isfinite(value)) continue;
+        }
+
+        json_utils_writer_reset(writer);
+        assert(json_utils_writer_double(writer, value));
+        size_t len;
+        const char* out = json_utils_writer_data(writer, &len);
+
+        char* end;
+        double back = strtod(out, &end);
+        assert(end == out + len && memcmp(&back, &value, sizeof(value)) == 0);
+
+        t_json_utils_document* document = json_utils_document_parse(out, len, NULL, NULL);
+        assert(document != NULL);
+        assert(json_utils_value_type(json_utils_document_root(document)) == JSON_UTILS_TYPE_NUMBER);
+        back = json_utils_value_double(json_utils_document_root(document));
+        assert(back == value && signbit(back) == signbit(value));
+        json_utils_document_free(document);
+    }
+
+    json_utils_writer_reset(writer);
+    assert(json_utils_writer_begin_array(writer));
+    assert(json_utils_writer_double(writer, NAN));
+    assert(json_utils_writer_double(writer, INFINITY));
+    assert(json_utils_writer_double(writer, -INFINITY));
+    assert(json_utils_writer_double(writer, 2.5));
+    assert(json_utils_writer_end_array(writer));
+    expect_output(writer, "[null,null,null,2.5]");
+    json_utils_writer_free(writer);
+}
+
+// Once the buffer fits the document, writing it again after a reset allocates nothing
+static void test_writer_reset(void)
+{
+    t_tracker tracker;
+    tracker_init(&tracker);
+    t_json_utils_writer* writer = json_utils_writer_new_with_allocator(16, &tracker.allocator);
+    assert(writer != NULL);
+
+    size_t allocations = 0, first_len = 0;
+    for (int round = 0; round < 5; round++)
+    {
+        json_utils_writer_reset(writer);
+        expect_output(writer, "");
+
+        assert(json_utils_writer_begin_array(writer));
+        for (int i = 0; i < 200; i++)
+        {
+            assert(json_utils_writer_begin_object(writer));
+            assert(json_utils_writer_key(writer, "id"));
+            assert(json_utils_writer_int(writer, i));
+            assert(json_utils_writer_key(writer, "name\t"));
+            assert(json_utils_writer_string(writer, "caf\xc3\xa9 \"quoted\""));
+            assert(json_utils_writer_key(writer, "ratio"));
+            assert(json_utils_writer_double(writer, i / 7.0));
+            assert(json_utils_writer_end_object(writer));
+        }
+        assert(json_utils_writer_end_array(writer));
+
+        size_t len;
+        const char* out = json_utils_writer_data(writer, &len);
+        static const char start[] = "[{\"id\":0,\"name\\t\":\"caf\xc3\xa9 \\\"quoted\\\"\",\"ratio\":0},";
+        assert(out != NULL && len > sizeof(start) && memcmp(out, start, sizeof(start) - 1) == 0);
+
+        if (round == 0)
+        {
+            assert(tracker.allocations > 2);
+            allocations = tracker.allocations;
+            first_len = len;
+        }
+        assert(tracker.allocations == allocations && len == first_len);
+    }
+
+    json_utils_writer_free(writer);
+    assert(tracker.live == 0);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Tests                                                                      */
+/* -------------------------------------------------------------------------- */
+
+static void test_sax_events(void)
+{
+    static t_events events;
+    const char* json = "{\"a\": [1, -2.5e1, \"x\\u00e9\\ud83d\\ude00\\n\", true, false, null], \"\": {}}";
+    const char* expected = "{K<a>[N<1>N<-25>S<x\xc3\xa9\xf0\x9f\x98\x80\n>TFZ]K<>{}}";
+
+    // Every chunk size, down to byte by byte, gives the same events
+    for (size_t chunk = 0; chunk <= strlen(json); chunk++)
+    {
+        assert(sax_parse(json, strlen(json), chunk, NULL, &events) == JSON_UTILS_OK);
+        assert(events.len == strlen(expected) && memcmp(events.text, expected, events.len) == 0);
+        assert(events.documents == 1);
+    }
+}
+
+static void test_sax_errors(void)
+{
+    static t_events events;
+    static const char* const syntax[] =
+    {
+        "[1,]", "{\"a\":}", "[1 2]", "{\"a\":1,}", "[]]", "1x", "[01]", "{\"a\":1}x", "[\"a\x01\"]",
+        "nul", "{\"a\" 1}", "[1]  [2]", "\"\\x\"", "[.5]", "{1:2}"
+    };
+    static const char* const incomplete[] = { "", "  ", "\"abc", "[[]", "{\"a\":1", "[1,", "{\"a\"" };
+
+    for (size_t i = 0; i < sizeof(syntax) / sizeof(syntax[0]); i++)
+    {
+        assert(sax_parse(syntax[i], strlen(syntax[i]), 0, NULL, &events) == JSON_UTILS_ERROR_SYNTAX);
+        assert(sax_parse(syntax[i], strlen(syntax[i]), 1, NULL, &events) == JSON_UTILS_ERROR_SYNTAX);
+    }
+    for (size_t i = 0; i < sizeof(incomplete) / sizeof(incomplete[0]); i++)
+    {
+        assert(sax_parse(incomplete[i], strlen(incomplete[i]), 0, NULL, &events) == JSON_UTILS_ERROR_INCOMPLETE);
+    }
+
+    // Depth and token limits
+    t_json_utils_parser_options options = { .max_depth = 3 };
+    assert(sax_parse("[[[1]]]", 7, 0, &options, &events) == JSON_UTILS_OK);
+    assert(sax_parse("[[[[1]]]]", 9, 0, &options, &events) == JSON_UTILS_ERROR_DEPTH);
+
+    options = (t_json_utils_parser_options){ .max_token_size = 8 };
+    assert(sax_parse("[\"0123456789abcdef\"]", 20, 4, &options, &events) == JSON_UTILS_ERROR_TOKEN_TOO_LARGE);
+
+    // A failing callback stops parsing
+    events.abort_after = 3;
+    t_json_utils_parser* parser = json_utils_parser_new(&s_callbacks, &events, NULL);
+    assert(json_utils_parser_feed(parser, "[1, 2, 3, 4]", 12) == JSON_UTILS_ERROR_ABORTED);
+    assert(json_utils_parser_finish(parser) == JSON_UTILS_ERROR_ABORTED);
+    events.abort_after = 0;
+
+    // Reset clears the error
+    json_utils_parser_reset(parser);
+    assert(json_utils_parser_feed(parser, "[1]", 3) == JSON_UTILS_OK);
+    assert(json_utils_parser_finish(parser) == JSON_UTILS_OK);
+    json_utils_parser_free(parser);
+}
+
+static void test_sax_multiple_values(void)
+{
+    static t_events events;
+    const char* ndjson = "{\"a\":1}\n{\"a\":2}\n[3]\n\"x\"\n";
+    t_json_utils_parser_options options = { .multiple_values = true };
+
+    assert(sax_parse(ndjson, strlen(ndjson), 5, &options, &events) == JSON_UTILS_OK);
+    assert(events.documents == 4);
+    assert(sax_parse(ndjson, strlen(ndjson), 0, NULL, &events) == JSON_UTILS_ERROR_SYNTAX);
+}
+
+static void test_dom(void)
+{
+    const char* json = "{\"name\": \"caf\\u00e9\", \"count\": 42, \"ratio\": 0.5, \"big\": 1e300,"
+                       " \"flags\": [true, false, null], \"nested\": {\"a\": {\"b\": [1, 2, 3]}},"
+                       " \"dup\": 1, \"dup\": 2}";
+
+    for (int on_demand = 0; on_demand < 2; on_demand++)
+    {
+        t_json_utils_document_options options = { .on_demand = on_demand };
+        e_json_utils_status status;
+        t_json_utils_document* document = json_utils_document_parse(json, strlen(json), &options, &status);
+        assert(document != NULL && status == JSON_UTILS_OK);
+
+        t_json_utils_value* root = json_utils_document_root(document);
+        assert(json_utils_value_type(root) == JSON_UTILS_TYPE_OBJECT);
+        assert(json_utils_value_count(root) == 8);
+
+        size_t len;
+        const char* name = json_utils_value_string(json_utils_object_get(root, "name"), &len);
+        assert(len == 5 && memcmp(name, "caf\xc3\xa9", 5) == 0);
+
+        int64_t count;
+        assert(json_utils_value_int(json_utils_object_get(root, "count"), &count) && count == 42);
+        assert(!json_utils_value_int(json_utils_object_get(root, "ratio"), &count));
+        assert(json_utils_value_double(json_utils_object_get(root, "ratio")) == 0.5);
+        assert(json_utils_value_double(json_utils_object_get(root, "big")) == 1e300);
+
+        t_json_utils_value* flags = json_utils_object_get_view(root, STR_UTILS_VIEW_LITERAL("flags"));
+        assert(json_utils_value_count(flags) == 3);
+        assert(json_utils_value_bool(json_utils_array_get(flags, 0)));
+        assert(json_utils_value_type(json_utils_array_get(flags, 2)) == JSON_UTILS_TYPE_NULL);
+        assert(json_utils_array_get(flags, 3) == NULL);
+
+        t_json_utils_value* b = json_utils_object_get(json_utils_object_get(json_utils_object_get(root, "nested"), "a"), "b");
+        assert(json_utils_value_count(b) == 3 && json_utils_value_double(json_utils_array_get(b, 2)) == 3);
+
+        // First duplicate wins; missing keys and wrong types give NULL
+        assert(json_utils_value_int(json_utils_object_get(root, "dup"), &count) && count == 1);
+        assert(json_utils_object_get(root, "missing") == NULL);
+        assert(json_utils_object_get(flags, "name") == NULL);
+        assert(json_utils_value_string(flags, NULL) == NULL);
+
+        assert(json_utils_document_status(document) == JSON_UTILS_OK);
+        json_utils_document_free(document);
+    }
+}
+
+static void test_dom_large_object(void)
+{
+    // Enough members to get a hash index
+    static char json[1 << 14];
+    size_t len = 0;
+    json[len++] = '{';
+    for (int i = 0; i < 500; i++)
+    {
+        len += (size_t)snprintf(json + len, sizeof(json) - len, "%s\"key%d\":%d", i ? "," : "", i, i);
+    }
+    json[len++] = '}';
+
+    for (int on_demand = 0; on_demand < 2; on_demand++)
+    {
+        t_json_utils_document_options options = { .on_demand = on_demand };
+        t_json_utils_document* document = json_utils_document_parse(json, len, &options, NULL);
+        t_json_utils_value* root = json_utils_document_root(document);
+        assert(json_utils_value_count(root) == 500);
+
+        for (int i = 0; i < 500; i++)
+        {
+            char key[16];
+            snprintf(key, sizeof(key), "key%d", i);
+            int64_t value;
+            assert(json_utils_value_int(json_utils_object_get(root, key), &value) && value == i);
+        }
+        assert(json_utils_object_get(root, "key500") == NULL);
+        json_utils_document_free(document);
+    }
+}
+
+static void test_dom_errors(void)
+{
+    static const char* const invalid[] = { "", "[1,]", "{\"a\":}", "[[]", "[]]", "1x", "[\"a\x01\"]", "{\"a\" 1}" };
+
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+    {
+        e_json_utils_status status = JSON_UTILS_OK;
+        assert(json_utils_document_parse(invalid[i], strlen(invalid[i]), NULL, &status) == NULL);
+        assert(status != JSON_UTILS_OK);
+    }
+
+    // Mismatched closers fail at parse time in both modes, also past the first 64 levels of a skip:
+    // 100 arrays around an object at level 71, closed by '}' at level 100
+    static char deep[201];
+    for (int k = 0; k < 100; k++) deep[k] = k == 70 ? '{' : '[';
+    for (int k = 100; k < 200; k++) deep[k] = k == 100 ? '}' : ']';
+    static const char* const mismatched[] =
+    {
+        "[1, {\"a\": 2]}", "{\"a\": [1}]", "[}", "{\"a\": {]}", "[[1], {}}", deep
+    };
+
+    for (size_t i = 0; i < sizeof(mismatched) / sizeof(mismatched[0]); i++)
+    {
+        for (int on_demand = 0; on_demand < 2; on_demand++)
+        {
+            t_json_utils_document_options options = { .on_demand = on_demand };
+            e_json_utils_status status = JSON_UTILS_OK;
+            assert(json_utils_document_parse(mismatched[i], strlen(mismatched[i]), &options, &status) == NULL);
+            assert(status == JSON_UTILS_ERROR_SYNTAX);
+        }
+    }
+
+    // Then the object at level 71 closed by ']', then all arrays
+    deep[100] = ']';
+    t_json_utils_document_options on_demand_options = { .on_demand = true };
+    t_json_utils_document* nested = json_utils_document_parse(deep, strlen(deep), &on_demand_options, NULL);
+    assert(nested == NULL);
+    deep[70] = '[';
+    nested = json_utils_document_parse(deep, strlen(deep), &on_demand_options, NULL);
+    assert(nested != NULL && json_utils_value_count(json_utils_document_root(nested)) == 1);
+    json_utils_document_free(nested);
+
+    // On demand, an error inside a subtree shows up when it is first accessed
+    const char* json = "{\"good\": [1, 2], \"bad\": [1 2]}";
+    t_json_utils_document_options options = { .on_demand = true };
+    e_json_utils_status status;
+    t_json_utils_document* document = json_utils_document_parse(json, strlen(json), &options, &status);
+    assert(document != NULL && status == JSON_UTILS_OK);
+
+    t_json_utils_value* root = json_utils_document_root(document);
+    assert(json_utils_value_count(json_utils_object_get(root, "good")) == 2);
+    assert(json_utils_document_status(document) == JSON_UTILS_OK);
+    assert(json_utils_array_get(json_utils_object_get(root, "bad"), 0) == NULL);
+    assert(json_utils_document_status(document) == JSON_UTILS_ERROR_SYNTAX);
+    json_utils_document_free(document);
+}
+
+// The streaming parser in odd chunks, the DOM and the on-demand DOM all see the same document
+static void test_random_documents(void)
+{
+    static t_generator g;
+    static t_events sax, chunked, dom;
+
+    g.seed = 42;
+    for (int i = 0; i < 2000; i++)
+    {
+        g.len = 0;
+        generator_value(&g, 0);
+
+        assert(sax_parse(g.text, g.len, 0, NULL, &sax) == JSON_UTILS_OK);
+        assert(sax_parse(g.text, g.len, 1 + (size_t)i % 97, NULL, &chunked) == JSON_UTILS_OK);
+        assert(chunked.len == sax.len && memcmp(chunked.text, sax.text, sax.len) == 0);
+
+        for (int on_demand = 0; on_demand < 2; on_demand++)
+        {
+            t_json_utils_document_options options = { .on_demand = on_demand };
+            t_json_utils_document* document = json_utils_document_parse(g.text, g.len, &options, NULL);
+            assert(document != NULL);
+
+            dom.len = 0;
+            dom_walk(json_utils_document_root(document), &dom);
+            assert(dom.len == sax.len && memcmp(dom.text, sax.text, dom.len) == 0);
+            json_utils_document_free(document);
+        }
+    }
+}
+
+int main(void)
+{
+    test_sax_events();
+    test_sax_errors();
+    test_sax_multiple_values();
+    test_dom();
+    test_dom_large_object();
+    test_dom_errors();
+    test_random_documents();
+    test_escape_worst_case();
+    test_escape_offsets();
+    test_escape_random();
+    test_writer_nesting();
+    test_writer_errors();
+    test_writer_escaping();
+    test_writer_doubles();
+    test_writer_reset();
+
+    printf("All tests passed!\n");
+    return 0;
+}
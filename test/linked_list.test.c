@@ -0,0 +1,218 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "linked_list.h"
+#include "tracking_alloc.h"
+
+/*
+ * List operations against an array of the expected values, on a tracking
+ * allocator that checks the size passed to every free and that nothing is
+ * left once the lists are freed.
+ */
+
+static void assert_values(t_linked_list* list, const intptr_t* expected, size_t count)
+{
+    assert(linked_list_count(list) == count);
+
+    t_linked_list_node* node = linked_list_head(list);
+    for (size_t i = 0; i < count; i++, node = linked_list_next(node)) assert((intptr_t)linked_list_value(node) == expected[i]);
+    assert(node == NULL);
+
+    node = linked_list_tail(list);
+    for (size_t i = count; i-- > 0; node = linked_list_previous(node)) assert((intptr_t)linked_list_value(node) == expected[i]);
+    assert(node == NULL);
+}
+
+static bool is_even(t_linked_list_node* node, void* context)
+{
+    (void)context;
+    return (intptr_t)linked_list_value(node) % 2 == 0;
+}
+
+static bool equals(t_linked_list_node* node, void* context)
+{
+    return (intptr_t)linked_list_value(node) == *(intptr_t*)context;
+}
+
+static int ascending(t_linked_list_node* a, t_linked_list_node* b)
+{
+    intptr_t x = (intptr_t)linked_list_value(a), y = (intptr_t)linked_list_value(b);
+    return x < y ? -1 : x > y;
+}
+
+static size_t s_freed;
+
+static void count_free(t_linked_list_node* node)
+{
+    (void)node;
+    s_freed++;
+}
+
+static void test_operations(const t_alloc_utils* allocator)
+{
+    intptr_t expected[64];
+    size_t count = 0;
+
+    t_linked_list* list = linked_list_new_with_allocator(allocator);
+    assert(list != NULL && linked_list_count(list) == 0 && linked_list_head(list) == NULL);
+    assert(linked_list_at(list, 0) == NULL && linked_list_random(list) == NULL);
+
+    for (intptr_t i = 0; i < 10; i++)
+    {
+        assert(linked_list_add(list, (void*)i) != NULL);
+        expected[count++] = i;
+    }
+    assert_values(list, expected, count);
+
+    // At the head, in the middle, at the end; past the end is rejected
+    assert(linked_list_insert_at(list, 0, (void*)100) != NULL);
+    assert(linked_list_insert_at(list, 5, (void*)105) != NULL);
+    assert(linked_list_insert_at(list, 12, (void*)112) != NULL);
+    assert(linked_list_insert_at(list, 14, (void*)114) == NULL && linked_list_insert_at(list, -1, (void*)99) == NULL);
+    const intptr_t inserted[] = { 100, 0, 1, 2, 3, 105, 4, 5, 6, 7, 8, 9, 112 };
+    memcpy(expected, inserted, sizeof(inserted));
+    count = sizeof(inserted) / sizeof(inserted[0]);
+    assert_values(list, expected, count);
+    assert((intptr_t)linked_list_value(linked_list_at(list, 5)) == 105);
+
+    // Detached nodes are freed through the list that owned them
+    t_linked_list_node* node = linked_list_remove_at(list, 0);
+    assert(node != NULL && (intptr_t)linked_list_value(node) == 100);
+    linked_list_node_free(list, node, NULL);
+    node = linked_list_remove(list, linked_list_tail(list));
+    assert((intptr_t)linked_list_value(node) == 112);
+    s_freed = 0;
+    linked_list_node_free(list, node, count_free);
+    assert(s_freed == 1);
+    linked_list_free_at(list, 4, count_free);
+    assert(s_freed == 2 && linked_list_remove_at(list, 50) == NULL);
+    const intptr_t removed[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    memcpy(expected, removed, sizeof(removed));
+    count = sizeof(removed) / sizeof(removed[0]);
+    assert_values(list, expected, count);
+
+    intptr_t wanted = 7, missing = 70;
+    assert((intptr_t)linked_list_find(list, equals, &wanted) == 7 && linked_list_find(list, equals, &missing) == NULL);
+
+    // Selections are new lists on the same allocator
+    t_linked_list* even = linked_list_select(list, is_even, NULL);
+    const intptr_t evens[] = { 0, 2, 4, 6, 8 };
+    assert_values(even, evens, 5);
+    assert_values(list, expected, count);
+
+    // Sorting restores the order, with head and tail
+    linked_list_sort(even, ascending);
+    linked_list_free_at(even, 0, NULL);
+    assert(linked_list_insert_at(even, 4, (void*)-3) != NULL);
+    linked_list_sort(even, ascending);
+    const intptr_t sorted[] = { -3, 2, 4, 6, 8 };
+    assert_values(even, sorted, 5);
+
+    // Concatenation on the same allocator moves the nodes
+    assert(linked_list_concat(list, even));
+    assert(linked_list_count(even) == 0 && linked_list_head(even) == NULL && linked_list_tail(even) == NULL);
+    memcpy(expected + count, sorted, sizeof(sorted));
+    count += 5;
+    assert_values(list, expected, count);
+
+    s_freed = 0;
+    linked_list_free_after(list, 11, count_free);
+    assert(s_freed == 3);
+    assert_values(list, expected, 12);
+    linked_list_remove_after(list, 9);
+    assert_values(list, expected, 10);
+
+    linked_list_free(even, NULL);
+    s_freed = 0;
+    linked_list_free(list, count_free);
+    assert(s_freed == 10);
+}
+
+static void test_sample(void)
+{
+    t_linked_list* list = linked_list_new();
+    t_linked_list_node* picked[100];
+    t_rand_utils_state state;
+    rand_utils_state_seed(&state, 7);
+
+    for (intptr_t i = 0; i < 100; i++) linked_list_add(list, (void*)i);
+
+    // Distinct nodes, in list order
+    for (size_t k = 0; k <= 100; k += 7)
+    {
+        assert(linked_list_sample(list, k, picked, &state) == k);
+        for (size_t i = 1; i < k; i++) assert((intptr_t)linked_list_value(picked[i - 1]) < (intptr_t)linked_list_value(picked[i]));
+    }
+    assert(linked_list_sample(list, 500, picked, &state) == 100);
+
+    linked_list_free(list, NULL);
+}
+
+// Nodes moved between allocators are copied into the receiving list's allocator
+static void test_concat_across_allocators(t_tracker* tracker)
+{
+    t_alloc_utils_arena* arena = alloc_utils_arena_new(0);
+    t_linked_list* lists[3] =
+    {
+        linked_list_new_with_allocator(&tracker->allocator),
+        linked_list_new_with_allocator(alloc_utils_arena_allocator(arena)),
+        linked_list_new_with_allocator(alloc_utils_pool()),
+    };
+    intptr_t expected[15];
+
+    for (intptr_t i = 0; i < 15; i++)
+    {
+        assert(linked_list_add(lists[i / 5], (void*)i) != NULL);
+        expected[i] = i;
+    }
+
+    size_t live = tracker->live;
+    assert(linked_list_concat(lists[0], lists[1]));
+    assert(linked_list_concat(lists[0], lists[2]));
+    assert(tracker->live == live + 10);
+    assert_values(lists[0], expected, 15);
+    assert(linked_list_count(lists[1]) == 0 && linked_list_count(lists[2]) == 0);
+
+    // The empty lists keep working on their own allocators
+    assert(linked_list_add(lists[2], (void*)42) != NULL);
+    assert(!linked_list_concat(lists[0], NULL));
+
+    linked_list_free(lists[1], NULL);
+    linked_list_free(lists[2], NULL);
+    alloc_utils_arena_free(arena);
+    linked_list_free(lists[0], NULL);
+}
+
+int main(void)
+{
+    t_tracker tracker;
+    tracker_init(&tracker);
+
+    test_operations(&tracker.allocator);
+    assert(tracker.allocations > 0 && tracker.live == 0);
+    test_operations(NULL);
+    test_operations(alloc_utils_pool());
+
+    t_alloc_utils_arena* arena = alloc_utils_arena_new(256);
+    test_operations(alloc_utils_arena_allocator(arena));
+    alloc_utils_arena_free(arena);
+
+    test_sample();
+    test_concat_across_allocators(&tracker);
+    assert(tracker.live == 0);
+
+    // Lists built from arrays
+    void* values[] = { (void*)1, (void*)2, (void*)3, NULL };
+    t_linked_list* from_list = linked_list_new_from_list(values);
+    t_linked_list* from_array = linked_list_new_from_array(values, 2);
+    const intptr_t expected[] = { 1, 2, 3 };
+    assert_values(from_list, expected, 3);
+    assert_values(from_array, expected, 2);
+    linked_list_free(from_list, NULL);
+    linked_list_free(from_array, NULL);
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,749 @@
+#define _POSIX_C_SOURCE 200809L
+
+// DEBUG calls of the LOG_UTILS_* macros are compiled out of this file
+#define LOG_UTILS_COMPILE_MIN_LEVEL LOG_UTILS_LEVEL_INFO
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "json_utils.h"
+#include "log_utils.h"
+#include "log_utils_bin.h"
+#include "log_utils_sink.h"
+
+/*
+ * Lines are captured by a sink and read back with the JSON parser, so
+ * every check also proves that each line is a single valid JSON object.
+ * File sinks write into a temporary directory, and the binary log is read
+ * back through the log_utils_decode tool when it is built.
+ */
+
+#define CAPTURE_LINES 256
+
+typedef struct t_capture
+{
+    char*  lines[CAPTURE_LINES];
+    size_t lens[CAPTURE_LINES];
+    size_t count;
+} t_capture;
+
+static t_capture s_capture;
+
+static void capture_write(void* context, const char* line, size_t len)
+{
+    t_capture* capture = context;
+    assert(capture->count < CAPTURE_LINES && len > 0 && line[len - 1] == '\n');
+
+    capture->lines[capture->count] = malloc(len + 1);
+    assert(capture->lines[capture->count] != NULL);
+    memcpy(capture->lines[capture->count], line, len);
+    capture->lines[capture->count][len] = '\0';
+    capture->lens[capture->count++] = len;
+}
+
+static void capture_clear(void)
+{
+    for (size_t i = 0; i < s_capture.count; i++) free(s_capture.lines[i]);
+    s_capture.count = 0;
+}
+
+// Parses a captured line; member keys must all differ
+static t_json_utils_document* parse_line(size_t index)
+{
+    assert(index < s_capture.count);
+
+    e_json_utils_status status;
+    t_json_utils_document* document =
+        json_utils_document_parse(s_capture.lines[index], s_capture.lens[index], NULL, &status);
+    assert(document != NULL && status == JSON_UTILS_OK);
+
+    t_json_utils_value* root = json_utils_document_root(document);
+    assert(json_utils_value_type(root) == JSON_UTILS_TYPE_OBJECT);
+    size_t count = json_utils_value_count(root);
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t len_i;
+        const char* key_i = json_utils_object_key_at(root, i, &len_i);
+        for (size_t j = 0; j < i; j++)
+        {
+            size_t len_j;
+            const char* key_j = json_utils_object_key_at(root, j, &len_j);
+            assert(len_i != len_j || memcmp(key_i, key_j, len_i) != 0);
+        }
+    }
+    return document;
+}
+
+static bool member_is(t_json_utils_value* object, const char* key, const char* expected)
+{
+    size_t len;
+    const char* value = json_utils_value_string(json_utils_object_get(object, key), &len);
+    return value != NULL && len == strlen(expected) && memcmp(value, expected, len) == 0;
+}
+
+// Checks the level, context (NULL: null) and content of a captured line
+static void expect_line(size_t index, const char* level, const char* context, const char* content)
+{
+    t_json_utils_document* document = parse_line(index);
+    t_json_utils_value* root = json_utils_document_root(document);
+
+    assert(member_is(root, "level", level) && member_is(root, "content", content));
+    if (context) assert(member_is(root, "context", context));
+    else assert(json_utils_value_type(json_utils_object_get(root, "context")) == JSON_UTILS_TYPE_NULL);
+    json_utils_document_free(document);
+}
+
+static void test_reserved_fields(void)
+{
+    capture_clear();
+    LOG_UTILS_LOG_FIELDS(LOG_UTILS_LEVEL_ERROR, "real", "message",
+                         LOG_UTILS_FIELD_STRING("level", "DEBUG"),
+                         LOG_UTILS_FIELD_STRING("context", "other"),
+                         LOG_UTILS_FIELD_INT("timestamp", 0),
+                         LOG_UTILS_FIELD_STRING("content", "fake"),
+                         LOG_UTILS_FIELD_STRING("levels", "kept"));
+    assert(s_capture.count == 1);
+
+    t_json_utils_document* document = parse_line(0);
+    t_json_utils_value* root = json_utils_document_root(document);
+    assert(json_utils_value_count(root) == 9);
+    assert(member_is(root, "level", "ERROR") && member_is(root, "context", "real"));
+    assert(member_is(root, "content", "message"));
+    assert(member_is(root, "field.level", "DEBUG") && member_is(root, "field.context", "other"));
+    assert(member_is(root, "field.content", "fake") && member_is(root, "levels", "kept"));
+
+    int64_t timestamp;
+    assert(json_utils_value_int(json_utils_object_get(root, "field.timestamp"), &timestamp) && timestamp == 0);
+    assert(json_utils_value_type(json_utils_object_get(root, "timestamp")) == JSON_UTILS_TYPE_STRING);
+    json_utils_document_free(document);
+}
+
+static void test_flood_control(void)
+{
+    // Summaries only come from log_utils_flush() while the interval runs
+    log_utils_set_summary_interval(3600);
+
+    // 1 in 4 INFO messages, per context
+    capture_clear();
+    log_utils_set_sampling(LOG_UTILS_LEVEL_INFO, 4);
+    for (int i = 0; i < 20; i++)
+    {
+        log_utils_info("sampled", "%d", i);
+        log_utils_info(NULL, "%d", i);
+    }
+    log_utils_warn("sampled", "kept");
+    assert(s_capture.count == 11);
+    for (size_t i = 0; i < 5; i++)
+    {
+        char content[8];
+        sprintf(content, "%zu", i * 4);
+        expect_line(2 * i, "INFO", "sampled", content);
+        expect_line(2 * i + 1, "INFO", NULL, content);
+    }
+    expect_line(10, "WARN", "sampled", "kept");
+
+    log_utils_flush();
+    assert(s_capture.count == 13);
+    bool null_first = strstr(s_capture.lines[11], "null") != NULL;
+    expect_line(null_first ? 12 : 11, "INFO", "sampled", "suppressed 15 messages");
+    expect_line(null_first ? 11 : 12, "INFO", NULL, "suppressed 15 messages");
+
+    // Nothing is outstanding any more
+    log_utils_flush();
+    assert(s_capture.count == 13);
+    log_utils_set_sampling(LOG_UTILS_LEVEL_INFO, 0);
+
+    // Token bucket of 1 message per second with bursts of 3
+    capture_clear();
+    log_utils_set_rate_limit(1, 3);
+    for (int i = 0; i < 10; i++) log_utils_error("bucket", "%d", i);
+    assert(s_capture.count == 3);
+    for (size_t i = 0; i < 3; i++) expect_line(i, "ERROR", "bucket", (const char*[]){ "0", "1", "2" }[i]);
+    log_utils_flush();
+    assert(s_capture.count == 4);
+    expect_line(3, "ERROR", "bucket", "suppressed 7 messages");
+    log_utils_set_rate_limit(0, 0);
+
+    // Without an interval the next message reports the count first
+    capture_clear();
+    log_utils_set_summary_interval(0);
+    log_utils_set_sampling(LOG_UTILS_LEVEL_DEBUG, 2);
+    for (int i = 0; i < 4; i++) log_utils_debug("interval", "%d", i);
+    assert(s_capture.count == 4);
+    expect_line(0, "DEBUG", "interval", "0");
+    expect_line(1, "DEBUG", "interval", "suppressed 1 messages");
+    expect_line(2, "DEBUG", "interval", "2");
+    expect_line(3, "DEBUG", "interval", "suppressed 1 messages");
+    log_utils_flush();
+    assert(s_capture.count == 4);
+    log_utils_set_sampling(LOG_UTILS_LEVEL_DEBUG, 0);
+    log_utils_set_summary_interval(10);
+
+    // Disabled again: everything passes
+    capture_clear();
+    for (int i = 0; i < 10; i++) log_utils_debug("interval", "%d", i);
+    assert(s_capture.count == 10);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Lines                                                                      */
+/* -------------------------------------------------------------------------- */
+
+// Length of "{ \"timestamp\": \"" and of the timestamp after it
+#define TIMESTAMP_OFFSET 16
+#define TIMESTAMP_LEN    23
+
+// Checks the timestamp digits and separators, returns what follows the timestamp
+static const char* skip_timestamp(const char* line)
+{
+    static const char pattern[] = "dddd/dd/dd dd:dd:dd:ddd";
+
+    assert(strncmp(line, "{ \"timestamp\": \"", TIMESTAMP_OFFSET) == 0);
+    for (size_t i = 0; i < TIMESTAMP_LEN; i++)
+    {
+        char c = line[TIMESTAMP_OFFSET + i];
+        assert(pattern[i] == 'd' ? c >= '0' && c <= '9' : c == pattern[i]);
+    }
+    return line + TIMESTAMP_OFFSET + TIMESTAMP_LEN;
+}
+
+static void test_line_format(void)
+{
+    capture_clear();
+    log_utils_info("ctx", "hello %s %d", "world", 42);
+    log_utils_warn(NULL, "no context");
+    log_utils_error("quote\"d", "tab\t\"q\"\n\x01");
+    log_utils_write(LOG_UTILS_LEVEL_DEBUG, str_utils_view(NULL), str_utils_view_of("view\0bytes", 10));
+    log_utils_write(LOG_UTILS_LEVEL_INFO, str_utils_view_of("", 0), STR_UTILS_VIEW_LITERAL("empty context"));
+    log_utils_fields(LOG_UTILS_LEVEL_WARN, "ctx", NULL, NULL, 0);
+
+    static const char* const expected[] =
+    {
+        "\", \"level\": \"INFO\", \"context\": \"ctx\", \"content\": \"hello world 42\" }\n",
+        "\", \"level\": \"WARN\", \"context\": null, \"content\": \"no context\" }\n",
+        "\", \"level\": \"ERROR\", \"context\": \"quote\\\"d\", \"content\": \"tab\\t\\\"q\\\"\\n\\u0001\" }\n",
+        "\", \"level\": \"DEBUG\", \"context\": null, \"content\": \"view\\u0000bytes\" }\n",
+        "\", \"level\": \"INFO\", \"context\": \"\", \"content\": \"empty context\" }\n",
+        "\", \"level\": \"WARN\", \"context\": \"ctx\" }\n",
+    };
+    assert(s_capture.count == sizeof(expected) / sizeof(expected[0]));
+    for (size_t i = 0; i < s_capture.count; i++)
+    {
+        assert(strcmp(skip_timestamp(s_capture.lines[i]), expected[i]) == 0);
+        json_utils_document_free(parse_line(i));
+    }
+}
+
+// Milliseconds since the epoch of a captured line, through mktime
+static int64_t line_time_ms(size_t index)
+{
+    const char* t = s_capture.lines[index] + TIMESTAMP_OFFSET;
+    struct tm tm_info = { .tm_isdst = -1 };
+
+    assert(sscanf(t, "%4d/%2d/%2d %2d:%2d:%2d", &tm_info.tm_year, &tm_info.tm_mon, &tm_info.tm_mday,
+                  &tm_info.tm_hour, &tm_info.tm_min, &tm_info.tm_sec) == 6);
+    tm_info.tm_year -= 1900;
+    tm_info.tm_mon -= 1;
+    return (int64_t)mktime(&tm_info) * 1000 + atoi(t + 20);
+}
+
+static void sleep_ms(long ms)
+{
+    struct timespec delay = { ms / 1000, (ms % 1000) * 1000000 };
+    nanosleep(&delay, NULL);
+}
+
+// Sleeps until the wall clock is offset_ms away from the start of a coming second, returns that second
+static time_t sleep_past_second(long offset_ms)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    time_t second = now.tv_sec + 1;
+    long delay = 1000 + offset_ms - now.tv_nsec / 1000000;
+    if (delay < 5)
+    {
+        second++;
+        delay += 1000;
+    }
+    sleep_ms(delay);
+    return second;
+}
+
+static int s_evaluated;
+
+static int evaluate(void)
+{
+    s_evaluated++;
+    return 1;
+}
+
+// Arguments of filtered macro calls are never evaluated
+static void test_macro_levels(void)
+{
+    capture_clear();
+    s_evaluated = 0;
+
+    // Below LOG_UTILS_COMPILE_MIN_LEVEL, whatever the runtime level
+    log_utils_set_min_level(LOG_UTILS_LEVEL_DEBUG);
+    LOG_UTILS_LOG_DEBUG("macro", "%d", evaluate());
+    LOG_UTILS_LOG_FIELDS(LOG_UTILS_LEVEL_DEBUG, "macro", "fields", LOG_UTILS_FIELD_INT("n", evaluate()));
+    LOG_UTILS_BIN_DEBUG("macro", "%d", evaluate());
+    assert(s_evaluated == 0 && s_capture.count == 0);
+
+    // Below the runtime level
+    log_utils_set_min_level(LOG_UTILS_LEVEL_WARN);
+    LOG_UTILS_LOG_INFO("macro", "%d", evaluate());
+    LOG_UTILS_LOG_FIELDS(LOG_UTILS_LEVEL_INFO, "macro", "fields", LOG_UTILS_FIELD_INT("n", evaluate()));
+    LOG_UTILS_BIN_INFO("macro", "%d", evaluate());
+    assert(s_evaluated == 0 && s_capture.count == 0);
+
+    // ERROR always passes
+    log_utils_set_min_level(LOG_UTILS_LEVEL_ERROR + 1);
+    LOG_UTILS_LOG_WARN("macro", "%d", evaluate());
+    LOG_UTILS_LOG_ERROR("macro", "%d", evaluate());
+    assert(s_evaluated == 1 && s_capture.count == 1);
+
+    log_utils_set_min_level(LOG_UTILS_LEVEL_INFO);
+    LOG_UTILS_LOG_INFO("macro", "%d", evaluate());
+    LOG_UTILS_LOG_FIELDS(LOG_UTILS_LEVEL_WARN, "macro", "fields", LOG_UTILS_FIELD_INT("n", evaluate()));
+    assert(s_evaluated == 3 && s_capture.count == 3);
+    expect_line(1, "INFO", "macro", "1");
+
+    log_utils_set_min_level(LOG_UTILS_LEVEL_DEBUG);
+}
+
+static bool same_double(double a, double b)
+{
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+static void test_field_types(void)
+{
+    static const double doubles[] = { 0.1, -2.5e300, 5e-324, 1.0 / 3, -0.0, 123456789.125 };
+
+    capture_clear();
+    LOG_UTILS_LOG_FIELDS(LOG_UTILS_LEVEL_INFO, "fields", "typed",
+                         LOG_UTILS_FIELD_INT("min", INT64_MIN),
+                         LOG_UTILS_FIELD_INT("max", INT64_MAX),
+                         LOG_UTILS_FIELD_INT("zero", 0),
+                         LOG_UTILS_FIELD_DOUBLE("d0", doubles[0]),
+                         LOG_UTILS_FIELD_DOUBLE("d1", doubles[1]),
+                         LOG_UTILS_FIELD_DOUBLE("d2", doubles[2]),
+                         LOG_UTILS_FIELD_DOUBLE("d3", doubles[3]),
+                         LOG_UTILS_FIELD_DOUBLE("d4", doubles[4]),
+                         LOG_UTILS_FIELD_DOUBLE("d5", doubles[5]),
+                         LOG_UTILS_FIELD_DOUBLE("nan", NAN),
+                         LOG_UTILS_FIELD_DOUBLE("inf", INFINITY),
+                         LOG_UTILS_FIELD_DOUBLE("-inf", -INFINITY),
+                         LOG_UTILS_FIELD_STRING("s", "a\"b\\c\n\xc3\xa9"),
+                         LOG_UTILS_FIELD_STRING("null", NULL),
+                         LOG_UTILS_FIELD_BOOL("t", true),
+                         LOG_UTILS_FIELD_BOOL("f", false),
+                         LOG_UTILS_FIELD_STRING("key \"escaped\"", ""));
+    assert(s_capture.count == 1);
+
+    t_json_utils_document* document = parse_line(0);
+    t_json_utils_value* root = json_utils_document_root(document);
+    assert(json_utils_value_count(root) == 4 + 17);
+
+    int64_t value;
+    assert(json_utils_value_int(json_utils_object_get(root, "min"), &value) && value == INT64_MIN);
+    assert(json_utils_value_int(json_utils_object_get(root, "max"), &value) && value == INT64_MAX);
+    assert(json_utils_value_int(json_utils_object_get(root, "zero"), &value) && value == 0);
+    for (int i = 0; i < 6; i++)
+    {
+        char key[4] = { 'd', (char)('0' + i), '\0' };
+        assert(same_double(json_utils_value_double(json_utils_object_get(root, key)), doubles[i]));
+    }
+
+    // JSON has no NaN or infinities
+    const char* nulls[] = { "nan", "inf", "-inf", "null" };
+    for (int i = 0; i < 4; i++)
+    {
+        t_json_utils_value* field = json_utils_object_get(root, nulls[i]);
+        assert(field != NULL && json_utils_value_type(field) == JSON_UTILS_TYPE_NULL);
+    }
+
+    assert(member_is(root, "s", "a\"b\\c\n\xc3\xa9") && member_is(root, "key \"escaped\"", ""));
+    assert(json_utils_value_type(json_utils_object_get(root, "t")) == JSON_UTILS_TYPE_BOOL);
+    assert(json_utils_value_bool(json_utils_object_get(root, "t")));
+    assert(!json_utils_value_bool(json_utils_object_get(root, "f")));
+    json_utils_document_free(document);
+}
+
+/* -------------------------------------------------------------------------- */
+/* File sinks                                                                 */
+/* -------------------------------------------------------------------------- */
+
+static char s_directory[] = "/tmp/log_utils_XXXXXX";
+
+static char* file_path(const char* name)
+{
+    static char paths[4][64];
+    static int next;
+    char* path = paths[next++ % 4];
+    snprintf(path, sizeof(paths[0]), "%s/%s", s_directory, name);
+    return path;
+}
+
+// Returns the contents of a file, or NULL if it does not exist
+static char* read_file(const char* path, size_t* len)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    static char data[1 << 16];
+    *len = fread(data, 1, sizeof(data), file);
+    assert(*len < sizeof(data));
+    data[*len] = '\0';
+    fclose(file);
+    return data;
+}
+
+static size_t file_size(const char* path)
+{
+    struct stat st;
+    return stat(path, &st) == 0 ? (size_t)st.st_size : SIZE_MAX;
+}
+
+// 100-byte line number i
+static const char* numbered_line(size_t i)
+{
+    static char line[101];
+    snprintf(line, sizeof(line), "%04zu%095d\n", i, 0);
+    return line;
+}
+
+static void test_file_sink_batching(void)
+{
+    const char* path = file_path("batch.log");
+    t_log_utils_file_sink_options options = { .buffer_size = 1000 };
+    t_log_utils_sink* sink = log_utils_sink_file_new(path, &options);
+    assert(sink != NULL);
+
+    // Nothing reaches the file before the buffer is full
+    for (size_t i = 0; i < 9; i++) log_utils_sink_write(sink, numbered_line(i), 100);
+    assert(file_size(path) == 0);
+    log_utils_sink_write(sink, numbered_line(9), 100);
+    assert(file_size(path) == 1000);
+
+    // A line that does not fit goes out with the buffer
+    log_utils_sink_write(sink, numbered_line(10), 100);
+    assert(file_size(path) == 1000);
+    static char large[2000];
+    memset(large, 'x', sizeof(large) - 1);
+    large[sizeof(large) - 1] = '\n';
+    log_utils_sink_write(sink, large, sizeof(large));
+    assert(file_size(path) == 1100 + sizeof(large));
+
+    log_utils_sink_write(sink, numbered_line(11), 100);
+    log_utils_sink_flush(sink);
+    assert(file_size(path) == 1200 + sizeof(large));
+    log_utils_sink_free(sink);
+
+    size_t len;
+    char* data = read_file(path, &len);
+    for (size_t i = 0; i < 11; i++) assert(memcmp(data + i * 100, numbered_line(i), 100) == 0);
+    assert(memcmp(data + 1100, large, sizeof(large)) == 0);
+    assert(memcmp(data + 1100 + sizeof(large), numbered_line(11), 100) == 0);
+    unlink(path);
+
+    // With a flush interval, a quiet buffer is written out by the background thread
+    options.flush_interval_ms = 10;
+    sink = log_utils_sink_file_new(path, &options);
+    log_utils_sink_write(sink, numbered_line(0), 100);
+    for (int wait = 0; wait < 200 && file_size(path) == 0; wait++) sleep_ms(5);
+    assert(file_size(path) == 100);
+    log_utils_sink_free(sink);
+    unlink(path);
+}
+
+// Size rotation keeps path.1 .. path.max_files, each holding whole lines, newest first
+static void test_size_rotation(bool mmap)
+{
+    char* path = file_path(mmap ? "mmap.log" : "file.log");
+    t_log_utils_file_sink_options options = { .buffer_size = 256, .max_file_size = 550, .max_files = 2 };
+    t_log_utils_sink* sink = mmap ? log_utils_sink_mmap_new(path, &options) : log_utils_sink_file_new(path, &options);
+    assert(sink != NULL);
+
+    // Five lines per file: files hold 20..24, 15..19 and 10..14, older ones are gone
+    for (size_t i = 0; i < 23; i++) log_utils_sink_write(sink, numbered_line(i), 100);
+    log_utils_sink_free(sink);
+
+    for (unsigned k = 0; k <= 3; k++)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), k ? "%s.%u" : "%s", path, k);
+        size_t len;
+        char* data = read_file(name, &len);
+        if (k == 3)
+        {
+            assert(data == NULL);
+            continue;
+        }
+
+        // The last file is cut to its lines, not to the end of its mapping window
+        size_t first = 20 - 5 * k, count = k ? 5 : 3;
+        assert(data != NULL && len == count * 100);
+        for (size_t i = 0; i < count; i++) assert(memcmp(data + i * 100, numbered_line(first + i), 100) == 0);
+        unlink(name);
+    }
+
+    // Without max_files the file is truncated instead
+    options.max_files = 0;
+    sink = mmap ? log_utils_sink_mmap_new(path, &options) : log_utils_sink_file_new(path, &options);
+    for (size_t i = 0; i < 7; i++) log_utils_sink_write(sink, numbered_line(i), 100);
+    log_utils_sink_free(sink);
+    size_t len;
+    char* data = read_file(path, &len);
+    assert(len == 200 && memcmp(data, numbered_line(5), 100) == 0 && file_size(file_path("x.log.1")) == SIZE_MAX);
+    unlink(path);
+}
+
+// The cached "date and second" prefix of timestamps is rebuilt when the second changes, and
+// a time-rotating file rotates on its first line of the new second: both across one boundary
+static void test_second_boundary(void)
+{
+    char* path = file_path("time.log");
+    char* rotated = file_path("time.log.1");
+    t_log_utils_file_sink_options options = { .rotate_interval = 1, .max_files = 1 };
+
+    capture_clear();
+    time_t next = sleep_past_second(-30);
+    t_log_utils_sink* sink = log_utils_sink_file_new(path, &options);
+    assert(sink != NULL);
+    log_utils_sink_write(sink, numbered_line(0), 100);
+    log_utils_sink_write(sink, numbered_line(1), 100);
+
+    struct timespec start, now;
+    clock_gettime(CLOCK_REALTIME, &start);
+    do
+    {
+        log_utils_info("time", "tick");
+        sleep_ms(2);
+        clock_gettime(CLOCK_REALTIME, &now);
+    } while (now.tv_sec < next || now.tv_nsec < 30000000);
+    log_utils_info("time", "tick");
+
+    int64_t first = line_time_ms(0), last = line_time_ms(s_capture.count - 1);
+    assert(first / 1000 < next && last / 1000 >= next);
+    for (size_t i = 1; i < s_capture.count; i++) assert(line_time_ms(i) >= line_time_ms(i - 1));
+
+    // Within the coarse clock's lag of the real one
+    assert(first >= (int64_t)start.tv_sec * 1000 + start.tv_nsec / 1000000 - 20);
+    assert(last <= (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000 + 1);
+
+    log_utils_sink_write(sink, numbered_line(2), 100);
+    log_utils_sink_free(sink);
+
+    size_t len;
+    char* data = read_file(rotated, &len);
+    assert(data != NULL && len == 200 && memcmp(data, numbered_line(0), 100) == 0);
+    data = read_file(path, &len);
+    assert(data != NULL && len == 100 && memcmp(data, numbered_line(2), 100) == 0);
+    unlink(path);
+    unlink(rotated);
+}
+
+static void test_mmap_sink(void)
+{
+    const char* path = file_path("window.log");
+    t_log_utils_file_sink_options options = { .buffer_size = 4096 };
+    t_log_utils_sink* sink = log_utils_sink_mmap_new(path, &options);
+    assert(sink != NULL);
+
+    // Lines cross window boundaries; one larger than half a window bypasses the mapping
+    static char large[3000];
+    memset(large, 'y', sizeof(large) - 1);
+    large[sizeof(large) - 1] = '\n';
+    for (size_t i = 0; i < 100; i++)
+    {
+        log_utils_sink_write(sink, numbered_line(i), 100);
+        if (i == 50) log_utils_sink_write(sink, large, sizeof(large));
+    }
+    log_utils_sink_flush(sink);
+    log_utils_sink_free(sink);
+
+    // Trimmed to the data when freed, and appended to when reopened
+    assert(file_size(path) == 100 * 100 + sizeof(large));
+    sink = log_utils_sink_mmap_new(path, &options);
+    log_utils_sink_write(sink, numbered_line(100), 100);
+    log_utils_sink_free(sink);
+
+    size_t len;
+    char* data = read_file(path, &len);
+    assert(len == 101 * 100 + sizeof(large));
+    for (size_t i = 0, offset = 0; i <= 100; i++)
+    {
+        assert(memcmp(data + offset, numbered_line(i), 100) == 0);
+        offset += 100;
+        if (i == 50)
+        {
+            assert(memcmp(data + offset, large, sizeof(large)) == 0);
+            offset += sizeof(large);
+        }
+    }
+    unlink(path);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Sink swap                                                                  */
+/* -------------------------------------------------------------------------- */
+
+#define SWAP_THREADS 3
+#define SWAP_SINKS   40
+
+typedef struct t_swap_sink
+{
+    atomic_bool   retired;  // Set once log_utils_set_sink() replaced it
+    atomic_size_t lines;
+} t_swap_sink;
+
+static atomic_bool s_swap_stop;
+
+// Slow on purpose, so that writers are often inside it when the sink is replaced
+static void swap_write(void* context, const char* line, size_t len)
+{
+    t_swap_sink* sink = context;
+    (void)line;
+    (void)len;
+
+    assert(!atomic_load(&sink->retired));
+    for (volatile int i = 0; i < 2000; i++) {}
+    atomic_fetch_add(&sink->lines, 1);
+    assert(!atomic_load(&sink->retired));
+}
+
+static void* swap_writer(void* context)
+{
+    (void)context;
+    while (!atomic_load(&s_swap_stop)) log_utils_info("swap", "line");
+    return NULL;
+}
+
+// A replaced sink is freed as soon as log_utils_set_sink() returns, while other threads keep logging
+static void test_sink_swap(t_log_utils_sink* restore)
+{
+    static t_swap_sink contexts[SWAP_SINKS];
+    t_log_utils_sink* sinks[SWAP_SINKS];
+    pthread_t threads[SWAP_THREADS];
+
+    for (int i = 0; i < SWAP_SINKS; i++)
+    {
+        atomic_init(&contexts[i].retired, false);
+        atomic_init(&contexts[i].lines, 0);
+        sinks[i] = log_utils_sink_new(swap_write, NULL, NULL, &contexts[i]);
+        assert(sinks[i] != NULL);
+    }
+
+    capture_clear();
+    atomic_store(&s_swap_stop, false);
+    log_utils_set_sink(sinks[0]);
+    for (int i = 0; i < SWAP_THREADS; i++) assert(pthread_create(&threads[i], NULL, swap_writer, NULL) == 0);
+
+    size_t total = 0;
+    for (int i = 1; i <= SWAP_SINKS; i++)
+    {
+        sleep_ms(1);
+        if (i == SWAP_SINKS)
+        {
+            // The capture sink is not thread-safe
+            atomic_store(&s_swap_stop, true);
+            for (int t = 0; t < SWAP_THREADS; t++) pthread_join(threads[t], NULL);
+        }
+        log_utils_set_sink(i < SWAP_SINKS ? sinks[i] : restore);
+        atomic_store(&contexts[i - 1].retired, true);
+        total += atomic_load(&contexts[i - 1].lines);
+        log_utils_sink_free(sinks[i - 1]);
+    }
+    assert(total > 0 && s_capture.count == 0);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Binary log                                                                 */
+/* -------------------------------------------------------------------------- */
+
+// Encodes with log_utils_bin, decodes with the tool, and compares with printf
+static void test_bin_round_trip(void)
+{
+#ifdef LOG_UTILS_DECODE_PATH
+    const char* path = file_path("binary.log");
+    char expected[8][256];
+    int lines = 0;
+
+    assert(log_utils_bin_open(path));
+    for (int i = 0; i < 3; i++)
+    {
+        LOG_UTILS_BIN_INFO("bin", "int %d str %s dbl %.3f u64 %llu neg %lld hex %#x %c %%", -5 - i, "h\"i",
+                           2.5 * i, 18446744073709551615ull, -9223372036854775807ll, 255u + i, 'z');
+        snprintf(expected[lines++], sizeof(expected[0]), "int %d str %s dbl %.3f u64 %llu neg %lld hex %#x %c %%",
+                 -5 - i, "h\"i", 2.5 * i, 18446744073709551615ull, -9223372036854775807ll, 255u + i, 'z');
+    }
+    LOG_UTILS_BIN_WARN(NULL, "no arguments");
+    snprintf(expected[lines++], sizeof(expected[0]), "no arguments");
+    LOG_UTILS_BIN_ERROR("stars", "[%*d|%-6s|%.2s|%hhd|%e]", 5, 42, "ab", "xyz", 300, 1e-7);
+    snprintf(expected[lines++], sizeof(expected[0]), "[%*d|%-6s|%.2s|%hhd|%e]",
+             5, 42, "ab", "xyz", (signed char)300, 1e-7);
+    log_utils_bin_close();
+
+    char command[512];
+    snprintf(command, sizeof(command), "'%s' '%s'", LOG_UTILS_DECODE_PATH, path);
+    FILE* decoded = popen(command, "r");
+    assert(decoded != NULL);
+
+    capture_clear();
+    char line[1024];
+    while (fgets(line, sizeof(line), decoded)) capture_write(&s_capture, line, strlen(line));
+    assert(pclose(decoded) == 0);
+    assert(s_capture.count == (size_t)lines);
+
+    for (int i = 0; i < lines; i++)
+    {
+        skip_timestamp(s_capture.lines[i]);
+        const char* level = i < 3 ? "INFO" : i == 3 ? "WARN" : "ERROR";
+        const char* context = i < 3 ? "bin" : i == 3 ? NULL : "stars";
+        expect_line((size_t)i, level, context, expected[i]);
+    }
+    unlink(path);
+#endif
+}
+
+int main(void)
+{
+    t_log_utils_sink* sink = log_utils_sink_new(capture_write, NULL, NULL, &s_capture);
+    assert(sink != NULL);
+    log_utils_set_sink(sink);
+
+    test_line_format();
+    test_macro_levels();
+    test_field_types();
+    test_reserved_fields();
+    test_flood_control();
+    test_sink_swap(sink);
+
+    assert(mkdtemp(s_directory) != NULL);
+    test_file_sink_batching();
+    test_size_rotation(false);
+    test_size_rotation(true);
+    test_second_boundary();
+    test_mmap_sink();
+    test_bin_round_trip();
+    assert(rmdir(s_directory) == 0);
+
+    log_utils_set_sink(NULL);
+    log_utils_sink_free(sink);
+    capture_clear();
+
+    printf("All tests passed!\n");
+    return 0;
+}
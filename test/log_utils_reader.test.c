@@ -0,0 +1,252 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "log_utils_reader.h"
+
+/*
+ * Log files are written to a temporary file and read back with every
+ * combination of thread count and chunk size, down to one byte per chunk,
+ * so each line boundary also falls on a chunk boundary.
+ */
+
+#define MAX_WORKERS 4
+
+static char s_path[] = "/tmp/log_utils_reader_XXXXXX";
+
+static void write_file(const char* data)
+{
+    FILE* file = fopen(s_path, "wb");
+    assert(file != NULL);
+    assert(fwrite(data, 1, strlen(data), file) == strlen(data));
+    fclose(file);
+}
+
+// Per-worker sums, so the callback needs no lock
+typedef struct t_collect
+{
+    uint64_t count[MAX_WORKERS];
+    uint64_t sum[MAX_WORKERS];    // Of the numbers in the contents
+    uint64_t levels[MAX_WORKERS][4];
+    size_t   stop_after;          // Only with one thread; 0 never stops
+} t_collect;
+
+static bool collect(void* context, unsigned worker, const t_log_utils_record* record)
+{
+    t_collect* collect = context;
+    assert(worker < MAX_WORKERS);
+    assert(record->timestamp_len == 23 && record->line[0] == '{' && record->line[record->line_len - 1] == '}');
+    assert(record->level >= LOG_UTILS_LEVEL_DEBUG && record->level <= LOG_UTILS_LEVEL_ERROR);
+
+    uint64_t number = 0;
+    for (size_t i = 0; i < record->content_len; i++) number = number * 10 + (uint64_t)(record->content[i] - '0');
+
+    collect->count[worker]++;
+    collect->sum[worker] += number;
+    collect->levels[worker][record->level]++;
+    return collect->stop_after == 0 || collect->count[worker] < collect->stop_after;
+}
+
+static uint64_t total(const uint64_t* values)
+{
+    uint64_t sum = 0;
+    for (int i = 0; i < MAX_WORKERS; i++) sum += values[i];
+    return sum;
+}
+
+static const char* s_levels[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+static const char* s_contexts[] = { "net", "a\\\"b", "disk" };  // As escaped in the line: a"b
+
+// Line i has level i % 4, context i % 3 and content i; odd lines end with CRLF
+static char* build_log(size_t lines)
+{
+    char* data = malloc(lines * 128 + 1);
+    assert(data != NULL);
+
+    size_t len = 0;
+    for (size_t i = 0; i < lines; i++)
+    {
+        len += (size_t)sprintf(data + len,
+                               "{ \"timestamp\": \"2024/01/02 03:04:05:678\", \"level\": \"%s\", \"context\": \"%s\", "
+                               "\"content\": \"%zu\" }%s",
+                               s_levels[i % 4], s_contexts[i % 3], i, i % 2 ? "\r\n" : "\n");
+    }
+    data[len] = '\0';
+    return data;
+}
+
+static void test_chunks(void)
+{
+    const size_t lines = 120;
+    char* data = build_log(lines);
+    write_file(data);
+    free(data);
+
+    const size_t chunk_sizes[] = { 1, 7, 64, 1000, 0 };
+    for (unsigned threads = 1; threads <= MAX_WORKERS; threads++)
+    {
+        for (size_t c = 0; c < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); c++)
+        {
+            t_log_utils_reader_options options = { .threads = threads, .chunk_size = chunk_sizes[c] };
+            t_log_utils_reader_stats stats;
+            t_collect result = { 0 };
+
+            assert(log_utils_reader_read_file(s_path, &options, collect, &result, &stats));
+            assert(stats.records == lines && stats.filtered == 0 && stats.malformed == 0);
+            assert(total(result.count) == lines && total(result.sum) == lines * (lines - 1) / 2);
+        }
+    }
+}
+
+static void test_filters(void)
+{
+    const size_t lines = 120;
+    char* data = build_log(lines);
+    write_file(data);
+    free(data);
+
+    for (unsigned threads = 1; threads <= 2; threads++)
+    {
+        // Level: WARN and ERROR lines
+        t_log_utils_reader_options options = { .threads = threads, .chunk_size = 100, .min_level = LOG_UTILS_LEVEL_WARN };
+        t_log_utils_reader_stats stats;
+        t_collect result = { 0 };
+        assert(log_utils_reader_read_file(s_path, &options, collect, &result, &stats));
+        assert(stats.records == lines / 2 && stats.filtered == lines / 2 && stats.malformed == 0);
+        for (int w = 0; w < MAX_WORKERS; w++) assert(result.levels[w][0] == 0 && result.levels[w][1] == 0);
+
+        // Context that is escaped in the line
+        options = (t_log_utils_reader_options){ .threads = threads, .chunk_size = 100, .context = "a\"b" };
+        memset(&result, 0, sizeof(result));
+        assert(log_utils_reader_read_file(s_path, &options, collect, &result, &stats));
+        assert(stats.records == lines / 3 && stats.filtered == lines - lines / 3);
+
+        uint64_t expected = 0;
+        for (size_t i = 1; i < lines; i += 3) expected += i;
+        assert(total(result.sum) == expected);
+
+        // Both, with a context that is a prefix of another
+        options.min_level = LOG_UTILS_LEVEL_ERROR;
+        options.context = "a";
+        memset(&result, 0, sizeof(result));
+        assert(log_utils_reader_read_file(s_path, &options, collect, &result, &stats));
+        assert(stats.records == 0 && stats.filtered == lines);
+
+        options.context = "net";
+        memset(&result, 0, sizeof(result));
+        assert(log_utils_reader_read_file(s_path, &options, collect, &result, &stats));
+        expected = 0;
+        for (size_t i = 3; i < lines; i += 12) expected += i;
+        assert(stats.records == lines / 12 && total(result.sum) == expected);
+    }
+}
+
+// Records checked one by one, in file order
+typedef struct t_expect
+{
+    const char* level;
+    const char* context;   // NULL for a null context
+    const char* content;   // NULL when absent
+    size_t      seen;
+} t_expect;
+
+static t_expect s_expected[8];
+
+static bool check(void* context, unsigned worker, const t_log_utils_record* record)
+{
+    (void)context;
+    (void)worker;
+    t_expect* expected = &s_expected[s_expected[0].seen++];
+
+    assert(strcmp(s_levels[record->level], expected->level) == 0);
+    if (expected->context) assert(record->context_len == strlen(expected->context) && memcmp(record->context, expected->context, record->context_len) == 0);
+    else assert(record->context == NULL);
+    if (expected->content) assert(record->content_len == strlen(expected->content) && memcmp(record->content, expected->content, record->content_len) == 0);
+    else assert(record->content == NULL);
+    return true;
+}
+
+static void test_records(void)
+{
+    write_file("{\"timestamp\": \"2024/01/02 03:04:05:678\", \"level\": \"INFO\", \"context\": null, \"content\": \"tab\\tand \\u00e9\"}\r\n"
+               "\r\n"
+               "not json\n"
+               "{\"level\": \"INFO\", \"context\": \"x\"}\n"
+               "{\"timestamp\": \"t\", \"level\": \"TRACE\"}\n"
+               "{\"timestamp\": \"t\", \"level\": 3}\n"
+               "{\"timestamp\": \"t\", \"level\": \"WARN\", \"fields\": {\"level\": \"DEBUG\", \"context\": \"inner\"}}\n"
+               "{\"timestamp\": \"t\", \"level\": \"ERROR\", \"context\": \"real\", \"level\": \"DEBUG\", \"context\": \"other\"}\n"
+               "{\"timestamp\": \"t\", \"level\": \"DEBUG\", \"context\": \"real\", \"content\": \"last\"}");
+
+    s_expected[0] = (t_expect){ "INFO", NULL, "tab\tand \xc3\xa9", 0 };
+    s_expected[1] = (t_expect){ "WARN", NULL, NULL, 0 };
+    s_expected[2] = (t_expect){ "ERROR", "real", NULL, 0 };
+    s_expected[3] = (t_expect){ "DEBUG", "real", "last", 0 };
+
+    t_log_utils_reader_options options = { .threads = 1 };
+    t_log_utils_reader_stats stats;
+    assert(log_utils_reader_read_file(s_path, &options, check, NULL, &stats));
+    assert(s_expected[0].seen == 4 && stats.records == 4 && stats.malformed == 4 && stats.filtered == 0);
+
+    // Repeated members keep their first value, before and after the raw filter
+    options.min_level = LOG_UTILS_LEVEL_INFO;
+    options.context = "real";
+    s_expected[0] = (t_expect){ "ERROR", "real", NULL, 0 };
+    assert(log_utils_reader_read_file(s_path, &options, check, NULL, &stats));
+    assert(s_expected[0].seen == 1 && stats.records == 1);
+}
+
+static void test_stop(void)
+{
+    char* data = build_log(100);
+    write_file(data);
+    free(data);
+
+    t_log_utils_reader_options options = { .threads = 1, .chunk_size = 10 };
+    t_log_utils_reader_stats stats;
+    t_collect result = { .stop_after = 5 };
+    assert(log_utils_reader_read_file(s_path, &options, collect, &result, &stats));
+    assert(result.count[0] == 5 && result.sum[0] == 0 + 1 + 2 + 3 + 4 && stats.records == 5);
+
+    // Several threads stop too, each after at most its current record
+    options.threads = MAX_WORKERS;
+    memset(&result, 0, sizeof(result));
+    result.stop_after = 1;
+    assert(log_utils_reader_read_file(s_path, &options, collect, &result, &stats));
+    assert(total(result.count) >= 1 && total(result.count) <= MAX_WORKERS && stats.records == total(result.count));
+}
+
+static void test_files(void)
+{
+    t_log_utils_reader_stats stats = { 1, 1, 1 };
+    t_collect result = { 0 };
+
+    write_file("");
+    assert(log_utils_reader_read_file(s_path, NULL, collect, &result, &stats));
+    assert(stats.records == 0 && stats.filtered == 0 && stats.malformed == 0);
+
+    assert(!log_utils_reader_read_file("/nonexistent/log", NULL, collect, &result, &stats));
+    assert(!log_utils_reader_read_file(s_path, NULL, NULL, &result, &stats));
+}
+
+int main(void)
+{
+    int fd = mkstemp(s_path);
+    assert(fd >= 0);
+    close(fd);
+
+    test_chunks();
+    test_filters();
+    test_records();
+    test_stop();
+    test_files();
+
+    unlink(s_path);
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,355 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "math_utils.h"
+
+/*
+ * Array kernels against plain loops written from their documentation: the
+ * same pairwise tree for sums, the same groups of four and chunks for
+ * prefix sums, so every result must match bit for bit. CTest runs this
+ * file once per SIMD level.
+ */
+
+#define SUM_BLOCK    256
+#define SUM_LANES    16
+#define PREFIX_CHUNK ((size_t)1 << 16)
+
+static uint64_t s_state = 0x9e3779b97f4a7c15ull;
+
+static uint64_t next_random(void)
+{
+    s_state ^= s_state << 13;
+    s_state ^= s_state >> 7;
+    s_state ^= s_state << 17;
+    return s_state;
+}
+
+static bool same_float(float a, float b)
+{
+    return memcmp(&a, &b, sizeof(a)) == 0 || (isnan(a) && isnan(b));
+}
+
+// Finite, of mixed scales and signs
+static float random_finite(void)
+{
+    uint64_t r = next_random();
+    float unit = (float)(r >> 40) * 0x1.0p-24f - 0.5f;
+    return ldexpf(unit, (int)(r >> 20 & 15) - 4);
+}
+
+// Finite values, NaN at nan_rate in 1/64ths, and special values now and then
+static float random_float(unsigned nan_rate)
+{
+    static const float special[] = { 0.0f, -0.0f, 1e-45f, -1e-40f, 3e38f, -3e38f, INFINITY, -INFINITY };
+    uint64_t r = next_random();
+
+    if ((r & 63) < nan_rate) return NAN;
+    if ((r >> 6 & 63) == 0) return special[(r >> 12) % (sizeof(special) / sizeof(special[0]))];
+    return random_finite();
+}
+
+static int32_t random_int(void)
+{
+    uint64_t r = next_random();
+    switch (r & 3)
+    {
+        case 0: return (int32_t)(uint32_t)(r >> 32);
+        case 1: return (int32_t)(r >> 32 & 0xffff) - 0x8000;
+        case 2: return r & 4 ? INT32_MAX - (int32_t)(r >> 60) : INT32_MIN + (int32_t)(r >> 60);
+        default: return (int32_t)(r >> 32 & 15) - 8;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* References                                                                 */
+/* -------------------------------------------------------------------------- */
+
+// Element i of a block goes to lane i % 16, then lanes fold in halves
+static float reference_block_sum(const float* values, size_t count)
+{
+    float lanes[SUM_LANES] = { 0.0f };
+    for (size_t i = 0; i < count; i++) lanes[i % SUM_LANES] += values[i];
+    for (size_t width = SUM_LANES / 2; width > 0; width /= 2)
+    {
+        for (size_t j = 0; j < width; j++) lanes[j] += lanes[j + width];
+    }
+    return lanes[0];
+}
+
+// Block sums merged pairwise as a binary counter, what is left added from the most recent
+static float reference_sumf(const float* values, size_t count)
+{
+    float sums[64];
+    unsigned levels[64];
+    unsigned depth = 0;
+
+    for (size_t i = 0; i < count; i += SUM_BLOCK)
+    {
+        float sum = reference_block_sum(values + i, count - i < SUM_BLOCK ? count - i : SUM_BLOCK);
+        unsigned level = 0;
+        while (depth > 0 && levels[depth - 1] == level)
+        {
+            sum = sums[--depth] + sum;
+            level++;
+        }
+        sums[depth] = sum;
+        levels[depth++] = level;
+    }
+
+    if (depth == 0) return 0.0f;
+    float total = sums[depth - 1];
+    for (unsigned i = depth - 1; i-- > 0;) total = sums[i] + total;
+    return total;
+}
+
+// Groups of four summed as a tree then added to the running total, restarted every chunk
+static void reference_prefix_sumf(float* out, const float* values, size_t count)
+{
+    float offset = 0.0f;
+    for (size_t begin = 0; begin < count; begin += PREFIX_CHUNK)
+    {
+        size_t chunk = count - begin < PREFIX_CHUNK ? count - begin : PREFIX_CHUNK;
+        const float* x = values + begin;
+        float* o = out + begin;
+        float total = 0.0f;
+        size_t i = 0;
+
+        for (; i + 4 <= chunk; i += 4)
+        {
+            float s0 = x[i] + 0.0f, s1 = x[i + 1] + x[i], s2 = x[i + 2] + x[i + 1], s3 = x[i + 3] + x[i + 2];
+            float t0 = s0 + 0.0f, t1 = s1 + 0.0f, t2 = s2 + s0, t3 = s3 + s1;
+            o[i] = t0 + total;
+            o[i + 1] = t1 + total;
+            o[i + 2] = t2 + total;
+            o[i + 3] = total = t3 + total;
+        }
+        for (; i < chunk; i++) o[i] = total = total + x[i];
+
+        if (begin > 0)
+        {
+            for (i = 0; i < chunk; i++) o[i] += offset;
+        }
+        offset = offset + total;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* Tests                                                                      */
+/* -------------------------------------------------------------------------- */
+
+static void test_scalars(void)
+{
+    assert(math_utils_clampf(-2.0f, -1.0f, 1.0f) == -1.0f);
+    assert(math_utils_clampf(2.0f, -1.0f, 1.0f) == 1.0f);
+    assert(math_utils_clampf(0.5f, -1.0f, 1.0f) == 0.5f);
+    assert(isnan(math_utils_clampf(NAN, -1.0f, 1.0f)));
+    assert(math_utils_clamp(-5, 0, 10) == 0 && math_utils_clamp(15, 0, 10) == 10 && math_utils_clamp(5, 0, 10) == 5);
+    assert(math_utils_max(1.0f, 2.0f) == 2.0f && math_utils_min(1.0f, 2.0f) == 1.0f);
+}
+
+static void check_floats(const float* values, size_t count)
+{
+    static float out[4096], expected[4096];
+
+    math_utils_array_clampf(out, values, count, -0.25f, 0.5f);
+    for (size_t i = 0; i < count; i++) assert(same_float(out[i], math_utils_clampf(values[i], -0.25f, 0.5f)));
+
+    float min = INFINITY, max = -INFINITY;
+    size_t argmin = SIZE_MAX, argmax = SIZE_MAX;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (values[i] < min || (argmin == SIZE_MAX && values[i] == min))
+        {
+            min = values[i];
+            argmin = i;
+        }
+        if (values[i] > max || (argmax == SIZE_MAX && values[i] == max))
+        {
+            max = values[i];
+            argmax = i;
+        }
+    }
+
+    // Among zeros of both signs, either may come back
+    float found = math_utils_array_minf(values, count);
+    assert(argmin == SIZE_MAX ? isnan(found) : found == min);
+    found = math_utils_array_maxf(values, count);
+    assert(argmax == SIZE_MAX ? isnan(found) : found == max);
+    assert(math_utils_array_argminf(values, count) == argmin);
+    assert(math_utils_array_argmaxf(values, count) == argmax);
+
+    assert(same_float(math_utils_array_sumf(values, count), reference_sumf(values, count)));
+
+    math_utils_array_prefix_sumf(out, values, count);
+    reference_prefix_sumf(expected, values, count);
+    for (size_t i = 0; i < count; i++) assert(same_float(out[i], expected[i]));
+}
+
+static void check_ints(const int32_t* values, size_t count)
+{
+    static int32_t out[4096];
+
+    math_utils_array_clamp(out, values, count, -1000, 70000);
+    for (size_t i = 0; i < count; i++) assert(out[i] == math_utils_clamp(values[i], -1000, 70000));
+
+    int32_t min = INT32_MAX, max = INT32_MIN;
+    size_t argmin = SIZE_MAX, argmax = SIZE_MAX;
+    int64_t sum = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (argmin == SIZE_MAX || values[i] < min)
+        {
+            min = values[i];
+            argmin = i;
+        }
+        if (argmax == SIZE_MAX || values[i] > max)
+        {
+            max = values[i];
+            argmax = i;
+        }
+        sum += values[i];
+    }
+
+    assert(math_utils_array_min(values, count) == min && math_utils_array_max(values, count) == max);
+    assert(math_utils_array_argmin(values, count) == argmin && math_utils_array_argmax(values, count) == argmax);
+    assert(math_utils_array_sum(values, count) == sum);
+
+    math_utils_array_prefix_sum(out, values, count);
+    uint32_t running = 0;
+    for (size_t i = 0; i < count; i++) assert(out[i] == (int32_t)(running += (uint32_t)values[i]));
+}
+
+// Every length up to a few vectors and blocks, at every alignment
+static void test_small_arrays(void)
+{
+    static float floats[4096 + 8];
+    static int32_t ints[4096 + 8];
+    static const unsigned nan_rates[] = { 0, 4, 64 };
+
+    for (size_t count = 0; count <= 4096; count += count < 100 ? 1 : count < 600 ? 13 : 511)
+    {
+        for (size_t offset = 0; offset < 8; offset += count < 100 ? 1 : 3)
+        {
+            for (size_t r = 0; r < sizeof(nan_rates) / sizeof(nan_rates[0]); r++)
+            {
+                for (size_t i = 0; i < count; i++) floats[offset + i] = random_float(nan_rates[r]);
+                check_floats(floats + offset, count);
+            }
+            for (size_t i = 0; i < count; i++) ints[offset + i] = random_int();
+            check_ints(ints + offset, count);
+        }
+    }
+
+    // Only zeros of both signs, and only infinities
+    float zeros[37], infinities[37];
+    for (size_t i = 0; i < 37; i++)
+    {
+        zeros[i] = i % 3 ? 0.0f : -0.0f;
+        infinities[i] = i % 5 ? INFINITY : -INFINITY;
+    }
+    check_floats(zeros, 37);
+    check_floats(infinities, 37);
+    assert(math_utils_array_argminf(infinities, 37) == 0 && math_utils_array_argmaxf(infinities, 37) == 1);
+    assert(isnan(math_utils_array_sumf(infinities, 37)));
+}
+
+static void test_empty(void)
+{
+    float f = 1.0f;
+    int32_t n = 1;
+    assert(isnan(math_utils_array_minf(&f, 0)) && isnan(math_utils_array_maxf(&f, 0)));
+    assert(math_utils_array_min(&n, 0) == INT32_MAX && math_utils_array_max(&n, 0) == INT32_MIN);
+    assert(math_utils_array_argminf(&f, 0) == SIZE_MAX && math_utils_array_argmax(&n, 0) == SIZE_MAX);
+    assert(math_utils_array_sumf(&f, 0) == 0.0f && math_utils_array_sum(&n, 0) == 0);
+}
+
+static void test_in_place(void)
+{
+    float floats[1000], expected[1000];
+    int32_t ints[1000];
+    for (size_t i = 0; i < 1000; i++)
+    {
+        floats[i] = random_float(0);
+        ints[i] = random_int();
+    }
+
+    reference_prefix_sumf(expected, floats, 1000);
+    math_utils_array_prefix_sumf(floats, floats, 1000);
+    for (size_t i = 0; i < 1000; i++) assert(same_float(floats[i], expected[i]));
+
+    math_utils_array_clampf(floats, floats, 1000, -1.0f, 1.0f);
+    for (size_t i = 0; i < 1000; i++) assert(same_float(floats[i], math_utils_clampf(expected[i], -1.0f, 1.0f)));
+
+    int32_t first = ints[0], second = ints[1];
+    math_utils_array_prefix_sum(ints, ints, 1000);
+    assert(ints[0] == first && ints[1] == (int32_t)((uint32_t)first + (uint32_t)second));
+}
+
+// Past the chunk size of prefix sums and the threshold for threads
+static void test_large_arrays(void)
+{
+    size_t count = ((size_t)1 << 22) + 3 * PREFIX_CHUNK + 1001;
+    float* floats = malloc(count * sizeof(float));
+    float* out = malloc(count * sizeof(float));
+    float* expected = malloc(count * sizeof(float));
+    int32_t* ints = malloc(count * sizeof(int32_t));
+    int32_t* int_out = malloc(count * sizeof(int32_t));
+    assert(floats != NULL && out != NULL && expected != NULL && ints != NULL && int_out != NULL);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        floats[i] = random_finite();
+        ints[i] = random_int();
+    }
+    floats[count - 7] = NAN;
+
+    size_t argmax = 0, argmin = 0;
+    for (size_t i = 1; i < count; i++)
+    {
+        if (floats[i] > floats[argmax]) argmax = i;
+        if (ints[i] < ints[argmin]) argmin = i;
+    }
+
+    assert(same_float(math_utils_array_sumf(floats, count), reference_sumf(floats, count)));
+    assert(math_utils_array_maxf(floats, count) == floats[argmax] && math_utils_array_argmaxf(floats, count) == argmax);
+    assert(math_utils_array_min(ints, count) == ints[argmin] && math_utils_array_argmin(ints, count) == argmin);
+
+    math_utils_array_prefix_sumf(out, floats, count);
+    reference_prefix_sumf(expected, floats, count);
+    for (size_t i = 0; i < count; i++) assert(same_float(out[i], expected[i]));
+
+    math_utils_array_clampf(out, floats, count, -0.5f, 0.5f);
+    for (size_t i = 0; i < count; i++) assert(same_float(out[i], math_utils_clampf(floats[i], -0.5f, 0.5f)));
+
+    int64_t sum = 0;
+    uint32_t running = 0;
+    math_utils_array_prefix_sum(int_out, ints, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        sum += ints[i];
+        assert(int_out[i] == (int32_t)(running += (uint32_t)ints[i]));
+    }
+    assert(math_utils_array_sum(ints, count) == sum);
+
+    free(floats);
+    free(out);
+    free(expected);
+    free(ints);
+    free(int_out);
+}
+
+int main(void)
+{
+    test_scalars();
+    test_empty();
+    test_small_arrays();
+    test_in_place();
+    test_large_arrays();
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,286 @@
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "math_utils.h"
+#include "math_utils_vec2.h"
+
+/*
+ * Batch kernels against the single-vector functions, bit for bit except
+ * for the documented fma rounding and the fast normalize. CTest runs this
+ * file once per SIMD level, so the scalar, SSE2 and AVX2 kernels all face
+ * the same checks.
+ */
+
+static uint32_t s_seed = 1;
+
+static float next_float(float scale)
+{
+    s_seed = s_seed * 1103515245u + 12345u;
+    return ((float)(s_seed >> 8) * 0x1.0p-24f - 0.5f) * scale;
+}
+
+static bool same_float(float a, float b)
+{
+    return memcmp(&a, &b, sizeof(a)) == 0 || (isnan(a) && isnan(b));
+}
+
+// Random vectors of all scales, then every pair of special components
+static t_math_utils_vec2_buffer* make_vectors(size_t count)
+{
+    static const float special[] =
+    {
+        0.0f, -0.0f, 1e-45f, 1e-40f, 1e-20f, 1e-19f, 1.0f, 3.0f, 1e19f, 2e19f, 1e30f, 3e38f, INFINITY, -INFINITY, NAN
+    };
+    const size_t specials = sizeof(special) / sizeof(special[0]);
+
+    t_math_utils_vec2_buffer* buffer = math_utils_vec2_buffer_new(0);
+    assert(buffer != NULL);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        float scale = i % 3 == 0 ? 1e3f : i % 3 == 1 ? 1.0f : 1e-3f;
+        assert(math_utils_vec2_buffer_push(buffer, math_utils_vec2(next_float(scale), next_float(scale))));
+    }
+    for (size_t i = 0; i < specials; i++)
+    {
+        for (size_t j = 0; j < specials; j++)
+        {
+            float y = j % 2 ? -special[j] : special[j];
+            assert(math_utils_vec2_buffer_push(buffer, math_utils_vec2(special[i], y)));
+        }
+    }
+    return buffer;
+}
+
+// Copies the first count vectors, so kernels see every tail length
+static t_math_utils_vec2_buffer* prefix(const t_math_utils_vec2_buffer* source, size_t count)
+{
+    t_math_utils_vec2_buffer* buffer = math_utils_vec2_buffer_new(count);
+    assert(buffer != NULL && math_utils_vec2_buffer_resize(buffer, count));
+    memcpy(buffer->x, source->x, count * sizeof(float));
+    memcpy(buffer->y, source->y, count * sizeof(float));
+    return buffer;
+}
+
+static void test_buffer(void)
+{
+    t_math_utils_vec2_buffer* buffer = math_utils_vec2_buffer_new(3);
+    assert(buffer != NULL && buffer->count == 0 && buffer->capacity >= 3);
+
+    for (int i = 0; i < 100; i++) assert(math_utils_vec2_buffer_push(buffer, math_utils_vec2((float)i, (float)-i)));
+    assert(buffer->count == 100 && buffer->capacity >= 100);
+    assert((uintptr_t)buffer->x % 64 == 0 && (uintptr_t)buffer->y % 64 == 0);
+    assert(math_utils_vec2_buffer_get(buffer, 42).x == 42 && math_utils_vec2_buffer_get(buffer, 42).y == -42);
+
+    // Shrinking then growing again gives zero vectors
+    assert(math_utils_vec2_buffer_resize(buffer, 10));
+    assert(math_utils_vec2_buffer_resize(buffer, 50));
+    assert(buffer->count == 50 && buffer->x[9] == 9 && buffer->x[10] == 0 && buffer->y[49] == 0);
+
+    assert(math_utils_vec2_buffer_reserve(buffer, 1000) && buffer->capacity >= 1000 && buffer->count == 50);
+    math_utils_vec2_buffer_free(buffer);
+}
+
+static bool same_vec2(t_math_utils_vec2 v, float x, float y)
+{
+    return same_float(v.x, x) && same_float(v.y, y);
+}
+
+// Close to the exact result of an angle that float cannot hold, such as pi / 2
+static bool near_vec2(t_math_utils_vec2 v, float x, float y, float scale)
+{
+    return fabsf(v.x - x) <= 4e-7f * scale && fabsf(v.y - y) <= 4e-7f * scale;
+}
+
+// Inputs are chosen so that every product is exact, whether the compiler fuses them or not
+static void test_geometry(void)
+{
+    const float pi = 3.14159265358979f;
+    t_math_utils_vec2 a = math_utils_vec2(3, -4), b = math_utils_vec2(2, 5);
+
+    assert(math_utils_vec2_dot(a, b) == -14 && math_utils_vec2_dot(b, a) == -14);
+    assert(math_utils_vec2_dot(math_utils_vec2(0.5f, 0.25f), math_utils_vec2(4, 8)) == 4);
+    assert(math_utils_vec2_dot(math_utils_vec2(1, 2), math_utils_vec2(-2, 1)) == 0);
+
+    // Positive when the second vector is counterclockwise from the first
+    assert(math_utils_vec2_cross(math_utils_vec2(1, 0), math_utils_vec2(0, 1)) == 1);
+    assert(math_utils_vec2_cross(math_utils_vec2(0, 1), math_utils_vec2(1, 0)) == -1);
+    assert(math_utils_vec2_cross(a, b) == 23 && math_utils_vec2_cross(b, a) == -23);
+    assert(math_utils_vec2_cross(math_utils_vec2(2, 3), math_utils_vec2(-4, -6)) == 0);
+
+    // 3-4-5 triangles, also where the squares overflow or underflow
+    assert(math_utils_vec2_distance_squared(math_utils_vec2(1, 2), math_utils_vec2(4, 6)) == 25);
+    assert(math_utils_vec2_distance(math_utils_vec2(1, 2), math_utils_vec2(4, 6)) == 5);
+    assert(math_utils_vec2_distance(math_utils_vec2(4, 6), math_utils_vec2(1, 2)) == 5);
+    assert(math_utils_vec2_distance(a, a) == 0);
+    assert(math_utils_vec2_distance(math_utils_vec2(0x1p70f, 0), math_utils_vec2(-0x2p70f, 0x4p70f)) == 0x5p70f);
+    assert(math_utils_vec2_distance(math_utils_vec2(0x3p-80f, 0x4p-80f), math_utils_vec2(0, 0)) == 0x5p-80f);
+
+    // Both ends exact, whatever the values; halfway and beyond the ends
+    t_math_utils_vec2 p = math_utils_vec2(0.1f, 1e30f), q = math_utils_vec2(-7.3f, 3.3f);
+    assert(same_vec2(math_utils_vec2_lerp(p, q, 0), p.x, p.y));
+    assert(same_vec2(math_utils_vec2_lerp(p, q, 1), q.x, q.y));
+    assert(same_vec2(math_utils_vec2_lerp(math_utils_vec2(0, 0), math_utils_vec2(2, 4), 0.5f), 1, 2));
+    assert(same_vec2(math_utils_vec2_lerp(math_utils_vec2(4, 8), math_utils_vec2(8, 0), 0.25f), 5, 6));
+    assert(same_vec2(math_utils_vec2_lerp(math_utils_vec2(0, 0), math_utils_vec2(1, -1), 2), 2, -2));
+    assert(same_vec2(math_utils_vec2_lerp(math_utils_vec2(0, 0), math_utils_vec2(1, -1), -1), -1, 1));
+
+    // Over axis normals the reflection is exact; over an oblique one it is undone by a second
+    assert(same_vec2(math_utils_vec2_reflect(math_utils_vec2(1, -1), math_utils_vec2(0, 1)), 1, 1));
+    assert(same_vec2(math_utils_vec2_reflect(math_utils_vec2(3, 4), math_utils_vec2(1, 0)), -3, 4));
+    assert(same_vec2(math_utils_vec2_reflect(math_utils_vec2(3, 4), math_utils_vec2(-1, 0)), -3, 4));
+    assert(same_vec2(math_utils_vec2_reflect(math_utils_vec2(3, 0), math_utils_vec2(0, 1)), 3, 0));
+    t_math_utils_vec2 n = math_utils_vec2(0.6f, 0.8f);
+    t_math_utils_vec2 r = math_utils_vec2_reflect(math_utils_vec2(1, 0), n);
+    assert(near_vec2(r, 0.28f, -0.96f, 1));
+    assert(near_vec2(math_utils_vec2_reflect(r, n), 1, 0, 1));
+
+    // Counterclockwise; quarter and half turns land on the axes
+    assert(same_vec2(math_utils_vec2_rotate(a, 0), 3, -4));
+    assert(near_vec2(math_utils_vec2_rotate(math_utils_vec2(1, 0), pi / 2), 0, 1, 1));
+    assert(near_vec2(math_utils_vec2_rotate(math_utils_vec2(1, 0), -pi / 2), 0, -1, 1));
+    assert(near_vec2(math_utils_vec2_rotate(math_utils_vec2(1, 0), pi), -1, 0, 1));
+    assert(near_vec2(math_utils_vec2_rotate(math_utils_vec2(0, 1), pi / 2), -1, 0, 1));
+    assert(near_vec2(math_utils_vec2_rotate(a, pi / 2), 4, 3, 5));
+    assert(near_vec2(math_utils_vec2_rotate(a, -pi / 2), -4, -3, 5));
+    assert(near_vec2(math_utils_vec2_rotate(a, pi), -3, 4, 5));
+    assert(near_vec2(math_utils_vec2_rotate(a, -pi), -3, 4, 5));
+    assert(near_vec2(math_utils_vec2_rotate(a, 2 * pi), 3, -4, 5));
+}
+
+static void test_arithmetic(void)
+{
+    t_math_utils_vec2_buffer* all_a = make_vectors(1000);
+    t_math_utils_vec2_buffer* all_b = make_vectors(1000);
+    t_math_utils_vec2_buffer* out = math_utils_vec2_buffer_new(0);
+    static float dots[2000];
+
+    for (size_t count = 0; count <= all_a->count; count += count < 40 ? 1 : 97)
+    {
+        t_math_utils_vec2_buffer* a = prefix(all_a, count);
+        t_math_utils_vec2_buffer* b = prefix(all_b, count);
+
+        assert(math_utils_vec2_buffer_add(out, a, b) && out->count == count);
+        for (size_t i = 0; i < count; i++)
+        {
+            t_math_utils_vec2 v = math_utils_vec2_add(math_utils_vec2_buffer_get(a, i), math_utils_vec2_buffer_get(b, i));
+            assert(same_float(out->x[i], v.x) && same_float(out->y[i], v.y));
+        }
+
+        assert(math_utils_vec2_buffer_sub(out, a, b) && out->count == count);
+        for (size_t i = 0; i < count; i++)
+        {
+            t_math_utils_vec2 v = math_utils_vec2_sub(math_utils_vec2_buffer_get(a, i), math_utils_vec2_buffer_get(b, i));
+            assert(same_float(out->x[i], v.x) && same_float(out->y[i], v.y));
+        }
+
+        assert(math_utils_vec2_buffer_scale(out, a, -2.5f) && out->count == count);
+        for (size_t i = 0; i < count; i++)
+        {
+            t_math_utils_vec2 v = math_utils_vec2_scale(math_utils_vec2_buffer_get(a, i), -2.5f);
+            assert(same_float(out->x[i], v.x) && same_float(out->y[i], v.y));
+        }
+
+        assert(math_utils_vec2_buffer_dot(dots, a, b));
+        for (size_t i = 0; i < count; i++)
+        {
+            assert(same_float(dots[i], math_utils_vec2_dot(math_utils_vec2_buffer_get(a, i), math_utils_vec2_buffer_get(b, i))));
+        }
+
+        // Fused or not, depending on the level
+        assert(math_utils_vec2_buffer_fma(out, a, 0.75f, b) && out->count == count);
+        for (size_t i = 0; i < count; i++)
+        {
+            volatile float px = a->x[i] * 0.75f, py = a->y[i] * 0.75f;
+            assert(same_float(out->x[i], px + b->x[i]) || same_float(out->x[i], fmaf(a->x[i], 0.75f, b->x[i])));
+            assert(same_float(out->y[i], py + b->y[i]) || same_float(out->y[i], fmaf(a->y[i], 0.75f, b->y[i])));
+        }
+
+        t_math_utils_vec2 min = math_utils_vec2(-1, -0.5f), max = math_utils_vec2(0.25f, 2);
+        assert(math_utils_vec2_buffer_clamp(out, a, min, max) && out->count == count);
+        for (size_t i = 0; i < count; i++)
+        {
+            assert(same_float(out->x[i], math_utils_clampf(a->x[i], min.x, max.x)));
+            assert(same_float(out->y[i], math_utils_clampf(a->y[i], min.y, max.y)));
+        }
+
+        // In place: out is an input
+        assert(math_utils_vec2_buffer_add(a, a, b));
+        for (size_t i = 0; i < count; i++) assert(same_float(a->x[i], all_a->x[i] + b->x[i]));
+
+        math_utils_vec2_buffer_free(a);
+        math_utils_vec2_buffer_free(b);
+    }
+
+    // Inputs of different counts
+    t_math_utils_vec2_buffer* short_b = prefix(all_b, 5);
+    assert(!math_utils_vec2_buffer_add(out, all_a, short_b));
+    assert(!math_utils_vec2_buffer_dot(dots, all_a, short_b));
+    math_utils_vec2_buffer_free(short_b);
+
+    math_utils_vec2_buffer_free(all_a);
+    math_utils_vec2_buffer_free(all_b);
+    math_utils_vec2_buffer_free(out);
+}
+
+static void test_length_normalize(void)
+{
+    t_math_utils_vec2_buffer* all = make_vectors(1000);
+    t_math_utils_vec2_buffer* exact = math_utils_vec2_buffer_new(0);
+    t_math_utils_vec2_buffer* fast = math_utils_vec2_buffer_new(0);
+    static float lengths[2000];
+
+    for (size_t count = 0; count <= all->count; count += count < 40 ? 1 : 97)
+    {
+        t_math_utils_vec2_buffer* a = prefix(all, count);
+
+        math_utils_vec2_buffer_length(lengths, a);
+        assert(math_utils_vec2_buffer_normalize_fast(fast, a) && fast->count == count);
+#ifndef MATH_UTILS_VEC2_FAST_MATH
+        assert(math_utils_vec2_buffer_normalize(exact, a) && exact->count == count);
+#endif
+
+        for (size_t i = 0; i < count; i++)
+        {
+            t_math_utils_vec2 v = math_utils_vec2_buffer_get(a, i);
+            t_math_utils_vec2 u = math_utils_vec2_normalize(v);
+            assert(same_float(lengths[i], math_utils_vec2_length(v)));
+#ifndef MATH_UTILS_VEC2_FAST_MATH
+            assert(same_float(exact->x[i], u.x) && same_float(exact->y[i], u.y));
+#endif
+            assert(fabsf(fast->x[i] - u.x) <= 4e-7f && fabsf(fast->y[i] - u.y) <= 4e-7f);
+
+            // Within a few ulps of the double-precision result, at every scale
+            double h = hypot(v.x, v.y);
+            if (isfinite(h) && h > 0)
+            {
+                assert(fabs(u.x - v.x / h) <= 2e-7 && fabs(u.y - v.y / h) <= 2e-7);
+                if (h <= FLT_MAX) assert(fabs(lengths[i] - h) <= 2e-7 * h + 1e-45);
+            }
+            else assert(u.x == 0 && u.y == 0 && fast->x[i] == 0 && fast->y[i] == 0);
+        }
+
+        // In place
+        assert(math_utils_vec2_buffer_normalize_fast(a, a));
+        assert(memcmp(a->x, fast->x, count * sizeof(float)) == 0 && memcmp(a->y, fast->y, count * sizeof(float)) == 0);
+        math_utils_vec2_buffer_free(a);
+    }
+
+    math_utils_vec2_buffer_free(all);
+    math_utils_vec2_buffer_free(exact);
+    math_utils_vec2_buffer_free(fast);
+}
+
+int main(void)
+{
+    test_buffer();
+    test_geometry();
+    test_arithmetic();
+    test_length_normalize();
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,614 @@
+#include <assert.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rand_utils.h"
+
+/*
+ * Bulk fills are checked against a scalar model of the documented stream:
+ * value i of a group comes from lane i % 8, stepped with
+ * rand_utils_state_next(), and a call drops what is left of its last group.
+ * CTest runs this file once per SIMD level, so every kernel must match it.
+ */
+typedef struct t_model
+{
+    t_rand_utils_state lanes[RAND_UTILS_LANES];
+    uint64_t           group[RAND_UTILS_LANES];
+    size_t             position;
+} t_model;
+
+static void model_init(t_model* model, const t_rand_utils_lanes* lanes)
+{
+    for (int lane = 0; lane < RAND_UTILS_LANES; lane++)
+    {
+        for (int w = 0; w < 4; w++) model->lanes[lane].s[w] = lanes->s[w][lane];
+    }
+    model->position = RAND_UTILS_LANES;
+}
+
+static uint64_t model_next(t_model* model)
+{
+    if (model->position == RAND_UTILS_LANES)
+    {
+        for (int lane = 0; lane < RAND_UTILS_LANES; lane++) model->group[lane] = rand_utils_state_next(&model->lanes[lane]);
+        model->position = 0;
+    }
+    return model->group[model->position++];
+}
+
+// Ends a bulk call: the rest of the group is dropped
+static void model_end_call(t_model* model)
+{
+    model->position = RAND_UTILS_LANES;
+}
+
+// Two 32-bit draws per raw value, low half first
+typedef struct t_model_draws
+{
+    t_model* model;
+    uint64_t raw;
+    bool     high;
+} t_model_draws;
+
+static uint32_t model_draw(t_model_draws* draws)
+{
+    if (!draws->high) draws->raw = model_next(draws->model);
+    draws->high = !draws->high;
+    return (uint32_t)(draws->raw >> (draws->high ? 0 : 32));
+}
+
+static uint64_t multiply_high(uint64_t a, uint64_t b, uint64_t* low)
+{
+    uint64_t al = a & 0xffffffffu, ah = a >> 32, bl = b & 0xffffffffu, bh = b >> 32;
+    uint64_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+    uint64_t middle = (ll >> 32) + (lh & 0xffffffffu) + (hl & 0xffffffffu);
+    *low = (middle << 32) | (ll & 0xffffffffu);
+    return hh + (lh >> 32) + (hl >> 32) + (middle >> 32);
+}
+
+static void model_fill_u64(t_model* model, uint64_t* out, size_t count, uint64_t min, uint64_t max)
+{
+    uint64_t range = max - min + 1;
+    uint64_t threshold = range ? (0 - range) % range : 0;
+
+    for (size_t i = 0; i < count;)
+    {
+        uint64_t raw = model_next(model);
+        if (!range)
+        {
+            out[i++] = raw;
+            continue;
+        }
+
+        uint64_t low;
+        uint64_t high = multiply_high(raw, range, &low);
+        if (low >= threshold) out[i++] = min + high;
+    }
+    model_end_call(model);
+}
+
+static void model_fill_u32(t_model* model, uint32_t* out, size_t count, uint32_t min, uint32_t max)
+{
+    t_model_draws draws = { model, 0, false };
+    uint64_t range = (uint64_t)max - min + 1;
+    uint32_t threshold = (uint32_t)((0x100000000ull - range) % range);
+
+    for (size_t i = 0; i < count;)
+    {
+        uint32_t draw = model_draw(&draws);
+        if (range > UINT32_MAX)
+        {
+            out[i++] = draw;
+            continue;
+        }
+
+        uint64_t product = (uint64_t)draw * range;
+        if ((uint32_t)product >= threshold) out[i++] = min + (uint32_t)(product >> 32);
+    }
+    model_end_call(model);
+}
+
+static void model_fill_float(t_model* model, float* out, size_t count, float min, float max)
+{
+    t_model_draws draws = { model, 0, false };
+    float span = max - min;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        float value = min + (float)(int32_t)(model_draw(&draws) >> 8) * 0x1.0p-24f * span;
+        out[i] = value < max ? value : min;
+    }
+    model_end_call(model);
+}
+
+static void model_fill_double(t_model* model, double* out, size_t count, double min, double max)
+{
+    double span = max - min;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t bits = model_next(model) >> 12 | 0x3ff0000000000000ull;
+        double unit;
+        memcpy(&unit, &bits, sizeof(unit));
+
+        double value = min + (unit - 1.0) * span;
+        out[i] = value < max ? value : min;
+    }
+    model_end_call(model);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Generator                                                                  */
+/* -------------------------------------------------------------------------- */
+
+// From the reference xoshiro256** and splitmix64, so runs on any platform and build agree with them
+static void test_known_answers(void)
+{
+    static const uint64_t outputs[] =
+    {
+        0x0000000000002d00ull, 0x0000000000000000ull, 0x000000005a007080ull,
+        0x10e0000000009d80ull, 0x10e0b61ce1009d80ull, 0x0870021ce143ad00ull
+    };
+    t_rand_utils_state state = { { 1, 2, 3, 4 } };
+    for (size_t i = 0; i < sizeof(outputs) / sizeof(outputs[0]); i++)
+    {
+        assert(rand_utils_state_next(&state) == outputs[i]);
+    }
+
+    // Seeding takes the first four splitmix64 outputs of the seed
+    static const uint64_t seeded[] =
+    {
+        0xe220a8397b1dcdafull, 0x6e789e6aa1b965f4ull, 0x06c45d188009454full, 0xf88bb8a8724c81ecull
+    };
+    static const uint64_t seeded_outputs[] =
+    {
+        0x99ec5f36cb75f2b4ull, 0xbf6e1f784956452aull, 0x1a5f849d4933e6e0ull, 0x6aa594f1262d2d2cull
+    };
+    rand_utils_state_seed(&state, 0);
+    for (int w = 0; w < 4; w++) assert(state.s[w] == seeded[w]);
+    for (int i = 0; i < 4; i++) assert(rand_utils_state_next(&state) == seeded_outputs[i]);
+}
+
+// Lemire's method as documented: the high half of raw * range, redrawn while the low half is below 2^64 mod range
+static uint64_t bounded_reference(t_rand_utils_state* state, uint64_t range)
+{
+    uint64_t threshold = range ? (0 - range) % range : 0;
+    for (;;)
+    {
+        uint64_t low;
+        uint64_t high = multiply_high(rand_utils_state_next(state), range, &low);
+        if (low >= threshold) return high;
+    }
+}
+
+static void test_bounded_edges(void)
+{
+    // Rejection is rare for small ranges and close to one in two just above 2^63
+    static const uint64_t ranges[] =
+    {
+        0, 1, 2, 3, 10, 1ull << 32, (1ull << 32) + 1, 1ull << 63, (1ull << 63) + 1, UINT64_MAX - 1, UINT64_MAX
+    };
+    t_rand_utils_state state, reference;
+    rand_utils_state_seed(&state, 21);
+    reference = state;
+
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++)
+    {
+        for (int i = 0; i < 2000; i++)
+        {
+            uint64_t value = rand_utils_state_bounded(&state, ranges[r]);
+            assert(value == bounded_reference(&reference, ranges[r]));
+            assert(ranges[r] == 0 ? value == 0 : value < ranges[r]);
+        }
+        assert(memcmp(&state, &reference, sizeof(state)) == 0);
+    }
+
+    // The full int range, without overflow, reaches both signs
+    int negative = 0, positive = 0;
+    for (int i = 0; i < 2000; i++)
+    {
+        int value = rand_utils_state_int(&state, INT_MIN, INT_MAX);
+        assert(value == (int)((int64_t)INT_MIN + (int64_t)bounded_reference(&reference, 1ull << 32)));
+        negative += value < 0;
+        positive += value > 0;
+    }
+    assert(negative > 900 && positive > 900);
+
+    // Ranges of two at both ends
+    bool seen[2][2] = { { false, false }, { false, false } };
+    for (int i = 0; i < 200; i++)
+    {
+        int low = rand_utils_state_int(&state, INT_MIN, INT_MIN + 1);
+        int high = rand_utils_state_int(&state, INT_MAX - 1, INT_MAX);
+        assert((low == INT_MIN || low == INT_MIN + 1) && (high == INT_MAX - 1 || high == INT_MAX));
+        seen[0][low - INT_MIN] = true;
+        seen[1][INT_MAX - high] = true;
+    }
+    assert(seen[0][0] && seen[0][1] && seen[1][0] && seen[1][1]);
+
+    // A range of one, or an empty one, gives min without drawing
+    reference = state;
+    assert(rand_utils_state_int(&state, 7, 7) == 7);
+    assert(rand_utils_state_int(&state, INT_MAX, INT_MAX) == INT_MAX);
+    assert(rand_utils_state_int(&state, 5, -5) == 5);
+    assert(rand_utils_state_int(&state, INT_MAX, INT_MIN) == INT_MAX);
+    assert(memcmp(&state, &reference, sizeof(state)) == 0);
+}
+
+static void assert_state(const t_rand_utils_state* state, const uint64_t expected[4])
+{
+    for (int w = 0; w < 4; w++) assert(state->s[w] == expected[w]);
+}
+
+// Expected states are the transition matrix over GF(2) raised to 2^128 and 2^192, not the jump polynomials
+static void test_jump(void)
+{
+    static const uint64_t jumped[] =
+    {
+        0x8c7a153956b5f3d1ull, 0x701f1a713401d85eull, 0x6527f66a65469085ull, 0x8386b786c4408050ull
+    };
+    static const uint64_t jumped_twice[] =
+    {
+        0x46f0982578de9ff7ull, 0xb1ba9f06c0b88626ull, 0x0f85ed0825d9669dull, 0x9764a25d66e64f2cull
+    };
+    static const uint64_t long_jumped[] =
+    {
+        0x096a8eb71295a400ull, 0xdbf84991e50f4516ull, 0x534ee745810d2a0eull, 0x31655ca1a2215bf1ull
+    };
+    static const uint64_t seeded_long_jumped[] =
+    {
+        0xaf65dfebc3f98b67ull, 0xbb26b6403a6dd452ull, 0xbf68673518d166bdull, 0x4c9939968279ffa0ull
+    };
+
+    t_rand_utils_state state = { { 1, 2, 3, 4 } };
+    rand_utils_state_jump(&state);
+    assert_state(&state, jumped);
+    rand_utils_state_jump(&state);
+    assert_state(&state, jumped_twice);
+
+    state = (t_rand_utils_state){ { 1, 2, 3, 4 } };
+    rand_utils_state_long_jump(&state);
+    assert_state(&state, long_jumped);
+
+    rand_utils_state_seed(&state, 0);
+    rand_utils_state_long_jump(&state);
+    assert_state(&state, seeded_long_jumped);
+}
+
+// Stream k of a split is the seeded generator jumped k times, as rand_utils_state_stream() builds it
+static void test_split(void)
+{
+    t_rand_utils_state master = { { 1, 2, 3, 4 } }, streams[6], copy;
+    rand_utils_state_split(&master, streams, 3);
+    assert(master.s[0] == 1 && master.s[1] == 2 && master.s[2] == 3 && master.s[3] == 4);
+    assert(memcmp(&streams[0], &master, sizeof(master)) == 0);
+    assert(streams[1].s[0] == 0x8c7a153956b5f3d1ull && streams[2].s[0] == 0x46f0982578de9ff7ull);
+
+    for (uint64_t seed = 0; seed < 4; seed++)
+    {
+        rand_utils_state_seed(&master, seed);
+        copy = master;
+        rand_utils_state_split(&master, streams, 6);
+        assert(memcmp(&master, &copy, sizeof(master)) == 0);
+
+        for (uint64_t k = 0; k < 6; k++)
+        {
+            t_rand_utils_state stream;
+            rand_utils_state_stream(&stream, seed, k);
+            assert(memcmp(&stream, &streams[k], sizeof(stream)) == 0);
+
+            // Same draws from then on
+            for (int i = 0; i < 4; i++) assert(rand_utils_state_next(&stream) == rand_utils_state_next(&streams[k]));
+        }
+    }
+
+    // No streams asked, none written
+    memset(streams, 0xab, sizeof(streams));
+    rand_utils_state_split(&master, streams, 0);
+    for (size_t i = 0; i < sizeof(streams); i++) assert(((unsigned char*)streams)[i] == 0xab);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Bulk fills                                                                 */
+/* -------------------------------------------------------------------------- */
+
+// Sizes around the group, chunk and vector widths, and a few large ones
+static const size_t s_counts[] = { 0, 1, 2, 3, 7, 8, 9, 15, 16, 17, 31, 33, 255, 256, 257, 511, 512, 513, 1000, 4099, 70001 };
+#define COUNTS (sizeof(s_counts) / sizeof(s_counts[0]))
+
+static void test_fill_u64(void)
+{
+    static uint64_t out[70001], expected[70001];
+    static const uint64_t ranges[][2] =
+    {
+        { 0, UINT64_MAX }, { 0, 999 }, { 10, 10 }, { 0, (1ull << 63) + 12345 }, { 5, UINT64_MAX - 1 }, { 3, 1 }
+    };
+
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++)
+    {
+        t_rand_utils_lanes lanes;
+        t_model model;
+        rand_utils_lanes_seed(&lanes, 1000 + r);
+        model_init(&model, &lanes);
+
+        // Consecutive calls on the same lanes, each starting a new group
+        for (size_t c = 0; c < COUNTS; c++)
+        {
+            size_t count = s_counts[c];
+            uint64_t min = ranges[r][0], max = ranges[r][1];
+            rand_utils_fill_u64(&lanes, out, count, min, max);
+
+            if (max < min)
+            {
+                for (size_t i = 0; i < count; i++) assert(out[i] == min);
+                continue;
+            }
+            model_fill_u64(&model, expected, count, min, max);
+            assert(memcmp(out, expected, count * sizeof(out[0])) == 0);
+        }
+    }
+}
+
+static void test_fill_u32(void)
+{
+    static uint32_t out[70001], expected[70001];
+    static const uint32_t ranges[][2] =
+    {
+        { 0, UINT32_MAX }, { 0, 999 }, { 5, 0x80000004u }, { 0, 0xc0000000u }, { 0, 2 }, { 7, 7 }, { 0, 0xfffffffeu }
+    };
+
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++)
+    {
+        t_rand_utils_lanes lanes;
+        t_model model;
+        rand_utils_lanes_seed(&lanes, 2000 + r);
+        model_init(&model, &lanes);
+
+        for (size_t c = 0; c < COUNTS; c++)
+        {
+            size_t count = s_counts[c];
+            rand_utils_fill_u32(&lanes, out, count, ranges[r][0], ranges[r][1]);
+            model_fill_u32(&model, expected, count, ranges[r][0], ranges[r][1]);
+            assert(memcmp(out, expected, count * sizeof(out[0])) == 0);
+        }
+    }
+}
+
+static void test_fill_float(void)
+{
+    static float out[70001], expected[70001];
+    static const float ranges[][2] = { { 0, 1 }, { -3.5f, 12 }, { -FLT_MAX / 2, FLT_MAX / 2 }, { 1e-30f, 2e-30f } };
+
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++)
+    {
+        t_rand_utils_lanes lanes;
+        t_model model;
+        rand_utils_lanes_seed(&lanes, 3000 + r);
+        model_init(&model, &lanes);
+
+        for (size_t c = 0; c < COUNTS; c++)
+        {
+            size_t count = s_counts[c];
+            rand_utils_fill_float(&lanes, out, count, ranges[r][0], ranges[r][1]);
+            model_fill_float(&model, expected, count, ranges[r][0], ranges[r][1]);
+            assert(memcmp(out, expected, count * sizeof(out[0])) == 0);
+
+            for (size_t i = 0; i < count; i++) assert(out[i] >= ranges[r][0] && out[i] < ranges[r][1]);
+        }
+    }
+}
+
+static void test_fill_double(void)
+{
+    static double out[70001], expected[70001];
+    static const double ranges[][2] = { { 0, 1 }, { -3.5, 12 }, { -DBL_MAX / 2, DBL_MAX / 2 }, { 1e300, 1.0000001e300 } };
+
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++)
+    {
+        t_rand_utils_lanes lanes;
+        t_model model;
+        rand_utils_lanes_seed(&lanes, 4000 + r);
+        model_init(&model, &lanes);
+
+        for (size_t c = 0; c < COUNTS; c++)
+        {
+            size_t count = s_counts[c];
+            rand_utils_fill_double(&lanes, out, count, ranges[r][0], ranges[r][1]);
+            model_fill_double(&model, expected, count, ranges[r][0], ranges[r][1]);
+            assert(memcmp(out, expected, count * sizeof(out[0])) == 0);
+
+            for (size_t i = 0; i < count; i++) assert(out[i] >= ranges[r][0] && out[i] < ranges[r][1]);
+        }
+    }
+
+    // Empty ranges give min
+    t_rand_utils_lanes lanes;
+    rand_utils_lanes_seed(&lanes, 1);
+    rand_utils_fill_double(&lanes, out, 5, 2, 2);
+    for (size_t i = 0; i < 5; i++) assert(out[i] == 2);
+}
+
+static void test_lanes(void)
+{
+    // Lane j is the seeded generator jumped j times
+    t_rand_utils_lanes lanes;
+    t_rand_utils_state state;
+    rand_utils_lanes_seed(&lanes, 77);
+    rand_utils_state_seed(&state, 77);
+
+    for (int lane = 0; lane < RAND_UTILS_LANES; lane++)
+    {
+        for (int w = 0; w < 4; w++) assert(lanes.s[w][lane] == state.s[w]);
+        rand_utils_state_jump(&state);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* Distributions                                                              */
+/* -------------------------------------------------------------------------- */
+
+// Sample sizes and tolerances give false failures far less often than once in a million runs
+#define SAMPLES 200000
+
+// Binomial count of an event of probability p among SAMPLES draws, within 6 standard deviations
+static void assert_frequency(long count, double p)
+{
+    double expected = p * SAMPLES;
+    assert(fabs((double)count - expected) <= 6 * sqrt(expected * (1 - p)) + 1);
+}
+
+static void test_normal(void)
+{
+    t_rand_utils_state state;
+    rand_utils_state_seed(&state, 11);
+
+    // 8 bins over [-2, 2) and the tail beyond the ziggurat base, which takes the slow path
+    const double r = 3.6541528853610088;
+    long bins[8] = { 0 }, tail = 0;
+    double sum = 0, squares = 0;
+    for (int i = 0; i < SAMPLES; i++)
+    {
+        double x = rand_utils_state_normal(&state, 0, 1);
+        sum += x;
+        squares += x * x;
+        if (x >= -2 && x < 2) bins[(int)((x + 2) * 2)]++;
+        tail += fabs(x) > r;
+    }
+
+    assert(fabs(sum / SAMPLES) <= 6 / sqrt(SAMPLES));
+    assert(fabs(squares / SAMPLES - 1) <= 6 * sqrt(2.0 / SAMPLES));
+    for (int b = 0; b < 8; b++)
+    {
+        double low = -2 + b * 0.5, high = low + 0.5;
+        assert_frequency(bins[b], 0.5 * (erf(high / sqrt(2)) - erf(low / sqrt(2))));
+    }
+    assert_frequency(tail, erfc(r / sqrt(2)));
+
+    // Mean and standard deviation parameters
+    sum = 0;
+    for (int i = 0; i < SAMPLES; i++) sum += rand_utils_state_normal(&state, 5, 2);
+    assert(fabs(sum / SAMPLES - 5) <= 6 * 2 / sqrt(SAMPLES));
+}
+
+static void test_exponential(void)
+{
+    t_rand_utils_state state;
+    rand_utils_state_seed(&state, 12);
+
+    long below[4] = { 0 };
+    double sum = 0;
+    for (int i = 0; i < SAMPLES; i++)
+    {
+        double x = rand_utils_state_exponential(&state, 2);
+        assert(x >= 0);
+        sum += x;
+        for (int b = 0; b < 4; b++) below[b] += x < (b + 1) * 1.5;
+    }
+
+    assert(fabs(sum / SAMPLES - 0.5) <= 6 * 0.5 / sqrt(SAMPLES));
+    for (int b = 0; b < 4; b++) assert_frequency(below[b], 1 - exp(-2 * (b + 1) * 1.5));
+}
+
+static void test_poisson_geometric(void)
+{
+    t_rand_utils_state state;
+    rand_utils_state_seed(&state, 13);
+
+    // Both sides of the switch to transformed rejection at 10
+    static const double means[] = { 0.5, 3, 9.9, 10, 37.5, 1000 };
+    for (size_t m = 0; m < sizeof(means) / sizeof(means[0]); m++)
+    {
+        double mean = means[m], sum = 0, squares = 0;
+        for (int i = 0; i < SAMPLES; i++)
+        {
+            double x = (double)rand_utils_state_poisson(&state, mean);
+            sum += x;
+            squares += x * x;
+        }
+
+        double sample_mean = sum / SAMPLES, variance = squares / SAMPLES - sample_mean * sample_mean;
+        assert(fabs(sample_mean - mean) <= 6 * sqrt(mean / SAMPLES));
+        assert(fabs(variance - mean) <= 6 * sqrt((mean + 2 * mean * mean) / SAMPLES));
+    }
+
+    static const double probabilities[] = { 0.01, 0.3, 0.9 };
+    for (size_t k = 0; k < sizeof(probabilities) / sizeof(probabilities[0]); k++)
+    {
+        double p = probabilities[k], sum = 0;
+        long ones = 0;
+        for (int i = 0; i < SAMPLES; i++)
+        {
+            uint64_t x = rand_utils_state_geometric(&state, p);
+            assert(x >= 1);
+            sum += (double)x;
+            ones += x == 1;
+        }
+
+        assert(fabs(sum / SAMPLES - 1 / p) <= 6 * sqrt((1 - p) / (p * p) / SAMPLES));
+        assert_frequency(ones, p);
+    }
+
+    assert(rand_utils_state_geometric(&state, 1) == 1);
+    assert(rand_utils_state_geometric(&state, 0) == UINT64_MAX);
+    assert(rand_utils_state_poisson(&state, 0) == 0);
+    assert(rand_utils_state_poisson(&state, -1) == 0);
+}
+
+static void test_alias(void)
+{
+    t_rand_utils_state state;
+    rand_utils_state_seed(&state, 14);
+
+    const double weights[] = { 1, 0, 3, 6, 0.5, 0.0001, 2 };
+    const double total = 12.5001;
+    t_rand_utils_alias* alias = rand_utils_alias_new(weights, 7);
+    assert(alias != NULL);
+
+    long counts[7] = { 0 };
+    for (int i = 0; i < SAMPLES; i++)
+    {
+        size_t k = rand_utils_alias_sample(alias, &state);
+        assert(k < 7);
+        counts[k]++;
+    }
+    assert(counts[1] == 0);
+    for (int k = 0; k < 7; k++) assert_frequency(counts[k], weights[k] / total);
+    rand_utils_alias_free(alias);
+
+    // A single category, and the generator of the calling thread
+    alias = rand_utils_alias_new(weights + 2, 1);
+    for (int i = 0; i < 100; i++) assert(rand_utils_alias_sample(alias, NULL) == 0);
+    rand_utils_alias_free(alias);
+
+    const double negative[] = { 1, -1 }, zeros[] = { 0, 0 }, nan[] = { 1, NAN }, inf[] = { 1, INFINITY };
+    assert(rand_utils_alias_new(negative, 2) == NULL);
+    assert(rand_utils_alias_new(zeros, 2) == NULL);
+    assert(rand_utils_alias_new(nan, 2) == NULL);
+    assert(rand_utils_alias_new(inf, 2) == NULL);
+    assert(rand_utils_alias_new(weights, 0) == NULL);
+}
+
+int main(void)
+{
+    test_known_answers();
+    test_bounded_edges();
+    test_jump();
+    test_split();
+    test_lanes();
+    test_fill_u64();
+    test_fill_u32();
+    test_fill_float();
+    test_fill_double();
+    test_normal();
+    test_exponential();
+    test_poisson_geometric();
+    test_alias();
+
+    printf("All tests passed!\n");
+    return 0;
+}
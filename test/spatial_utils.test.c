@@ -0,0 +1,253 @@
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spatial_utils.h"
+
+/*
+ * The grid and the quadtree against a brute-force scan of the same points,
+ * through random inserts, updates and removals: radius and box queries
+ * must return the same sets, nearest queries the same distances in order.
+ */
+
+#define MAX_ID 3000
+
+static t_math_utils_vec2 s_positions[MAX_ID];
+static bool s_live[MAX_ID];
+static uint64_t s_state = 88172645463325252ull;
+
+static double next_random(void)
+{
+    s_state ^= s_state << 13;
+    s_state ^= s_state >> 7;
+    s_state ^= s_state << 17;
+    return (double)(s_state >> 11) * 0x1.0p-53;
+}
+
+static int compare_ids(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static int compare_floats(const void* a, const void* b)
+{
+    float x = *(const float*)a, y = *(const float*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Uniform, clustered, heavily duplicated, or spread over a huge range
+static t_math_utils_vec2 random_point(int mode)
+{
+    if (mode == 0) return math_utils_vec2((float)(next_random() * 100), (float)(next_random() * 100));
+    if (mode == 1)
+    {
+        float cx = (float)((int)(next_random() * 4) * 30), cy = (float)((int)(next_random() * 3) * 40);
+        return math_utils_vec2(cx + (float)(next_random() * 0.5), cy + (float)(next_random() * 0.5));
+    }
+    if (mode == 2) return math_utils_vec2((float)(int)(next_random() * 3), (float)(int)(next_random() * 3));
+    return math_utils_vec2((float)((next_random() - 0.5) * 1e7), (float)((next_random() - 0.5) * 1e7));
+}
+
+static float distance_squared(t_math_utils_vec2 a, t_math_utils_vec2 b)
+{
+    float dx = a.x - b.x, dy = a.y - b.y;
+    return dx * dx + dy * dy;
+}
+
+static size_t brute_radius(t_math_utils_vec2 center, float radius, uint32_t* out)
+{
+    size_t count = 0;
+    for (uint32_t i = 0; i < MAX_ID; i++)
+    {
+        t_math_utils_vec2 p = s_positions[i];
+        if (!s_live[i] || p.x < center.x - radius || p.x > center.x + radius) continue;
+        if (p.y < center.y - radius || p.y > center.y + radius) continue;
+        if (distance_squared(p, center) <= radius * radius) out[count++] = i;
+    }
+    return count;
+}
+
+static size_t brute_box(t_math_utils_vec2 min, t_math_utils_vec2 max, uint32_t* out)
+{
+    size_t count = 0;
+    for (uint32_t i = 0; i < MAX_ID; i++)
+    {
+        t_math_utils_vec2 p = s_positions[i];
+        if (s_live[i] && p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y) out[count++] = i;
+    }
+    return count;
+}
+
+static size_t live_count(void)
+{
+    size_t count = 0;
+    for (uint32_t i = 0; i < MAX_ID; i++) count += s_live[i];
+    return count;
+}
+
+static void assert_same_set(uint32_t* found, size_t found_count, uint32_t* expected, size_t expected_count)
+{
+    assert(found_count == expected_count);
+    qsort(found, found_count, sizeof(uint32_t), compare_ids);
+    qsort(expected, expected_count, sizeof(uint32_t), compare_ids);
+    assert(memcmp(found, expected, found_count * sizeof(uint32_t)) == 0);
+}
+
+// Squared distances from point to every live point, ascending; returns their count
+static size_t sorted_distances(t_math_utils_vec2 point, float* out)
+{
+    size_t count = 0;
+    for (uint32_t i = 0; i < MAX_ID; i++)
+    {
+        if (s_live[i]) out[count++] = distance_squared(s_positions[i], point);
+    }
+    qsort(out, count, sizeof(float), compare_floats);
+    return count;
+}
+
+// Ties may come in any order, so only the distances are compared
+static void assert_nearest(t_math_utils_vec2 point, const float* expected, size_t expected_count,
+                           const uint32_t* ids, const float* distances, size_t count)
+{
+    assert(count == expected_count);
+    for (size_t i = 0; i < count; i++)
+    {
+        assert(ids[i] < MAX_ID && s_live[ids[i]]);
+        float d = distance_squared(s_positions[ids[i]], point);
+        assert(d == expected[i] && distances[i] == sqrtf(d));
+        for (size_t j = 0; j < i; j++) assert(ids[j] != ids[i]);
+    }
+}
+
+static void test_against_brute_force(int mode, float cell_size)
+{
+    static t_math_utils_vec2 points[1000];
+    static uint32_t grid_ids[MAX_ID], tree_ids[MAX_ID], expected[MAX_ID];
+    static float grid_distances[MAX_ID], tree_distances[MAX_ID], expected_distances[MAX_ID];
+
+    t_spatial_utils_grid* grid = spatial_utils_grid_new(cell_size);
+    t_spatial_utils_quadtree* tree = spatial_utils_quadtree_new();
+    assert(grid != NULL && tree != NULL);
+
+    // Bulk build; NaN points are skipped
+    memset(s_live, 0, sizeof(s_live));
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        points[i] = random_point(mode);
+        if (i % 97 == 5) points[i].x = NAN;
+        s_positions[i] = points[i];
+        s_live[i] = !isnan(points[i].x);
+    }
+    assert(spatial_utils_grid_build(grid, points, 1000));
+    assert(spatial_utils_quadtree_build(tree, points, 1000));
+    assert(spatial_utils_grid_count(grid) == live_count() && spatial_utils_quadtree_count(tree) == live_count());
+
+    for (int step = 0; step < 4000; step++)
+    {
+        int operation = (int)(next_random() * 10);
+        uint32_t id = (uint32_t)(next_random() * MAX_ID);
+        t_math_utils_vec2 p = random_point(mode);
+
+        if (operation < 3)
+        {
+            bool inserted = spatial_utils_grid_insert(grid, id, p);
+            assert(inserted == !s_live[id] && spatial_utils_quadtree_insert(tree, id, p) == inserted);
+            if (inserted)
+            {
+                s_live[id] = true;
+                s_positions[id] = p;
+            }
+        }
+        else if (operation < 6)
+        {
+            // Half of the moves stay within the same cell or its neighbours
+            if (next_random() < 0.5 && s_live[id])
+            {
+                p = math_utils_vec2(s_positions[id].x + (float)(next_random() - 0.5) * cell_size * 0.3f,
+                                    s_positions[id].y + (float)(next_random() - 0.5) * cell_size * 0.3f);
+            }
+            bool updated = spatial_utils_grid_update(grid, id, p);
+            assert(updated == s_live[id] && spatial_utils_quadtree_update(tree, id, p) == updated);
+            if (updated) s_positions[id] = p;
+        }
+        else if (operation < 8)
+        {
+            bool removed = spatial_utils_grid_remove(grid, id);
+            assert(removed == s_live[id] && spatial_utils_quadtree_remove(tree, id) == removed);
+            s_live[id] = false;
+        }
+        else
+        {
+            t_math_utils_vec2 center = random_point(mode);
+            float radius = (float)(next_random() * next_random() * (mode == 3 ? 3e6 : 40));
+            size_t count = brute_radius(center, radius, expected);
+            assert_same_set(grid_ids, spatial_utils_grid_query_radius(grid, center, radius, grid_ids, MAX_ID),
+                            expected, count);
+            assert_same_set(tree_ids, spatial_utils_quadtree_query_radius(tree, center, radius, tree_ids, MAX_ID),
+                            expected, count);
+
+            t_math_utils_vec2 min = random_point(mode);
+            t_math_utils_vec2 max = math_utils_vec2(min.x + radius, min.y + radius * 0.7f);
+            count = brute_box(min, max, expected);
+            assert_same_set(grid_ids, spatial_utils_grid_query_box(grid, min, max, grid_ids, MAX_ID), expected, count);
+            assert_same_set(tree_ids, spatial_utils_quadtree_query_box(tree, min, max, tree_ids, MAX_ID),
+                            expected, count);
+
+            // Mostly small k, sometimes more than the points nearby, sometimes far outside the points
+            size_t k = next_random() < 0.1 ? (size_t)(next_random() * 200) : (size_t)(next_random() * 10);
+            if (next_random() < 0.05) center = math_utils_vec2(center.x + 1e6f, center.y - 1e6f);
+            size_t live = sorted_distances(center, expected_distances);
+            size_t found = k < live ? k : live;
+            count = spatial_utils_grid_query_nearest(grid, center, k, grid_ids, grid_distances);
+            assert_nearest(center, expected_distances, found, grid_ids, grid_distances, count);
+            count = spatial_utils_quadtree_query_nearest(tree, center, k, tree_ids, tree_distances);
+            assert_nearest(center, expected_distances, found, tree_ids, tree_distances, count);
+
+            // The total is returned even when only capacity ids are written
+            assert(spatial_utils_grid_count(grid) == live && spatial_utils_quadtree_count(tree) == live);
+            assert(spatial_utils_grid_query_radius(grid, center, 1e30f, grid_ids, 3) == live);
+            assert(spatial_utils_quadtree_query_radius(tree, center, INFINITY, tree_ids, 3) == live);
+        }
+    }
+
+    spatial_utils_grid_free(grid);
+    spatial_utils_quadtree_free(tree);
+}
+
+static void test_infinite_distances(void)
+{
+    // Squared distances overflow to infinity; the points must still be found
+    t_math_utils_vec2 points[4] = { { 1e30f, 1e30f }, { 1e30f, 1e30f }, { 1e30f, 1e30f }, { 1e30f, 1e30f } };
+    t_math_utils_vec2 far = math_utils_vec2(-1e30f, 1e30f);
+    uint32_t ids[4];
+    float distances[4];
+
+    t_spatial_utils_grid* grid = spatial_utils_grid_new(1.0f);
+    t_spatial_utils_quadtree* tree = spatial_utils_quadtree_new();
+    assert(spatial_utils_grid_build(grid, points, 4) && spatial_utils_quadtree_build(tree, points, 4));
+
+    assert(spatial_utils_grid_query_nearest(grid, far, 4, ids, distances) == 4);
+    assert(isinf(distances[0]) && isinf(distances[3]));
+    assert(spatial_utils_quadtree_query_nearest(tree, far, 4, ids, NULL) == 4);
+    qsort(ids, 4, sizeof(uint32_t), compare_ids);
+    assert(ids[0] == 0 && ids[1] == 1 && ids[2] == 2 && ids[3] == 3);
+
+    spatial_utils_grid_free(grid);
+    spatial_utils_quadtree_free(tree);
+}
+
+int main(void)
+{
+    test_against_brute_force(0, 2.0f);
+    test_against_brute_force(1, 1.0f);
+    test_against_brute_force(2, 0.5f);
+    test_against_brute_force(3, 1000.0f);
+    test_against_brute_force(0, 0.01f);
+    test_infinite_distances();
+
+    printf("All tests passed!\n");
+    return 0;
+}
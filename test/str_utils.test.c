@@ -0,0 +1,810 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "str_utils.h"
+#include "tracking_alloc.h"
+
+static uint64_t s_seed = 0x9e3779b97f4a7c15ull;
+
+static uint64_t next_random(void)
+{
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 7;
+    s_seed ^= s_seed << 17;
+    return s_seed;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Number conversion                                                          */
+/* -------------------------------------------------------------------------- */
+
+static void test_format_integers(void)
+{
+    char buffer[STR_UTILS_I64_BUFFER_SIZE + 1], expected[32];
+
+    for (int i = 0; i < 200000; i++)
+    {
+        uint64_t u = next_random() >> (next_random() % 64);
+        size_t n = str_utils_format_u64(buffer, u);
+        snprintf(expected, sizeof(expected), "%" PRIu64, u);
+        assert(n == strlen(expected) && memcmp(buffer, expected, n) == 0);
+
+        int64_t s = (int64_t)next_random() >> (next_random() % 64);
+        n = str_utils_format_i64(buffer, s);
+        snprintf(expected, sizeof(expected), "%" PRId64, s);
+        assert(n == strlen(expected) && memcmp(buffer, expected, n) == 0);
+
+        int64_t back;
+        assert(str_utils_parse_i64(buffer, n, &back) == n && back == s);
+
+        int width = (int)(next_random() % 8);
+        n = str_utils_format_u64_padded(buffer, u % 100000, (size_t)width);
+        snprintf(expected, sizeof(expected), "%0*" PRIu64, width, u % 100000);
+        assert(n == strlen(expected) && memcmp(buffer, expected, n) == 0);
+    }
+
+    assert(str_utils_format_i64(buffer, INT64_MIN) == 20 && memcmp(buffer, "-9223372036854775808", 20) == 0);
+    assert(str_utils_format_u64(buffer, UINT64_MAX) == 20 && memcmp(buffer, "18446744073709551615", 20) == 0);
+    assert(str_utils_format_u64(buffer, 0) == 1 && buffer[0] == '0');
+}
+
+static void test_parse_integers(void)
+{
+    uint64_t u;
+    int64_t s;
+
+    assert(str_utils_parse_u64("18446744073709551615x", 21, &u) == 20 && u == UINT64_MAX);
+    assert(str_utils_parse_u64("18446744073709551616", 20, &u) == 0);
+    assert(str_utils_parse_u64("-1", 2, &u) == 0);
+    assert(str_utils_parse_u64("", 0, &u) == 0);
+    assert(str_utils_parse_u64("0042", 4, &u) == 4 && u == 42);
+
+    assert(str_utils_parse_i64("-9223372036854775808", 20, &s) == 20 && s == INT64_MIN);
+    assert(str_utils_parse_i64("9223372036854775807", 19, &s) == 19 && s == INT64_MAX);
+    assert(str_utils_parse_i64("9223372036854775808", 19, &s) == 0);
+    assert(str_utils_parse_i64("-9223372036854775809", 20, &s) == 0);
+    assert(str_utils_parse_i64("+17,", 4, &s) == 3 && s == 17);
+    assert(str_utils_parse_i64("-", 1, &s) == 0);
+}
+
+// Digits of a formatted double that carry information: no sign, point, exponent, or padding zeros
+static int significant_digits(const char* text)
+{
+    const char* end = strchr(text, 'e');
+    if (!end) end = text + strlen(text);
+
+    const char* first = text;
+    while (first < end && (*first < '1' || *first > '9')) first++;
+    const char* last = end;
+    while (last > first && (last[-1] < '1' || last[-1] > '9')) last--;
+
+    int digits = 0;
+    for (const char* c = first; c < last; c++) digits += *c >= '0' && *c <= '9';
+    return digits;
+}
+
+static void test_format_double(void)
+{
+    static const struct
+    {
+        double      value;
+        const char* text;
+    } layouts[] =
+    {
+        { 0.001, "0.001" }, { 1e21, "1e+21" }, { 123456789012345678901.0, "123456789012345680000" },
+        { 1.5, "1.5" }, { -0.0, "-0" }, { 0.0, "0" }, { 1e-7, "1e-7" }, { 0.000001, "0.000001" },
+        { 5e-324, "5e-324" }, { 1.7976931348623157e308, "1.7976931348623157e+308" }, { 0.1, "0.1" },
+        { 0.1 + 0.2, "0.30000000000000004" }, { 1e23, "1e+23" }, { -2.5e-300, "-2.5e-300" },
+        { 9007199254740992.0, "9007199254740992" }, { -42, "-42" }, { 2.2250738585072014e-308, "2.2250738585072014e-308" },
+        { -3.6819108600211877e+189, "-3.6819108600211877e+189" }  // Grisu2 alone gives ...878e+189
+    };
+
+    char buffer[STR_UTILS_DOUBLE_BUFFER_SIZE + 1];
+    for (size_t i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++)
+    {
+        size_t n = str_utils_format_double(buffer, layouts[i].value);
+        buffer[n] = '\0';
+        assert(strcmp(buffer, layouts[i].text) == 0);
+    }
+
+    buffer[str_utils_format_double(buffer, NAN)] = '\0';
+    assert(strcmp(buffer, "nan") == 0);
+    buffer[str_utils_format_double(buffer, -INFINITY)] = '\0';
+    assert(strcmp(buffer, "-inf") == 0);
+
+    // Random bit patterns read back exactly, with no more digits than the shortest printf form
+    for (int i = 0; i < 50000; i++)
+    {
+        uint64_t bits = next_random();
+        if (i % 8 == 0) bits &= ~((1ull << 52) - 1);  // Powers of two, where the lower boundary is closer
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        if (i % 4 == 1)
+        {
+            value = (double)(next_random() % 100000) / (double)(1 + next_random() % 1000);
+            memcpy(&bits, &value, sizeof(bits));
+        }
+        if (!isfinite(value)) continue;
+
+        size_t n = str_utils_format_double(buffer, value);
+        assert(n < STR_UTILS_DOUBLE_BUFFER_SIZE);
+        buffer[n] = '\0';
+
+        double back;
+        assert(str_utils_parse_double(buffer, n, &back) == n && memcmp(&back, &value, sizeof(value)) == 0);
+
+        int shortest = 1;
+        for (char text[32];; shortest++)
+        {
+            snprintf(text, sizeof(text), "%.*e", shortest - 1, value);
+            if (strtod(text, NULL) == value) break;
+        }
+        assert(significant_digits(buffer) <= shortest);
+        assert(significant_digits(buffer) == shortest || (bits & ((1ull << 52) - 1)) == 0);
+    }
+}
+
+// Compares with strtod, which glibc rounds correctly
+static void check_parse_double(const char* text)
+{
+    double expected = strtod(text, NULL), value;
+    assert(str_utils_parse_double(text, strlen(text), &value) == strlen(text));
+    assert(memcmp(&value, &expected, sizeof(value)) == 0);
+}
+
+static void test_parse_double(void)
+{
+    static const char* const edges[] =
+    {
+        "0", "-0", "0.0", "1e-400", "-1e400", "2.2250738585072011e-308", "2.2250738585072014e-308",
+        "4.9406564584124654e-324", "2.4703282292062327e-324", "2.4703282292062328e-324",
+        "1.7976931348623157e308", "1.7976931348623158e308", "1.7976931348623159e308", "9007199254740993",
+        "9007199254740992.5", "0.1", "123456789012345678901234567890",
+        "1.00000000000000011102230246251565404236316680908203125",
+        "1.00000000000000011102230246251565404236316680908203124",
+        "1.00000000000000011102230246251565404236316680908203126",
+        ".5", "5.", "1e23", "8.589973e9", "7.3177701707893310e+15",
+        "0.000000000000000000000000000000000000000000001", "1e0", "1E+2", "3.14159e-0", "00001.5"
+    };
+
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) check_parse_double(edges[i]);
+
+    // Random mantissas up to 40 digits, many of them near halfway cases
+    for (int i = 0; i < 100000; i++)
+    {
+        char text[80];
+        int n = 0, digits = 1 + (int)(next_random() % 40);
+        int point = (int)(next_random() % (uint64_t)(digits + 1));
+        if (next_random() % 2) text[n++] = '-';
+        for (int j = 0; j < digits; j++)
+        {
+            if (j == point && j) text[n++] = '.';
+            int digit = j > 16 && next_random() % 3 ? (next_random() % 2 ? 0 : 9) : (int)(next_random() % 10);
+            text[n++] = (char)('0' + digit);
+        }
+        snprintf(text + n, sizeof(text) - (size_t)n, "e%d", (int)(next_random() % 700) - 350);
+        check_parse_double(text);
+
+        // %.17g of any double reads back
+        uint64_t bits = next_random();
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        if (isfinite(value))
+        {
+            snprintf(text, sizeof(text), "%.17g", value);
+            check_parse_double(text);
+        }
+    }
+
+    // Longest valid prefix
+    double value;
+    assert(str_utils_parse_double("12.5e", 5, &value) == 4 && value == 12.5);
+    assert(str_utils_parse_double("1e+x", 4, &value) == 1 && value == 1);
+    assert(str_utils_parse_double(".", 1, &value) == 0);
+    assert(str_utils_parse_double("-.e1", 4, &value) == 0);
+    assert(str_utils_parse_double("inf", 3, &value) == 0);
+    assert(str_utils_parse_double("0x10", 4, &value) == 1 && value == 0);
+}
+
+/* -------------------------------------------------------------------------- */
+/* UTF-8                                                                      */
+/* -------------------------------------------------------------------------- */
+
+// Bytewise validator after table 3-7 of the Unicode standard, reporting maximal subparts
+static size_t utf8_reference(const unsigned char* text, size_t len, size_t* invalid_len)
+{
+    size_t i = 0;
+    while (i < len)
+    {
+        unsigned c = text[i];
+        if (c < 0x80)
+        {
+            i++;
+            continue;
+        }
+
+        size_t trailing;
+        unsigned low = 0x80, high = 0xbf;
+        if (c >= 0xc2 && c <= 0xdf) trailing = 1;
+        else if (c == 0xe0) { trailing = 2; low = 0xa0; }
+        else if (c == 0xed) { trailing = 2; high = 0x9f; }
+        else if (c >= 0xe1 && c <= 0xef) trailing = 2;
+        else if (c == 0xf0) { trailing = 3; low = 0x90; }
+        else if (c == 0xf4) { trailing = 3; high = 0x8f; }
+        else if (c >= 0xf1 && c <= 0xf3) trailing = 3;
+        else
+        {
+            *invalid_len = 1;
+            return i;
+        }
+
+        for (size_t k = 1; k <= trailing; k++)
+        {
+            if (i + k >= len || text[i + k] < low || text[i + k] > high)
+            {
+                *invalid_len = k;
+                return i;
+            }
+            low = 0x80;
+            high = 0xbf;
+        }
+        i += trailing + 1;
+    }
+    return STR_UTILS_NPOS;
+}
+
+static void test_utf8_examples(void)
+{
+    const char* text = "a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80";  // a, e acute, euro sign, U+1F600
+    const uint16_t expected[] = { 'a', 0xe9, 0x20ac, 0xd83d, 0xde00 };
+    uint16_t utf16[16];
+    char utf8[48];
+
+    assert(str_utils_utf8_valid(str_utils_view(text)));
+    assert(str_utils_utf8_to_utf16(str_utils_view(text), utf16) == 5);
+    assert(memcmp(utf16, expected, sizeof(expected)) == 0);
+    assert(str_utils_utf16_to_utf8(expected, 5, utf8) == strlen(text) && memcmp(utf8, text, strlen(text)) == 0);
+    assert(str_utils_utf8_to_utf16(str_utils_view_of(text, 0), utf16) == 0);
+
+    static const struct
+    {
+        const char* text;
+        size_t      offset;
+        size_t      invalid_len;
+    } invalid[] =
+    {
+        { "\x80", 0, 1 },                  // Lone continuation byte
+        { "ab\xc0\x80", 2, 1 },            // Overlong NUL
+        { "\xe0\x80\x80", 0, 1 },          // Overlong three-byte form
+        { "\xed\xa0\x80", 0, 1 },          // Surrogate
+        { "\xf4\x90\x80\x80", 0, 1 },      // Above U+10FFFF
+        { "\xf5\x80\x80\x80", 0, 1 },
+        { "x\xe2\x82", 1, 2 },             // Truncated at the end
+        { "\xf0\x9f\x98y", 0, 3 },         // Truncated before an ASCII byte
+        { "0123456789abcdefghijklmnopqrstu\xff", 31, 1 }  // At the end of a 32-byte block
+    };
+
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+    {
+        size_t invalid_len = 0;
+        t_str_utils_view view = str_utils_view(invalid[i].text);
+        assert(str_utils_utf8_find_invalid(view, &invalid_len) == invalid[i].offset);
+        assert(invalid_len == invalid[i].invalid_len);
+        assert(str_utils_utf8_to_utf16(view, utf16) == STR_UTILS_NPOS);
+    }
+
+    // Unpaired surrogates have no UTF-8 form
+    const uint16_t lone_high[] = { 'a', 0xd800, 'b' }, lone_low[] = { 0xdc00 }, truncated[] = { 0xd83d };
+    assert(str_utils_utf16_to_utf8(lone_high, 3, utf8) == STR_UTILS_NPOS);
+    assert(str_utils_utf16_to_utf8(lone_low, 1, utf8) == STR_UTILS_NPOS);
+    assert(str_utils_utf16_to_utf8(truncated, 1, utf8) == STR_UTILS_NPOS);
+}
+
+// Random texts across block boundaries agree with the bytewise reference, and valid ones round-trip
+static void test_utf8_random(void)
+{
+    static const char* const valid[] =
+    {
+        "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xed\x9f\xbf", "\xee\x80\x80", "\xf4\x8f\xbf\xbf",
+        "\xf0\x90\x80\x80", "\xe0\xa0\x80", "\xc2\x80"
+    };
+    static const char* const invalid[] =
+    {
+        "\x80", "\xc0\x80", "\xc1\xbf", "\xe0\x80\x80", "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xf5\x80", "\xff",
+        "\xe2\x82", "\xf0\x9f\x98", "\xc3", "\xf8\x88\x80\x80\x80"
+    };
+
+    static unsigned char text[600];
+    static uint16_t utf16[600];
+    static char back[1800];
+
+    for (int i = 0; i < 50000; i++)
+    {
+        size_t len = 0, target = next_random() % 300;
+        bool bytes = next_random() % 4 == 0;
+        while (len < target)
+        {
+            if (bytes)
+            {
+                text[len++] = (unsigned char)next_random();
+                continue;
+            }
+
+            const char* piece = next_random() % 50 == 0 ? invalid[next_random() % 12]
+                              : next_random() % 4 ? "x" : valid[next_random() % 9];
+            size_t n = strlen(piece);
+            if (len + n > sizeof(text)) break;
+            memcpy(text + len, piece, n);
+            len += n;
+        }
+        if (len && next_random() % 20 == 0) len--;
+
+        t_str_utils_view view = str_utils_view_of((const char*)text, len);
+        size_t expected_len = 0, invalid_len = 0;
+        size_t expected = utf8_reference(text, len, &expected_len);
+        assert(str_utils_utf8_find_invalid(view, &invalid_len) == expected);
+        assert(expected == STR_UTILS_NPOS || invalid_len == expected_len);
+
+        size_t units = str_utils_utf8_to_utf16(view, utf16);
+        assert((units == STR_UTILS_NPOS) == (expected != STR_UTILS_NPOS));
+        if (units != STR_UTILS_NPOS)
+        {
+            assert(units <= len);
+            assert(str_utils_utf16_to_utf8(utf16, units, back) == len && memcmp(back, text, len) == 0);
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* Searching                                                                  */
+/* -------------------------------------------------------------------------- */
+
+static size_t find_reference(const char* haystack, size_t len, const char* needle, size_t needle_len)
+{
+    for (size_t i = 0; i + needle_len <= len; i++)
+    {
+        if (memcmp(haystack + i, needle, needle_len) == 0) return i;
+    }
+    return STR_UTILS_NPOS;
+}
+
+static size_t count_reference(const char* haystack, size_t len, const char* needle, size_t needle_len)
+{
+    size_t count = 0;
+    for (size_t i = 0; needle_len && i + needle_len <= len;)
+    {
+        if (memcmp(haystack + i, needle, needle_len) == 0)
+        {
+            count++;
+            i += needle_len;
+        }
+        else
+        {
+            i++;
+        }
+    }
+    return count;
+}
+
+static size_t find_any_reference(const char* haystack, size_t len, const char* bytes, size_t bytes_len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (memchr(bytes, haystack[i], bytes_len)) return i;
+    }
+    return STR_UTILS_NPOS;
+}
+
+// Few distinct bytes, so needles and sets match often; a third of the alphabet is >= 0x80
+static const char s_alphabet[] = "ab,; \x80\xc3\xff";
+
+static char random_byte(int mode)
+{
+    return mode == 0 ? "ab"[next_random() % 2]
+         : mode == 1 ? s_alphabet[next_random() % (sizeof(s_alphabet) - 1)]
+         : (char)next_random();
+}
+
+// Haystacks at every alignment, with needles copied across the 16/32/64-byte boundaries
+static void test_find_random(void)
+{
+    static const size_t needle_lens[] = { 1, 2, 3, 4, 7, 15, 16, 17, 31, 32, 33, 63, 64, 65 };
+    static const size_t boundaries[] = { 16, 32, 48, 64, 128, 192 };
+    static char buffer[64 + 320];
+    char needle[80], bytes[8];
+
+    for (int i = 0; i < 30000; i++)
+    {
+        int mode = (int)(next_random() % 3);
+        size_t len = next_random() % 320;
+        char* haystack = buffer + next_random() % 64;
+        for (size_t j = 0; j < len; j++) haystack[j] = random_byte(mode);
+
+        size_t needle_len = needle_lens[next_random() % (sizeof(needle_lens) / sizeof(needle_lens[0]))];
+        if (needle_len <= len && next_random() % 2)
+        {
+            // Starts before a boundary and ends after it, when the needle spans one
+            size_t boundary = boundaries[next_random() % (sizeof(boundaries) / sizeof(boundaries[0]))];
+            size_t at = boundary > needle_len / 2 ? boundary - needle_len / 2 : 0;
+            if (at + needle_len > len) at = len - needle_len;
+            memcpy(needle, haystack + at, needle_len);
+        }
+        else
+        {
+            for (size_t j = 0; j < needle_len; j++) needle[j] = random_byte(mode);
+        }
+
+        t_str_utils_view view = str_utils_view_of(haystack, len);
+        t_str_utils_view needle_view = str_utils_view_of(needle, needle_len);
+        assert(str_utils_view_find(view, needle_view) == find_reference(haystack, len, needle, needle_len));
+        assert(str_utils_view_count(view, needle_view) == count_reference(haystack, len, needle, needle_len));
+        assert(str_utils_view_find_char(view, needle[0]) == find_reference(haystack, len, needle, 1));
+
+        size_t bytes_len = 1 + next_random() % sizeof(bytes);
+        for (size_t j = 0; j < bytes_len; j++) bytes[j] = random_byte(mode == 0 ? 1 : mode);
+        t_str_utils_view bytes_view = str_utils_view_of(bytes, bytes_len);
+        t_str_utils_byte_set set;
+        str_utils_byte_set_init(&set, bytes_view);
+        size_t expected = find_any_reference(haystack, len, bytes, bytes_len);
+        assert(str_utils_view_find_any(view, bytes_view) == expected);
+        assert(str_utils_view_find_set(view, &set) == expected);
+    }
+
+    // Edge cases
+    t_str_utils_view text = STR_UTILS_VIEW_LITERAL("abcabc");
+    assert(str_utils_view_find(text, STR_UTILS_VIEW_LITERAL("")) == 0);
+    assert(str_utils_view_count(text, STR_UTILS_VIEW_LITERAL("")) == 0);
+    assert(str_utils_view_find(text, STR_UTILS_VIEW_LITERAL("abcabcd")) == STR_UTILS_NPOS);
+    assert(str_utils_view_find(str_utils_view(NULL), STR_UTILS_VIEW_LITERAL("a")) == STR_UTILS_NPOS);
+    assert(str_utils_view_count(STR_UTILS_VIEW_LITERAL("aaaaa"), STR_UTILS_VIEW_LITERAL("aa")) == 2);
+    assert(str_utils_view_find_any(text, STR_UTILS_VIEW_LITERAL("")) == STR_UTILS_NPOS);
+    assert(str_utils_view_find_any(STR_UTILS_VIEW_LITERAL("x\xff"), STR_UTILS_VIEW_LITERAL("\x7f\xff")) == 1);
+}
+
+// Splits text at every delimiter, keeping or dropping empty fields; returns the token count
+static size_t tokenize_reference(const char* text, size_t len, const char* delimiters, size_t delimiters_len,
+                                 bool skip_empty, t_str_utils_view* tokens)
+{
+    size_t count = 0, start = 0;
+    for (size_t i = 0; i <= len; i++)
+    {
+        if (i < len && !memchr(delimiters, text[i], delimiters_len)) continue;
+        if (!skip_empty || i > start) tokens[count++] = str_utils_view_of(text + start, i - start);
+        start = i + 1;
+    }
+    return count;
+}
+
+static void check_tokens(t_str_utils_view text, t_str_utils_view delimiters, bool skip_empty)
+{
+    static t_str_utils_view expected[400];
+    size_t count = 0;
+    if (text.data)
+    {
+        count = tokenize_reference(text.data, text.len, delimiters.data, delimiters.len, skip_empty, expected);
+    }
+
+    t_str_utils_tokenizer tokenizer;
+    t_str_utils_view token;
+    str_utils_tokenizer_init(&tokenizer, text, delimiters, skip_empty);
+    for (size_t i = 0; i < count; i++)
+    {
+        assert(str_utils_tokenizer_next(&tokenizer, &token));
+        assert(token.data == expected[i].data && token.len == expected[i].len);
+    }
+    assert(!str_utils_tokenizer_next(&tokenizer, &token));
+    assert(!str_utils_tokenizer_next(&tokenizer, &token));
+}
+
+static void test_tokenizer(void)
+{
+    static char buffer[64 + 320];
+    char delimiters[6];
+
+    for (int i = 0; i < 20000; i++)
+    {
+        size_t len = next_random() % 320;
+        char* text = buffer + next_random() % 64;
+        int density = 1 + (int)(next_random() % 8);
+        size_t delimiters_len = 1 + next_random() % sizeof(delimiters);
+        for (size_t j = 0; j < delimiters_len; j++)
+        {
+            delimiters[j] = s_alphabet[2 + next_random() % (sizeof(s_alphabet) - 3)];
+        }
+
+        // Runs of delimiters, including at the 64-byte block ends
+        for (size_t j = 0; j < len; j++)
+        {
+            bool delimiter = (int)(next_random() % 8) < density || j % 64 == 63 || j % 64 == 0;
+            text[j] = delimiter ? delimiters[next_random() % delimiters_len] : "ab"[next_random() % 2];
+        }
+
+        t_str_utils_view view = str_utils_view_of(text, len);
+        t_str_utils_view delimiter_view = str_utils_view_of(delimiters, delimiters_len);
+        check_tokens(view, delimiter_view, false);
+        check_tokens(view, delimiter_view, true);
+    }
+
+    // An empty text is one empty field; the null view has none
+    const char* cases[] = { "", ",", ",,", "a,", ",a", "a,,b", "abc" };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        check_tokens(str_utils_view(cases[i]), STR_UTILS_VIEW_LITERAL(","), false);
+        check_tokens(str_utils_view(cases[i]), STR_UTILS_VIEW_LITERAL(","), true);
+    }
+    check_tokens(str_utils_view(NULL), STR_UTILS_VIEW_LITERAL(","), false);
+}
+
+/* -------------------------------------------------------------------------- */
+/* String builder                                                             */
+/* -------------------------------------------------------------------------- */
+
+static void check_builder(const t_str_utils_builder* builder, const char* expected, size_t len)
+{
+    assert(builder->len == len && builder->len < builder->capacity);
+    assert(memcmp(builder->data, expected, len) == 0 && builder->data[len] == '\0');
+}
+
+// Inline storage until 63 bytes, then one heap block growing geometrically
+static void test_builder_growth(void)
+{
+    static char expected[20000];
+    t_tracker tracker;
+    tracker_init(&tracker);
+
+    t_str_utils_builder builder;
+    str_utils_builder_init_with_allocator(&builder, NULL, 0, &tracker.allocator);
+    assert(builder.data == builder.inline_buffer && builder.capacity == STR_UTILS_BUILDER_INLINE_SIZE);
+    check_builder(&builder, "", 0);
+
+    size_t len = 0;
+    for (; len < STR_UTILS_BUILDER_INLINE_SIZE - 1; len++)
+    {
+        expected[len] = (char)('a' + len % 26);
+        assert(str_utils_builder_append_char(&builder, expected[len]));
+    }
+    assert(builder.data == builder.inline_buffer && !builder.owned && tracker.allocations == 0);
+    check_builder(&builder, expected, len);
+
+    expected[len] = '!';
+    assert(str_utils_builder_append(&builder, expected + len, 1));
+    len++;
+    assert(builder.owned && tracker.allocations == 1 && tracker.live == 1);
+    check_builder(&builder, expected, len);
+
+    // Appends of every size, checked after each one
+    while (len < sizeof(expected) - 300)
+    {
+        size_t n = (size_t)(next_random() % 300);
+        for (size_t i = 0; i < n; i++) expected[len + i] = (char)('A' + (len + i) % 26);
+        switch (n % 3)
+        {
+            case 0:  assert(str_utils_builder_append(&builder, expected + len, n)); break;
+            case 1:  assert(str_utils_builder_append_view(&builder, str_utils_view_of(expected + len, n))); break;
+            default: for (size_t i = 0; i < n; i++) assert(str_utils_builder_append_char(&builder, expected[len + i]));
+        }
+        len += n;
+        check_builder(&builder, expected, len);
+    }
+    assert(tracker.allocations <= 10 && tracker.live == 1);
+
+    // Reserved room is filled through commit without reallocating
+    size_t allocations = tracker.allocations;
+    assert(str_utils_builder_reserve(&builder, 200));
+    memset(builder.data + builder.len, 'z', 200);
+    str_utils_builder_commit(&builder, 200);
+    memset(expected + len, 'z', 200);
+    len += 200;
+    check_builder(&builder, expected, len);
+    assert(tracker.allocations == allocations);
+
+    // Impossible sizes and failed allocations leave the contents alone
+    assert(!str_utils_builder_reserve(&builder, SIZE_MAX));
+    tracker.limit = tracker.allocations;
+    assert(!str_utils_builder_append(&builder, expected, builder.capacity));
+    check_builder(&builder, expected, len);
+    tracker.limit = SIZE_MAX;
+
+    str_utils_builder_free(&builder);
+    assert(tracker.live == 0 && builder.data == builder.inline_buffer);
+    check_builder(&builder, "", 0);
+}
+
+// A caller buffer is used up to its last byte, then copied to the heap and left alone
+static void test_builder_buffer(void)
+{
+    t_tracker tracker;
+    tracker_init(&tracker);
+    char buffer[16];
+    memset(buffer, '#', sizeof(buffer));
+
+    t_str_utils_builder builder;
+    str_utils_builder_init_with_allocator(&builder, buffer, sizeof(buffer), &tracker.allocator);
+    assert(builder.data == buffer && builder.capacity == sizeof(buffer) && buffer[0] == '\0');
+
+    assert(str_utils_builder_append(&builder, "0123456789abcde", 15));
+    assert(builder.data == buffer && tracker.allocations == 0);
+    check_builder(&builder, "0123456789abcde", 15);
+
+    assert(str_utils_builder_append_char(&builder, 'f'));
+    assert(builder.data != buffer && builder.owned && tracker.live == 1);
+    check_builder(&builder, "0123456789abcdef", 16);
+    assert(memcmp(buffer, "0123456789abcde", 16) == 0);
+
+    str_utils_builder_free(&builder);
+    assert(tracker.live == 0);
+
+    // No buffer, or an empty one, selects the inline buffer
+    str_utils_builder_init_buffer(&builder, NULL, 16);
+    assert(builder.data == builder.inline_buffer && builder.capacity == STR_UTILS_BUILDER_INLINE_SIZE);
+    str_utils_builder_init_buffer(&builder, buffer, 0);
+    assert(builder.data == builder.inline_buffer && builder.allocator == alloc_utils_default());
+    str_utils_builder_free(&builder);
+}
+
+// Formatting that does not fit grows the builder once and formats again from the copied arguments
+static void test_builder_appendf(void)
+{
+    static char source[300];
+    for (size_t i = 0; i < sizeof(source); i++) source[i] = (char)('a' + i % 26);
+
+    t_tracker tracker;
+    tracker_init(&tracker);
+
+    // Around every capacity boundary: the output fills the room exactly, or misses it by one
+    char expected[1024];
+    for (size_t prefix = 0; prefix < 70; prefix += 7)
+    {
+        for (int n = 0; n < 200; n++)
+        {
+            t_str_utils_builder builder;
+            str_utils_builder_init_with_allocator(&builder, NULL, 0, &tracker.allocator);
+            assert(str_utils_builder_append(&builder, source, prefix));
+
+            assert(str_utils_builder_appendf(&builder, "%.*s|%d|%s", n, source + prefix, n, "end"));
+            size_t len = prefix + (size_t)snprintf(expected + prefix, sizeof(expected) - prefix, "%.*s|%d|%s",
+                                                   n, source + prefix, n, "end");
+            memcpy(expected, source, prefix);
+            check_builder(&builder, expected, len);
+
+            str_utils_builder_free(&builder);
+        }
+    }
+    assert(tracker.live == 0);
+
+    // Several arguments of several types, all read again by the second pass
+    t_str_utils_builder builder;
+    str_utils_builder_init_with_allocator(&builder, NULL, 0, &tracker.allocator);
+    assert(str_utils_builder_appendf(&builder, "%s/%d/%.3f/%c/%" PRIu64 "/%s", source + 200, -7, 2.5, 'x',
+                                     UINT64_MAX, "tail"));
+    int len = snprintf(expected, sizeof(expected), "%s/%d/%.3f/%c/%" PRIu64 "/%s", source + 200, -7, 2.5, 'x',
+                       UINT64_MAX, "tail");
+    check_builder(&builder, expected, (size_t)len);
+
+    // A failed growth leaves the contents as they were, over the truncated first pass
+    assert(str_utils_builder_reserve(&builder, 100));
+    tracker.limit = tracker.allocations;
+    assert(!str_utils_builder_appendf(&builder, "%s%s", source, source));
+    check_builder(&builder, expected, (size_t)len);
+    tracker.limit = SIZE_MAX;
+
+    str_utils_builder_free(&builder);
+    assert(tracker.live == 0);
+}
+
+// Reset keeps the heap block, so rebuilding strings of the same size allocates nothing
+static void test_builder_reset(void)
+{
+    t_tracker tracker;
+    tracker_init(&tracker);
+
+    t_str_utils_builder builder;
+    str_utils_builder_init_with_allocator(&builder, NULL, 0, &tracker.allocator);
+
+    char expected[4096];
+    size_t allocations = 0, capacity = 0;
+    for (int round = 0; round < 100; round++)
+    {
+        str_utils_builder_reset(&builder);
+        check_builder(&builder, "", 0);
+
+        size_t len = 0;
+        for (int i = 0; i < 100; i++)
+        {
+            len += (size_t)snprintf(expected + len, sizeof(expected) - len, "item %d = %.2f; ", i, i / 4.0);
+            assert(str_utils_builder_appendf(&builder, "item %d = %.2f; ", i, i / 4.0));
+        }
+        assert(str_utils_builder_append(&builder, "done", 4) && str_utils_builder_append_char(&builder, '.'));
+        memcpy(expected + len, "done.", 5);
+        len += 5;
+        check_builder(&builder, expected, len);
+
+        if (round == 0)
+        {
+            allocations = tracker.allocations;
+            capacity = builder.capacity;
+            assert(allocations > 0 && capacity > len);
+        }
+        assert(tracker.allocations == allocations && builder.capacity == capacity && tracker.live == 1);
+    }
+
+    str_utils_builder_free(&builder);
+    assert(tracker.live == 0);
+}
+
+static void test_builder_detach(void)
+{
+    t_tracker tracker;
+    tracker_init(&tracker);
+    t_str_utils_builder builder;
+    char buffer[32];
+
+    // Not owned, in the inline or a caller buffer: copied to a block of len + 1 bytes from the allocator
+    for (int caller = 0; caller < 2; caller++)
+    {
+        str_utils_builder_init_with_allocator(&builder, caller ? buffer : NULL, sizeof(buffer), &tracker.allocator);
+        assert(str_utils_builder_append(&builder, "short", 5));
+
+        tracker.limit = tracker.allocations;
+        assert(str_utils_builder_detach(&builder) == NULL);
+        check_builder(&builder, "short", 5);
+        tracker.limit = SIZE_MAX;
+
+        char* str = str_utils_builder_detach(&builder);
+        assert(str != NULL && str != buffer && strcmp(str, "short") == 0 && tracker.live == 1);
+        tracker_free(&tracker, str, 6);
+        assert(builder.data == builder.inline_buffer && !builder.owned);
+        check_builder(&builder, "", 0);
+    }
+
+    // Owned, from another allocator: shrunk to len + 1 bytes, which sized frees check
+    str_utils_builder_init_with_allocator(&builder, NULL, 0, &tracker.allocator);
+    for (int i = 0; i < 50; i++) assert(str_utils_builder_append(&builder, "0123456789", 10));
+    assert(builder.owned && builder.capacity > 501);
+    char* str = str_utils_builder_detach(&builder);
+    assert(str != NULL && strlen(str) == 500 && memcmp(str + 490, "0123456789", 10) == 0 && tracker.live == 1);
+    tracker_free(&tracker, str, 501);
+    assert(tracker.live == 0 && builder.data == builder.inline_buffer && builder.len == 0);
+
+    // The builder is usable again, and detaching it empty gives an empty string
+    assert(str_utils_builder_append(&builder, "again", 5));
+    check_builder(&builder, "again", 5);
+    str_utils_builder_reset(&builder);
+    str = str_utils_builder_detach(&builder);
+    assert(str != NULL && str[0] == '\0');
+    tracker_free(&tracker, str, 1);
+    assert(tracker.live == 0);
+
+    // Owned, from the default allocator: the block itself, for free()
+    str_utils_builder_init(&builder);
+    for (int i = 0; i < 50; i++) assert(str_utils_builder_append(&builder, "0123456789", 10));
+    const char* data = builder.data;
+    str = str_utils_builder_detach(&builder);
+    assert(str == data && strlen(str) == 500);
+    free(str);
+    assert(builder.data == builder.inline_buffer && !builder.owned);
+    str_utils_builder_free(&builder);
+}
+
+int main(void)
+{
+    test_format_integers();
+    test_parse_integers();
+    test_format_double();
+    test_parse_double();
+    test_utf8_examples();
+    test_utf8_random();
+    test_find_random();
+    test_tokenizer();
+    test_builder_growth();
+    test_builder_buffer();
+    test_builder_appendf();
+    test_builder_reset();
+    test_builder_detach();
+
+    printf("All tests passed!\n");
+    return 0;
+}
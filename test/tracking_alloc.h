@@ -0,0 +1,70 @@
+#ifndef TRACKING_ALLOC_H
+#define TRACKING_ALLOC_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alloc_utils.h"
+
+/*
+ * Allocator for tests: each block is preceded by its size and a marker,
+ * checked when it is freed or reallocated, and live blocks are counted so
+ * a test can assert that nothing was leaked or allocated at all. Setting a
+ * limit makes allocations fail, to exercise out-of-memory paths.
+ */
+
+typedef struct t_tracker
+{
+    t_alloc_utils allocator;  // Passes the tracker as its context
+    size_t live;
+    size_t allocations;
+    size_t limit;             // Allocations fail once this many were made; SIZE_MAX never fails
+} t_tracker;
+
+static inline void* tracker_alloc(void* context, size_t size)
+{
+    t_tracker* tracker = context;
+    if (tracker->allocations >= tracker->limit) return NULL;
+
+    size_t* block = malloc(size + 2 * sizeof(size_t));
+    if (block == NULL) return NULL;
+
+    block[0] = size;
+    block[1] = 0xfeedu;
+    tracker->live++;
+    tracker->allocations++;
+    return block + 2;
+}
+
+static inline void tracker_free(void* context, void* pointer, size_t size)
+{
+    if (pointer == NULL) return;
+
+    t_tracker* tracker = context;
+    size_t* block = (size_t*)pointer - 2;
+    assert(block[0] == size && block[1] == 0xfeedu);
+    block[1] = 0;
+    tracker->live--;
+    free(block);
+}
+
+static inline void* tracker_realloc(void* context, void* pointer, size_t old_size, size_t new_size)
+{
+    void* block = tracker_alloc(context, new_size);
+    if (block == NULL) return NULL;
+    if (pointer != NULL)
+    {
+        memcpy(block, pointer, old_size < new_size ? old_size : new_size);
+        tracker_free(context, pointer, old_size);
+    }
+    return block;
+}
+
+static inline void tracker_init(t_tracker* tracker)
+{
+    *tracker = (t_tracker) { .allocator = { tracker_alloc, tracker_realloc, tracker_free, tracker },
+                             .limit = SIZE_MAX };
+}
+
+#endif /* TRACKING_ALLOC_H */
@@ -0,0 +1,559 @@
+/*
+ * log_utils_decode: turns a binary stream written by log_utils_bin into the
+ * JSON lines log_utils prints.
+ *
+ * Usage: log_utils_decode [input [output]]   (defaults: stdin, stdout)
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "json_utils.h"
+#include "log_utils_bin.h"
+
+typedef struct t_decode_format
+{
+    bool     defined;
+    int      level;
+    char*    context;  // NULL when logged with a NULL context
+    char*    format;
+    uint8_t  kind_count;
+    uint8_t  kinds[LOG_UTILS_BIN_MAX_ARGS];
+} t_decode_format;
+
+typedef struct t_decode_state
+{
+    uint64_t         ticks_per_second;
+    uint64_t         base_ticks;
+    int64_t          base_realtime_ns;
+    t_decode_format* formats;
+    size_t           format_capacity;
+} t_decode_state;
+
+typedef struct t_decode_cursor
+{
+    const uint8_t* data;
+    size_t         size;
+    size_t         offset;
+    bool           failed;
+} t_decode_cursor;
+
+typedef struct t_decode_text
+{
+    char*  data;
+    size_t size;
+    size_t capacity;
+} t_decode_text;
+
+static const char* decode_level_string(int level)
+{
+    switch (level)
+    {
+        case 0:  return "DEBUG";
+        case 1:  return "INFO";
+        case 2:  return "WARN";
+        case 3:  return "ERROR";
+        default: return "UNKNOWN";
+    }
+}
+
+static uint64_t decode_varint(t_decode_cursor* cursor)
+{
+    uint64_t value = 0;
+
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (cursor->offset >= cursor->size)
+        {
+            cursor->failed = true;
+            return 0;
+        }
+
+        uint8_t byte = cursor->data[cursor->offset++];
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+
+    cursor->failed = true;
+    return 0;
+}
+
+static int64_t decode_zigzag(t_decode_cursor* cursor)
+{
+    uint64_t value = decode_varint(cursor);
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static const uint8_t* decode_bytes(t_decode_cursor* cursor, size_t len)
+{
+    if (cursor->size - cursor->offset < len)
+    {
+        cursor->failed = true;
+        return NULL;
+    }
+
+    const uint8_t* bytes = cursor->data + cursor->offset;
+    cursor->offset += len;
+    return bytes;
+}
+
+static char* decode_string(t_decode_cursor* cursor, size_t len)
+{
+    const uint8_t* bytes = decode_bytes(cursor, len);
+    if (!bytes) return NULL;
+
+    char* str = malloc(len + 1);
+    if (!str) return NULL;
+
+    memcpy(str, bytes, len);
+    str[len] = '\0';
+    return str;
+}
+
+static void text_append(t_decode_text* text, const char* str, size_t len)
+{
+    if (text->size + len + 1 > text->capacity)
+    {
+        size_t capacity = text->capacity ? text->capacity : 256;
+        while (text->size + len + 1 > capacity) capacity *= 2;
+
+        char* data = realloc(text->data, capacity);
+        if (!data) return;
+
+        text->data = data;
+        text->capacity = capacity;
+    }
+
+    memcpy(text->data + text->size, str, len);
+    text->size += len;
+    text->data[text->size] = '\0';
+}
+
+/* -------------------------------------------------------------------------- */
+/* Records                                                                    */
+/* -------------------------------------------------------------------------- */
+
+static bool decode_dict(t_decode_state* state, t_decode_cursor* cursor)
+{
+    uint64_t id = decode_varint(cursor);
+    int level = (int)decode_zigzag(cursor);
+    uint64_t context_size = decode_varint(cursor);
+    char* context = context_size ? decode_string(cursor, context_size - 1) : NULL;
+    char* format = decode_string(cursor, decode_varint(cursor));
+    uint64_t kind_count = decode_varint(cursor);
+    const uint8_t* kinds = kind_count <= LOG_UTILS_BIN_MAX_ARGS ? decode_bytes(cursor, kind_count) : NULL;
+
+    if (cursor->failed || !format || !kinds || id == 0 || id > UINT32_MAX)
+    {
+        free(context);
+        free(format);
+        return false;
+    }
+
+    if (id >= state->format_capacity)
+    {
+        size_t capacity = state->format_capacity ? state->format_capacity : 64;
+        while (id >= capacity) capacity *= 2;
+
+        t_decode_format* formats = realloc(state->formats, capacity * sizeof(t_decode_format));
+        if (!formats) return false;
+
+        memset(formats + state->format_capacity, 0, (capacity - state->format_capacity) * sizeof(t_decode_format));
+        state->formats = formats;
+        state->format_capacity = capacity;
+    }
+
+    t_decode_format* entry = &state->formats[id];
+    free(entry->context);
+    free(entry->format);
+
+    entry->defined = true;
+    entry->level = level;
+    entry->context = context;
+    entry->format = format;
+    entry->kind_count = (uint8_t)kind_count;
+    memcpy(entry->kinds, kinds, kind_count);
+
+    return true;
+}
+
+typedef struct t_decode_arg
+{
+    uint8_t     kind;
+    long long   i;
+    unsigned long long u;
+    double      d;
+    const char* s;
+    size_t      s_len;
+} t_decode_arg;
+
+static bool decode_arg(t_decode_cursor* cursor, uint8_t kind, t_decode_arg* arg)
+{
+    arg->kind = kind;
+
+    switch (kind)
+    {
+        case LOG_UTILS_BIN_KIND_I32:
+        case LOG_UTILS_BIN_KIND_I64:
+            arg->i = decode_zigzag(cursor);
+            break;
+        case LOG_UTILS_BIN_KIND_U32:
+        case LOG_UTILS_BIN_KIND_U64:
+        case LOG_UTILS_BIN_KIND_POINTER:
+            arg->u = decode_varint(cursor);
+            break;
+        case LOG_UTILS_BIN_KIND_DOUBLE:
+        case LOG_UTILS_BIN_KIND_LONG_DOUBLE:
+        {
+            const uint8_t* bytes = decode_bytes(cursor, sizeof(double));
+            if (bytes) memcpy(&arg->d, bytes, sizeof(double));
+            break;
+        }
+        case LOG_UTILS_BIN_KIND_STRING:
+            arg->s_len = decode_varint(cursor);
+            arg->s = (const char*)decode_bytes(cursor, arg->s_len);
+            break;
+        default:
+            return false;
+    }
+
+    return !cursor->failed;
+}
+
+static int decode_snprintf(char* buffer, size_t size, const char* spec, const int* stars, int star_count,
+                           const t_decode_arg* arg, const char* string)
+{
+#define DECODE_SNPRINTF(value)                                                       \
+    (star_count == 0 ? snprintf(buffer, size, spec, value)                           \
+     : star_count == 1 ? snprintf(buffer, size, spec, stars[0], value)               \
+     : snprintf(buffer, size, spec, stars[0], stars[1], value))
+
+    switch (arg->kind)
+    {
+        case LOG_UTILS_BIN_KIND_I32:         return DECODE_SNPRINTF((int)arg->i);
+        case LOG_UTILS_BIN_KIND_I64:         return DECODE_SNPRINTF(arg->i);
+        case LOG_UTILS_BIN_KIND_U32:         return DECODE_SNPRINTF((unsigned int)arg->u);
+        case LOG_UTILS_BIN_KIND_U64:         return DECODE_SNPRINTF(arg->u);
+        case LOG_UTILS_BIN_KIND_POINTER:     return DECODE_SNPRINTF((void*)(uintptr_t)arg->u);
+        case LOG_UTILS_BIN_KIND_DOUBLE:
+        case LOG_UTILS_BIN_KIND_LONG_DOUBLE: return DECODE_SNPRINTF(arg->d);
+        case LOG_UTILS_BIN_KIND_STRING:      return DECODE_SNPRINTF(string);
+        default:                             return 0;
+    }
+
+#undef DECODE_SNPRINTF
+}
+
+/*
+ * Formats one conversion. spec holds the conversion up to its length
+ * modifier ("%-08" ...); the modifier matching the recorded kind is added here.
+ */
+static void decode_format_spec(t_decode_text* text, char* spec, size_t spec_len, char conversion,
+                               const char* length, const int* stars, int star_count, const t_decode_arg* arg)
+{
+    char buffer[512];
+    char* string = NULL;
+
+    snprintf(spec + spec_len, 16, "%s%c", length, conversion);
+
+    if (arg->kind == LOG_UTILS_BIN_KIND_STRING)
+    {
+        string = malloc(arg->s_len + 1);
+        if (!string) return;
+        memcpy(string, arg->s, arg->s_len);
+        string[arg->s_len] = '\0';
+    }
+
+    int written = decode_snprintf(buffer, sizeof(buffer), spec, stars, star_count, arg, string);
+
+    if (written >= 0 && (size_t)written < sizeof(buffer))
+    {
+        text_append(text, buffer, (size_t)written);
+    }
+    else if (written >= 0)
+    {
+        char* large = malloc((size_t)written + 1);
+        if (large)
+        {
+            decode_snprintf(large, (size_t)written + 1, spec, stars, star_count, arg, string);
+            text_append(text, large, (size_t)written);
+            free(large);
+        }
+    }
+
+    free(string);
+}
+
+/*
+ * Renders the content of an event by walking its format string and pulling
+ * recorded arguments in the same order printf would.
+ */
+static bool decode_content(t_decode_text* text, const t_decode_format* format, t_decode_cursor* cursor)
+{
+    uint8_t next_kind = 0;
+    const char* p = format->format;
+
+    text->size = 0;
+    text_append(text, "", 0);
+
+    while (*p)
+    {
+        const char* literal = p;
+        while (*p && *p != '%') p++;
+        text_append(text, literal, (size_t)(p - literal));
+
+        if (!*p) break;
+
+        const char* start = p++;
+        if (*p == '%')
+        {
+            text_append(text, "%", 1);
+            p++;
+            continue;
+        }
+
+        t_log_utils_bin_conversion conversion;
+        log_utils_bin_parse_conversion(p, &conversion);
+        if (!conversion.conversion) break;
+        p = conversion.end;
+
+        int stars[2];
+        int star_count = 0;
+        for (uint8_t i = 0; i < conversion.star_count && next_kind < format->kind_count; i++)
+        {
+            t_decode_arg star = { 0 };
+            if (!decode_arg(cursor, format->kinds[next_kind++], &star)) return false;
+            stars[star_count++] = (int)star.i;
+        }
+
+        if (conversion.kind && next_kind >= format->kind_count)
+        {
+            // Argument not recorded: keep the conversion verbatim
+            text_append(text, start, (size_t)(p - start));
+            continue;
+        }
+
+        t_decode_arg arg = { 0 };
+        if (conversion.kind && !decode_arg(cursor, format->kinds[next_kind++], &arg)) return false;
+
+        if (conversion.verbatim)
+        {
+            // Unsupported conversion: its arguments are consumed but not rendered
+            text_append(text, start, (size_t)(p - start));
+            continue;
+        }
+
+        if (conversion.conversion == 'n') continue;
+
+        char spec[64];
+        size_t spec_len = (size_t)(conversion.length - start);
+        if (spec_len > sizeof(spec) - 16) spec_len = sizeof(spec) - 16;
+        memcpy(spec, start, spec_len);
+        spec[spec_len] = '\0';
+
+        const char* length = "";
+        if (arg.kind == LOG_UTILS_BIN_KIND_I64 || arg.kind == LOG_UTILS_BIN_KIND_U64) length = "ll";
+        else if (conversion.halves && (arg.kind == LOG_UTILS_BIN_KIND_I32 || arg.kind == LOG_UTILS_BIN_KIND_U32)) length = conversion.halves > 1 ? "hh" : "h";
+
+        decode_format_spec(text, spec, spec_len, conversion.conversion, length, stars, star_count, &arg);
+    }
+
+    // Arguments past the last conversion ('*' overflow, malformed formats) are skipped
+    while (next_kind < format->kind_count)
+    {
+        t_decode_arg arg;
+        if (!decode_arg(cursor, format->kinds[next_kind++], &arg)) return false;
+    }
+
+    return true;
+}
+
+static void decode_timestamp(const t_decode_state* state, uint64_t ticks, char* buffer, size_t size)
+{
+    long double elapsed = (long double)(int64_t)(ticks - state->base_ticks) * 1e9L
+                        / (long double)(state->ticks_per_second ? state->ticks_per_second : 1);
+    int64_t ns = state->base_realtime_ns + (int64_t)elapsed;
+    time_t seconds = (time_t)(ns / 1000000000);
+    struct tm tm_info;
+
+    localtime_r(&seconds, &tm_info);
+
+    // Format: YYYY/MM/DD HH:MM:SS:MSS
+    snprintf(buffer, size, "%04d/%02d/%02d %02d:%02d:%02d:%03d",
+             tm_info.tm_year + 1900,
+             tm_info.tm_mon + 1,
+             tm_info.tm_mday,
+             tm_info.tm_hour,
+             tm_info.tm_min,
+             tm_info.tm_sec,
+             (int)(ns / 1000000 % 1000));
+}
+
+static bool decode_block(const t_decode_state* state, t_decode_cursor* cursor, t_decode_text* text, FILE* output)
+{
+    const uint8_t* base = decode_bytes(cursor, sizeof(uint64_t));
+    if (!base) return false;
+
+    uint64_t ticks;
+    memcpy(&ticks, base, sizeof(ticks));
+
+    while (cursor->offset < cursor->size)
+    {
+        uint64_t id = decode_varint(cursor);
+        ticks += (uint64_t)decode_zigzag(cursor);
+
+        if (cursor->failed || id >= state->format_capacity || !state->formats[id].defined) return false;
+
+        const t_decode_format* format = &state->formats[id];
+        if (!decode_content(text, format, cursor)) return false;
+
+        char timestamp[64];
+        decode_timestamp(state, ticks, timestamp, sizeof(timestamp));
+
+        // A NULL context escapes to null, written without quotes
+        char* escaped_context = json_utils_escape(format->context);
+        char* escaped_content = json_utils_escape(text->data);
+        const char* quote = format->context ? "\"" : "";
+
+        if (escaped_context && escaped_content)
+        {
+            fprintf(output, "{ \"timestamp\": \"%s\", \"level\": \"%s\", \"context\": %s%s%s, \"content\": \"%s\" }\n",
+                    timestamp,
+                    decode_level_string(format->level),
+                    quote, escaped_context, quote,
+                    escaped_content);
+        }
+
+        free(escaped_context);
+        free(escaped_content);
+    }
+
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Stream                                                                     */
+/* -------------------------------------------------------------------------- */
+
+static bool decode_read(FILE* input, void* data, size_t size)
+{
+    return fread(data, 1, size, input) == size;
+}
+
+static int decode_stream(FILE* input, FILE* output)
+{
+    t_decode_state state = { 0 };
+    t_decode_text text = { 0 };
+    uint8_t header[LOG_UTILS_BIN_MAGIC_SIZE + 3 * sizeof(uint64_t)];
+
+    if (!decode_read(input, header, sizeof(header)) || memcmp(header, LOG_UTILS_BIN_MAGIC, LOG_UTILS_BIN_MAGIC_SIZE) != 0)
+    {
+        fprintf(stderr, "log_utils_decode: not a log_utils binary stream\n");
+        return 1;
+    }
+
+    memcpy(&state.ticks_per_second, header + LOG_UTILS_BIN_MAGIC_SIZE, sizeof(uint64_t));
+    memcpy(&state.base_ticks, header + LOG_UTILS_BIN_MAGIC_SIZE + 8, sizeof(uint64_t));
+    memcpy(&state.base_realtime_ns, header + LOG_UTILS_BIN_MAGIC_SIZE + 16, sizeof(int64_t));
+
+    uint8_t* payload = NULL;
+    size_t payload_capacity = 0;
+    int status = 0;
+
+    for (;;)
+    {
+        uint8_t record_header[5];
+        size_t got = fread(record_header, 1, sizeof(record_header), input);
+
+        if (got == 0) break;
+        if (got != sizeof(record_header))
+        {
+            fprintf(stderr, "log_utils_decode: truncated record header\n");
+            status = 1;
+            break;
+        }
+
+        uint32_t size;
+        memcpy(&size, record_header + 1, sizeof(size));
+
+        if (size > payload_capacity)
+        {
+            uint8_t* grown = realloc(payload, size);
+            if (!grown)
+            {
+                fprintf(stderr, "log_utils_decode: out of memory\n");
+                status = 1;
+                break;
+            }
+            payload = grown;
+            payload_capacity = size;
+        }
+
+        if (!decode_read(input, payload, size))
+        {
+            fprintf(stderr, "log_utils_decode: truncated record\n");
+            status = 1;
+            break;
+        }
+
+        t_decode_cursor cursor = { payload, size, 0, false };
+        bool ok = record_header[0] == LOG_UTILS_BIN_TAG_DICT ? decode_dict(&state, &cursor)
+                : record_header[0] == LOG_UTILS_BIN_TAG_BLOCK ? decode_block(&state, &cursor, &text, output)
+                : false;
+
+        if (!ok)
+        {
+            fprintf(stderr, "log_utils_decode: corrupt record (tag %u)\n", record_header[0]);
+            status = 1;
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < state.format_capacity; i++)
+    {
+        free(state.formats[i].context);
+        free(state.formats[i].format);
+    }
+    free(state.formats);
+    free(payload);
+    free(text.data);
+
+    return status;
+}
+
+int main(int argc, char** argv)
+{
+    FILE* input = stdin;
+    FILE* output = stdout;
+
+    if (argc > 3)
+    {
+        fprintf(stderr, "Usage: %s [input [output]]\n", argv[0]);
+        return 2;
+    }
+
+    if (argc > 1 && !(input = fopen(argv[1], "rb")))
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    if (argc > 2 && !(output = fopen(argv[2], "w")))
+    {
+        perror(argv[2]);
+        fclose(input);
+        return 1;
+    }
+
+    int status = decode_stream(input, output);
+
+    if (input != stdin) fclose(input);
+    if (output != stdout) fclose(output);
+
+    return status;
+}